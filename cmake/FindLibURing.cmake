@@ -0,0 +1,19 @@
+find_path(LIBURING_INCLUDE_DIR NAMES liburing.h)
+find_library(LIBURING_LIBRARIES NAMES uring)
+
+if(LIBURING_INCLUDE_DIR AND LIBURING_LIBRARIES)
+    set(LIBURING_FOUND ON)
+endif(LIBURING_INCLUDE_DIR AND LIBURING_LIBRARIES)
+
+if(LIBURING_FOUND)
+    if (NOT LIBURING_FIND_QUIETLY)
+        message(STATUS "Found liburing includes: ${LIBURING_INCLUDE_DIR}/liburing.h")
+        message(STATUS "Found liburing library: ${LIBURING_LIBRARIES}")
+    endif (NOT LIBURING_FIND_QUIETLY)
+else(LIBURING_FOUND)
+    if (LIBURING_FIND_REQUIRED)
+        message(FATAL_ERROR "Could not find liburing development files")
+    endif (LIBURING_FIND_REQUIRED)
+endif (LIBURING_FOUND)
+
+mark_as_advanced(LIBURING_INCLUDE_DIR LIBURING_LIBRARIES)
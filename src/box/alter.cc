@@ -215,6 +215,16 @@ index_opts_decode(struct index_opts *opts, const char *map,
 			  "bloom_fpr must be greater than 0 and "
 			  "less than or equal to 1");
 	}
+	if (opts->compaction_policy == vy_compaction_policy_MAX) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS, "compaction_policy must be "
+			  "one of 'tiered', 'leveled' or 'time_window'");
+	}
+	if (opts->compaction_window <= 0) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS,
+			  "compaction_window must be greater than 0");
+	}
 }
 
 /**
@@ -249,6 +259,13 @@ index_def_new_from_tuple(struct tuple *tuple, struct space *space)
 	index_opts_decode(&opts, opts_field, &fiber()->gc);
 	const char *parts = tuple_field(tuple, BOX_INDEX_FIELD_PARTS);
 	uint32_t part_count = mp_decode_array(&parts);
+	if (opts.bloom_prefix_parts > 0 &&
+	    opts.bloom_prefix_parts >= part_count) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS,
+			  "bloom_prefix_parts must be less than "
+			  "the number of key parts");
+	}
 	if (name_len > BOX_NAME_MAX) {
 		tnt_raise(ClientError, ER_MODIFY_INDEX,
 			  tt_cstr(name, BOX_INVALID_NAME_MAX),
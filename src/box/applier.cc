@@ -47,6 +47,13 @@
 #include "xrow_io.h"
 #include "error.h"
 #include "session.h"
+#include "scoped_guard.h"
+#include "txn.h"
+#include "schema.h"
+#include "space.h"
+#include "index.h"
+#include "tuple.h"
+#include "tuple_hash.h"
 
 STRS(applier_state, applier_STATE);
 
@@ -96,6 +103,48 @@ applier_log_error(struct applier *applier, struct error *e)
 	applier->last_logged_errcode = errcode;
 }
 
+/**
+ * A row promoted in the replica set vclock, but not written
+ * to WAL yet, see replicaset.applier.order.
+ */
+struct applier_pending {
+	/** Link in replicaset_order::pending. */
+	struct rlist in_pending;
+	/** Origin of the row. */
+	uint32_t replica_id;
+	/** LSN of the row. */
+	int64_t lsn;
+	/** Position of the row among promoted rows of its origin. */
+	int64_t ticket;
+	/** Set once the row has passed its turn to be written to WAL. */
+	bool turn_taken;
+};
+
+/**
+ * Get the vclock of rows that have been written to WAL: the
+ * replica set vclock less rows promoted, but not written yet.
+ * Only this vclock may be acknowledged to a master, because
+ * the master may remove xlogs with rows acknowledged by all
+ * replicas.
+ */
+static void
+applier_ack_vclock(struct vclock *vclock)
+{
+	vclock_create(vclock);
+	struct vclock_iterator it;
+	vclock_iterator_init(&it, &replicaset.vclock);
+	vclock_foreach(&it, c) {
+		struct rlist *pending = &replicaset.applier.order[c.id].pending;
+		if (!rlist_empty(pending)) {
+			c.lsn = rlist_first_entry(pending,
+					struct applier_pending,
+					in_pending)->lsn - 1;
+		}
+		if (c.lsn > 0)
+			vclock_follow(vclock, c.id, c.lsn);
+	}
+}
+
 /*
  * Fiber function to write vclock to replication master.
  * To track connection status, replica answers master
@@ -128,8 +177,10 @@ applier_writer_f(va_list ap)
 		    applier->state != APPLIER_FOLLOW)
 			continue;
 		try {
+			struct vclock vclock;
+			applier_ack_vclock(&vclock);
 			struct xrow_header xrow;
-			xrow_encode_vclock(&xrow, &replicaset.vclock);
+			xrow_encode_vclock(&xrow, &vclock);
 			coio_write_xrow(&io, &xrow);
 		} catch (SocketError *e) {
 			/*
@@ -252,6 +303,34 @@ done:
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/**
+ * Apply rows of a snapshot block sent by the master as
+ * IPROTO_XLOG_TX row on initial join.
+ */
+static void
+applier_apply_xlog_tx(struct applier *applier, struct xrow_header *row,
+		      ZSTD_DStream *zdctx)
+{
+	const char *data;
+	size_t size;
+	xrow_decode_xlog_tx_xc(row, &data, &size);
+	struct xlog_tx_cursor tx_cursor;
+	ssize_t rc = xlog_tx_cursor_create(&tx_cursor, &data, data + size,
+					   zdctx);
+	if (rc < 0)
+		diag_raise();
+	if (rc > 0)
+		tnt_raise(ClientError, ER_INVALID_MSGPACK, "XLOG_TX block");
+	auto guard = make_scoped_guard([&]{
+		xlog_tx_cursor_destroy(&tx_cursor);
+	});
+	struct xrow_header tx_row;
+	while ((rc = xlog_tx_cursor_next_row(&tx_cursor, &tx_row)) == 0)
+		xstream_write_xc(applier->join_stream, &tx_row);
+	if (rc < 0)
+		diag_raise();
+}
+
 /**
  * Execute and process JOIN request (bootstrap the instance).
  */
@@ -293,11 +372,22 @@ applier_join(struct applier *applier)
 	 * Receive initial data.
 	 */
 	assert(applier->join_stream != NULL);
+	/* Decompresses snapshot blocks, see IPROTO_XLOG_TX. */
+	ZSTD_DStream *zdctx = ZSTD_createDStream();
+	if (zdctx == NULL) {
+		tnt_raise(ClientError, ER_COMPRESSION,
+			  "failed to create context");
+	}
+	auto zdctx_guard = make_scoped_guard([=]{
+		ZSTD_freeDStream(zdctx);
+	});
 	while (true) {
 		coio_read_xrow(coio, ibuf, &row);
 		applier->last_row_time = ev_monotonic_now(loop());
 		if (iproto_type_is_dml(row.type)) {
 			xstream_write_xc(applier->join_stream, &row);
+		} else if (row.type == IPROTO_XLOG_TX) {
+			applier_apply_xlog_tx(applier, &row, zdctx);
 		} else if (row.type == IPROTO_OK) {
 			if (applier->version_id < version_id(1, 7, 0)) {
 				/*
@@ -358,6 +448,518 @@ applier_join(struct applier *applier)
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/**
+ * Max number of rows an applier may have dispatched to worker
+ * fibers, but not applied yet.
+ */
+enum { APPLIER_INFLIGHT_MAX = 1024 };
+
+/** A row queued to a worker fiber. */
+struct applier_job {
+	/** Link in applier_worker::queue. */
+	struct stailq_entry in_queue;
+	/** Applier that received the row. */
+	struct applier *applier;
+	/** Position of the row among rows written to WAL. */
+	struct applier_pending pending;
+	/** The row. Its body is stored right after this struct. */
+	struct xrow_header row;
+};
+
+/** A fiber applying rows received by an applier. */
+struct applier_worker {
+	/** Applier this worker belongs to. */
+	struct applier *applier;
+	/** Worker fiber. */
+	struct fiber *fiber;
+	/** Rows to apply, in the order they were received. */
+	struct stailq queue;
+	/** Signaled when a row is queued or the worker is stopped. */
+	struct fiber_cond cond;
+	/** Set to make the worker exit once its queue is empty. */
+	bool is_stopped;
+};
+
+/**
+ * Promote the replica set vclock to a row and line the row up
+ * to be written to WAL after all rows of the same origin that
+ * have been promoted before it, whichever applier received them.
+ */
+static void
+applier_promote(struct applier_pending *pending,
+		const struct xrow_header *row)
+{
+	struct replicaset_order *order =
+		&replicaset.applier.order[row->replica_id];
+	vclock_follow(&replicaset.vclock, row->replica_id, row->lsn);
+	pending->replica_id = row->replica_id;
+	pending->lsn = row->lsn;
+	pending->ticket = order->next_ticket++;
+	pending->turn_taken = false;
+	rlist_add_tail_entry(&order->pending, pending, in_pending);
+}
+
+/** Wait until it's the turn of a row to be submitted to WAL. */
+static void
+applier_wait_turn(struct applier_pending *pending)
+{
+	assert(!pending->turn_taken);
+	struct replicaset_order *order =
+		&replicaset.applier.order[pending->replica_id];
+	while (order->turn != pending->ticket)
+		fiber_cond_wait(&replicaset.applier.order_cond);
+}
+
+/**
+ * Pass the turn to the next row of the same origin. Fibers
+ * woken up by this function don't run until the current fiber
+ * yields, so if the row has been prepared, it is queued to WAL
+ * before the next one.
+ */
+static void
+applier_pass_turn(struct applier_pending *pending)
+{
+	struct replicaset_order *order =
+		&replicaset.applier.order[pending->replica_id];
+	assert(order->turn == pending->ticket);
+	order->turn++;
+	pending->turn_taken = true;
+	fiber_cond_broadcast(&replicaset.applier.order_cond);
+}
+
+/**
+ * Forget a row that has been written to WAL or has failed
+ * to apply.
+ */
+static void
+applier_complete(struct applier_pending *pending)
+{
+	/* The row failed before it was submitted to WAL. */
+	if (!pending->turn_taken) {
+		applier_wait_turn(pending);
+		applier_pass_turn(pending);
+	}
+	rlist_del_entry(pending, in_pending);
+}
+
+static void
+applier_job_on_prepare(struct trigger *trigger, void *event)
+{
+	(void) event;
+	struct applier_job *job = (struct applier_job *) trigger->data;
+	applier_wait_turn(&job->pending);
+	applier_pass_turn(&job->pending);
+}
+
+/**
+ * Apply a row queued to a worker. The row is applied in an
+ * explicit transaction so that it can wait for its turn to be
+ * written to WAL after it has been prepared by the engine.
+ */
+static int
+applier_apply_job(struct applier_job *job)
+{
+	struct trigger on_prepare;
+	trigger_create(&on_prepare, applier_job_on_prepare, job, NULL);
+	struct txn *txn = txn_begin(false);
+	if (txn == NULL)
+		return -1;
+	txn_on_prepare(txn, &on_prepare);
+	try {
+		xstream_write_xc(job->applier->subscribe_stream, &job->row);
+	} catch (Exception *) {
+		txn_rollback();
+		return -1;
+	}
+	return txn_commit(txn);
+}
+
+static int
+applier_worker_f(va_list ap)
+{
+	struct applier_worker *worker = va_arg(ap, struct applier_worker *);
+	struct applier *applier = worker->applier;
+	/* See applier_f(). */
+	current_session()->type = SESSION_TYPE_APPLIER;
+
+	while (!worker->is_stopped || !stailq_empty(&worker->queue)) {
+		if (stailq_empty(&worker->queue)) {
+			fiber_cond_wait(&worker->cond);
+			continue;
+		}
+		struct applier_job *job = stailq_shift_entry(&worker->queue,
+					struct applier_job, in_queue);
+		if (applier_apply_job(job) != 0) {
+			/*
+			 * Like in case the reader fails to apply
+			 * a row, the row is skipped on reconnect,
+			 * because the replica set vclock has already
+			 * been promoted. Rows dispatched after it
+			 * are still applied.
+			 */
+			if (diag_is_empty(&applier->apply_diag))
+				diag_move(diag_get(), &applier->apply_diag);
+			diag_clear(diag_get());
+		}
+		applier_complete(&job->pending);
+		free(job);
+		applier->apply_inflight--;
+		fiber_cond_broadcast(&applier->apply_cond);
+		/* Acknowledge the row to the master. */
+		fiber_cond_signal(&applier->writer_cond);
+		fiber_gc();
+	}
+	return 0;
+}
+
+/**
+ * Start replication_apply_fibers worker fibers, unless rows
+ * are configured to be applied one by one.
+ */
+static void
+applier_start_workers(struct applier *applier)
+{
+	assert(applier->workers == NULL);
+	int count = replication_apply_fibers;
+	if (count <= 1)
+		return;
+	size_t size = count * sizeof(*applier->workers);
+	applier->workers = (struct applier_worker *) calloc(1, size);
+	if (applier->workers == NULL) {
+		tnt_raise(OutOfMemory, size, "malloc",
+			  "struct applier_worker");
+	}
+	applier->worker_count = 0;
+	applier->apply_inflight = 0;
+	for (int i = 0; i < count; i++) {
+		struct applier_worker *worker = &applier->workers[i];
+		char name[FIBER_NAME_MAX];
+		int pos = snprintf(name, sizeof(name), "applier%d/", i);
+		uri_format(name + pos, sizeof(name) - pos,
+			   &applier->uri, false);
+		worker->applier = applier;
+		worker->fiber = fiber_new_xc(name, applier_worker_f);
+		stailq_create(&worker->queue);
+		fiber_cond_create(&worker->cond);
+		worker->is_stopped = false;
+		applier->worker_count++;
+		fiber_set_joinable(worker->fiber, true);
+		fiber_start(worker->fiber, worker);
+	}
+}
+
+/**
+ * Wait until all rows queued to workers have been applied
+ * and stop the workers.
+ */
+static void
+applier_stop_workers(struct applier *applier)
+{
+	if (applier->workers == NULL)
+		return;
+	bool cancellable = fiber_set_cancellable(false);
+	for (int i = 0; i < applier->worker_count; i++) {
+		struct applier_worker *worker = &applier->workers[i];
+		worker->is_stopped = true;
+		fiber_cond_signal(&worker->cond);
+	}
+	for (int i = 0; i < applier->worker_count; i++) {
+		struct applier_worker *worker = &applier->workers[i];
+		fiber_join(worker->fiber);
+		fiber_cond_destroy(&worker->cond);
+	}
+	fiber_set_cancellable(cancellable);
+	assert(applier->apply_inflight == 0);
+	free(applier->workers);
+	applier->workers = NULL;
+	applier->worker_count = 0;
+	diag_clear(&applier->apply_diag);
+}
+
+/** Raise the error a worker failed to apply a row with, if any. */
+static void
+applier_check_workers(struct applier *applier)
+{
+	if (!diag_is_empty(&applier->apply_diag)) {
+		diag_move(&applier->apply_diag, diag_get());
+		diag_raise();
+	}
+}
+
+/**
+ * Check if a row may be applied concurrently with rows that
+ * modify other keys and, if it may, compute the hash of the
+ * primary key it modifies.
+ */
+static bool
+applier_row_key_hash(struct xrow_header *row, uint32_t *hash)
+{
+	switch (row->type) {
+	case IPROTO_INSERT:
+	case IPROTO_REPLACE:
+	case IPROTO_UPSERT:
+	case IPROTO_DELETE:
+	case IPROTO_UPDATE:
+		break;
+	default:
+		return false;
+	}
+	struct request request;
+	if (xrow_decode_dml(row, &request,
+			    dml_request_key_map(row->type)) != 0) {
+		diag_clear(diag_get());
+		return false;
+	}
+	struct space *space = space_by_id(request.space_id);
+	if (space == NULL || space_is_system(space) || request.index_id != 0)
+		return false;
+	/*
+	 * Triggers may access any data, while rows modifying
+	 * different primary keys may still conflict in a unique
+	 * secondary index, so such rows are applied one by one.
+	 */
+	if (!rlist_empty(&space->before_replace) ||
+	    !rlist_empty(&space->on_replace))
+		return false;
+	for (uint32_t i = 1; i < space->index_count; i++) {
+		if (space->index[i]->def->opts.is_unique)
+			return false;
+	}
+	struct index *pk = space_index(space, 0);
+	if (pk == NULL)
+		return false;
+	struct key_def *key_def = pk->def->key_def;
+	const char *key = request.key;
+	if (request.type != IPROTO_DELETE && request.type != IPROTO_UPDATE) {
+		key = NULL;
+		if (tuple_validate_raw(space->format, request.tuple) == 0)
+			key = tuple_extract_key_raw(request.tuple,
+						    request.tuple_end,
+						    key_def, NULL);
+	}
+	uint32_t part_count = key != NULL ? mp_decode_array(&key) : 0;
+	if (key == NULL ||
+	    exact_key_validate(key_def, key, part_count) != 0) {
+		/* Let the reader fail to apply the row and report it. */
+		diag_clear(diag_get());
+		return false;
+	}
+	*hash = key_hash(key, key_def);
+	return true;
+}
+
+/**
+ * Apply a row received from a master.
+ *
+ * If the applier has worker fibers, the row is queued to the
+ * worker chosen by the hash of the key it modifies, so rows
+ * modifying the same key are applied in order, while rows
+ * modifying different keys are applied concurrently. Rows of
+ * each origin are still submitted to WAL in the order of their
+ * LSNs, so rows applied concurrently may be written in one
+ * batch. A row that can't be applied concurrently, e.g. DDL,
+ * is applied by the reader after all rows received before it.
+ */
+static void
+applier_apply_row(struct applier *applier, struct xrow_header *row)
+{
+	uint32_t hash = 0;
+	bool is_async = applier->workers != NULL &&
+			(applier->state == APPLIER_SYNC ||
+			 applier->state == APPLIER_FOLLOW) &&
+			applier_row_key_hash(row, &hash);
+	if (applier->workers != NULL) {
+		int max_inflight = is_async ? APPLIER_INFLIGHT_MAX - 1 : 0;
+		while (applier->apply_inflight > max_inflight) {
+			fiber_cond_wait(&applier->apply_cond);
+			fiber_testcancel();
+		}
+		applier_check_workers(applier);
+	}
+	/*
+	 * Check the vclock after waiting for workers, since
+	 * another applier may apply the row in the meantime.
+	 */
+	if (vclock_get(&replicaset.vclock, row->replica_id) >= row->lsn)
+		return;
+	/**
+	 * Promote the replica set vclock before
+	 * applying the row. If there is an
+	 * exception (conflict) applying the row,
+	 * the row is skipped when the replication
+	 * is resumed.
+	 */
+	if (!is_async) {
+		/*
+		 * Keep the turn until the row has been written,
+		 * since the row may yield before it is submitted
+		 * to WAL.
+		 */
+		struct applier_pending pending;
+		applier_promote(&pending, row);
+		auto pending_guard = make_scoped_guard([&] {
+			applier_complete(&pending);
+		});
+		applier_wait_turn(&pending);
+		xstream_write_xc(applier->subscribe_stream, row);
+		return;
+	}
+	assert(row->bodycnt == 1);
+	size_t size = sizeof(struct applier_job) + row->body[0].iov_len;
+	struct applier_job *job = (struct applier_job *) malloc(size);
+	if (job == NULL)
+		tnt_raise(OutOfMemory, size, "malloc", "struct applier_job");
+	applier_promote(&job->pending, row);
+	job->applier = applier;
+	job->row = *row;
+	job->row.body[0].iov_base = job + 1;
+	memcpy(job->row.body[0].iov_base, row->body[0].iov_base,
+	       row->body[0].iov_len);
+	struct applier_worker *worker =
+		&applier->workers[hash % applier->worker_count];
+	stailq_add_tail_entry(&worker->queue, job, in_queue);
+	applier->apply_inflight++;
+	fiber_cond_signal(&worker->cond);
+}
+
+/**
+ * Switch the applier to decompressing the data received from
+ * the master. Called when the master confirms it compresses
+ * the rows it sends in response to SUBSCRIBE.
+ */
+static void
+applier_enable_compression(struct applier *applier)
+{
+	assert(applier->zdctx == NULL);
+	applier->zdctx = ZSTD_createDStream();
+	if (applier->zdctx == NULL) {
+		tnt_raise(ClientError, ER_DECOMPRESSION,
+			  "failed to create context");
+	}
+	size_t rc = ZSTD_initDStream(applier->zdctx);
+	if (ZSTD_isError(rc))
+		tnt_raise(ClientError, ER_DECOMPRESSION, ZSTD_getErrorName(rc));
+	/*
+	 * Data read ahead after the response to SUBSCRIBE
+	 * is already compressed.
+	 */
+	struct ibuf *ibuf = &applier->ibuf;
+	struct ibuf *zbuf = &applier->zbuf;
+	size_t size = ibuf_used(ibuf);
+	if (size > 0) {
+		ibuf_reserve_xc(zbuf, size);
+		memcpy(zbuf->wpos, ibuf->rpos, size);
+		zbuf->wpos += size;
+	}
+	ibuf_reset(ibuf);
+}
+
+/**
+ * Switch the applier back to reading data received from the
+ * master as is. Called when the compressed stream ends, which
+ * happens when the relay exits. Data received after the end
+ * of the stream, such as the error that stopped the relay,
+ * is not compressed.
+ */
+static void
+applier_disable_compression(struct applier *applier)
+{
+	assert(applier->zdctx != NULL);
+	ZSTD_freeDStream(applier->zdctx);
+	applier->zdctx = NULL;
+	struct ibuf *ibuf = &applier->ibuf;
+	struct ibuf *zbuf = &applier->zbuf;
+	size_t size = ibuf_used(zbuf);
+	if (size > 0) {
+		ibuf_reserve_xc(ibuf, size);
+		memcpy(ibuf->wpos, zbuf->rpos, size);
+		ibuf->wpos += size;
+	}
+	ibuf_reset(zbuf);
+}
+
+/**
+ * Decompress data received from the master to the input
+ * buffer until there are at least @size bytes in it. If the
+ * compressed stream ends, the rest is read as is.
+ */
+static void
+applier_decompress(struct applier *applier, size_t size,
+		   ev_tstamp start, ev_tstamp *delay)
+{
+	struct ibuf *ibuf = &applier->ibuf;
+	struct ibuf *zbuf = &applier->zbuf;
+	while (ibuf_used(ibuf) < size) {
+		if (applier->zdctx == NULL) {
+			coio_breadn_timeout(&applier->io, ibuf,
+					    size - ibuf_used(ibuf), *delay);
+			coio_timeout_update(start, delay);
+			continue;
+		}
+		ibuf_reserve_xc(ibuf, MAX(size - ibuf_used(ibuf),
+					  ZSTD_DStreamOutSize()));
+		ZSTD_inBuffer input = {zbuf->rpos, ibuf_used(zbuf), 0};
+		ZSTD_outBuffer output = {ibuf->wpos, ibuf_unused(ibuf), 0};
+		size_t rc = ZSTD_decompressStream(applier->zdctx,
+						  &output, &input);
+		if (ZSTD_isError(rc)) {
+			tnt_raise(ClientError, ER_DECOMPRESSION,
+				  ZSTD_getErrorName(rc));
+		}
+		zbuf->rpos += input.pos;
+		ibuf->wpos += output.pos;
+		if (rc == 0) {
+			/* The compressed stream has ended. */
+			applier_disable_compression(applier);
+			continue;
+		}
+		if (input.pos > 0 || output.pos > 0)
+			continue;
+		/* All received data is decompressed, read more. */
+		if (ibuf_used(zbuf) == 0)
+			ibuf_reset(zbuf);
+		coio_breadn_timeout(&applier->io, zbuf, 1, *delay);
+		coio_timeout_update(start, delay);
+	}
+}
+
+/**
+ * Read a row sent by the master in response to SUBSCRIBE,
+ * decompressing it if necessary.
+ */
+static void
+applier_read_xrow(struct applier *applier, struct xrow_header *row,
+		  ev_tstamp timeout)
+{
+	struct ibuf *ibuf = &applier->ibuf;
+	if (applier->zdctx == NULL) {
+		coio_read_xrow_timeout_xc(&applier->io, ibuf, row, timeout);
+		return;
+	}
+	ev_tstamp start, delay;
+	coio_timeout_init(&start, &delay, timeout);
+	/* Read fixed header */
+	applier_decompress(applier, 1, start, &delay);
+
+	/* Read length */
+	if (mp_typeof(*ibuf->rpos) != MP_UINT) {
+		tnt_raise(ClientError, ER_INVALID_MSGPACK,
+			  "packet length");
+	}
+	ssize_t to_read = mp_check_uint(ibuf->rpos, ibuf->wpos);
+	if (to_read > 0)
+		applier_decompress(applier, ibuf_used(ibuf) + to_read,
+				   start, &delay);
+
+	uint32_t len = mp_decode_uint((const char **) &ibuf->rpos);
+
+	/* Read header and body */
+	applier_decompress(applier, len, start, &delay);
+
+	xrow_header_decode_xc(row, (const char **) &ibuf->rpos,
+			      ibuf->rpos + len);
+}
+
 /**
  * Execute and process SUBSCRIBE request (follow updates from a master).
  */
@@ -372,7 +974,10 @@ applier_subscribe(struct applier *applier)
 	struct xrow_header row;
 
 	xrow_encode_subscribe_xc(&row, &REPLICASET_UUID, &INSTANCE_UUID,
-				 &replicaset.vclock);
+				 &replicaset.vclock,
+				 replication_compression ?
+				 IPROTO_COMPRESSION_ZSTD :
+				 IPROTO_COMPRESSION_NONE);
 	coio_write_xrow(coio, &row);
 
 	if (applier->state == APPLIER_READY) {
@@ -413,7 +1018,19 @@ applier_subscribe(struct applier *applier)
 		 */
 		struct vclock vclock;
 		vclock_create(&vclock);
-		xrow_decode_vclock_xc(&row, &vclock);
+		uint32_t compression;
+		xrow_decode_subscribe_response_xc(&row, &vclock, &compression);
+		/*
+		 * The rows that follow are compressed if the
+		 * master supports compression, and it was
+		 * requested.
+		 */
+		if (compression == IPROTO_COMPRESSION_ZSTD) {
+			applier_enable_compression(applier);
+		} else if (compression != IPROTO_COMPRESSION_NONE) {
+			tnt_raise(ClientError, ER_PROTOCOL,
+				  "Unknown compression of SUBSCRIBE stream");
+		}
 	}
 	/**
 	 * Tarantool < 1.6.7:
@@ -440,6 +1057,11 @@ applier_subscribe(struct applier *applier)
 
 	applier->lag = TIMEOUT_INFINITY;
 
+	auto workers_guard = make_scoped_guard([=] {
+		applier_stop_workers(applier);
+	});
+	applier_start_workers(applier);
+
 	/*
 	 * Process a stream of rows from the binary log.
 	 */
@@ -468,7 +1090,7 @@ applier_subscribe(struct applier *applier)
 			coio_read_xrow(coio, ibuf, &row);
 		} else {
 			double timeout = replication_disconnect_timeout();
-			coio_read_xrow_timeout_xc(coio, ibuf, &row, timeout);
+			applier_read_xrow(applier, &row, timeout);
 		}
 
 		if (iproto_type_is_error(row.type))
@@ -488,18 +1110,8 @@ applier_subscribe(struct applier *applier)
 		applier->lag = ev_now(loop()) - row.tm;
 		applier->last_row_time = ev_monotonic_now(loop());
 
-		if (vclock_get(&replicaset.vclock, row.replica_id) < row.lsn) {
-			/**
-			 * Promote the replica set vclock before
-			 * applying the row. If there is an
-			 * exception (conflict) applying the row,
-			 * the row is skipped when the replication
-			 * is resumed.
-			 */
-			vclock_follow(&replicaset.vclock, row.replica_id,
-				      row.lsn);
-			xstream_write_xc(applier->subscribe_stream, &row);
-		}
+		if (vclock_get(&replicaset.vclock, row.replica_id) < row.lsn)
+			applier_apply_row(applier, &row);
 		if (applier->state == APPLIER_SYNC ||
 		    applier->state == APPLIER_FOLLOW)
 			fiber_cond_signal(&applier->writer_cond);
@@ -522,6 +1134,11 @@ applier_disconnect(struct applier *applier, enum applier_state state)
 	coio_close(loop(), &applier->io);
 	/* Clear all unparsed input. */
 	ibuf_reinit(&applier->ibuf);
+	ibuf_reinit(&applier->zbuf);
+	if (applier->zdctx != NULL) {
+		ZSTD_freeDStream(applier->zdctx);
+		applier->zdctx = NULL;
+	}
 	fiber_gc();
 }
 
@@ -662,6 +1279,7 @@ applier_new(const char *uri, struct xstream *join_stream,
 	}
 	coio_create(&applier->io, -1);
 	ibuf_create(&applier->ibuf, &cord()->slabc, 1024);
+	ibuf_create(&applier->zbuf, &cord()->slabc, 1024);
 
 	/* uri_parse() sets pointers to applier->source buffer */
 	snprintf(applier->source, sizeof(applier->source), "%s", uri);
@@ -676,6 +1294,8 @@ applier_new(const char *uri, struct xstream *join_stream,
 	rlist_create(&applier->on_state);
 	fiber_cond_create(&applier->resume_cond);
 	fiber_cond_create(&applier->writer_cond);
+	fiber_cond_create(&applier->apply_cond);
+	diag_create(&applier->apply_diag);
 
 	return applier;
 }
@@ -685,10 +1305,14 @@ applier_delete(struct applier *applier)
 {
 	assert(applier->reader == NULL && applier->writer == NULL);
 	ibuf_destroy(&applier->ibuf);
+	ibuf_destroy(&applier->zbuf);
 	assert(applier->io.fd == -1);
+	assert(applier->zdctx == NULL);
 	trigger_destroy(&applier->on_state);
 	fiber_cond_destroy(&applier->resume_cond);
 	fiber_cond_destroy(&applier->writer_cond);
+	fiber_cond_destroy(&applier->apply_cond);
+	diag_destroy(&applier->apply_diag);
 	free(applier);
 }
 
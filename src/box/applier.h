@@ -36,16 +36,19 @@
 #include <tarantool_ev.h>
 
 #include <small/ibuf.h>
+#include <zstd.h>
 
 #include "fiber_cond.h"
 #include "trigger.h"
 #include "trivia/util.h"
+#include "diag.h"
 #include "tt_uuid.h"
 #include "uri.h"
 
 #include "vclock.h"
 
 struct xstream;
+struct applier_worker;
 
 enum { APPLIER_SOURCE_MAXLEN = 1024 }; /* enough to fit URI with passwords */
 
@@ -106,6 +109,14 @@ struct applier {
 	struct ev_io io;
 	/** Input buffer */
 	struct ibuf ibuf;
+	/**
+	 * Context decompressing the rows the master sends in
+	 * response to SUBSCRIBE to @ibuf, or NULL if the rows
+	 * are not compressed, see enum iproto_compression.
+	 */
+	ZSTD_DStream *zdctx;
+	/** Input buffer for data compressed by the master. */
+	struct ibuf zbuf;
 	/** Triggers invoked on state change */
 	struct rlist on_state;
 	/**
@@ -119,6 +130,20 @@ struct applier {
 	struct xstream *join_stream;
 	/** xstream to process rows during final JOIN and SUBSCRIBE */
 	struct xstream *subscribe_stream;
+	/**
+	 * Fibers applying rows concurrently in SUBSCRIBE mode,
+	 * see replication_apply_fibers. NULL if rows are applied
+	 * by the reader fiber one by one.
+	 */
+	struct applier_worker *workers;
+	/** Number of fibers in the workers array. */
+	int worker_count;
+	/** Number of rows dispatched to workers, but not applied yet. */
+	int apply_inflight;
+	/** Signaled when apply_inflight changes. */
+	struct fiber_cond apply_cond;
+	/** The first error a worker failed to apply a row with. */
+	struct diag apply_diag;
 };
 
 /**
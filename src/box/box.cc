@@ -46,6 +46,7 @@
 #include <rmean.h>
 #include "main.h"
 #include "tuple.h"
+#include "tuple_convert.h"
 #include "session.h"
 #include "schema.h"
 #include "engine.h"
@@ -421,6 +422,17 @@ box_check_replication_sync_lag(void)
 	return lag;
 }
 
+static int
+box_check_replication_apply_fibers(void)
+{
+	int count = cfg_geti("replication_apply_fibers");
+	if (count <= 0) {
+		tnt_raise(ClientError, ER_CFG, "replication_apply_fibers",
+			  "the value must be greater than 0");
+	}
+	return count;
+}
+
 static void
 box_check_instance_uuid(struct tt_uuid *uuid)
 {
@@ -491,6 +503,41 @@ box_check_wal_max_size(int64_t wal_max_size)
 	return wal_max_size;
 }
 
+static double
+box_check_wal_group_commit_delay(void)
+{
+	double delay = cfg_getd("wal_group_commit_delay");
+	if (delay < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_delay",
+			  "the value must not be negative");
+	}
+	return delay;
+}
+
+static int64_t
+box_check_wal_group_commit_min_size(void)
+{
+	int64_t min_size = cfg_geti64("wal_group_commit_min_size");
+	if (min_size < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_min_size",
+			  "the value must not be negative");
+	}
+	return min_size;
+}
+
+static int
+box_check_iproto_threads(void)
+{
+	int threads = cfg_geti("iproto_threads");
+	if (threads < 1 || threads > IPROTO_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "iproto_threads",
+			  tt_sprintf("must be greater than or equal to 1 "
+				     "and less than or equal to %d",
+				     IPROTO_THREADS_MAX));
+	}
+	return threads;
+}
+
 static void
 box_check_vinyl_options(void)
 {
@@ -547,11 +594,15 @@ box_check_config()
 	box_check_replication_connect_timeout();
 	box_check_replication_connect_quorum();
 	box_check_replication_sync_lag();
+	box_check_replication_apply_fibers();
 	box_check_readahead(cfg_geti("readahead"));
+	box_check_iproto_threads();
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
 	box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
+	box_check_wal_group_commit_delay();
+	box_check_wal_group_commit_min_size();
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
 	box_check_vinyl_options();
 }
@@ -638,6 +689,18 @@ box_set_replication_timeout(void)
 	replication_timeout = box_check_replication_timeout();
 }
 
+void
+box_set_replication_apply_fibers(void)
+{
+	replication_apply_fibers = box_check_replication_apply_fibers();
+}
+
+void
+box_set_replication_compression(void)
+{
+	replication_compression = cfg_geti("replication_compression") != 0;
+}
+
 void
 box_set_replication_connect_timeout(void)
 {
@@ -732,6 +795,15 @@ box_set_checkpoint_count(void)
 	gc_set_checkpoint_count(checkpoint_count);
 }
 
+void
+box_set_wal_group_commit(void)
+{
+	double delay = box_check_wal_group_commit_delay();
+	int64_t min_size = box_check_wal_group_commit_min_size();
+	wal_set_group_commit(delay, min_size,
+			     cfg_geti("wal_group_commit_adaptive") != 0);
+}
+
 void
 box_set_vinyl_max_tuple_size(void)
 {
@@ -751,6 +823,35 @@ box_set_vinyl_cache(void)
 	vinyl_engine_set_cache(vinyl, cfg_geti64("vinyl_cache"));
 }
 
+void
+box_set_vinyl_page_cache(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_page_cache(vinyl, cfg_geti64("vinyl_page_cache"));
+}
+
+void
+box_set_vinyl_write_rate_limit(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_write_rate_limit(vinyl,
+			cfg_getd("vinyl_write_rate_limit"));
+}
+
+void
+box_set_vinyl_read_latency_target(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_read_latency_target(vinyl,
+			cfg_getd("vinyl_read_latency_target"));
+}
+
 void
 box_set_vinyl_timeout(void)
 {
@@ -897,13 +998,78 @@ box_process1(struct request *request, box_tuple_t **result)
 }
 
 int
-box_select(uint32_t space_id, uint32_t index_id,
-	   int iterator, uint32_t offset, uint32_t limit,
-	   const char *key, const char *key_end,
-	   struct port *port)
+box_process_batch(struct request *request,
+		  int (*on_error)(uint32_t row_no, void *arg), void *arg)
 {
-	(void)key_end;
+	assert(iproto_type_is_batch(request->type));
+	struct space *space = space_cache_find(request->space_id);
+	if (space == NULL)
+		return -1;
+	if (!space->def->opts.temporary && box_check_writable() != 0)
+		return -1;
+	/* The body is valid MsgPack, but its type isn't checked. */
+	if (mp_typeof(*request->tuple) != MP_ARRAY) {
+		diag_set(ClientError, ER_TUPLE_NOT_ARRAY);
+		return -1;
+	}
+	if (box_txn_begin() != 0)
+		return -1;
+
+	struct request row;
+	memset(&row, 0, sizeof(row));
+	row.type = request->type == IPROTO_INSERT_BATCH ?
+		   IPROTO_INSERT : IPROTO_REPLACE;
+	row.space_id = request->space_id;
+	const char *data = request->tuple;
+	uint32_t count = mp_decode_array(&data);
+	for (uint32_t i = 0; i < count; i++) {
+		bool is_array = mp_typeof(*data) == MP_ARRAY;
+		row.tuple = data;
+		mp_next(&data);
+		row.tuple_end = data;
+		/*
+		 * The space may be altered while vinyl yields,
+		 * look it up again.
+		 */
+		space = space_cache_find(request->space_id);
+		if (space == NULL)
+			goto rollback;
+		int rc;
+		if (!is_array) {
+			diag_set(ClientError, ER_TUPLE_NOT_ARRAY);
+			rc = -1;
+		} else {
+			/*
+			 * A failed statement is rolled back alone,
+			 * the transaction goes on.
+			 */
+			rc = process_rw(&row, space, NULL);
+		}
+		if (rc != 0 && on_error(i + 1, arg) != 0)
+			goto rollback;
+	}
+	/* All rows go to WAL in one journal entry. */
+	return box_txn_commit();
+rollback:
+	txn_rollback();
+	return -1;
+}
 
+/**
+ * Iterate over tuples matching a SELECT request and pass each
+ * of them to @a cb. Common part of box_select() and
+ * box_select_to_obuf().
+ *
+ * @param[out] p_count Number of tuples passed to @a cb.
+ * @retval  0 Success.
+ * @retval -1 Error, diag is set.
+ */
+static int
+box_select_foreach(uint32_t space_id, uint32_t index_id,
+		   int iterator, uint32_t offset, uint32_t limit,
+		   const char *key, int (*cb)(struct tuple *, void *),
+		   void *cb_arg, uint32_t *p_count)
+{
 	rmean_collect(rmean_box, IPROTO_SELECT, 1);
 
 	if (iterator < 0 || iterator >= iterator_type_MAX) {
@@ -946,7 +1112,6 @@ box_select(uint32_t space_id, uint32_t index_id,
 	int rc = 0;
 	uint32_t found = 0;
 	struct tuple *tuple;
-	port_tuple_create(port);
 	while (found < limit) {
 		rc = iterator_next(it, &tuple);
 		if (rc != 0 || tuple == NULL)
@@ -955,7 +1120,7 @@ box_select(uint32_t space_id, uint32_t index_id,
 			offset--;
 			continue;
 		}
-		rc = port_tuple_add(port, tuple);
+		rc = cb(tuple, cb_arg);
 		if (rc != 0)
 			break;
 		found++;
@@ -963,14 +1128,96 @@ box_select(uint32_t space_id, uint32_t index_id,
 	iterator_delete(it);
 
 	if (rc != 0) {
-		port_destroy(port);
 		txn_rollback_stmt();
 		return -1;
 	}
 	txn_commit_ro_stmt(txn);
+	*p_count = found;
 	return 0;
 }
 
+static int
+box_select_add_to_port(struct tuple *tuple, void *arg)
+{
+	return port_tuple_add((struct port *) arg, tuple);
+}
+
+int
+box_select(uint32_t space_id, uint32_t index_id,
+	   int iterator, uint32_t offset, uint32_t limit,
+	   const char *key, const char *key_end,
+	   struct port *port)
+{
+	(void)key_end;
+
+	uint32_t count;
+	port_tuple_create(port);
+	if (box_select_foreach(space_id, index_id, iterator, offset, limit,
+			       key, box_select_add_to_port, port,
+			       &count) != 0) {
+		port_destroy(port);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+box_select_add_to_obuf(struct tuple *tuple, void *arg)
+{
+	if (tuple_to_obuf(tuple, (struct obuf *) arg) != 0)
+		return -1;
+	ERROR_INJECT(ERRINJ_PORT_DUMP, {
+		diag_set(OutOfMemory, tuple_size(tuple), "obuf_dup", "data");
+		return -1;
+	});
+	return 0;
+}
+
+int
+box_select_to_obuf(uint32_t space_id, uint32_t index_id,
+		   int iterator, uint32_t offset, uint32_t limit,
+		   const char *key, const char *key_end,
+		   struct obuf *out, struct obuf_svp *svp)
+{
+	struct space *space = space_by_id(space_id);
+	if (space == NULL || !space_is_memtx(space)) {
+		/*
+		 * Iterators of other engines may yield, and
+		 * another request could write to the output
+		 * buffer meanwhile, so collect the tuples in
+		 * a port and encode them all at once.
+		 */
+		struct port port;
+		if (box_select(space_id, index_id, iterator, offset, limit,
+			       key, key_end, &port) != 0)
+			return -1;
+		if (iproto_prepare_select(out, svp) != 0) {
+			port_destroy(&port);
+			return -1;
+		}
+		int count = port_dump_16(&port, out);
+		port_destroy(&port);
+		if (count < 0)
+			obuf_rollback_to_svp(out, svp);
+		return count;
+	}
+	/*
+	 * Memtx iterators never yield so tuples can be encoded
+	 * right as they are found, without referencing them
+	 * and allocating port entries.
+	 */
+	if (iproto_prepare_select(out, svp) != 0)
+		return -1;
+	uint32_t count;
+	if (box_select_foreach(space_id, index_id, iterator, offset, limit,
+			       key, box_select_add_to_obuf, out,
+			       &count) != 0) {
+		obuf_rollback_to_svp(out, svp);
+		return -1;
+	}
+	return count;
+}
+
 int
 box_insert(uint32_t space_id, const char *tuple, const char *tuple_end,
 	   box_tuple_t **result)
@@ -1256,7 +1503,7 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 *
 	 * Replica => Master
 	 *
-	 * => JOIN { INSTANCE_UUID: replica_uuid }
+	 * => JOIN { INSTANCE_UUID: replica_uuid, JOIN_XLOG_TX: true }
 	 * <= OK { VCLOCK: start_vclock }
 	 *    Replica has enough permissions and master is ready for JOIN.
 	 *     - start_vclock - vclock of the latest master's checkpoint.
@@ -1266,6 +1513,8 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 *    Initial data: a stream of engine-specifc rows, e.g. snapshot
 	 *    rows for memtx or dirty cursor data for Vinyl. Engine can
 	 *    use REPLICA_ID, LSN and other fields for internal purposes.
+	 *    Snapshot blocks of memtx are sent as is in XLOG_TX rows
+	 *    if the replica has set JOIN_XLOG_TX, see IPROTO_XLOG_TX.
 	 *    ...
 	 * <= INSERT
 	 * <= OK { VCLOCK: stop_vclock } - end of initial JOIN stage.
@@ -1295,7 +1544,8 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 
 	/* Decode JOIN request */
 	struct tt_uuid instance_uuid = uuid_nil;
-	xrow_decode_join_xc(header, &instance_uuid);
+	bool xlog_tx;
+	xrow_decode_join_xc(header, &instance_uuid, &xlog_tx);
 
 	/* Check that bootstrap has been finished */
 	if (!is_box_configured)
@@ -1357,7 +1607,7 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	/*
 	 * Initial stream: feed replica with dirty data from engines.
 	 */
-	relay_initial_join(io->fd, header->sync, &start_vclock);
+	relay_initial_join(io->fd, header->sync, &start_vclock, xlog_tx);
 	say_info("initial data sent.");
 
 	/**
@@ -1409,9 +1659,11 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	struct tt_uuid replicaset_uuid = uuid_nil, replica_uuid = uuid_nil;
 	struct vclock replica_clock;
 	uint32_t replica_version_id;
+	uint32_t compression;
 	vclock_create(&replica_clock);
 	xrow_decode_subscribe_xc(header, &replicaset_uuid, &replica_uuid,
-				 &replica_clock, &replica_version_id);
+				 &replica_clock, &replica_version_id,
+				 &compression);
 
 	/* Forbid connection to itself */
 	if (tt_uuid_is_equal(&replica_uuid, &INSTANCE_UUID))
@@ -1446,6 +1698,14 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 			  "wal_mode = 'none'");
 	}
 
+	/*
+	 * Compress the rows sent to the replica if it asks
+	 * for it and the method is known to us. Let the replica
+	 * know which method is used in the response.
+	 */
+	if (compression != IPROTO_COMPRESSION_ZSTD)
+		compression = IPROTO_COMPRESSION_NONE;
+
 	/*
 	 * Send a response to SUBSCRIBE request, tell
 	 * the replica how many rows we have in stock for it,
@@ -1454,7 +1714,7 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	struct xrow_header row;
 	struct vclock current_vclock;
 	wal_checkpoint(&current_vclock, true);
-	xrow_encode_vclock_xc(&row, &current_vclock);
+	xrow_encode_subscribe_response_xc(&row, &current_vclock, compression);
 	/*
 	 * Identify the message with the replica id of this
 	 * instance, this is the only way for a replica to find
@@ -1479,7 +1739,7 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	 * indefinitely).
 	 */
 	relay_subscribe(io->fd, header->sync, replica, &replica_clock,
-			replica_version_id);
+			replica_version_id, compression);
 }
 
 /** Insert a new cluster into _schema */
@@ -1556,7 +1816,10 @@ engine_init()
 	engine_register((struct engine *)vinyl);
 	box_set_vinyl_max_tuple_size();
 	box_set_vinyl_cache();
+	box_set_vinyl_page_cache();
 	box_set_vinyl_timeout();
+	box_set_vinyl_write_rate_limit();
+	box_set_vinyl_read_latency_target();
 }
 
 /**
@@ -1730,7 +1993,7 @@ box_cfg_xc(void)
 	schema_init();
 	replication_init();
 	port_init();
-	iproto_init();
+	iproto_init(box_check_iproto_threads());
 	wal_thread_start();
 
 	title("loading");
@@ -1745,6 +2008,8 @@ box_cfg_xc(void)
 	box_set_replication_connect_timeout();
 	box_set_replication_connect_quorum();
 	replication_sync_lag = box_check_replication_sync_lag();
+	box_set_replication_apply_fibers();
+	box_set_replication_compression();
 	xstream_create(&join_stream, apply_initial_join_row);
 	xstream_create(&subscribe_stream, apply_row);
 
@@ -1912,6 +2177,7 @@ box_cfg_xc(void)
 	enum wal_mode wal_mode = box_check_wal_mode(cfg_gets("wal_mode"));
 	wal_init(wal_mode, cfg_gets("wal_dir"), &INSTANCE_UUID,
 		 &replicaset.vclock, wal_max_rows, wal_max_size);
+	box_set_wal_group_commit();
 
 	rmean_cleanup(rmean_box);
 
@@ -2044,6 +2310,7 @@ box_reset_stat(void)
 {
 	rmean_cleanup(rmean_box);
 	rmean_cleanup(rmean_error);
+	wal_reset_stat();
 	engine_reset_stat();
 	space_foreach(box_reset_space_stat, NULL);
 }
@@ -48,6 +48,7 @@ struct port;
 struct request;
 struct xrow_header;
 struct obuf;
+struct obuf_svp;
 struct ev_io;
 struct auth_request;
 
@@ -176,12 +177,34 @@ void box_set_too_long_threshold(void);
 void box_set_readahead(void);
 void box_set_checkpoint_count(void);
 void box_set_memtx_max_tuple_size(void);
+void box_set_wal_group_commit(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
+void box_set_vinyl_page_cache(void);
 void box_set_vinyl_timeout(void);
+void box_set_vinyl_write_rate_limit(void);
+void box_set_vinyl_read_latency_target(void);
 void box_set_replication_timeout(void);
+void box_set_replication_apply_fibers(void);
+void box_set_replication_compression(void);
 void box_set_replication_connect_quorum(void);
 
+/**
+ * Execute a SELECT request and encode the result into @a out
+ * as an IPROTO_SELECT reply body, with the reply header space
+ * reserved at @a svp (see iproto_prepare_select()). Tuples of
+ * memtx spaces are encoded right as they are found, without
+ * collecting them in a port first.
+ *
+ * @return number of encoded tuples or -1 on error, diag is set
+ *         and @a out is left intact.
+ */
+int
+box_select_to_obuf(uint32_t space_id, uint32_t index_id,
+		   int iterator, uint32_t offset, uint32_t limit,
+		   const char *key, const char *key_end,
+		   struct obuf *out, struct obuf_svp *svp);
+
 extern "C" {
 #endif /* defined(__cplusplus) */
 
@@ -388,6 +411,21 @@ box_sequence_reset(uint32_t seq_id);
 int
 box_process1(struct request *request, box_tuple_t **result);
 
+/**
+ * Execute an INSERT_BATCH or REPLACE_BATCH request: insert or
+ * replace every tuple of the request->tuple array in one
+ * transaction, so that the whole batch is written to WAL at
+ * once. A row which fails is skipped, and @a on_error is called
+ * with its 1-based number and the error in the diagnostics area.
+ * The callback may abort the batch by returning -1.
+ *
+ * @retval  0 Success, the transaction is committed.
+ * @retval -1 Error, the transaction is rolled back.
+ */
+int
+box_process_batch(struct request *request,
+		  int (*on_error)(uint32_t row_no, void *arg), void *arg);
+
 int
 boxk(int type, uint32_t space_id, const char *format, ...);
 
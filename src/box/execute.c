@@ -42,6 +42,8 @@
 #include "schema.h"
 #include "port.h"
 #include "memtx_tuple.h"
+#include "session.h"
+#include "sql_stmt_cache.h"
 
 const char *sql_type_strs[] = {
 	NULL,
@@ -262,12 +264,14 @@ error:
 
 	uint32_t map_size = mp_decode_map(&data);
 	request->sql_text = NULL;
+	request->stmt_id = 0;
 	request->bind = NULL;
 	request->bind_count = 0;
 	request->sync = row->sync;
 	for (uint32_t i = 0; i < map_size; ++i) {
 		uint8_t key = *data;
-		if (key != IPROTO_SQL_BIND && key != IPROTO_SQL_TEXT) {
+		if (key != IPROTO_SQL_BIND && key != IPROTO_SQL_TEXT &&
+		    key != IPROTO_STMT_ID) {
 			mp_check(&data, end);   /* skip the key */
 			mp_check(&data, end);   /* skip the value */
 			continue;
@@ -278,11 +282,23 @@ error:
 		if (key == IPROTO_SQL_BIND) {
 			if (sql_bind_list_decode(request, value, region) != 0)
 				return -1;
+		} else if (key == IPROTO_STMT_ID) {
+			if (mp_typeof(*value) != MP_UINT)
+				goto error;
+			uint64_t stmt_id = mp_decode_uint(&value);
+			if (stmt_id > UINT32_MAX) {
+				diag_set(ClientError, ER_SQL_EXECUTE,
+					 "invalid prepared statement id");
+				return -1;
+			}
+			request->stmt_id = stmt_id;
 		} else {
 			request->sql_text = value;
 		}
 	}
-	if (request->sql_text == NULL) {
+	/* EXECUTE may refer to a prepared statement by id. */
+	if (request->sql_text == NULL &&
+	    (row->type != IPROTO_EXECUTE || request->stmt_id == 0)) {
 		diag_set(ClientError, ER_MISSING_REQUEST_FIELD,
 			 iproto_key_name(IPROTO_SQL_TEXT));
 		return -1;
@@ -645,10 +661,35 @@ err_execute:
 	return -1;
 }
 
+/** Execute a statement compiled with PREPARE. */
+static int
+sql_execute_prepared(const struct sql_request *request, struct obuf *out,
+		     struct region *region)
+{
+	sqlite3 *db = sql_get();
+	if (db == NULL) {
+		diag_set(ClientError, ER_LOADING);
+		return -1;
+	}
+	struct sqlite3_stmt *stmt =
+		sql_stmt_cache_acquire(current_session()->id,
+				       request->stmt_id);
+	if (stmt == NULL)
+		return -1;
+	int rc = sql_bind(request, stmt);
+	if (rc == 0)
+		rc = sql_execute_and_encode(db, stmt, out, request->sync,
+					    region);
+	sql_stmt_cache_release(request->stmt_id, stmt);
+	return rc;
+}
+
 int
 sql_prepare_and_execute(const struct sql_request *request, struct obuf *out,
 			struct region *region)
 {
+	if (request->sql_text == NULL)
+		return sql_execute_prepared(request, out, region);
 	const char *sql = request->sql_text;
 	uint32_t len;
 	sql = mp_decode_str(&sql, &len);
@@ -674,3 +715,49 @@ err_stmt:
 	sqlite3_finalize(stmt);
 	return -1;
 }
+
+int
+sql_prepare(const struct sql_request *request, struct obuf *out)
+{
+	const char *sql = request->sql_text;
+	uint32_t len;
+	sql = mp_decode_str(&sql, &len);
+	uint32_t stmt_id;
+	struct sqlite3_stmt *stmt =
+		sql_stmt_cache_prepare(current_session(), sql, len, &stmt_id);
+	if (stmt == NULL)
+		return -1;
+
+	struct obuf_svp header_svp;
+	/* Prepare memory for the iproto header. */
+	if (iproto_prepare_header(out, &header_svp, IPROTO_SQL_HEADER_LEN) != 0)
+		return -1;
+	int bind_count = sqlite3_bind_parameter_count(stmt);
+	if (iproto_reply_map_key(out, 2, IPROTO_SQL_INFO) != 0)
+		goto err_body;
+	int size = mp_sizeof_uint(IPROTO_STMT_ID) + mp_sizeof_uint(stmt_id) +
+		   mp_sizeof_uint(IPROTO_BIND_COUNT) +
+		   mp_sizeof_uint(bind_count);
+	char *buf = obuf_alloc(out, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "obuf_alloc", "buf");
+		goto err_body;
+	}
+	buf = mp_encode_uint(buf, IPROTO_STMT_ID);
+	buf = mp_encode_uint(buf, stmt_id);
+	buf = mp_encode_uint(buf, IPROTO_BIND_COUNT);
+	buf = mp_encode_uint(buf, bind_count);
+	int keys = 1;
+	int column_count = sqlite3_column_count(stmt);
+	if (column_count > 0) {
+		if (sql_get_description(stmt, out, column_count) != 0)
+			goto err_body;
+		keys = 2;
+	}
+	iproto_reply_sql(out, &header_svp, request->sync, schema_version, keys);
+	return 0;
+
+err_body:
+	obuf_rollback_to_svp(out, &header_svp);
+	return -1;
+}
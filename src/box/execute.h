@@ -43,11 +43,16 @@ struct region;
 struct sql_bind;
 struct xrow_header;
 
-/** EXECUTE request. */
+/** EXECUTE or PREPARE request. */
 struct sql_request {
 	uint64_t sync;
 	/** SQL statement text. */
 	const char *sql_text;
+	/**
+	 * Id of a statement compiled with PREPARE. Is used by
+	 * EXECUTE if @sql_text is NULL.
+	 */
+	uint32_t stmt_id;
 	/** Array of parameters. */
 	struct sql_bind *bind;
 	/** Length of the @bind. */
@@ -55,7 +60,7 @@ struct sql_request {
 };
 
 /**
- * Parse the EXECUTE request.
+ * Parse the EXECUTE or PREPARE request.
  * @param row Encoded data.
  * @param[out] request Request to decode to.
  * @param region Allocator.
@@ -107,6 +112,37 @@ int
 sql_prepare_and_execute(const struct sql_request *request, struct obuf *out,
 			struct region *region);
 
+/**
+ * Compile an SQL statement and keep it in the statement cache
+ * for subsequent EXECUTE requests, which refer to it by id.
+ * Response structure:
+ * +----------------------------------------------+
+ * | IPROTO_OK, sync, schema_version   ...        | iproto_header
+ * +----------------------------------------------+---------------
+ * | Body - a map with one or two keys.           |
+ * |                                              |
+ * | IPROTO_BODY: {                               |
+ * |     IPROTO_SQL_INFO: {                       |
+ * |         IPROTO_STMT_ID: number,              |
+ * |         IPROTO_BIND_COUNT: number            |
+ * |     },                                       |
+ * |                                              |
+ * |     IPROTO_METADATA: [                       | only if the
+ * |         {IPROTO_FIELD_NAME: column name1},   | statement
+ * |         ...                                  | returns rows
+ * |     ]                                        |
+ * | }                                            |
+ * +----------------------------------------------+
+ *
+ * @param request IProto request.
+ * @param out Out buffer of the iproto message.
+ *
+ * @retval  0 Success.
+ * @retval -1 Client or memory error.
+ */
+int
+sql_prepare(const struct sql_request *request, struct obuf *out);
+
 #if defined(__cplusplus)
 } /* extern "C" { */
 #include "diag.h"
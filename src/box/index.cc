@@ -38,6 +38,8 @@
 #include "txn.h"
 #include "rmean.h"
 #include "info.h"
+#include "port.h"
+#include "fiber.h"
 
 /* {{{ Utilities. **********************************************/
 
@@ -430,6 +432,78 @@ box_index_info(uint32_t space_id, uint32_t index_id,
 	return 0;
 }
 
+int
+box_index_get_multi(uint32_t space_id, uint32_t index_id, const char *keys,
+		    const char *keys_end, struct port *port)
+{
+	assert(keys != NULL && keys_end != NULL && port != NULL);
+	(void)keys_end;
+	struct space *space;
+	struct index *index;
+	if (check_index(space_id, index_id, &space, &index) != 0)
+		return -1;
+	if (!index->def->opts.is_unique) {
+		diag_set(ClientError, ER_MORE_THAN_ONE_TUPLE);
+		return -1;
+	}
+	if (mp_typeof(*keys) != MP_ARRAY) {
+		diag_set(ClientError, ER_TUPLE_NOT_ARRAY);
+		return -1;
+	}
+	uint32_t key_count = mp_decode_array(&keys);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size = key_count * (sizeof(const char *) +
+				   sizeof(struct tuple *));
+	const char **key_parts = (const char **) region_alloc(region, size);
+	if (key_parts == NULL) {
+		diag_set(OutOfMemory, size, "region", "keys");
+		return -1;
+	}
+	struct tuple **result = (struct tuple **) (key_parts + key_count);
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (mp_typeof(*keys) != MP_ARRAY) {
+			diag_set(ClientError, ER_TUPLE_NOT_ARRAY);
+			goto error;
+		}
+		key_parts[i] = keys;
+		uint32_t part_count = mp_decode_array(&keys);
+		if (exact_key_validate(index->def->key_def, keys, part_count))
+			goto error;
+		for (uint32_t j = 0; j < part_count; j++)
+			mp_next(&keys);
+	}
+	/* Start transaction in the engine. */
+	struct txn *txn;
+	if (txn_begin_ro_stmt(space, &txn) != 0)
+		goto error;
+	if (index_get_multi(index, key_parts, key_count, result) != 0) {
+		txn_rollback_stmt();
+		goto error;
+	}
+	txn_commit_ro_stmt(txn);
+	/* Count statistics. */
+	rmean_collect(rmean_box, IPROTO_SELECT, 1);
+
+	port_tuple_create(port);
+	int rc;
+	rc = 0;
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (result[i] == NULL)
+			continue;
+		if (rc == 0 && port_tuple_add(port, result[i]) != 0)
+			rc = -1;
+		tuple_unref(result[i]);
+	}
+	if (rc != 0)
+		port_destroy(port);
+	region_truncate(region, region_svp);
+	return rc;
+error:
+	region_truncate(region, region_svp);
+	return -1;
+}
+
 /* }}} */
 
 /* {{{ Internal API */
@@ -536,8 +610,7 @@ index_build(struct index *index, struct index *pk)
 	if (rc != 0)
 		return -1;
 
-	index_end_build(index);
-	return 0;
+	return index_end_build(index);
 }
 
 /* }}} */
@@ -631,6 +704,26 @@ generic_index_get(struct index *index, const char *key,
 	return -1;
 }
 
+int
+generic_index_get_multi(struct index *index, const char **keys,
+			uint32_t key_count, struct tuple **result)
+{
+	for (uint32_t i = 0; i < key_count; i++) {
+		const char *key = keys[i];
+		uint32_t part_count = mp_decode_array(&key);
+		if (index_get(index, key, part_count, &result[i]) != 0) {
+			while (i-- > 0) {
+				if (result[i] != NULL)
+					tuple_unref(result[i]);
+			}
+			return -1;
+		}
+		if (result[i] != NULL)
+			tuple_ref(result[i]);
+	}
+	return 0;
+}
+
 int
 generic_index_replace(struct index *index, struct tuple *old_tuple,
 		      struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -683,9 +776,10 @@ generic_index_build_next(struct index *index, struct tuple *tuple)
 	return index_replace(index, NULL, tuple, DUP_INSERT, &unused);
 }
 
-void
+int
 generic_index_end_build(struct index *)
 {
+	return 0;
 }
 
 /* }}} */
@@ -45,6 +45,7 @@ struct index;
 struct index_def;
 struct key_def;
 struct info_handler;
+struct port;
 
 /** \cond public */
 
@@ -230,6 +231,23 @@ int
 box_index_info(uint32_t space_id, uint32_t index_id,
 	       struct info_handler *info);
 
+/**
+ * Get tuples by an array of keys from a unique index
+ * (index:get_multi()). Found tuples are appended to the
+ * port in the order of keys, keys not found are skipped.
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier
+ * \param keys encoded array of keys, each in MsgPack Array format
+ * \param keys_end the end of encoded \a keys
+ * \param[out] port port to store found tuples
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ */
+int
+box_index_get_multi(uint32_t space_id, uint32_t index_id, const char *keys,
+		    const char *keys_end, struct port *port);
+
 struct iterator {
 	/**
 	 * Iterate to the next tuple.
@@ -378,6 +396,14 @@ struct index_vtab {
 			 const char *key, uint32_t part_count);
 	int (*get)(struct index *index, const char *key,
 		   uint32_t part_count, struct tuple **result);
+	/**
+	 * Look up a batch of full keys. keys[i] points to the
+	 * i-th key in MsgPack Array format. The tuple found for
+	 * it is returned in result[i] with a reference, NULL if
+	 * not found.
+	 */
+	int (*get_multi)(struct index *index, const char **keys,
+			 uint32_t key_count, struct tuple **result);
 	int (*replace)(struct index *index, struct tuple *old_tuple,
 		       struct tuple *new_tuple, enum dup_replace_mode mode,
 		       struct tuple **result);
@@ -406,7 +432,12 @@ struct index_vtab {
 	 */
 	int (*reserve)(struct index *index, uint32_t size_hint);
 	int (*build_next)(struct index *index, struct tuple *tuple);
-	void (*end_build)(struct index *index);
+	/**
+	 * Finish building. May fail, e.g. if the index is
+	 * unique and a duplicate was found among the tuples
+	 * added with build_next().
+	 */
+	int (*end_build)(struct index *index);
 };
 
 struct index {
@@ -532,6 +563,13 @@ index_get(struct index *index, const char *key,
 	return index->vtab->get(index, key, part_count, result);
 }
 
+static inline int
+index_get_multi(struct index *index, const char **keys,
+		uint32_t key_count, struct tuple **result)
+{
+	return index->vtab->get_multi(index, keys, key_count, result);
+}
+
 static inline int
 index_replace(struct index *index, struct tuple *old_tuple,
 	      struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -583,10 +621,10 @@ index_build_next(struct index *index, struct tuple *tuple)
 	return index->vtab->build_next(index, tuple);
 }
 
-static inline void
+static inline int
 index_end_build(struct index *index)
 {
-	index->vtab->end_build(index);
+	return index->vtab->end_build(index);
 }
 
 /*
@@ -602,6 +640,8 @@ int generic_index_random(struct index *, uint32_t, struct tuple **);
 ssize_t generic_index_count(struct index *, enum iterator_type,
 			    const char *, uint32_t);
 int generic_index_get(struct index *, const char *, uint32_t, struct tuple **);
+int generic_index_get_multi(struct index *, const char **, uint32_t,
+			    struct tuple **);
 int generic_index_replace(struct index *, struct tuple *, struct tuple *,
 			  enum dup_replace_mode, struct tuple **);
 struct snapshot_iterator *generic_index_create_snapshot_iterator(struct index *);
@@ -610,7 +650,7 @@ void generic_index_reset_stat(struct index *);
 void generic_index_begin_build(struct index *);
 int generic_index_reserve(struct index *, uint32_t);
 int generic_index_build_next(struct index *, struct tuple *);
-void generic_index_end_build(struct index *);
+int generic_index_end_build(struct index *);
 
 #if defined(__cplusplus)
 } /* extern "C" */
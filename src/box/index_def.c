@@ -36,6 +36,10 @@ const char *index_type_strs[] = { "HASH", "TREE", "BITSET", "RTREE" };
 
 const char *rtree_index_distance_type_strs[] = { "EUCLID", "MANHATTAN" };
 
+const char *vy_compaction_policy_strs[] = {
+	"tiered", "leveled", "time_window"
+};
+
 const struct index_opts index_opts_default = {
 	/* .unique              = */ true,
 	/* .dimension           = */ 2,
@@ -45,6 +49,9 @@ const struct index_opts index_opts_default = {
 	/* .run_count_per_level = */ 2,
 	/* .run_size_ratio      = */ 3.5,
 	/* .bloom_fpr           = */ 0.05,
+	/* .bloom_prefix_parts  = */ 0,
+	/* .compaction_policy   = */ VY_COMPACTION_POLICY_TIERED,
+	/* .compaction_window   = */ 86400,
 	/* .lsn                 = */ 0,
 	/* .sql                 = */ NULL,
 };
@@ -59,6 +66,12 @@ const struct opt_def index_opts_reg[] = {
 	OPT_DEF("run_count_per_level", OPT_INT64, struct index_opts, run_count_per_level),
 	OPT_DEF("run_size_ratio", OPT_FLOAT, struct index_opts, run_size_ratio),
 	OPT_DEF("bloom_fpr", OPT_FLOAT, struct index_opts, bloom_fpr),
+	OPT_DEF("bloom_prefix_parts", OPT_UINT32, struct index_opts,
+		bloom_prefix_parts),
+	OPT_DEF_ENUM("compaction_policy", vy_compaction_policy,
+		     struct index_opts, compaction_policy, NULL),
+	OPT_DEF("compaction_window", OPT_FLOAT, struct index_opts,
+		compaction_window),
 	OPT_DEF("lsn", OPT_INT64, struct index_opts, lsn),
 	OPT_DEF("sql", OPT_STRPTR, struct index_opts, sql),
 	OPT_END,
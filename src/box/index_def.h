@@ -58,6 +58,17 @@ enum rtree_index_distance_type {
 };
 extern const char *rtree_index_distance_type_strs[];
 
+enum vy_compaction_policy {
+	/* Size-tiered: merge runs of similar size. */
+	VY_COMPACTION_POLICY_TIERED,
+	/* Leveled: keep one run per level, bound read amplification. */
+	VY_COMPACTION_POLICY_LEVELED,
+	/* Time window: never merge runs dumped in different windows. */
+	VY_COMPACTION_POLICY_TIME_WINDOW,
+	vy_compaction_policy_MAX
+};
+extern const char *vy_compaction_policy_strs[];
+
 /** Index options */
 struct index_opts {
 	/**
@@ -91,6 +102,21 @@ struct index_opts {
 	double run_size_ratio;
 	/* Bloom filter false positive rate. */
 	double bloom_fpr;
+	/**
+	 * Number of leading key parts to build an additional
+	 * bloom filter for, so that lookups by a partial key
+	 * can skip runs. 0 disables the prefix bloom filter.
+	 */
+	uint32_t bloom_prefix_parts;
+	/**
+	 * Strategy used to pick runs of a range for compaction.
+	 */
+	enum vy_compaction_policy compaction_policy;
+	/**
+	 * Width of a time window, in seconds, used by the
+	 * time window compaction policy.
+	 */
+	double compaction_window;
 	/**
 	 * LSN from the time of index creation.
 	 */
@@ -143,6 +169,13 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->run_size_ratio < o2->run_size_ratio ? -1 : 1;
 	if (o1->bloom_fpr != o2->bloom_fpr)
 		return o1->bloom_fpr < o2->bloom_fpr ? -1 : 1;
+	if (o1->bloom_prefix_parts != o2->bloom_prefix_parts)
+		return o1->bloom_prefix_parts < o2->bloom_prefix_parts ?
+		       -1 : 1;
+	if (o1->compaction_policy != o2->compaction_policy)
+		return o1->compaction_policy < o2->compaction_policy ? -1 : 1;
+	if (o1->compaction_window != o2->compaction_window)
+		return o1->compaction_window < o2->compaction_window ? -1 : 1;
 	return 0;
 }
 
@@ -50,6 +50,7 @@
 
 #include "port.h"
 #include "box.h"
+#include "index.h"
 #include "call.h"
 #include "tuple_convert.h"
 #include "session.h"
@@ -60,7 +61,11 @@
 #include "rmean.h"
 #include "execute.h"
 
-/* The number of iproto messages in flight */
+/*
+ * The number of iproto messages in flight. The limit is split
+ * between network threads, so that the tx fiber pool sees the
+ * same load no matter how many threads there are.
+ */
 enum { IPROTO_MSG_MAX = 768 };
 
 /**
@@ -147,7 +152,7 @@ struct iproto_msg
 		struct call_request call;
 		/** Authentication request. */
 		struct auth_request auth;
-		/* SQL request, if this is the EXECUTE request. */
+		/* SQL request, if this is EXECUTE or PREPARE. */
 		struct sql_request sql;
 		/** In case of iproto parse error, saved diagnostics. */
 		struct diag diag;
@@ -186,61 +191,12 @@ struct iproto_msg
 	bool close_connection;
 };
 
-static struct mempool iproto_msg_pool;
-
-static struct iproto_msg *
-iproto_msg_new(struct iproto_connection *con)
-{
-	struct iproto_msg *msg =
-		(struct iproto_msg *) mempool_alloc_xc(&iproto_msg_pool);
-	msg->connection = con;
-	return msg;
-}
-
-/**
- * Resume stopped connections, if any.
- */
-static void
-iproto_resume();
-
-static void
-iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
-		  bool *stop_input);
-
-static inline void
-iproto_msg_delete(struct iproto_msg *msg)
-{
-	mempool_free(&iproto_msg_pool, msg);
-	iproto_resume();
-}
-
-/**
- * A single global queue for all requests in all connections. All
- * requests from all connections are processed concurrently.
- * Is also used as a queue for just established connections and to
- * execute disconnect triggers. A few notes about these triggers:
- * - they need to be run in a fiber
- * - unlike an ordinary request failure, on_connect trigger
- *   failure must lead to connection close.
- * - on_connect trigger must be processed before any other
- *   request on this connection.
- */
-static struct cpipe tx_pipe;
-static struct cpipe net_pipe;
-
-/**
- * Network thread.
- */
-static struct cord net_cord;
-
 /**
  * Slab cache used for allocating memory for output network buffers
  * in the tx thread.
  */
 static struct slab_cache net_slabc;
 
-struct rmean *rmean_net;
-
 enum rmean_net_name {
 	IPROTO_SENT,
 	IPROTO_RECEIVED,
@@ -249,16 +205,83 @@ enum rmean_net_name {
 
 const char *rmean_net_strings[IPROTO_LAST] = { "SENT", "RECEIVED" };
 
+/**
+ * A network thread. Every thread runs its own event loop,
+ * accepts connections on the shared listening socket and
+ * serves them until they are closed: a connection never
+ * migrates between threads.
+ *
+ * All threads talk to the single tx thread. Since the message
+ * routes back from tx end in the pipe of the thread which
+ * owns the connection, each thread has its own copy of every
+ * route.
+ */
+struct iproto_thread {
+	/** Thread number, 0 for the thread which binds the port. */
+	int id;
+	/** Cbus endpoint name, "net" for the first thread. */
+	char name[FIBER_NAME_MAX];
+	/** Network cord. */
+	struct cord net_cord;
+	/**
+	 * A queue for all requests in all connections of this
+	 * thread. All requests from all connections are processed
+	 * concurrently. Is also used as a queue for just
+	 * established connections and to execute disconnect
+	 * triggers. A few notes about these triggers:
+	 * - they need to be run in a fiber
+	 * - unlike an ordinary request failure, on_connect trigger
+	 *   failure must lead to connection close.
+	 * - on_connect trigger must be processed before any other
+	 *   request on this connection.
+	 */
+	struct cpipe tx_pipe;
+	/** A pipe from tx back to this thread. */
+	struct cpipe net_pipe;
+	struct mempool iproto_msg_pool;
+	struct mempool iproto_connection_pool;
+	/** Connections with input stopped by throttling. */
+	struct rlist stopped_connections;
+	/** Share of IPROTO_MSG_MAX this thread may have in flight. */
+	size_t msg_max;
+	/** iproto binary listener */
+	struct evio_service binary;
+	/** Network statistics of this thread. */
+	struct rmean *rmean;
+	/* Message routes ending in this thread. */
+	struct cmsg_hop disconnect_route[2];
+	struct cmsg_hop misc_route[2];
+	struct cmsg_hop call_route[2];
+	struct cmsg_hop select_route[2];
+	struct cmsg_hop process1_route[2];
+	struct cmsg_hop sql_route[2];
+	struct cmsg_hop batch_route[2];
+	struct cmsg_hop get_multi_route[2];
+	struct cmsg_hop join_route[2];
+	struct cmsg_hop subscribe_route[2];
+	struct cmsg_hop error_route[2];
+	struct cmsg_hop connect_route[2];
+	const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX];
+};
+
+static struct iproto_thread *iproto_threads;
+static int iproto_threads_count;
+
+static struct iproto_msg *
+iproto_msg_new(struct iproto_connection *con);
+
+/**
+ * Resume stopped connections, if any.
+ */
 static void
-tx_process_disconnect(struct cmsg *m);
+iproto_resume(struct iproto_thread *iproto_thread);
 
 static void
-net_finish_disconnect(struct cmsg *m);
+iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
+		  bool *stop_input);
 
-static const struct cmsg_hop disconnect_route[] = {
-	{ tx_process_disconnect, &net_pipe },
-	{ net_finish_disconnect, NULL },
-};
+static inline void
+iproto_msg_delete(struct iproto_msg *msg);
 
 /* }}} */
 
@@ -356,6 +379,8 @@ struct iproto_connection
 	/* Pre-allocated disconnect msg. */
 	struct iproto_msg *disconnect;
 	struct rlist in_stop_list;
+	/** The network thread serving the connection. */
+	struct iproto_thread *iproto_thread;
 	/**
 	 * The following fields are used exclusively by the tx thread.
 	 * Align them to prevent false-sharing.
@@ -367,8 +392,22 @@ struct iproto_connection
 	} tx;
 };
 
-static struct mempool iproto_connection_pool;
-static RLIST_HEAD(stopped_connections);
+static struct iproto_msg *
+iproto_msg_new(struct iproto_connection *con)
+{
+	struct iproto_msg *msg = (struct iproto_msg *)
+		mempool_alloc_xc(&con->iproto_thread->iproto_msg_pool);
+	msg->connection = con;
+	return msg;
+}
+
+static inline void
+iproto_msg_delete(struct iproto_msg *msg)
+{
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	mempool_free(&iproto_thread->iproto_msg_pool, msg);
+	iproto_resume(iproto_thread);
+}
 
 /**
  * Return true if we have not enough spare messages
@@ -376,11 +415,12 @@ static RLIST_HEAD(stopped_connections);
  * discounted: they are mostly reserved and idle.
  */
 static inline bool
-iproto_must_stop_input()
+iproto_must_stop_input(struct iproto_thread *iproto_thread)
 {
-	size_t connection_count = mempool_count(&iproto_connection_pool);
-	size_t request_count = mempool_count(&iproto_msg_pool);
-	return request_count > connection_count + IPROTO_MSG_MAX;
+	size_t connection_count =
+		mempool_count(&iproto_thread->iproto_connection_pool);
+	size_t request_count = mempool_count(&iproto_thread->iproto_msg_pool);
+	return request_count > connection_count + iproto_thread->msg_max;
 }
 
 /**
@@ -390,20 +430,20 @@ iproto_must_stop_input()
  * object in the message pool.
  */
 static void
-iproto_resume()
+iproto_resume(struct iproto_thread *iproto_thread)
 {
 	/*
 	 * Most of the time we have nothing to do here: throttling
 	 * is not active.
 	 */
-	if (rlist_empty(&stopped_connections))
+	if (rlist_empty(&iproto_thread->stopped_connections))
 		return;
-	if (iproto_must_stop_input())
+	if (iproto_must_stop_input(iproto_thread))
 		return;
 
 	struct iproto_connection *con;
-	con = rlist_first_entry(&stopped_connections, struct iproto_connection,
-				in_stop_list);
+	con = rlist_first_entry(&iproto_thread->stopped_connections,
+				struct iproto_connection, in_stop_list);
 	ev_feed_event(con->loop, &con->input, EV_READ);
 }
 
@@ -437,7 +477,8 @@ iproto_connection_stop(struct iproto_connection *con)
 		 sio_socketname(con->input.fd));
 	assert(rlist_empty(&con->in_stop_list));
 	ev_io_stop(con->loop, &con->input);
-	rlist_add_tail(&stopped_connections, &con->in_stop_list);
+	rlist_add_tail(&con->iproto_thread->stopped_connections,
+		       &con->in_stop_list);
 }
 
 /**
@@ -481,7 +522,7 @@ iproto_connection_close(struct iproto_connection *con)
 		assert(con->disconnect != NULL);
 		struct iproto_msg *msg = con->disconnect;
 		con->disconnect = NULL;
-		cpipe_push(&tx_pipe, &msg->base);
+		cpipe_push(&con->iproto_thread->tx_pipe, &msg->base);
 	}
 	rlist_del(&con->in_stop_list);
 }
@@ -586,7 +627,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		const char *pos = reqstart;
 		/* Read request length. */
 		if (mp_typeof(*pos) != MP_UINT) {
-			cpipe_flush_input(&tx_pipe);
+			cpipe_flush_input(&con->iproto_thread->tx_pipe);
 			tnt_raise(ClientError, ER_INVALID_MSGPACK,
 				  "packet length");
 		}
@@ -607,7 +648,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		 * This can't throw, but should not be
 		 * done in case of exception.
 		 */
-		cpipe_push_input(&tx_pipe, &msg->base);
+		cpipe_push_input(&con->iproto_thread->tx_pipe, &msg->base);
 		n_requests++;
 		/* Request is parsed */
 		assert(reqend > reqstart);
@@ -646,7 +687,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		 */
 		ev_feed_event(con->loop, &con->input, EV_READ);
 	}
-	cpipe_flush_input(&tx_pipe);
+	cpipe_flush_input(&con->iproto_thread->tx_pipe);
 }
 
 static void
@@ -665,7 +706,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 		 * resume one more connection which might have
 		 * input.
 		 */
-		iproto_resume();
+		iproto_resume(con->iproto_thread);
 	}
 	/*
 	 * Throttle if there are too many pending requests,
@@ -674,7 +715,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	 * another fiber waiting for write to complete).
 	 * Ignore iproto_connection->disconnect messages.
 	 */
-	if (iproto_must_stop_input()) {
+	if (iproto_must_stop_input(con->iproto_thread)) {
 		iproto_connection_stop(con);
 		return;
 	}
@@ -697,7 +738,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+		rmean_collect(con->iproto_thread->rmean, IPROTO_RECEIVED, nrd);
 
 		/* Update the read position and connection state. */
 		in->wpos += nrd;
@@ -754,7 +795,7 @@ iproto_flush(struct iproto_connection *con)
 	ssize_t nwr = sio_writev(fd, iov, iovcnt);
 
 	/* Count statistics */
-	rmean_collect(rmean_net, IPROTO_SENT, nwr);
+	rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
 	if (nwr > 0) {
 		if (begin->used + nwr == end->used) {
 			*begin = *end;
@@ -798,10 +839,11 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 }
 
 static struct iproto_connection *
-iproto_connection_new(int fd)
+iproto_connection_new(struct iproto_thread *iproto_thread, int fd)
 {
 	struct iproto_connection *con = (struct iproto_connection *)
-		mempool_alloc_xc(&iproto_connection_pool);
+		mempool_alloc_xc(&iproto_thread->iproto_connection_pool);
+	con->iproto_thread = iproto_thread;
 	con->input.data = con->output.data = con;
 	con->loop = loop();
 	ev_io_init(&con->input, iproto_connection_on_input, fd, EV_READ);
@@ -820,7 +862,7 @@ iproto_connection_new(int fd)
 	rlist_create(&con->in_stop_list);
 	/* It may be very awkward to allocate at close. */
 	con->disconnect = iproto_msg_new(con);
-	cmsg_init(&con->disconnect->base, disconnect_route);
+	cmsg_init(&con->disconnect->base, iproto_thread->disconnect_route);
 	return con;
 }
 
@@ -844,7 +886,7 @@ iproto_connection_delete(struct iproto_connection *con)
 	       con->obuf[1].iov[0].iov_base == NULL);
 	if (con->disconnect)
 		iproto_msg_delete(con->disconnect);
-	mempool_free(&iproto_connection_pool, con);
+	mempool_free(&con->iproto_thread->iproto_connection_pool, con);
 }
 
 /* }}} iproto_connection */
@@ -866,6 +908,12 @@ tx_process_select(struct cmsg *msg);
 static void
 tx_process_sql(struct cmsg *msg);
 
+static void
+tx_process_batch(struct cmsg *msg);
+
+static void
+tx_process_get_multi(struct cmsg *msg);
+
 static void
 tx_reply_error(struct iproto_msg *msg);
 
@@ -887,67 +935,12 @@ net_end_join(struct cmsg *msg);
 static void
 net_end_subscribe(struct cmsg *msg);
 
-static const struct cmsg_hop misc_route[] = {
-	{ tx_process_misc, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop call_route[] = {
-	{ tx_process_call, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop select_route[] = {
-	{ tx_process_select, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop process1_route[] = {
-	{ tx_process1, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop sql_route[] = {
-	{ tx_process_sql, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
-	NULL,                                   /* IPROTO_OK */
-	select_route,                           /* IPROTO_SELECT */
-	process1_route,                         /* IPROTO_INSERT */
-	process1_route,                         /* IPROTO_REPLACE */
-	process1_route,                         /* IPROTO_UPDATE */
-	process1_route,                         /* IPROTO_DELETE */
-	call_route,                             /* IPROTO_CALL_16 */
-	misc_route,                             /* IPROTO_AUTH */
-	call_route,                             /* IPROTO_EVAL */
-	process1_route,                         /* IPROTO_UPSERT */
-	call_route,                             /* IPROTO_CALL */
-	sql_route,                              /* IPROTO_EXECUTE */
-	NULL,                                   /* IPROTO_NOP */
-};
-
-static const struct cmsg_hop join_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_join, NULL },
-};
-
-static const struct cmsg_hop subscribe_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_subscribe, NULL },
-};
-
-static const struct cmsg_hop error_route[] = {
-	{ tx_reply_iproto_error, &net_pipe },
-	{ net_send_error, NULL },
-};
-
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input)
 {
 	uint8_t type;
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
 
 	if (xrow_header_decode(&msg->header, pos, reqend))
 		goto error;
@@ -967,42 +960,46 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 	case IPROTO_UPDATE:
 	case IPROTO_DELETE:
 	case IPROTO_UPSERT:
+	case IPROTO_INSERT_BATCH:
+	case IPROTO_REPLACE_BATCH:
+	case IPROTO_GET_MULTI:
 		if (xrow_decode_dml(&msg->header, &msg->dml,
 				    dml_request_key_map(type)))
 			goto error;
-		assert(type < sizeof(dml_route)/sizeof(*dml_route));
-		cmsg_init(&msg->base, dml_route[type]);
+		assert(type < lengthof(iproto_thread->dml_route));
+		cmsg_init(&msg->base, iproto_thread->dml_route[type]);
 		break;
 	case IPROTO_CALL_16:
 	case IPROTO_CALL:
 	case IPROTO_EVAL:
 		if (xrow_decode_call(&msg->header, &msg->call))
 			goto error;
-		cmsg_init(&msg->base, call_route);
+		cmsg_init(&msg->base, iproto_thread->call_route);
 		break;
 	case IPROTO_EXECUTE:
+	case IPROTO_PREPARE:
 		if (xrow_decode_sql(&msg->header, &msg->sql, &fiber()->gc))
 			goto error;
-		cmsg_init(&msg->base, sql_route);
+		cmsg_init(&msg->base, iproto_thread->sql_route);
 		break;
 	case IPROTO_PING:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_JOIN:
-		cmsg_init(&msg->base, join_route);
+		cmsg_init(&msg->base, iproto_thread->join_route);
 		*stop_input = true;
 		break;
 	case IPROTO_SUBSCRIBE:
-		cmsg_init(&msg->base, subscribe_route);
+		cmsg_init(&msg->base, iproto_thread->subscribe_route);
 		*stop_input = true;
 		break;
 	case IPROTO_REQUEST_VOTE:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_AUTH:
 		if (xrow_decode_auth(&msg->header, &msg->auth))
 			goto error;
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	default:
 		diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE,
@@ -1015,7 +1012,7 @@ error:
 	diag_log();
 	diag_create(&msg->diag);
 	diag_move(&fiber()->diag, &msg->diag);
-	cmsg_init(&msg->base, error_route);
+	cmsg_init(&msg->base, iproto_thread->error_route);
 }
 
 static void
@@ -1074,9 +1071,11 @@ static void
 net_finish_disconnect(struct cmsg *m)
 {
 	struct iproto_msg *msg = (struct iproto_msg *) m;
-	/* Runs the trigger, which may yield. */
-	iproto_connection_delete(msg->connection);
+	struct iproto_connection *con = msg->connection;
+	/* The msg refers to its thread through the connection. */
 	iproto_msg_delete(msg);
+	/* Runs the trigger, which may yield. */
+	iproto_connection_delete(con);
 }
 
 
@@ -1099,7 +1098,7 @@ net_discard_input(struct cmsg *m)
 	msg->p_ibuf->rpos += msg->len;
 	msg->len = 0;
 	msg->connection->long_poll_requests++;
-	iproto_resume();
+	iproto_resume(msg->connection->iproto_thread);
 }
 
 static void
@@ -1109,7 +1108,8 @@ tx_discard_input(struct iproto_msg *msg)
 		{ net_discard_input, NULL },
 	};
 	cmsg_init(&msg->discard_input, discard_input_route);
-	cpipe_push(&net_pipe, &msg->discard_input);
+	cpipe_push(&msg->connection->iproto_thread->net_pipe,
+		   &msg->discard_input);
 }
 
 /**
@@ -1203,38 +1203,106 @@ error:
 	tx_reply_error(msg);
 }
 
+/**
+ * Append a failed row of a batch to the list of errors,
+ * encoded as [row number, error code, error message].
+ */
+static int
+tx_batch_on_error(uint32_t row_no, void *arg)
+{
+	struct ibuf *errors = (struct ibuf *) arg;
+	const box_error_t *e = diag_last_error(diag_get());
+	uint32_t code = box_error_code(e);
+	const char *message = box_error_message(e);
+	uint32_t len = strlen(message);
+	size_t size = mp_sizeof_array(3) + mp_sizeof_uint(row_no) +
+		      mp_sizeof_uint(code) + mp_sizeof_str(len);
+	char *data = (char *) ibuf_alloc(errors, size);
+	if (data == NULL) {
+		diag_set(OutOfMemory, size, "ibuf_alloc", "batch errors");
+		return -1;
+	}
+	data = mp_encode_array(data, 3);
+	data = mp_encode_uint(data, row_no);
+	data = mp_encode_uint(data, code);
+	data = mp_encode_str(data, message, len);
+	return 0;
+}
+
 static void
-tx_process_select(struct cmsg *m)
+tx_process_batch(struct cmsg *m)
 {
 	struct iproto_msg *msg = tx_accept_msg(m);
 	struct obuf *out = msg->connection->tx.p_obuf;
+
+	tx_fiber_init(msg->connection->session, msg->header.sync);
+	if (tx_check_schema(msg->header.schema_version))
+		goto error;
+
+	/*
+	 * Errors are collected aside and copied to the output
+	 * buffer only when the batch is committed: other fibers
+	 * may write to the same buffer while this one yields.
+	 */
+	struct ibuf errors;
+	ibuf_create(&errors, cord_slab_cache(), 1024);
+	uint32_t error_count;
+	error_count = 0;
+	struct obuf_svp svp;
+	if (box_process_batch(&msg->dml, tx_batch_on_error, &errors) != 0)
+		goto error_free;
+	for (const char *pos = errors.rpos; pos < errors.wpos; mp_next(&pos))
+		error_count++;
+	if (iproto_prepare_select(out, &svp) != 0)
+		goto error_free;
+	if (ibuf_used(&errors) > 0 &&
+	    obuf_dup(out, errors.rpos, ibuf_used(&errors)) !=
+	    ibuf_used(&errors)) {
+		diag_set(OutOfMemory, ibuf_used(&errors), "obuf_dup", "data");
+		obuf_rollback_to_svp(out, &svp);
+		goto error_free;
+	}
+	ibuf_destroy(&errors);
+	iproto_reply_select(out, &svp, msg->header.sync, ::schema_version,
+			    error_count);
+	iproto_wpos_create(&msg->wpos, out);
+	return;
+error_free:
+	ibuf_destroy(&errors);
+error:
+	tx_reply_error(msg);
+}
+
+static void
+tx_process_get_multi(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	struct obuf *out = msg->connection->tx.p_obuf;
+	struct request *req = &msg->dml;
 	struct obuf_svp svp;
 	struct port port;
 	int count;
-	int rc;
-	struct request *req = &msg->dml;
 
 	tx_fiber_init(msg->connection->session, msg->header.sync);
 
 	if (tx_check_schema(msg->header.schema_version))
 		goto error;
 
-	rc = box_select(req->space_id, req->index_id,
-			req->iterator, req->offset, req->limit,
-			req->key, req->key_end, &port);
-	if (rc < 0)
+	/*
+	 * Lookups may yield, so the tuples are collected
+	 * in a port and encoded only when all of them are
+	 * found.
+	 */
+	if (box_index_get_multi(req->space_id, req->index_id, req->key,
+				req->key_end, &port) != 0)
 		goto error;
 	if (iproto_prepare_select(out, &svp) != 0) {
 		port_destroy(&port);
 		goto error;
 	}
-	/*
-	 * SELECT output format has not changed since Tarantool 1.6
-	 */
-	count = port_dump_16(&port, out);
+	count = port_dump(&port, out);
 	port_destroy(&port);
 	if (count < 0) {
-		/* Discard the prepared select. */
 		obuf_rollback_to_svp(out, &svp);
 		goto error;
 	}
@@ -1246,6 +1314,36 @@ error:
 	tx_reply_error(msg);
 }
 
+static void
+tx_process_select(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	struct obuf *out = msg->connection->tx.p_obuf;
+	struct obuf_svp svp;
+	int count;
+	struct request *req = &msg->dml;
+
+	tx_fiber_init(msg->connection->session, msg->header.sync);
+
+	if (tx_check_schema(msg->header.schema_version))
+		goto error;
+
+	/*
+	 * SELECT output format has not changed since Tarantool 1.6
+	 */
+	count = box_select_to_obuf(req->space_id, req->index_id,
+				   req->iterator, req->offset, req->limit,
+				   req->key, req->key_end, out, &svp);
+	if (count < 0)
+		goto error;
+	iproto_reply_select(out, &svp, msg->header.sync,
+			    ::schema_version, count);
+	iproto_wpos_create(&msg->wpos, out);
+	return;
+error:
+	tx_reply_error(msg);
+}
+
 static void
 tx_process_call_on_yield(struct trigger *trigger, void *event)
 {
@@ -1387,9 +1485,15 @@ tx_process_sql(struct cmsg *m)
 
 	if (tx_check_schema(msg->header.schema_version))
 		goto error;
-	assert(msg->header.type == IPROTO_EXECUTE);
-	if (sql_prepare_and_execute(&msg->sql, out, &fiber()->gc) != 0)
-		goto error;
+	if (msg->header.type == IPROTO_PREPARE) {
+		if (sql_prepare(&msg->sql, out) != 0)
+			goto error;
+	} else {
+		assert(msg->header.type == IPROTO_EXECUTE);
+		if (sql_prepare_and_execute(&msg->sql, out,
+					    &fiber()->gc) != 0)
+			goto error;
+	}
 	iproto_wpos_create(&msg->wpos, out);
 	return;
 error:
@@ -1552,7 +1656,8 @@ net_send_greeting(struct cmsg *m)
 						 obuf_iovcnt(out));
 
 			/* Count statistics */
-			rmean_collect(rmean_net, IPROTO_SENT, nwr);
+			rmean_collect(con->iproto_thread->rmean,
+				      IPROTO_SENT, nwr);
 		} catch (Exception *e) {
 			e->log();
 		}
@@ -1573,98 +1678,188 @@ net_send_greeting(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
-static const struct cmsg_hop connect_route[] = {
-	{ tx_process_connect, &net_pipe },
-	{ net_send_greeting, NULL },
-};
-
 /** }}} */
 
 /**
  * Create a connection and start input.
  */
 static void
-iproto_on_accept(struct evio_service * /* service */, int fd,
+iproto_on_accept(struct evio_service *service, int fd,
 		 struct sockaddr *addr, socklen_t addrlen)
 {
 	(void) addr;
 	(void) addrlen;
+	struct iproto_thread *iproto_thread =
+		(struct iproto_thread *) service->on_accept_param;
 	struct iproto_connection *con;
 
-	con = iproto_connection_new(fd);
+	con = iproto_connection_new(iproto_thread, fd);
 	/*
 	 * Ignore msg allocation failure - the queue size is
 	 * fixed so there is a limited number of msgs in
 	 * use, all stored in just a few blocks of the memory pool.
 	 */
 	struct iproto_msg *msg = iproto_msg_new(con);
-	cmsg_init(&msg->base, connect_route);
+	cmsg_init(&msg->base, iproto_thread->connect_route);
 	msg->p_ibuf = con->p_ibuf;
 	msg->wpos = con->wpos;
 	msg->close_connection = false;
-	cpipe_push(&tx_pipe, &msg->base);
+	cpipe_push(&iproto_thread->tx_pipe, &msg->base);
 }
 
-static struct evio_service binary; /* iproto binary listener */
-
 /**
  * The network io thread main function:
  * begin serving the message bus.
  */
 static int
-net_cord_f(va_list /* ap */)
+net_cord_f(va_list ap)
 {
-	mempool_create(&iproto_msg_pool, &cord()->slabc,
+	struct iproto_thread *iproto_thread =
+		va_arg(ap, struct iproto_thread *);
+
+	mempool_create(&iproto_thread->iproto_msg_pool, &cord()->slabc,
 		       sizeof(struct iproto_msg));
-	mempool_create(&iproto_connection_pool, &cord()->slabc,
+	mempool_create(&iproto_thread->iproto_connection_pool, &cord()->slabc,
 		       sizeof(struct iproto_connection));
 
-	evio_service_init(loop(), &binary, "binary",
-			  iproto_on_accept, NULL);
+	evio_service_init(loop(), &iproto_thread->binary, "binary",
+			  iproto_on_accept, iproto_thread);
 
 
 	/* Init statistics counter */
-	rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
+	iproto_thread->rmean = rmean_new(rmean_net_strings, IPROTO_LAST);
 
-	if (rmean_net == NULL) {
+	if (iproto_thread->rmean == NULL) {
 		tnt_raise(OutOfMemory, sizeof(struct rmean),
 			  "rmean", "struct rmean");
 	}
 
 	struct cbus_endpoint endpoint;
 	/* Create "net" endpoint. */
-	cbus_endpoint_create(&endpoint, "net", fiber_schedule_cb, fiber());
+	cbus_endpoint_create(&endpoint, iproto_thread->name,
+			     fiber_schedule_cb, fiber());
 	/* Create a pipe to "tx" thread. */
-	cpipe_create(&tx_pipe, "tx");
-	cpipe_set_max_input(&tx_pipe, IPROTO_MSG_MAX/2);
+	cpipe_create(&iproto_thread->tx_pipe, "tx");
+	cpipe_set_max_input(&iproto_thread->tx_pipe, IPROTO_MSG_MAX/2);
 	/* Process incomming messages. */
 	cbus_loop(&endpoint);
 
-	cpipe_destroy(&tx_pipe);
+	cpipe_destroy(&iproto_thread->tx_pipe);
 	/*
 	 * Nothing to do in the fiber so far, the service
 	 * will take care of creating events for incoming
 	 * connections.
 	 */
-	if (evio_service_is_active(&binary))
-		evio_service_stop(&binary);
+	if (iproto_thread->id != 0)
+		evio_service_detach(&iproto_thread->binary);
+	else if (evio_service_is_active(&iproto_thread->binary))
+		evio_service_stop(&iproto_thread->binary);
 
-	rmean_delete(rmean_net);
+	rmean_delete(iproto_thread->rmean);
 	return 0;
 }
 
-/** Initialize the iproto subsystem and start network io thread */
+static void
+iproto_route_create(struct cmsg_hop *route, cmsg_f tx_f, cmsg_f net_f,
+		    struct cpipe *net_pipe)
+{
+	route[0].f = tx_f;
+	route[0].pipe = net_pipe;
+	route[1].f = net_f;
+	route[1].pipe = NULL;
+}
+
+/** Fill in the routes of messages served by a network thread. */
+static void
+iproto_thread_init_routes(struct iproto_thread *iproto_thread)
+{
+	struct cpipe *net_pipe = &iproto_thread->net_pipe;
+	iproto_route_create(iproto_thread->disconnect_route,
+			    tx_process_disconnect, net_finish_disconnect,
+			    net_pipe);
+	iproto_route_create(iproto_thread->misc_route,
+			    tx_process_misc, net_send_msg, net_pipe);
+	iproto_route_create(iproto_thread->call_route,
+			    tx_process_call, net_send_msg, net_pipe);
+	iproto_route_create(iproto_thread->select_route,
+			    tx_process_select, net_send_msg, net_pipe);
+	iproto_route_create(iproto_thread->process1_route,
+			    tx_process1, net_send_msg, net_pipe);
+	iproto_route_create(iproto_thread->sql_route,
+			    tx_process_sql, net_send_msg, net_pipe);
+	iproto_route_create(iproto_thread->batch_route,
+			    tx_process_batch, net_send_msg, net_pipe);
+	iproto_route_create(iproto_thread->get_multi_route,
+			    tx_process_get_multi, net_send_msg, net_pipe);
+	iproto_route_create(iproto_thread->join_route,
+			    tx_process_join_subscribe, net_end_join, net_pipe);
+	iproto_route_create(iproto_thread->subscribe_route,
+			    tx_process_join_subscribe, net_end_subscribe,
+			    net_pipe);
+	iproto_route_create(iproto_thread->error_route,
+			    tx_reply_iproto_error, net_send_error, net_pipe);
+	iproto_route_create(iproto_thread->connect_route,
+			    tx_process_connect, net_send_greeting, net_pipe);
+
+	const struct cmsg_hop **dml_route = iproto_thread->dml_route;
+	memset(dml_route, 0, sizeof(iproto_thread->dml_route));
+	dml_route[IPROTO_SELECT] = iproto_thread->select_route;
+	dml_route[IPROTO_INSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_REPLACE] = iproto_thread->process1_route;
+	dml_route[IPROTO_UPDATE] = iproto_thread->process1_route;
+	dml_route[IPROTO_DELETE] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL_16] = iproto_thread->call_route;
+	dml_route[IPROTO_AUTH] = iproto_thread->misc_route;
+	dml_route[IPROTO_EVAL] = iproto_thread->call_route;
+	dml_route[IPROTO_UPSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL] = iproto_thread->call_route;
+	dml_route[IPROTO_EXECUTE] = iproto_thread->sql_route;
+	dml_route[IPROTO_INSERT_BATCH] = iproto_thread->batch_route;
+	dml_route[IPROTO_REPLACE_BATCH] = iproto_thread->batch_route;
+	dml_route[IPROTO_GET_MULTI] = iproto_thread->get_multi_route;
+}
+
+/** Initialize the iproto subsystem and start network io threads */
 void
-iproto_init()
+iproto_init(int thread_count)
 {
+	assert(thread_count > 0 && thread_count <= IPROTO_THREADS_MAX);
 	slab_cache_create(&net_slabc, &runtime);
 
-	if (cord_costart(&net_cord, "iproto", net_cord_f, NULL))
-		panic("failed to initialize iproto thread");
-
-	/* Create a pipe to "net" thread. */
-	cpipe_create(&net_pipe, "net");
-	cpipe_set_max_input(&net_pipe, IPROTO_MSG_MAX/2);
+	iproto_threads = (struct iproto_thread *)
+		calloc(thread_count, sizeof(*iproto_threads));
+	if (iproto_threads == NULL)
+		panic("failed to allocate iproto threads");
+	iproto_threads_count = thread_count;
+
+	for (int i = 0; i < thread_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		iproto_thread->id = i;
+		if (i == 0) {
+			snprintf(iproto_thread->name,
+				 sizeof(iproto_thread->name), "net");
+		} else {
+			snprintf(iproto_thread->name,
+				 sizeof(iproto_thread->name), "net%d", i);
+		}
+		rlist_create(&iproto_thread->stopped_connections);
+		iproto_thread->msg_max = IPROTO_MSG_MAX / thread_count;
+		iproto_thread_init_routes(iproto_thread);
+
+		char cord_name[FIBER_NAME_MAX];
+		if (i == 0)
+			snprintf(cord_name, sizeof(cord_name), "iproto");
+		else
+			snprintf(cord_name, sizeof(cord_name), "iproto%d", i);
+		if (cord_costart(&iproto_thread->net_cord, cord_name,
+				 net_cord_f, iproto_thread))
+			panic("failed to initialize iproto thread");
+
+		/* Create a pipe to "net" thread. */
+		cpipe_create(&iproto_thread->net_pipe, iproto_thread->name);
+		cpipe_set_max_input(&iproto_thread->net_pipe,
+				    IPROTO_MSG_MAX/2);
+	}
 }
 
 /**
@@ -1675,18 +1870,20 @@ iproto_init()
  */
 struct iproto_bind_msg: public cbus_call_msg
 {
+	struct iproto_thread *iproto_thread;
 	const char *uri;
 };
 
 static int
 iproto_do_bind(struct cbus_call_msg *m)
 {
-	const char *uri  = ((struct iproto_bind_msg *) m)->uri;
+	struct iproto_bind_msg *msg = (struct iproto_bind_msg *) m;
+	struct evio_service *binary = &msg->iproto_thread->binary;
 	try {
-		if (evio_service_is_active(&binary))
-			evio_service_stop(&binary);
-		if (uri != NULL)
-			evio_service_bind(&binary, uri);
+		if (evio_service_is_active(binary))
+			evio_service_stop(binary);
+		if (msg->uri != NULL)
+			evio_service_bind(binary, msg->uri);
 	} catch (Exception *e) {
 		return -1;
 	}
@@ -1696,44 +1893,115 @@ iproto_do_bind(struct cbus_call_msg *m)
 static int
 iproto_do_listen(struct cbus_call_msg *m)
 {
-	(void) m;
+	struct iproto_bind_msg *msg = (struct iproto_bind_msg *) m;
+	struct evio_service *binary = &msg->iproto_thread->binary;
 	try {
-		if (evio_service_is_active(&binary))
-			evio_service_listen(&binary);
+		if (evio_service_is_active(binary))
+			evio_service_listen(binary);
 	} catch (Exception *e) {
 		return -1;
 	}
 	return 0;
 }
 
-void
-iproto_bind(const char *uri)
+/**
+ * Start accepting connections on the socket bound and
+ * listened by the first thread. All threads are woken up by
+ * an incoming connection and race for it in accept(), so the
+ * connection is served by whichever thread wins.
+ */
+static int
+iproto_do_attach(struct cbus_call_msg *m)
+{
+	struct iproto_bind_msg *msg = (struct iproto_bind_msg *) m;
+	struct evio_service *binary = &iproto_threads[0].binary;
+	if (evio_service_is_active(binary))
+		evio_service_attach(&msg->iproto_thread->binary, binary);
+	return 0;
+}
+
+static int
+iproto_do_detach(struct cbus_call_msg *m)
 {
+	struct iproto_bind_msg *msg = (struct iproto_bind_msg *) m;
+	evio_service_detach(&msg->iproto_thread->binary);
+	return 0;
+}
+
+/** Execute @a func in the network thread @a iproto_thread. */
+static void
+iproto_thread_call(struct iproto_thread *iproto_thread, cbus_call_f func,
+		   const char *uri)
+{
+	/* Declare static to avoid stack corruption on fiber cancel. */
 	static struct iproto_bind_msg m;
+	m.iproto_thread = iproto_thread;
 	m.uri = uri;
-	if (cbus_call(&net_pipe, &tx_pipe, &m, iproto_do_bind,
-		      NULL, TIMEOUT_INFINITY))
+	if (cbus_call(&iproto_thread->net_pipe, &iproto_thread->tx_pipe, &m,
+		      func, NULL, TIMEOUT_INFINITY))
 		diag_raise();
 }
 
+void
+iproto_bind(const char *uri)
+{
+	/*
+	 * The other threads borrow the socket of the first one,
+	 * make them let it go before it is closed.
+	 */
+	for (int i = 1; i < iproto_threads_count; i++)
+		iproto_thread_call(&iproto_threads[i], iproto_do_detach, NULL);
+	iproto_thread_call(&iproto_threads[0], iproto_do_bind, uri);
+}
+
 void
 iproto_listen()
 {
-	/* Declare static to avoid stack corruption on fiber cancel. */
-	static struct cbus_call_msg m;
-	if (cbus_call(&net_pipe, &tx_pipe, &m, iproto_do_listen,
-		      NULL, TIMEOUT_INFINITY))
-		diag_raise();
+	iproto_thread_call(&iproto_threads[0], iproto_do_listen, NULL);
+	for (int i = 1; i < iproto_threads_count; i++)
+		iproto_thread_call(&iproto_threads[i], iproto_do_attach, NULL);
 }
 
 size_t
 iproto_mem_used(void)
 {
-	return slab_cache_used(&net_cord.slabc) + slab_cache_used(&net_slabc);
+	size_t mem = slab_cache_used(&net_slabc);
+	for (int i = 0; i < iproto_threads_count; i++)
+		mem += slab_cache_used(&iproto_threads[i].net_cord.slabc);
+	return mem;
 }
 
 void
 iproto_reset_stat(void)
 {
-	rmean_cleanup(rmean_net);
+	for (int i = 0; i < iproto_threads_count; i++)
+		rmean_cleanup(iproto_threads[i].rmean);
+}
+
+int
+iproto_thread_count(void)
+{
+	return iproto_threads_count;
+}
+
+int
+iproto_rmean_foreach(int thread_id, rmean_cb cb, void *cb_ctx)
+{
+	if (thread_id >= 0) {
+		assert(thread_id < iproto_threads_count);
+		return rmean_foreach(iproto_threads[thread_id].rmean,
+				     cb, cb_ctx);
+	}
+	for (size_t name = 0; name < IPROTO_LAST; name++) {
+		int64_t rps = 0, total = 0;
+		for (int i = 0; i < iproto_threads_count; i++) {
+			struct rmean *rmean = iproto_threads[i].rmean;
+			rps += rmean_mean(rmean, name);
+			total += rmean_total(rmean, name);
+		}
+		int rc = cb(rmean_net_strings[name], rps, total, cb_ctx);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
 }
@@ -33,12 +33,17 @@
 
 #include <stddef.h>
 
+#include "rmean.h"
+
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
 
 extern unsigned iproto_readahead;
 
+/** Max value of box.cfg.iproto_threads. */
+enum { IPROTO_THREADS_MAX = 32 };
+
 /**
  * Return size of memory used for storing network buffers.
  */
@@ -51,11 +56,29 @@ iproto_mem_used(void);
 void
 iproto_reset_stat(void);
 
+/**
+ * Return the number of network threads.
+ */
+int
+iproto_thread_count(void);
+
+/**
+ * Invoke @a cb for every network statistics counter of
+ * the network thread @a thread_id, or, if @a thread_id is
+ * negative, for the counters summed up over all threads.
+ */
+int
+iproto_rmean_foreach(int thread_id, rmean_cb cb, void *cb_ctx);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 
+/**
+ * Start @a thread_count network threads. Incoming connections
+ * are spread between them by the kernel.
+ */
 void
-iproto_init();
+iproto_init(int thread_count);
 
 void
 iproto_bind(const char *uri);
@@ -86,6 +86,8 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 	/* 0x26 */	MP_MAP, /* IPROTO_VCLOCK */
 	/* 0x27 */	MP_STR, /* IPROTO_EXPR */
 	/* 0x28 */	MP_ARRAY, /* IPROTO_OPS */
+	/* 0x29 */	MP_UINT, /* IPROTO_COMPRESSION */
+	/* 0x2a */	MP_BOOL, /* IPROTO_JOIN_XLOG_TX */
 	/* }}} */
 };
 
@@ -104,6 +106,11 @@ const char *iproto_type_strs[] =
 	"CALL",
 	"EXECUTE",
 	NULL, /* NOP */
+	NULL, /* PREPARE */
+	NULL, /* INSERT_BATCH */
+	NULL, /* REPLACE_BATCH */
+	NULL, /* GET_MULTI */
+	NULL, /* DEFERRED_DELETE */
 };
 
 #define bit(c) (1ULL<<IPROTO_##c)
@@ -121,6 +128,11 @@ const uint64_t iproto_body_key_map[IPROTO_TYPE_STAT_MAX] = {
 	0,                                                     /* CALL */
 	0,                                                     /* EXECUTE */
 	bit(SPACE_ID),                                         /* NOP */
+	0,                                                     /* PREPARE */
+	bit(SPACE_ID) | bit(TUPLE),                            /* INSERT_BATCH */
+	bit(SPACE_ID) | bit(TUPLE),                            /* REPLACE_BATCH */
+	bit(SPACE_ID) | bit(KEY),                              /* GET_MULTI */
+	bit(SPACE_ID) | bit(TUPLE),                            /* DEFERRED_DELETE */
 };
 #undef bit
 
@@ -166,8 +178,8 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"vector clock",     /* 0x26 */
 	"expression",       /* 0x27 */
 	"operations",       /* 0x28 */
-	NULL,               /* 0x29 */
-	NULL,               /* 0x2a */
+	"compression",      /* 0x29 */
+	"join xlog tx",     /* 0x2a */
 	NULL,               /* 0x2b */
 	NULL,               /* 0x2c */
 	NULL,               /* 0x2d */
@@ -194,6 +206,8 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"SQL options",      /* 0x42 */
 	"SQL info",         /* 0x43 */
 	"SQL row count",    /* 0x44 */
+	"statement id",     /* 0x45 */
+	"bind count",       /* 0x46 */
 };
 
 const char *vy_page_info_key_strs[VY_PAGE_INFO_KEY_MAX] = {
@@ -213,7 +227,10 @@ const char *vy_run_info_key_strs[VY_RUN_INFO_KEY_MAX] = {
 	"min lsn",
 	"max lsn",
 	"page count",
-	"bloom filter"
+	"bloom filter",
+	"prefix part count",
+	"prefix bloom filter",
+	"dump time",
 };
 
 const char *vy_row_index_key_strs[VY_ROW_INDEX_KEY_MAX] = {
@@ -87,6 +87,17 @@ enum iproto_key {
 	/* Also request keys. See the comment above. */
 	IPROTO_EXPR = 0x27, /* EVAL */
 	IPROTO_OPS = 0x28, /* UPSERT but not UPDATE ops, because of legacy */
+	/**
+	 * Compression of the rows streamed in response to
+	 * SUBSCRIBE, see enum iproto_compression. Requested
+	 * by the replica, confirmed by the master.
+	 */
+	IPROTO_COMPRESSION = 0x29,
+	/**
+	 * Set in JOIN by a replica which accepts the snapshot
+	 * as IPROTO_XLOG_TX rows, see below.
+	 */
+	IPROTO_JOIN_XLOG_TX = 0x2a,
 
 	/* Leave a gap between request keys and response keys */
 	IPROTO_DATA = 0x30,
@@ -111,6 +122,14 @@ enum iproto_key {
 	 */
 	IPROTO_SQL_INFO = 0x43,
 	IPROTO_SQL_ROW_COUNT = 0x44,
+	/**
+	 * Id of a statement compiled with PREPARE. Is sent
+	 * in IPROTO_SQL_INFO of the PREPARE response and can
+	 * be passed to EXECUTE instead of IPROTO_SQL_TEXT.
+	 */
+	IPROTO_STMT_ID = 0x45,
+	/** Number of parameters of a prepared statement. */
+	IPROTO_BIND_COUNT = 0x46,
 	IPROTO_KEY_MAX
 };
 
@@ -123,6 +142,17 @@ enum iproto_metadata_key {
 	IPROTO_FIELD_NAME = 0,
 };
 
+/** Compression methods of the replication stream. */
+enum iproto_compression {
+	/** Rows are sent as is. */
+	IPROTO_COMPRESSION_NONE = 0,
+	/**
+	 * Rows are sent as a single zstd stream, which is
+	 * flushed after each write.
+	 */
+	IPROTO_COMPRESSION_ZSTD = 1,
+};
+
 #define bit(c) (1ULL<<IPROTO_##c)
 
 #define IPROTO_HEAD_BMAP (bit(REQUEST_TYPE) | bit(SYNC) | bit(REPLICA_ID) |\
@@ -186,6 +216,21 @@ enum iproto_type {
 	IPROTO_EXECUTE = 11,
 	/** No operation. Treated as DML, used to bump LSN. */
 	IPROTO_NOP = 12,
+	/** Compile an SQL statement for later execution. */
+	IPROTO_PREPARE = 13,
+	/** Insert an array of tuples in one transaction. */
+	IPROTO_INSERT_BATCH = 14,
+	/** Replace an array of tuples in one transaction. */
+	IPROTO_REPLACE_BATCH = 15,
+	/** Get tuples by an array of keys from a unique index. */
+	IPROTO_GET_MULTI = 16,
+	/**
+	 * Delete an overwritten tuple from secondary indexes of
+	 * a vinyl space. Written to WAL by vinyl on primary index
+	 * compaction, see space_opts::defer_deletes. Not accepted
+	 * from clients.
+	 */
+	IPROTO_DEFERRED_DELETE = 17,
 	/** The maximum typecode used for box.stat() */
 	IPROTO_TYPE_STAT_MAX,
 
@@ -197,6 +242,11 @@ enum iproto_type {
 	IPROTO_SUBSCRIBE = 66,
 	/** Vote request command for master election */
 	IPROTO_REQUEST_VOTE = 67,
+	/**
+	 * A transaction block of a snapshot file sent as is
+	 * on initial join: { IPROTO_DATA: bin(fixheader + tx) }.
+	 */
+	IPROTO_XLOG_TX = 68,
 
 	/** Vinyl run info stored in .index file */
 	VY_INDEX_RUN_INFO = 100,
@@ -222,16 +272,29 @@ static inline const char *
 iproto_type_name(uint32_t type)
 {
 	/*
-	 * Sic: iptoto_type_strs[IPROTO_NOP] is NULL
-	 * to suppress box.stat() output.
+	 * Sic: iptoto_type_strs[IPROTO_NOP], [IPROTO_PREPARE],
+	 * the batch requests, [IPROTO_GET_MULTI] and
+	 * [IPROTO_DEFERRED_DELETE] are NULL to suppress box.stat()
+	 * output.
 	 */
-	if (type == IPROTO_NOP)
-		return "NOP";
-
-	if (type < IPROTO_TYPE_STAT_MAX)
+	if (type < IPROTO_TYPE_STAT_MAX && iproto_type_strs[type] != NULL)
 		return iproto_type_strs[type];
 
 	switch (type) {
+	case IPROTO_NOP:
+		return "NOP";
+	case IPROTO_PREPARE:
+		return "PREPARE";
+	case IPROTO_INSERT_BATCH:
+		return "INSERT_BATCH";
+	case IPROTO_REPLACE_BATCH:
+		return "REPLACE_BATCH";
+	case IPROTO_GET_MULTI:
+		return "GET_MULTI";
+	case IPROTO_DEFERRED_DELETE:
+		return "DEFERRED_DELETE";
+	case IPROTO_XLOG_TX:
+		return "XLOG_TX";
 	case VY_INDEX_RUN_INFO:
 		return "RUNINFO";
 	case VY_INDEX_PAGE_INFO:
@@ -261,7 +324,15 @@ static inline bool
 iproto_type_is_dml(uint32_t type)
 {
 	return (type >= IPROTO_SELECT && type <= IPROTO_DELETE) ||
-		type == IPROTO_UPSERT || type == IPROTO_NOP;
+		type == IPROTO_UPSERT || type == IPROTO_NOP ||
+		type == IPROTO_DEFERRED_DELETE;
+}
+
+/** A request applying a DML operation to an array of tuples. */
+static inline bool
+iproto_type_is_batch(uint32_t type)
+{
+	return type == IPROTO_INSERT_BATCH || type == IPROTO_REPLACE_BATCH;
 }
 
 /**
@@ -272,7 +343,8 @@ static inline uint64_t
 dml_request_key_map(uint32_t type)
 {
 	/** Advanced requests don't have a defined key map. */
-	assert(iproto_type_is_dml(type));
+	assert(iproto_type_is_dml(type) || iproto_type_is_batch(type) ||
+	       type == IPROTO_GET_MULTI);
 	extern const uint64_t iproto_body_key_map[];
 	return iproto_body_key_map[type];
 }
@@ -339,6 +411,12 @@ enum vy_run_info_key {
 	VY_RUN_INFO_PAGE_COUNT = 5,
 	/** Bloom filter for keys. */
 	VY_RUN_INFO_BLOOM = 6,
+	/** Number of key parts hashed by the prefix bloom filter. */
+	VY_RUN_INFO_PREFIX_PART_COUNT = 7,
+	/** Bloom filter for key prefixes. */
+	VY_RUN_INFO_PREFIX_BLOOM = 8,
+	/** Time of the most recent dump of the run data. */
+	VY_RUN_INFO_DUMP_TIME = 9,
 	/** The last key in this enum + 1 */
 	VY_RUN_INFO_KEY_MAX
 };
@@ -116,6 +116,29 @@ typedef uint32_t (*tuple_hash_t)(const struct tuple *tuple,
 typedef uint32_t (*key_hash_t)(const char *key,
 				const struct key_def *key_def);
 
+/**
+ * Tuple comparison hint. It is an integer value such that
+ * for any two tuples or keys a and b hint(a) < hint(b) implies
+ * a < b in terms of the key definition the hints were computed
+ * for. Equal hints tell nothing, tuples have to be compared.
+ * @sa tuple_hint(), key_hint().
+ */
+typedef uint64_t hint_t;
+
+/**
+ * Hint value meaning that no hint is available and a full
+ * comparison is required. It is never returned for a value
+ * that can be hinted.
+ */
+#define HINT_NONE ((hint_t)UINT64_MAX)
+
+/** @copydoc tuple_hint() */
+typedef hint_t (*tuple_hint_t)(const struct tuple *tuple,
+			       const struct key_def *key_def);
+/** @copydoc key_hint() */
+typedef hint_t (*key_hint_t)(const char *key, uint32_t part_count,
+			     const struct key_def *key_def);
+
 /* Definition of a multipart key. */
 struct key_def {
 	/** @see tuple_compare() */
@@ -130,6 +153,10 @@ struct key_def {
 	tuple_hash_t tuple_hash;
 	/** @see key_hash() */
 	key_hash_t key_hash;
+	/** @see tuple_hint() */
+	tuple_hint_t tuple_hint;
+	/** @see key_hint() */
+	key_hint_t key_hint;
 	/**
 	 * Minimal part count which always is unique. For example,
 	 * if a secondary index is unique, then
@@ -524,6 +551,48 @@ tuple_compare_with_key(const struct tuple *tuple, const char *key,
 	return key_def->tuple_compare_with_key(tuple, key, part_count, key_def);
 }
 
+/**
+ * Compute a comparison hint for a tuple. The hint is based
+ * on the first key part only.
+ * @param tuple tuple to compute the hint for
+ * @param key_def key definition
+ *
+ * @retval comparison hint or HINT_NONE
+ */
+static inline hint_t
+tuple_hint(const struct tuple *tuple, const struct key_def *key_def)
+{
+	return key_def->tuple_hint(tuple, key_def);
+}
+
+/**
+ * Compute a comparison hint for a key.
+ * @param key key parts without MessagePack array header
+ * @param part_count the number of parts in @a key
+ * @param key_def key definition
+ *
+ * @retval comparison hint or HINT_NONE
+ */
+static inline hint_t
+key_hint(const char *key, uint32_t part_count, const struct key_def *key_def)
+{
+	return key_def->key_hint(key, part_count, key_def);
+}
+
+/**
+ * Compare two comparison hints.
+ * @retval <0 or >0 if the hints are known to be different
+ * @retval 0 if the hints are equal or at least one of them
+ *         is HINT_NONE, i.e. a full comparison is required
+ */
+static inline int
+hint_cmp(hint_t hint_a, hint_t hint_b)
+{
+	if (hint_a == hint_b || hint_a == HINT_NONE || hint_b == HINT_NONE)
+		return 0;
+	return hint_a < hint_b ? -1 : 1;
+}
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
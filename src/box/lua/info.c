@@ -116,6 +116,14 @@ lbox_pushrelay(lua_State *L, struct relay *relay)
 	lua_pushstring(L, "vclock");
 	lbox_pushvclock(L, relay_vclock(relay));
 	lua_settable(L, -3);
+
+	lua_pushstring(L, "rows_per_write");
+	lua_pushnumber(L, relay_rows_per_write(relay));
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "compression_ratio");
+	lua_pushnumber(L, relay_compression_ratio(relay));
+	lua_settable(L, -3);
 }
 
 static void
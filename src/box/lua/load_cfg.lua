@@ -20,6 +20,7 @@ local default_cfg = {
     vinyl_dir           = '.',
     vinyl_memory        = 128 * 1024 * 1024,
     vinyl_cache         = 128 * 1024 * 1024,
+    vinyl_page_cache    = 0,
     vinyl_max_tuple_size = 1024 * 1024,
     vinyl_read_threads  = 1,
     vinyl_write_threads = 2,
@@ -29,18 +30,24 @@ local default_cfg = {
     vinyl_range_size          = 1024 * 1024 * 1024,
     vinyl_page_size           = 8 * 1024,
     vinyl_bloom_fpr           = 0.05,
+    vinyl_write_rate_limit    = nil, -- no limit
+    vinyl_read_latency_target = nil, -- no adaptation
     log                 = nil,
     log_nonblock        = true,
     log_level           = 5,
     log_format          = "plain",
     io_collect_interval = nil,
     readahead           = 16320,
+    iproto_threads      = 1,
     snap_io_rate_limit  = nil, -- no limit
     too_long_threshold  = 0.5,
     wal_mode            = "write",
     rows_per_wal        = 500000,
     wal_max_size        = 256 * 1024 * 1024,
     wal_dir_rescan_delay= 2,
+    wal_group_commit_delay    = 0,
+    wal_group_commit_min_size = 0,
+    wal_group_commit_adaptive = false,
     force_recovery      = false,
     replication         = nil,
     instance_uuid       = nil,
@@ -57,6 +64,8 @@ local default_cfg = {
     worker_pool_threads = 4,
     replication_timeout = 1,
     replication_sync_lag = 10,
+    replication_apply_fibers = 1,
+    replication_compression = false,
     replication_connect_timeout = 4,
     replication_connect_quorum = nil, -- connect all
 }
@@ -75,6 +84,7 @@ local template_cfg = {
     vinyl_dir           = 'string',
     vinyl_memory        = 'number',
     vinyl_cache               = 'number',
+    vinyl_page_cache          = 'number',
     vinyl_max_tuple_size      = 'number',
     vinyl_read_threads        = 'number',
     vinyl_write_threads       = 'number',
@@ -84,6 +94,8 @@ local template_cfg = {
     vinyl_range_size          = 'number',
     vinyl_page_size           = 'number',
     vinyl_bloom_fpr           = 'number',
+    vinyl_write_rate_limit    = 'number',
+    vinyl_read_latency_target = 'number',
 
     log              = 'string',
     log_nonblock     = 'boolean',
@@ -91,12 +103,16 @@ local template_cfg = {
     log_format          = 'string',
     io_collect_interval = 'number',
     readahead           = 'number',
+    iproto_threads      = 'number',
     snap_io_rate_limit  = 'number',
     too_long_threshold  = 'number',
     wal_mode            = 'string',
     rows_per_wal        = 'number',
     wal_max_size        = 'number',
     wal_dir_rescan_delay= 'number',
+    wal_group_commit_delay    = 'number',
+    wal_group_commit_min_size = 'number',
+    wal_group_commit_adaptive = 'boolean',
     force_recovery      = 'boolean',
     replication         = 'string, number, table',
     instance_uuid       = 'string',
@@ -113,6 +129,8 @@ local template_cfg = {
     worker_pool_threads = 'number',
     replication_timeout = 'number',
     replication_sync_lag = 'number',
+    replication_apply_fibers = 'number',
+    replication_compression = 'boolean',
     replication_connect_timeout = 'number',
     replication_connect_quorum = 'number',
 }
@@ -169,9 +187,15 @@ local dynamic_cfg = {
     snap_io_rate_limit      = private.cfg_set_snap_io_rate_limit,
     read_only               = private.cfg_set_read_only,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
+    wal_group_commit_delay  = private.cfg_set_wal_group_commit,
+    wal_group_commit_min_size = private.cfg_set_wal_group_commit,
+    wal_group_commit_adaptive = private.cfg_set_wal_group_commit,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_cache             = private.cfg_set_vinyl_cache,
+    vinyl_page_cache        = private.cfg_set_vinyl_page_cache,
     vinyl_timeout           = private.cfg_set_vinyl_timeout,
+    vinyl_write_rate_limit  = private.cfg_set_vinyl_write_rate_limit,
+    vinyl_read_latency_target = private.cfg_set_vinyl_read_latency_target,
     checkpoint_count        = private.cfg_set_checkpoint_count,
     checkpoint_interval     = private.checkpoint_daemon.set_checkpoint_interval,
     worker_pool_threads     = private.cfg_set_worker_pool_threads,
@@ -182,6 +206,8 @@ local dynamic_cfg = {
     end,
     force_recovery          = function() end,
     replication_timeout     = private.cfg_set_replication_timeout,
+    replication_apply_fibers = private.cfg_set_replication_apply_fibers,
+    replication_compression = private.cfg_set_replication_compression,
     replication_connect_quorum = private.cfg_set_replication_connect_quorum,
 }
 
@@ -190,6 +216,8 @@ local dynamic_cfg_skip_at_load = {
     listen                  = true,
     replication             = true,
     replication_timeout     = true,
+    replication_apply_fibers = true,
+    replication_compression = true,
     replication_connect_quorum = true,
     wal_dir_rescan_delay    = true,
     custom_proc_title       = true,
@@ -36,6 +36,7 @@
 #include "lua/msgpack.h"
 
 #include "box/box.h"
+#include "box/index.h"
 #include "box/port.h"
 #include "box/lua/tuple.h"
 
@@ -112,11 +113,37 @@ lbox_select(lua_State *L)
 
 /* }}} */
 
+/** {{{ Lua/C implementation of index:get_multi() **/
+
+static int
+lbox_index_get_multi(lua_State *L)
+{
+	if (lua_gettop(L) != 3 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2))
+		return luaL_error(L, "Usage index:get_multi(keys)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	size_t keys_len;
+	const char *keys = lbox_encode_tuple_on_gc(L, 3, &keys_len);
+
+	struct port port;
+	if (box_index_get_multi(space_id, index_id, keys, keys + keys_len,
+				&port) != 0) {
+		return luaT_error(L);
+	}
+	lbox_port_to_table(L, &port);
+	port_destroy(&port);
+	return 1; /* lua table with tuples */
+}
+
+/* }}} */
+
 void
 box_lua_misc_init(struct lua_State *L)
 {
 	static const struct luaL_Reg boxlib_internal[] = {
 		{"select", lbox_select},
+		{"get_multi", lbox_index_get_multi},
 		{NULL, NULL}
 	};
 
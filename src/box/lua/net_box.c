@@ -306,6 +306,48 @@ netbox_encode_replace(lua_State *L)
 	return netbox_encode_insert_or_replace(L, IPROTO_REPLACE);
 }
 
+static int
+netbox_encode_insert_batch(lua_State *L)
+{
+	return netbox_encode_insert_or_replace(L, IPROTO_INSERT_BATCH);
+}
+
+static int
+netbox_encode_replace_batch(lua_State *L)
+{
+	return netbox_encode_insert_or_replace(L, IPROTO_REPLACE_BATCH);
+}
+
+static int
+netbox_encode_get_multi(lua_State *L)
+{
+	if (lua_gettop(L) < 6)
+		return luaL_error(L, "Usage: netbox.encode_get_multi(ibuf, "
+		       "sync, schema_version, space_id, index_id, keys)");
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_GET_MULTI);
+
+	luamp_encode_map(cfg, &stream, 3);
+
+	/* encode space_id */
+	uint32_t space_id = lua_tonumber(L, 4);
+	luamp_encode_uint(cfg, &stream, IPROTO_SPACE_ID);
+	luamp_encode_uint(cfg, &stream, space_id);
+
+	/* encode index_id */
+	uint32_t index_id = lua_tonumber(L, 5);
+	luamp_encode_uint(cfg, &stream, IPROTO_INDEX_ID);
+	luamp_encode_uint(cfg, &stream, index_id);
+
+	/* encode keys */
+	luamp_encode_uint(cfg, &stream, IPROTO_KEY);
+	luamp_encode_tuple(L, cfg, &stream, 6);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
 static int
 netbox_encode_delete(lua_State *L)
 {
@@ -566,10 +608,17 @@ netbox_encode_execute(lua_State *L)
 
 	luamp_encode_map(cfg, &stream, 3);
 
-	size_t len;
-	const char *query = lua_tolstring(L, 4, &len);
-	luamp_encode_uint(cfg, &stream, IPROTO_SQL_TEXT);
-	luamp_encode_str(cfg, &stream, query, len);
+	if (lua_type(L, 4) == LUA_TNUMBER) {
+		/* Id of a prepared statement. */
+		uint64_t stmt_id = luaL_touint64(L, 4);
+		luamp_encode_uint(cfg, &stream, IPROTO_STMT_ID);
+		luamp_encode_uint(cfg, &stream, stmt_id);
+	} else {
+		size_t len;
+		const char *query = lua_tolstring(L, 4, &len);
+		luamp_encode_uint(cfg, &stream, IPROTO_SQL_TEXT);
+		luamp_encode_str(cfg, &stream, query, len);
+	}
 
 	luamp_encode_uint(cfg, &stream, IPROTO_SQL_BIND);
 	luamp_encode_tuple(L, cfg, &stream, 5);
@@ -581,6 +630,26 @@ netbox_encode_execute(lua_State *L)
 	return 0;
 }
 
+static int
+netbox_encode_prepare(lua_State *L)
+{
+	if (lua_gettop(L) < 4)
+		return luaL_error(L, "Usage: netbox.encode_prepare(ibuf, "\
+				  "sync, schema_version, query)");
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_PREPARE);
+
+	luamp_encode_map(cfg, &stream, 1);
+
+	size_t len;
+	const char *query = lua_tolstring(L, 4, &len);
+	luamp_encode_uint(cfg, &stream, IPROTO_SQL_TEXT);
+	luamp_encode_str(cfg, &stream, query, len);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
 int
 luaopen_net_box(struct lua_State *L)
 {
@@ -592,10 +661,14 @@ luaopen_net_box(struct lua_State *L)
 		{ "encode_select",  netbox_encode_select },
 		{ "encode_insert",  netbox_encode_insert },
 		{ "encode_replace", netbox_encode_replace },
+		{ "encode_insert_batch", netbox_encode_insert_batch },
+		{ "encode_replace_batch", netbox_encode_replace_batch },
+		{ "encode_get_multi", netbox_encode_get_multi },
 		{ "encode_delete",  netbox_encode_delete },
 		{ "encode_update",  netbox_encode_update },
 		{ "encode_upsert",  netbox_encode_upsert },
 		{ "encode_execute", netbox_encode_execute},
+		{ "encode_prepare", netbox_encode_prepare},
 		{ "encode_auth",    netbox_encode_auth },
 		{ "decode_greeting",netbox_decode_greeting },
 		{ "communicate",    netbox_communicate },
@@ -39,6 +39,8 @@ local IPROTO_SCHEMA_VERSION_KEY = 0x05
 local IPROTO_METADATA_KEY = 0x32
 local IPROTO_SQL_INFO_KEY = 0x43
 local IPROTO_SQL_ROW_COUNT_KEY = 0x44
+local IPROTO_STMT_ID_KEY   = 0x45
+local IPROTO_BIND_COUNT_KEY = 0x46
 local IPROTO_FIELD_NAME_KEY = 0
 local IPROTO_DATA_KEY      = 0x30
 local IPROTO_ERROR_KEY     = 0x31
@@ -60,11 +62,15 @@ local method_codec           = {
     eval    = internal.encode_eval,
     insert  = internal.encode_insert,
     replace = internal.encode_replace,
+    insert_batch = internal.encode_insert_batch,
+    replace_batch = internal.encode_replace_batch,
+    get_multi = internal.encode_get_multi,
     delete  = internal.encode_delete,
     update  = internal.encode_update,
     upsert  = internal.encode_upsert,
     select  = internal.encode_select,
     execute = internal.encode_execute,
+    prepare = internal.encode_prepare,
     -- inject raw data into connection, used by console and tests
     inject = function(buf, id, schema_version, bytes)
         local ptr = buf:reserve(#bytes)
@@ -884,6 +890,33 @@ function remote_methods:execute(query, parameters, sql_opts, netbox_opts)
     return {metadata = metadata, rows = res}
 end
 
+--
+-- Compile an SQL statement on the server. The returned
+-- stmt_id can be passed to execute() instead of the query
+-- text to skip parsing and code generation.
+--
+function remote_methods:prepare(query, netbox_opts)
+    check_remote_arg(self, "prepare")
+    local timeout = self:request_timeout(netbox_opts)
+    local err, res, metadata, info = self._transport.perform_request(timeout,
+                                    nil, 'prepare', self.schema_version,
+                                    query)
+    if err then
+        box.error({code = err, reason = res})
+    end
+    assert(info ~= nil and info[IPROTO_STMT_ID_KEY] ~= nil)
+    local stmt = {stmt_id = info[IPROTO_STMT_ID_KEY],
+                  bind_count = info[IPROTO_BIND_COUNT_KEY]}
+    if metadata ~= nil then
+        for i, field_meta in pairs(metadata) do
+            field_meta["name"] = field_meta[IPROTO_FIELD_NAME_KEY]
+            field_meta[IPROTO_FIELD_NAME_KEY] = nil
+        end
+        stmt.metadata = metadata
+    end
+    return stmt
+end
+
 function remote_methods:wait_state(state, timeout)
     check_remote_arg(self, 'wait_state')
     if timeout == nil then
@@ -1048,6 +1081,18 @@ space_metatable = function(remote)
         return one_tuple(remote:_request('replace', opts, self.id, tuple))
     end
 
+    -- Insert or replace all tuples in one transaction. Returns
+    -- the list of rows which failed, as {row_no, errcode, errmsg}.
+    function methods:insert_batch(tuples, opts)
+        check_space_arg(self, 'insert_batch')
+        return remote:_request('insert_batch', opts, self.id, tuples)
+    end
+
+    function methods:replace_batch(tuples, opts)
+        check_space_arg(self, 'replace_batch')
+        return remote:_request('replace_batch', opts, self.id, tuples)
+    end
+
     function methods:select(key, opts)
         check_space_arg(self, 'select')
         return check_primary_index(self):select(key, opts)
@@ -1074,6 +1119,11 @@ space_metatable = function(remote)
         return check_primary_index(self):get(key, opts)
     end
 
+    function methods:get_multi(keys, opts)
+        check_space_arg(self, 'get_multi')
+        return check_primary_index(self):get_multi(keys, opts)
+    end
+
     function methods:format(format)
         if format == nil then
             return self._format
@@ -1110,6 +1160,18 @@ index_metatable = function(remote)
         if res[1] ~= nil then return res[1] end
     end
 
+    -- Get tuples by a list of keys in one request. Keys not
+    -- found are skipped.
+    function methods:get_multi(keys, opts)
+        check_index_arg(self, 'get_multi')
+        local key_list = {}
+        for i, key in ipairs(keys) do
+            key_list[i] = type(key) == 'table' and key or {key}
+        end
+        return remote:_request('get_multi', opts, self.space.id, self.id,
+                               key_list)
+    end
+
     function methods:min(key, opts)
         check_index_arg(self, 'min')
         if opts and opts.buffer then
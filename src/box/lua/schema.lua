@@ -384,6 +384,7 @@ box.schema.space.create = function(name, options)
         user = 'string, number',
         format = 'table',
         temporary = 'boolean',
+        defer_deletes = 'boolean',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -427,6 +428,7 @@ box.schema.space.create = function(name, options)
     -- filter out global parameters from the options array
     local space_options = setmap({
         temporary = options.temporary and true or nil,
+        defer_deletes = options.defer_deletes and true or nil,
     })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -637,6 +639,9 @@ local index_options = {
     range_size = 'number',
     page_size = 'number',
     bloom_fpr = 'number',
+    bloom_prefix_parts = 'number',
+    compaction_policy = 'string',
+    compaction_window = 'number',
 }
 
 --
@@ -741,6 +746,9 @@ box.schema.index.create = function(space_id, name, options)
             run_count_per_level = options.run_count_per_level,
             run_size_ratio = options.run_size_ratio,
             bloom_fpr = options.bloom_fpr,
+            bloom_prefix_parts = options.bloom_prefix_parts,
+            compaction_policy = options.compaction_policy,
+            compaction_window = options.compaction_window,
     }
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
@@ -1270,6 +1278,18 @@ function box.schema.space.bless(space)
             offset, limit, key)
     end
 
+    index_mt.get_multi = function(index, keys)
+        check_index_arg(index, 'get_multi')
+        if type(keys) ~= 'table' then
+            box.error(box.error.PROC_LUA, "Usage: index:get_multi({key, ...})")
+        end
+        local key_list = {}
+        for i, key in ipairs(keys) do
+            key_list[i] = keify(key)
+        end
+        return internal.get_multi(index.space_id, index.id, key_list)
+    end
+
     index_mt.update = function(index, key, ops)
         check_index_arg(index, 'update')
         return internal.update(index.space_id, index.id, keify(key), ops);
@@ -1349,6 +1369,10 @@ function box.schema.space.bless(space)
         check_space_arg(space, 'select')
         return check_primary_index(space):select(key, opts)
     end
+    space_mt.get_multi = function(space, keys)
+        check_space_arg(space, 'get_multi')
+        return check_primary_index(space):get_multi(keys)
+    end
     space_mt.insert = function(space, tuple)
         check_space_arg(space, 'insert')
         return internal.insert(space.id, tuple);
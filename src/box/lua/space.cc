@@ -293,6 +293,16 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			lua_pushnumber(L, index_opts->bloom_fpr);
 			lua_setfield(L, -2, "bloom_fpr");
 
+			lua_pushnumber(L, index_opts->bloom_prefix_parts);
+			lua_setfield(L, -2, "bloom_prefix_parts");
+
+			lua_pushstring(L, vy_compaction_policy_strs[
+					index_opts->compaction_policy]);
+			lua_setfield(L, -2, "compaction_policy");
+
+			lua_pushnumber(L, index_opts->compaction_window);
+			lua_setfield(L, -2, "compaction_window");
+
 			lua_settable(L, -3);
 		}
 
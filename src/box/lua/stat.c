@@ -44,9 +44,9 @@
 
 extern struct rmean *rmean_box;
 extern struct rmean *rmean_error;
-/** network statistics (iproto & cbus) */
-extern struct rmean *rmean_net;
 extern struct rmean *rmean_tx_wal_bus;
+/** WAL statistics (group commit) */
+extern struct rmean *rmean_wal;
 
 static void
 fill_stat_item(struct lua_State *L, int rps, int64_t total)
@@ -124,14 +124,54 @@ static int
 lbox_stat_net_index(struct lua_State *L)
 {
 	luaL_checkstring(L, -1);
-	return rmean_foreach(rmean_net, seek_stat_item, L);
+	return iproto_rmean_foreach(-1, seek_stat_item, L);
 }
 
 static int
 lbox_stat_net_call(struct lua_State *L)
 {
 	lua_newtable(L);
-	rmean_foreach(rmean_net, set_stat_item, L);
+	iproto_rmean_foreach(-1, set_stat_item, L);
+	return 1;
+}
+
+/**
+ * box.stat.net.thread() - network statistics of every
+ * network thread, box.stat.net.thread(i) - of the i-th one.
+ */
+static int
+lbox_stat_net_thread(struct lua_State *L)
+{
+	int count = iproto_thread_count();
+	if (lua_gettop(L) > 0) {
+		int id = luaL_checkinteger(L, 1);
+		if (id < 1 || id > count)
+			return luaL_error(L, "thread id is out of range");
+		lua_newtable(L);
+		iproto_rmean_foreach(id - 1, set_stat_item, L);
+		return 1;
+	}
+	lua_createtable(L, count, 0);
+	for (int i = 0; i < count; i++) {
+		lua_newtable(L);
+		iproto_rmean_foreach(i, set_stat_item, L);
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
+
+static int
+lbox_stat_wal_index(struct lua_State *L)
+{
+	luaL_checkstring(L, -1);
+	return rmean_foreach(rmean_wal, seek_stat_item, L);
+}
+
+static int
+lbox_stat_wal_call(struct lua_State *L)
+{
+	lua_newtable(L);
+	rmean_foreach(rmean_wal, set_stat_item, L);
 	return 1;
 }
 
@@ -147,6 +187,12 @@ static const struct luaL_Reg lbox_stat_net_meta [] = {
 	{NULL, NULL}
 };
 
+static const struct luaL_Reg lbox_stat_wal_meta [] = {
+	{"__index", lbox_stat_wal_index},
+	{"__call",  lbox_stat_wal_call},
+	{NULL, NULL}
+};
+
 /** Initialize box.stat package. */
 void
 box_lua_stat_init(struct lua_State *L)
@@ -164,11 +210,25 @@ box_lua_stat_init(struct lua_State *L)
 	lua_pop(L, 1); /* stat module */
 
 
-	luaL_register_module(L, "box.stat.net", statlib);
+	static const struct luaL_Reg netlib [] = {
+		{"reset", lbox_stat_reset},
+		{"thread", lbox_stat_net_thread},
+		{NULL, NULL}
+	};
+
+	luaL_register_module(L, "box.stat.net", netlib);
 
 	lua_newtable(L);
 	luaL_register(L, NULL, lbox_stat_net_meta);
 	lua_setmetatable(L, -2);
 	lua_pop(L, 1); /* stat net module */
+
+
+	luaL_register_module(L, "box.stat.wal", statlib);
+
+	lua_newtable(L);
+	luaL_register(L, NULL, lbox_stat_wal_meta);
+	lua_setmetatable(L, -2);
+	lua_pop(L, 1); /* stat wal module */
 }
 
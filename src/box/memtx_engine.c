@@ -35,7 +35,9 @@
 #include <small/small.h>
 #include <small/mempool.h>
 
+#include "cbus.h"
 #include "coio_file.h"
+#include "fiber_cond.h"
 #include "tuple.h"
 #include "txn.h"
 #include "memtx_tree.h"
@@ -84,11 +86,60 @@ memtx_end_build_primary_key(struct space *space, void *param)
 	    memtx_space->replace == memtx_space_replace_all_keys)
 		return 0;
 
-	index_end_build(space->index[0]);
+	if (index_end_build(space->index[0]) != 0)
+		return -1;
 	memtx_space->replace = memtx_space_replace_primary_key;
 	return 0;
 }
 
+/**
+ * Build all secondary indexes of a space in one pass over
+ * the primary key: each tuple is added to all indexes at once,
+ * while its data is hot in cache. Tree indexes then sort the
+ * collected tuples, using multiple threads for large indexes.
+ */
+static int
+memtx_build_secondary_keys_bulk(struct space *space, ssize_t n_tuples)
+{
+	struct index *pk = space->index[0];
+	uint32_t estimated_tuples = n_tuples * 1.2;
+	for (uint32_t j = 1; j < space->index_count; j++) {
+		struct index *index = space->index[j];
+		index_begin_build(index);
+		if (index_reserve(index, estimated_tuples) != 0)
+			return -1;
+		if (n_tuples > 0) {
+			say_info("Adding %zd keys to %s index '%s' ...",
+				 n_tuples, index_type_strs[index->def->type],
+				 index->def->name);
+		}
+	}
+
+	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
+	if (it == NULL)
+		return -1;
+	int rc;
+	struct tuple *tuple;
+	while ((rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
+		for (uint32_t j = 1; j < space->index_count; j++) {
+			rc = index_build_next(space->index[j], tuple);
+			if (rc != 0)
+				break;
+		}
+		if (rc != 0)
+			break;
+	}
+	iterator_delete(it);
+	if (rc != 0)
+		return -1;
+
+	for (uint32_t j = 1; j < space->index_count; j++) {
+		if (index_end_build(space->index[j]) != 0)
+			return -1;
+	}
+	return 0;
+}
+
 /**
  * Secondary indexes are built in bulk after all data is
  * recovered. This function enables secondary keys on a space.
@@ -113,10 +164,8 @@ memtx_build_secondary_keys(struct space *space, void *param)
 				 space_name(space));
 		}
 
-		for (uint32_t j = 1; j < space->index_count; j++) {
-			if (index_build(space->index[j], pk) < 0)
-				return -1;
-		}
+		if (memtx_build_secondary_keys_bulk(space, n_tuples) != 0)
+			return -1;
 
 		if (n_tuples > 0) {
 			say_info("Space '%s': done", space_name(space));
@@ -143,6 +192,326 @@ memtx_engine_shutdown(struct engine *engine)
 	memtx_tuple_free();
 }
 
+/* {{{ Snapshot reader ****************************************/
+
+enum {
+	/** Number of read requests sent to the reader in advance. */
+	SNAP_READER_QUEUE_SIZE = 4,
+	/** Amount of row data returned by one read request. */
+	SNAP_READER_BATCH_SIZE = 1024 * 1024,
+};
+
+struct snap_reader;
+
+/** A read request: a batch of rows read from the snapshot. */
+struct snap_read_msg {
+	struct cmsg base;
+	struct snap_reader *reader;
+	/** Decompressed rows, referenced by @rows. */
+	char *data;
+	size_t data_size;
+	size_t data_capacity;
+	/** Decoded row headers. */
+	struct xrow_header *rows;
+	uint32_t row_count;
+	uint32_t row_capacity;
+	/** Set if the end of the snapshot has been reached. */
+	bool is_eof;
+	/** Set when the request has returned to tx. */
+	bool is_ready;
+	/** Request status and error, if any. */
+	int rc;
+	struct diag diag;
+};
+
+/**
+ * Snapshot reader reads, decompresses and validates snapshot
+ * rows in a separate thread, so that tx only has to allocate
+ * tuples and insert them into the primary keys. Read requests
+ * are sent in advance and processed by the reader thread in
+ * order, which makes reading from disk overlap with loading
+ * of tuples.
+ */
+struct snap_reader {
+	/** Reader thread. */
+	struct cord cord;
+	/** Pipe from tx to the reader thread. */
+	struct cpipe reader_pipe;
+	/** Pipe from the reader thread to tx. */
+	struct cpipe tx_pipe;
+	/** Route of a read request. */
+	struct cmsg_hop route[2];
+	/**
+	 * Snapshot cursor. Opened, used and closed in
+	 * the reader thread only.
+	 */
+	struct xlog_cursor cursor;
+	/** Name of the snapshot file. */
+	const char *filename;
+	bool force_recovery;
+	/**
+	 * Set by the reader thread if the snapshot has been
+	 * read up to the EOF marker.
+	 */
+	bool is_eof;
+	/** Signaled when a read request returns to tx. */
+	struct fiber_cond cond;
+	/** Read requests. */
+	struct snap_read_msg msgs[SNAP_READER_QUEUE_SIZE];
+};
+
+/** Open the next tx in the snapshot, skip corrupted ones if allowed. */
+static int
+snap_reader_next_tx(struct snap_reader *reader)
+{
+	struct xlog_cursor *cursor = &reader->cursor;
+	int rc;
+	while ((rc = xlog_cursor_next_tx(cursor)) < 0) {
+		struct error *e = diag_last_error(diag_get());
+		if (!reader->force_recovery || e->type != &type_XlogError)
+			return -1;
+		say_error("can't open tx: %s", e->errmsg);
+		if ((rc = xlog_cursor_find_tx_magic(cursor)) < 0)
+			return -1;
+		if (rc > 0)
+			break;
+	}
+	return rc;
+}
+
+/** Make sure a read request can store @a size more bytes of rows. */
+static int
+snap_read_msg_reserve(struct snap_read_msg *msg, size_t size)
+{
+	if (msg->data_size + size <= msg->data_capacity)
+		return 0;
+	size_t capacity = MAX(msg->data_capacity * 2, msg->data_size + size);
+	/* Row bodies reference the buffer, store them as offsets. */
+	for (uint32_t i = 0; i < msg->row_count; i++) {
+		struct iovec *body = &msg->rows[i].body[0];
+		body->iov_base = (void *)((char *)body->iov_base - msg->data);
+	}
+	char *data = realloc(msg->data, capacity);
+	if (data != NULL) {
+		msg->data = data;
+		msg->data_capacity = capacity;
+	}
+	for (uint32_t i = 0; i < msg->row_count; i++) {
+		struct iovec *body = &msg->rows[i].body[0];
+		body->iov_base = msg->data + (size_t)body->iov_base;
+	}
+	if (data == NULL) {
+		diag_set(OutOfMemory, capacity, "realloc", "snapshot rows");
+		return -1;
+	}
+	return 0;
+}
+
+/** Append rows of the current snapshot tx to a read request. */
+static int
+snap_read_msg_add_tx(struct snap_read_msg *msg)
+{
+	struct snap_reader *reader = msg->reader;
+	size_t size;
+	const char *rows = xlog_cursor_tx_rows(&reader->cursor, &size);
+	if (snap_read_msg_reserve(msg, size) != 0)
+		return -1;
+	const char *pos = msg->data + msg->data_size;
+	const char *end = pos + size;
+	memcpy((char *)pos, rows, size);
+	msg->data_size += size;
+	/* Release the tx. */
+	struct xrow_header unused;
+	int rc = xlog_cursor_next_row(&reader->cursor, &unused);
+	assert(rc == 1);
+	(void)rc;
+	while (pos < end) {
+		if (msg->row_count == msg->row_capacity) {
+			uint32_t capacity = MAX(msg->row_capacity * 2, 1024);
+			struct xrow_header *rows = realloc(msg->rows,
+						capacity * sizeof(*rows));
+			if (rows == NULL) {
+				diag_set(OutOfMemory, capacity * sizeof(*rows),
+					 "realloc", "snapshot row headers");
+				return -1;
+			}
+			msg->rows = rows;
+			msg->row_capacity = capacity;
+		}
+		/*
+		 * Decode the header. The body is checked with
+		 * mp_check() by xrow_header_decode() as well.
+		 */
+		struct xrow_header *row = &msg->rows[msg->row_count];
+		if (xrow_header_decode(row, &pos, end) != 0) {
+			/* Keep the reason, it is replaced below. */
+			diag_log();
+			diag_set(XlogError, "can't parse row");
+			if (!reader->force_recovery)
+				return -1;
+			/* Discard remaining rows of the tx. */
+			say_error("skipping the rest of the tx");
+			break;
+		}
+		msg->row_count++;
+	}
+	return 0;
+}
+
+/** Read the next batch of rows. Runs in the reader thread. */
+static void
+snap_read_f(struct cmsg *base)
+{
+	struct snap_read_msg *msg = (struct snap_read_msg *)base;
+	struct snap_reader *reader = msg->reader;
+	msg->data_size = 0;
+	msg->row_count = 0;
+	msg->is_eof = false;
+	msg->rc = 0;
+	while (msg->data_size < SNAP_READER_BATCH_SIZE) {
+		if (xlog_cursor_is_eof(&reader->cursor)) {
+			msg->is_eof = true;
+			break;
+		}
+		int rc = snap_reader_next_tx(reader);
+		if (rc == 0)
+			rc = snap_read_msg_add_tx(msg);
+		if (rc < 0) {
+			msg->rc = -1;
+			diag_move(diag_get(), &msg->diag);
+			break;
+		}
+		if (rc > 0) {
+			msg->is_eof = true;
+			reader->is_eof = xlog_cursor_is_eof(&reader->cursor);
+			break;
+		}
+	}
+}
+
+/** Called in tx when a read request is complete. */
+static void
+snap_read_complete_f(struct cmsg *base)
+{
+	struct snap_read_msg *msg = (struct snap_read_msg *)base;
+	msg->is_ready = true;
+	fiber_cond_signal(&msg->reader->cond);
+}
+
+/** Send a read request to the reader thread. */
+static void
+snap_reader_send(struct snap_reader *reader, struct snap_read_msg *msg)
+{
+	assert(msg->is_ready);
+	msg->is_ready = false;
+	cmsg_init(&msg->base, reader->route);
+	cpipe_push(&reader->reader_pipe, &msg->base);
+}
+
+/** Wait until a read request returns to tx. */
+static void
+snap_reader_wait(struct snap_reader *reader, struct snap_read_msg *msg)
+{
+	while (!msg->is_ready)
+		fiber_cond_wait(&reader->cond);
+}
+
+static int
+snap_reader_f(va_list ap)
+{
+	struct snap_reader *reader = va_arg(ap, struct snap_reader *);
+	struct cbus_endpoint endpoint;
+
+	cpipe_create(&reader->tx_pipe, "tx_prio");
+	cbus_endpoint_create(&endpoint, cord_name(cord()),
+			     fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	if (xlog_cursor_is_open(&reader->cursor))
+		xlog_cursor_close(&reader->cursor, false);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&reader->tx_pipe);
+	return 0;
+}
+
+struct snap_reader_open_msg {
+	struct cbus_call_msg base;
+	struct snap_reader *reader;
+};
+
+static int
+snap_reader_open_f(struct cbus_call_msg *base)
+{
+	struct snap_reader_open_msg *msg = (struct snap_reader_open_msg *)base;
+	struct snap_reader *reader = msg->reader;
+	return xlog_cursor_open(&reader->cursor, reader->filename);
+}
+
+static void
+snap_reader_delete(struct snap_reader *reader);
+
+/** Start the reader thread and open the snapshot file. */
+static struct snap_reader *
+snap_reader_new(const char *filename, bool force_recovery)
+{
+	struct snap_reader *reader = calloc(1, sizeof(*reader));
+	if (reader == NULL) {
+		diag_set(OutOfMemory, sizeof(*reader), "calloc",
+			 "struct snap_reader");
+		return NULL;
+	}
+	reader->filename = filename;
+	reader->force_recovery = force_recovery;
+	fiber_cond_create(&reader->cond);
+	for (int i = 0; i < SNAP_READER_QUEUE_SIZE; i++) {
+		struct snap_read_msg *msg = &reader->msgs[i];
+		msg->reader = reader;
+		msg->is_ready = true;
+		diag_create(&msg->diag);
+	}
+	if (cord_costart(&reader->cord, "snap_reader",
+			 snap_reader_f, reader) != 0)
+		panic("failed to start snapshot reader thread");
+	cpipe_create(&reader->reader_pipe, "snap_reader");
+	reader->route[0].f = snap_read_f;
+	reader->route[0].pipe = &reader->tx_pipe;
+	reader->route[1].f = snap_read_complete_f;
+	reader->route[1].pipe = NULL;
+
+	struct snap_reader_open_msg msg;
+	msg.reader = reader;
+	if (cbus_call(&reader->reader_pipe, &reader->tx_pipe, &msg.base,
+		      snap_reader_open_f, NULL, TIMEOUT_INFINITY) != 0) {
+		snap_reader_delete(reader);
+		return NULL;
+	}
+	return reader;
+}
+
+/**
+ * Wait for all pending read requests, stop the reader
+ * thread and free the reader.
+ */
+static void
+snap_reader_delete(struct snap_reader *reader)
+{
+	for (int i = 0; i < SNAP_READER_QUEUE_SIZE; i++)
+		snap_reader_wait(reader, &reader->msgs[i]);
+	cbus_stop_loop(&reader->reader_pipe);
+	cpipe_destroy(&reader->reader_pipe);
+	if (cord_join(&reader->cord) != 0)
+		panic("failed to join snapshot reader thread");
+	for (int i = 0; i < SNAP_READER_QUEUE_SIZE; i++) {
+		struct snap_read_msg *msg = &reader->msgs[i];
+		diag_destroy(&msg->diag);
+		free(msg->data);
+		free(msg->rows);
+	}
+	fiber_cond_destroy(&reader->cond);
+	free(reader);
+}
+
+/* }}} */
+
 static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row);
@@ -158,32 +527,49 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 						    signature, NONE);
 
 	say_info("recovering from `%s'", filename);
-	struct xlog_cursor cursor;
-	if (xlog_cursor_open(&cursor, filename) < 0)
+	struct snap_reader *reader = snap_reader_new(filename,
+						     memtx->force_recovery);
+	if (reader == NULL)
 		return -1;
-	INSTANCE_UUID = cursor.meta.instance_uuid;
+	INSTANCE_UUID = reader->cursor.meta.instance_uuid;
+	for (int i = 0; i < SNAP_READER_QUEUE_SIZE; i++)
+		snap_reader_send(reader, &reader->msgs[i]);
 
-	int rc;
-	struct xrow_header row;
+	int rc = 0;
 	uint64_t row_count = 0;
-	while ((rc = xlog_cursor_next(&cursor, &row,
-				      memtx->force_recovery)) == 0) {
-		row.lsn = signature;
-		rc = memtx_engine_recover_snapshot_row(memtx, &row);
-		if (rc < 0) {
-			if (!memtx->force_recovery)
-				break;
-			say_error("can't apply row: ");
-			diag_log();
+	for (int i = 0; rc == 0; i = (i + 1) % SNAP_READER_QUEUE_SIZE) {
+		struct snap_read_msg *msg = &reader->msgs[i];
+		snap_reader_wait(reader, msg);
+		if (msg->rc != 0) {
+			diag_move(&msg->diag, diag_get());
+			rc = -1;
+			break;
 		}
-		++row_count;
-		if (row_count % 100000 == 0) {
-			say_info("%.1fM rows processed",
-				 row_count / 1000000.);
-			fiber_yield_timeout(0);
+		for (uint32_t j = 0; j < msg->row_count; j++) {
+			struct xrow_header *row = &msg->rows[j];
+			row->lsn = signature;
+			rc = memtx_engine_recover_snapshot_row(memtx, row);
+			if (rc < 0) {
+				if (!memtx->force_recovery)
+					break;
+				say_error("can't apply row: ");
+				diag_log();
+				rc = 0;
+			}
+			++row_count;
+			if (row_count % 100000 == 0) {
+				say_info("%.1fM rows processed",
+					 row_count / 1000000.);
+				fiber_yield_timeout(0);
+			}
 		}
+		if (msg->is_eof)
+			break;
+		if (rc == 0)
+			snap_reader_send(reader, msg);
 	}
-	xlog_cursor_close(&cursor, false);
+	bool is_eof = reader->is_eof;
+	snap_reader_delete(reader);
 	if (rc < 0)
 		return -1;
 
@@ -192,7 +578,7 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 	 * marker - such snapshots are very likely corrupted and
 	 * should not be trusted.
 	 */
-	if (!xlog_cursor_is_eof(&cursor))
+	if (!is_eof)
 		panic("snapshot `%s' has no EOF marker", filename);
 
 	return 0;
@@ -263,7 +649,8 @@ memtx_engine_begin_final_recovery(struct engine *engine)
 
 	assert(memtx->state == MEMTX_INITIAL_RECOVERY);
 	/* End of the fast path: loaded the primary key. */
-	space_foreach(memtx_end_build_primary_key, memtx);
+	if (space_foreach(memtx_end_build_primary_key, memtx) != 0)
+		return -1;
 
 	if (!memtx->force_recovery) {
 		/*
@@ -828,8 +1215,19 @@ memtx_initial_join_f(va_list ap)
 	if (rc < 0)
 		return -1;
 
+	/*
+	 * Feed the snapshot as is, a tx block at a time, to
+	 * spare the relay decompression and decoding of every
+	 * row. The relay unpacks the blocks if the replica
+	 * doesn't accept IPROTO_XLOG_TX rows.
+	 */
+	const char *data;
+	size_t size;
 	struct xrow_header row;
-	while ((rc = xlog_cursor_next(&cursor, &row, true)) == 0) {
+	while ((rc = xlog_cursor_next_tx_raw(&cursor, &data, &size)) == 0) {
+		rc = xrow_encode_xlog_tx(&row, data, size);
+		if (rc < 0)
+			break;
 		rc = xstream_write(stream, &row);
 		if (rc < 0)
 			break;
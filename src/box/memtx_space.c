@@ -873,18 +873,26 @@ memtx_space_build_secondary_key(struct space *old_space,
 	}
 
 	/* Now deal with any kind of add index during normal operation. */
+	ssize_t n_tuples = index_size(pk);
+	if (n_tuples < 0)
+		return -1;
+	index_begin_build(new_index);
+	if (index_reserve(new_index, n_tuples) != 0)
+		return -1;
+
 	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
 	if (it == NULL)
 		return -1;
 
 	/*
-	 * The index has to be built tuple by tuple, since
-	 * there is no guarantee that all tuples satisfy
-	 * new index' constraints. If any tuple can not be
-	 * added to the index (insufficient number of fields,
-	 * etc., the build is aborted.
+	 * The index is built in bulk: tree indexes collect
+	 * all tuples, sort them and check them for duplicates
+	 * in end_build(), other indexes insert tuples one by
+	 * one. Still, there is no guarantee that all tuples
+	 * satisfy new index' constraints. If any tuple can not
+	 * be added to the index (insufficient number of fields,
+	 * a duplicate, etc.), the build is aborted.
 	 */
-	/* Build the new index. */
 	int rc;
 	struct tuple *tuple;
 	while ((rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
@@ -895,19 +903,17 @@ memtx_space_build_secondary_key(struct space *old_space,
 		rc = tuple_validate(new_space->format, tuple);
 		if (rc != 0)
 			break;
-		/*
-		 * @todo: better message if there is a duplicate.
-		 */
-		struct tuple *old_tuple;
-		rc = index_replace(new_index, NULL, tuple,
-				   DUP_INSERT, &old_tuple);
+		rc = index_build_next(new_index, tuple);
 		if (rc != 0)
 			break;
-		assert(old_tuple == NULL); /* Guaranteed by DUP_INSERT. */
-		(void) old_tuple;
 	}
 	iterator_delete(it);
-	return rc;
+	if (rc != 0)
+		return -1;
+	/*
+	 * @todo: better message if there is a duplicate.
+	 */
+	return index_end_build(new_index);
 }
 
 static int
@@ -999,6 +1005,7 @@ static const struct space_vtab memtx_space_vtab = {
 	/* .execute_delete = */ memtx_space_execute_delete,
 	/* .execute_update = */ memtx_space_execute_update,
 	/* .execute_upsert = */ memtx_space_execute_upsert,
+	/* .execute_deferred_delete = */ NULL,
 	/* .ephemeral_replace = */ memtx_space_ephemeral_replace,
 	/* .ephemeral_delete = */ memtx_space_ephemeral_delete,
 	/* .ephemeral_cleanup = */ memtx_space_ephemeral_cleanup,
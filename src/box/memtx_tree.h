@@ -51,12 +51,47 @@ struct memtx_tree_key_data
 	const char *key;
 	/** Number of msgpacked search fields */
 	uint32_t part_count;
+	/** Comparison hint, see key_hint(). */
+	hint_t hint;
 };
 
+/**
+ * Struct that is used as an element in BPS tree definition.
+ * The comparison hint is stored next to the tuple pointer so
+ * that most comparisons made while descending the tree are
+ * resolved without looking at the tuple data.
+ */
+struct memtx_tree_data {
+	/** Indexed tuple. */
+	struct tuple *tuple;
+	/** Comparison hint, see tuple_hint(). */
+	hint_t hint;
+};
+
+/**
+ * BPS tree element comparator.
+ * @param element_a - the first element to compare.
+ * @param element_b - the second element to compare.
+ * @param def - key definition.
+ * @retval 0  if a == b in terms of def.
+ * @retval <0 if a < b in terms of def.
+ * @retval >0 if a > b in terms of def.
+ */
+static inline int
+memtx_tree_compare(const struct memtx_tree_data *element_a,
+		   const struct memtx_tree_data *element_b,
+		   struct key_def *def)
+{
+	int rc = hint_cmp(element_a->hint, element_b->hint);
+	if (rc != 0)
+		return rc;
+	return tuple_compare(element_a->tuple, element_b->tuple, def);
+}
+
 /**
  * BPS tree element vs key comparator.
  * Defined in header in order to allow compiler to inline it.
- * @param tuple - tuple to compare.
+ * @param element - tree element to compare.
  * @param key_data - key to compare with.
  * @param def - key definition.
  * @retval 0  if tuple == key in terms of def.
@@ -64,20 +99,24 @@ struct memtx_tree_key_data
  * @retval >0 if tuple > key in terms of def.
  */
 static inline int
-memtx_tree_compare_key(const struct tuple *tuple,
+memtx_tree_compare_key(const struct memtx_tree_data *element,
 		       const struct memtx_tree_key_data *key_data,
 		       struct key_def *def)
 {
-	return tuple_compare_with_key(tuple, key_data->key,
+	int rc = hint_cmp(element->hint, key_data->hint);
+	if (rc != 0)
+		return rc;
+	return tuple_compare_with_key(element->tuple, key_data->key,
 				      key_data->part_count, def);
 }
 
 #define BPS_TREE_NAME memtx_tree
 #define BPS_TREE_BLOCK_SIZE (512)
 #define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
-#define BPS_TREE_COMPARE(a, b, arg) tuple_compare(a, b, arg)
-#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_compare_key(a, b, arg)
-#define bps_tree_elem_t struct tuple *
+#define BPS_TREE_COMPARE(a, b, arg) memtx_tree_compare(&(a), &(b), arg)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_compare_key(&(a), b, arg)
+#define BPS_TREE_IS_IDENTICAL(a, b) ((a).tuple == (b).tuple)
+#define bps_tree_elem_t struct memtx_tree_data
 #define bps_tree_key_t struct memtx_tree_key_data *
 #define bps_tree_arg_t struct key_def *
 
@@ -88,6 +127,7 @@ memtx_tree_compare_key(const struct tuple *tuple,
 #undef BPS_TREE_EXTENT_SIZE
 #undef BPS_TREE_COMPARE
 #undef BPS_TREE_COMPARE_KEY
+#undef BPS_TREE_IS_IDENTICAL
 #undef bps_tree_elem_t
 #undef bps_tree_key_t
 #undef bps_tree_arg_t
@@ -95,7 +135,7 @@ memtx_tree_compare_key(const struct tuple *tuple,
 struct memtx_tree_index {
 	struct index base;
 	struct memtx_tree tree;
-	struct tuple **build_array;
+	struct memtx_tree_data *build_array;
 	size_t build_array_size, build_array_alloc_size;
 };
 
@@ -320,6 +320,14 @@ recover_current_wal:
 	region_free(&fiber()->gc);
 }
 
+void
+recovery_skip_log(struct recovery *r)
+{
+	if (xlog_cursor_is_open(&r->cursor))
+		xlog_cursor_close(&r->cursor, false);
+	trigger_run_xc(&r->on_close_log, NULL);
+}
+
 void
 recovery_finalize(struct recovery *r, struct xstream *stream)
 {
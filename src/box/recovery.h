@@ -100,4 +100,15 @@ void
 recover_remaining_wals(struct recovery *r, struct xstream *stream,
 		       struct vclock *stop_vclock, bool scan_dir);
 
+/**
+ * Close the xlog file being read, if any, and run on_close_log
+ * triggers as if all rows up to the current vclock were read
+ * from xlog files. Used when rows are obtained some other way,
+ * e.g. from the WAL memory buffer. The next call to
+ * recover_remaining_wals() resumes reading from the file that
+ * stores rows following the current vclock.
+ */
+void
+recovery_skip_log(struct recovery *r);
+
 #endif /* TARANTOOL_RECOVERY_H_INCLUDED */
@@ -30,6 +30,10 @@
  */
 #include "relay.h"
 
+#include <small/ibuf.h>
+#include <small/obuf.h>
+#include <zstd.h>
+
 #include "trivia/config.h"
 #include "trivia/util.h"
 #include "cbus.h"
@@ -37,6 +41,7 @@
 #include "errinj.h"
 #include "fiber.h"
 #include "say.h"
+#include "scoped_guard.h"
 
 #include "coio.h"
 #include "coio_task.h"
@@ -52,6 +57,35 @@
 #include "xrow_io.h"
 #include "xstream.h"
 #include "wal.h"
+#include "xlog.h"
+
+enum {
+	/**
+	 * Rows sent to the replica are accumulated in the relay
+	 * output buffer, which is flushed once it exceeds this size.
+	 */
+	RELAY_SEND_BUF_MAX = 64 * 1024,
+	/** Level of compression of the stream sent to the replica. */
+	RELAY_COMPRESSION_LEVEL = 3,
+};
+
+/**
+ * Max time a row may stay in the relay output buffer before
+ * it is sent to the replica, in seconds.
+ */
+static const double RELAY_SEND_LATENCY = 0.01;
+
+/** Relay output statistics. */
+struct relay_stat {
+	/** Number of rows sent to the replica. */
+	int64_t rows;
+	/** Number of socket writes used for sending them. */
+	int64_t writes;
+	/** Size of the rows sent to the replica. */
+	int64_t bytes;
+	/** Number of bytes written, less if rows are compressed. */
+	int64_t bytes_written;
+};
 
 /**
  * Cbus message to send status updates from relay to tx thread.
@@ -63,6 +97,8 @@ struct relay_status_msg {
 	struct relay *relay;
 	/** Replica vclock. */
 	struct vclock vclock;
+	/** Relay output statistics. */
+	struct relay_stat stat;
 };
 
 /**
@@ -126,12 +162,48 @@ struct relay {
 	struct stailq pending_gc;
 	/** Time when last row was sent to peer. */
 	double last_row_tm;
+	/**
+	 * Buffer accumulating rows to be sent to the replica
+	 * so that many rows can be sent with a single write.
+	 */
+	struct obuf send_buf;
+	/** Time when the oldest row in @send_buf was added. */
+	double send_buf_tm;
+	/** Relay output statistics. */
+	struct relay_stat stat;
+	/**
+	 * Context compressing the rows sent to the replica, or
+	 * NULL if they are sent as is, see enum iproto_compression.
+	 */
+	ZSTD_CStream *zctx;
+	/** Buffer for compressed contents of @send_buf. */
+	struct ibuf zbuf;
+	/**
+	 * Set on initial join if the replica accepts snapshot
+	 * blocks sent as IPROTO_XLOG_TX rows. Otherwise the relay
+	 * unpacks the blocks and sends their rows one by one.
+	 */
+	bool join_xlog_tx;
+	/** Context decompressing snapshot blocks, see @join_xlog_tx. */
+	ZSTD_DStream *zdctx;
+	/** Position of the relay in the WAL memory buffer. */
+	struct wal_mem_cursor mem_cursor;
+	/** Buffer for rows read from the WAL memory buffer. */
+	struct ibuf mem_buf;
+	/**
+	 * Set if WAL files were created while the relay was
+	 * reading rows from memory, so the WAL directory must
+	 * be rescanned before reading xlog files.
+	 */
+	bool wal_dir_is_stale;
 
 	struct {
 		/* Align to prevent false-sharing with tx thread */
 		alignas(CACHELINE_SIZE)
 		/** Known relay vclock. */
 		struct vclock vclock;
+		/** Known relay output statistics. */
+		struct relay_stat stat;
 	} tx;
 };
 
@@ -141,9 +213,28 @@ relay_vclock(const struct relay *relay)
 	return &relay->tx.vclock;
 }
 
+double
+relay_rows_per_write(const struct relay *relay)
+{
+	const struct relay_stat *stat = &relay->tx.stat;
+	return stat->writes > 0 ? (double)stat->rows / stat->writes : 0;
+}
+
+double
+relay_compression_ratio(const struct relay *relay)
+{
+	const struct relay_stat *stat = &relay->tx.stat;
+	return stat->bytes_written > 0 ?
+	       (double)stat->bytes / stat->bytes_written : 1;
+}
+
 static void
 relay_send(struct relay *relay, struct xrow_header *packet);
 static void
+relay_flush(struct relay *relay);
+static void
+relay_end_compression(struct relay *relay);
+static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row);
 static void
 relay_send_row(struct xstream *stream, struct xrow_header *row);
@@ -171,6 +262,8 @@ relay_destroy(struct relay *relay)
 	}
 	if (relay->r != NULL)
 		recovery_delete(relay->r);
+	if (relay->zdctx != NULL)
+		ZSTD_freeDStream(relay->zdctx);
 	fiber_cond_destroy(&relay->reader_cond);
 	diag_destroy(&relay->diag);
 	TRASH(relay);
@@ -192,13 +285,17 @@ relay_set_cord_name(int fd)
 }
 
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
+relay_initial_join(int fd, uint64_t sync, struct vclock *vclock,
+		   bool xlog_tx)
 {
 	struct relay relay;
 	relay_create(&relay, fd, sync, relay_send_initial_join_row);
+	relay.join_xlog_tx = xlog_tx;
 	assert(relay.stream.write != NULL);
+	auto guard = make_scoped_guard([&]{
+		relay_destroy(&relay);
+	});
 	engine_join_xc(vclock, &relay.stream);
-	relay_destroy(&relay);
 }
 
 int
@@ -208,10 +305,16 @@ relay_final_join_f(va_list ap)
 	coio_enable();
 	relay_set_cord_name(relay->io.fd);
 
+	obuf_create(&relay->send_buf, &cord()->slabc, RELAY_SEND_BUF_MAX);
+	auto buf_guard = make_scoped_guard([=]{
+		obuf_destroy(&relay->send_buf);
+	});
+
 	/* Send all WALs until stop_vclock */
 	assert(relay->stream.write != NULL);
 	recover_remaining_wals(relay->r, &relay->stream,
 			       &relay->stop_vclock, true);
+	relay_flush(relay);
 	assert(vclock_compare(&relay->r->vclock, &relay->stop_vclock) == 0);
 	return 0;
 }
@@ -261,6 +364,7 @@ tx_status_update(struct cmsg *msg)
 {
 	struct relay_status_msg *status = (struct relay_status_msg *)msg;
 	vclock_copy(&status->relay->tx.vclock, &status->vclock);
+	status->relay->tx.stat = status->stat;
 	static const struct cmsg_hop route[] = {
 		{relay_status_update, NULL}
 	};
@@ -325,6 +429,51 @@ relay_schedule_pending_gc(struct relay *relay, int64_t signature)
 		cpipe_push(&relay->tx_pipe, &gc_msg->msg);
 }
 
+/**
+ * Send rows written to WAL recently to the replica straight
+ * from the WAL memory buffer, see wal_mem_read(). Return -1
+ * if the rows the replica needs aren't in memory any more and
+ * have to be read from xlog files.
+ */
+static int
+relay_send_from_mem(struct relay *relay)
+{
+	struct recovery *r = relay->r;
+	struct ibuf *buf = &relay->mem_buf;
+	while (true) {
+		ibuf_reset(buf);
+		ssize_t size = wal_mem_read(&relay->mem_cursor,
+					    &r->vclock, buf);
+		if (size <= 0)
+			return size;
+		const char *pos = buf->rpos;
+		while (pos < buf->wpos) {
+			struct wal_mem_entry entry;
+			memcpy(&entry, pos, sizeof(entry));
+			pos += sizeof(entry);
+			const char *data = pos;
+			pos += entry.size;
+			if (entry.replica_id == 0) {
+				/*
+				 * A new WAL file was created: let
+				 * garbage collection know the relay
+				 * is done with the previous ones.
+				 */
+				recovery_skip_log(r);
+				relay->wal_dir_is_stale = true;
+				continue;
+			}
+			if (entry.lsn <= vclock_get(&r->vclock,
+						    entry.replica_id))
+				continue;
+			struct xrow_header row;
+			xrow_header_decode_xc(&row, &data, pos);
+			vclock_follow(&r->vclock, row.replica_id, row.lsn);
+			xstream_write_xc(&relay->stream, &row);
+		}
+	}
+}
+
 static void
 relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 {
@@ -337,8 +486,15 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 		return;
 	}
 	try {
-		recover_remaining_wals(relay->r, &relay->stream, NULL,
-				       (events & WAL_EVENT_ROTATE) != 0);
+		if (relay_send_from_mem(relay) != 0) {
+			bool scan_dir = (events & WAL_EVENT_ROTATE) != 0 ||
+					relay->wal_dir_is_stale;
+			recover_remaining_wals(relay->r, &relay->stream, NULL,
+					       scan_dir);
+			relay->wal_dir_is_stale = false;
+		}
+		/* Send the rows read so far without waiting for more. */
+		relay_flush(relay);
 	} catch (Exception *e) {
 		e->log();
 		diag_move(diag_get(), &relay->diag);
@@ -397,6 +553,7 @@ relay_send_heartbeat(struct relay *relay)
 	xrow_encode_timestamp(&row, instance_id, ev_now(loop()));
 	try {
 		relay_send(relay, &row);
+		relay_flush(relay);
 	} catch (Exception *e) {
 		e->log();
 	}
@@ -411,9 +568,32 @@ static int
 relay_subscribe_f(va_list ap)
 {
 	struct relay *relay = va_arg(ap, struct relay *);
+	uint32_t compression = va_arg(ap, uint32_t);
 	struct recovery *r = relay->r;
 
+	if (compression == IPROTO_COMPRESSION_ZSTD) {
+		relay->zctx = ZSTD_createCStream();
+		if (relay->zctx == NULL) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 "failed to create context");
+			return -1;
+		}
+		size_t rc = ZSTD_initCStream(relay->zctx,
+					     RELAY_COMPRESSION_LEVEL);
+		if (ZSTD_isError(rc)) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 ZSTD_getErrorName(rc));
+			ZSTD_freeCStream(relay->zctx);
+			return -1;
+		}
+	}
+
 	coio_enable();
+	obuf_create(&relay->send_buf, &cord()->slabc, RELAY_SEND_BUF_MAX);
+	ibuf_create(&relay->mem_buf, &cord()->slabc, RELAY_SEND_BUF_MAX);
+	ibuf_create(&relay->zbuf, &cord()->slabc, RELAY_SEND_BUF_MAX);
+	/* The WAL directory hasn't been scanned yet. */
+	relay->wal_dir_is_stale = true;
 	cbus_endpoint_create(&relay->endpoint, cord_name(cord()),
 			     fiber_schedule_cb, fiber());
 	cbus_pair("tx", cord_name(cord()), &relay->tx_pipe, &relay->relay_pipe,
@@ -480,6 +660,7 @@ relay_subscribe_f(va_list ap)
 		};
 		cmsg_init(&relay->status_msg.msg, route);
 		vclock_copy(&relay->status_msg.vclock, send_vclock);
+		relay->status_msg.stat = relay->stat;
 		relay->status_msg.relay = relay;
 		cpipe_push(&relay->tx_pipe, &relay->status_msg.msg);
 		/* Collect xlog files received by the replica. */
@@ -496,6 +677,13 @@ relay_subscribe_f(va_list ap)
 	cbus_unpair(&relay->tx_pipe, &relay->relay_pipe,
 		    NULL, NULL, cbus_process);
 	cbus_endpoint_destroy(&relay->endpoint, cbus_process);
+	if (relay->zctx != NULL) {
+		relay_end_compression(relay);
+		ZSTD_freeCStream(relay->zctx);
+	}
+	obuf_destroy(&relay->send_buf);
+	ibuf_destroy(&relay->mem_buf);
+	ibuf_destroy(&relay->zbuf);
 	if (!diag_is_empty(&relay->diag)) {
 		/* An error has occured while ACKs of xlog reading */
 		diag_move(&relay->diag, diag_get());
@@ -510,7 +698,8 @@ relay_subscribe_f(va_list ap)
 /** Replication acceptor fiber handler. */
 void
 relay_subscribe(int fd, uint64_t sync, struct replica *replica,
-		struct vclock *replica_clock, uint32_t replica_version_id)
+		struct vclock *replica_clock, uint32_t replica_version_id,
+		uint32_t compression)
 {
 	assert(replica->id != REPLICA_ID_NIL);
 	/* Don't allow multiple relays for the same replica */
@@ -543,7 +732,7 @@ relay_subscribe(int fd, uint64_t sync, struct replica *replica,
 	replica_set_relay(replica, &relay);
 
 	int rc = cord_costart(&relay.cord, tt_sprintf("relay_%p", &relay),
-			      relay_subscribe_f, &relay);
+			      relay_subscribe_f, &relay, compression);
 	if (rc == 0)
 		rc = cord_cojoin(&relay.cord);
 
@@ -554,24 +743,190 @@ relay_subscribe(int fd, uint64_t sync, struct replica *replica,
 		diag_raise();
 }
 
+/**
+ * Compress rows accumulated in the relay output buffer to
+ * relay::zbuf. The compression stream is flushed so that the
+ * replica can decode all the rows as soon as it receives them,
+ * but it is not ended until the relay exits: rows sent later
+ * are compressed using the history of the rows sent before them.
+ */
 static void
-relay_send(struct relay *relay, struct xrow_header *packet)
+relay_compress(struct relay *relay)
 {
-	packet->sync = relay->sync;
+	struct obuf *buf = &relay->send_buf;
+	struct ibuf *zbuf = &relay->zbuf;
+	ibuf_reset(zbuf);
+	size_t rc;
+	int iovcnt = obuf_iovcnt(buf);
+	for (int i = 0; i < iovcnt; i++) {
+		ZSTD_inBuffer input = {buf->iov[i].iov_base,
+				       buf->iov[i].iov_len, 0};
+		while (input.pos < input.size) {
+			ibuf_reserve_xc(zbuf, ZSTD_CStreamOutSize());
+			ZSTD_outBuffer output = {zbuf->wpos,
+						 ibuf_unused(zbuf), 0};
+			rc = ZSTD_compressStream(relay->zctx, &output, &input);
+			if (ZSTD_isError(rc))
+				goto error;
+			zbuf->wpos += output.pos;
+		}
+	}
+	do {
+		ibuf_reserve_xc(zbuf, ZSTD_CStreamOutSize());
+		ZSTD_outBuffer output = {zbuf->wpos, ibuf_unused(zbuf), 0};
+		rc = ZSTD_flushStream(relay->zctx, &output);
+		if (ZSTD_isError(rc))
+			goto error;
+		zbuf->wpos += output.pos;
+	} while (rc > 0);
+	return;
+error:
+	tnt_raise(ClientError, ER_COMPRESSION, ZSTD_getErrorName(rc));
+}
+
+/**
+ * End the compressed stream sent to the replica. Called when
+ * the relay exits, so that the replica reads the data that
+ * follows, such as the error that stopped the relay, as is.
+ * The socket may be broken at this point, so write errors are
+ * ignored.
+ */
+static void
+relay_end_compression(struct relay *relay)
+{
+	struct ibuf *zbuf = &relay->zbuf;
+	ibuf_reset(zbuf);
+	size_t rc;
+	do {
+		if (ibuf_reserve(zbuf, ZSTD_CStreamOutSize()) == NULL)
+			return;
+		ZSTD_outBuffer output = {zbuf->wpos, ibuf_unused(zbuf), 0};
+		rc = ZSTD_endStream(relay->zctx, &output);
+		if (ZSTD_isError(rc))
+			return;
+		zbuf->wpos += output.pos;
+	} while (rc > 0);
+	(void) write(relay->io.fd, zbuf->rpos, ibuf_used(zbuf));
+}
+
+/**
+ * Send rows accumulated in the relay output buffer
+ * to the replica with a single write.
+ */
+static void
+relay_flush(struct relay *relay)
+{
+	struct obuf *buf = &relay->send_buf;
+	size_t size = obuf_size(buf);
+	if (size == 0)
+		return;
 	relay->last_row_tm = ev_monotonic_now(loop());
-	coio_write_xrow(&relay->io, packet);
+	size_t written = size;
+	if (relay->zctx != NULL) {
+		relay_compress(relay);
+		written = ibuf_used(&relay->zbuf);
+		coio_write(&relay->io, relay->zbuf.rpos, written);
+	} else {
+		/* coio_writev() modifies the vector so pass a copy. */
+		struct iovec iov[SMALL_OBUF_IOV_MAX + 1];
+		int iovcnt = obuf_iovcnt(buf);
+		memcpy(iov, buf->iov, iovcnt * sizeof(iov[0]));
+		coio_writev(&relay->io, iov, iovcnt, size);
+	}
+	relay->stat.writes++;
+	relay->stat.bytes += size;
+	relay->stat.bytes_written += written;
+	obuf_reset(buf);
+	/* Free row headers encoded by relay_send(). */
 	fiber_gc();
+}
+
+/**
+ * Append a row to the relay output buffer. The buffer is
+ * flushed when it gets full or the oldest row in it has been
+ * waiting for too long. The caller is supposed to flush the
+ * buffer when it runs out of rows to send.
+ */
+static void
+relay_send(struct relay *relay, struct xrow_header *packet)
+{
+	packet->sync = relay->sync;
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_to_iovec_xc(packet, iov);
+	struct obuf *buf = &relay->send_buf;
+	double now = ev_monotonic_time();
+	if (obuf_size(buf) == 0)
+		relay->send_buf_tm = now;
+	/*
+	 * Copy the row body, because it may point to a buffer
+	 * that will be reused for reading the next rows.
+	 */
+	for (int i = 0; i < iovcnt; i++)
+		obuf_dup_xc(buf, iov[i].iov_base, iov[i].iov_len);
+	relay->stat.rows++;
+	if (obuf_size(buf) >= RELAY_SEND_BUF_MAX ||
+	    now - relay->send_buf_tm >= RELAY_SEND_LATENCY)
+		relay_flush(relay);
 
 	struct errinj *inj = errinj(ERRINJ_RELAY_TIMEOUT, ERRINJ_DOUBLE);
 	if (inj != NULL && inj->dparam > 0)
 		fiber_sleep(inj->dparam);
 }
 
+/**
+ * Send rows of a snapshot block to a replica which doesn't
+ * accept IPROTO_XLOG_TX rows.
+ */
+static void
+relay_send_xlog_tx_rows(struct relay *relay, struct xrow_header *packet)
+{
+	assert(packet->bodycnt == 2);
+	const char *data = (const char *) packet->body[1].iov_base;
+	const char *data_end = data + packet->body[1].iov_len;
+	if (relay->zdctx == NULL) {
+		relay->zdctx = ZSTD_createDStream();
+		if (relay->zdctx == NULL) {
+			tnt_raise(ClientError, ER_COMPRESSION,
+				  "failed to create context");
+		}
+	}
+	struct xlog_tx_cursor tx_cursor;
+	ssize_t rc = xlog_tx_cursor_create(&tx_cursor, &data, data_end,
+					   relay->zdctx);
+	if (rc < 0)
+		diag_raise();
+	/* The block is read from the file as a whole. */
+	assert(rc == 0);
+	auto guard = make_scoped_guard([&]{
+		xlog_tx_cursor_destroy(&tx_cursor);
+	});
+	struct xrow_header row;
+	while ((rc = xlog_tx_cursor_next_row(&tx_cursor, &row)) == 0) {
+		row.sync = relay->sync;
+		coio_write_xrow(&relay->io, &row);
+	}
+	if (rc < 0)
+		diag_raise();
+}
+
 static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row)
 {
 	struct relay *relay = container_of(stream, struct relay, stream);
-	relay_send(relay, row);
+	if (row->type == IPROTO_XLOG_TX && !relay->join_xlog_tx) {
+		relay_send_xlog_tx_rows(relay, row);
+		fiber_gc();
+		return;
+	}
+	/*
+	 * Engines feed initial join rows from their own threads,
+	 * while the relay output buffer may only be used by the
+	 * thread whose slab cache it is allocated from. So write
+	 * rows to the socket right away.
+	 */
+	row->sync = relay->sync;
+	coio_write_xrow(&relay->io, row);
+	fiber_gc();
 }
 
 /** Send a single row to the client. */
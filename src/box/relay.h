@@ -50,6 +50,23 @@ struct vclock;
 const struct vclock *
 relay_vclock(const struct relay *relay);
 
+/**
+ * Returns the average number of rows sent to the replica
+ * with a single socket write.
+ * @param relay relay
+ */
+double
+relay_rows_per_write(const struct relay *relay);
+
+/**
+ * Returns the ratio of the size of the rows sent to the replica
+ * to the number of bytes written to the socket, which is greater
+ * than 1 if the rows are compressed.
+ * @param relay relay
+ */
+double
+relay_compression_ratio(const struct relay *relay);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -60,9 +77,11 @@ relay_vclock(const struct relay *relay);
  * @param fd        client connection
  * @param sync      sync from incoming JOIN request
  * @param vclock    vclock of the last checkpoint
+ * @param xlog_tx   the replica accepts IPROTO_XLOG_TX rows
  */
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock);
+relay_initial_join(int fd, uint64_t sync, struct vclock *vclock,
+		   bool xlog_tx);
 
 /**
  * Send final JOIN rows to the replica.
@@ -77,10 +96,13 @@ relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
 /**
  * Subscribe a replica to updates.
  *
+ * @param compression compression of the rows sent to the
+ *                    replica, see enum iproto_compression.
  * @return none.
  */
 void
 relay_subscribe(int fd, uint64_t sync, struct replica *replica,
-		struct vclock *replica_vclock, uint32_t replica_version_id);
+		struct vclock *replica_vclock, uint32_t replica_version_id,
+		uint32_t compression);
 
 #endif /* TARANTOOL_REPLICATION_RELAY_H_INCLUDED */
@@ -50,6 +50,8 @@ double replication_timeout = 1.0; /* seconds */
 double replication_connect_timeout = 4.0; /* seconds */
 int replication_connect_quorum = REPLICATION_CONNECT_QUORUM_ALL;
 double replication_sync_lag = 10.0; /* seconds */
+int replication_apply_fibers = 1;
+bool replication_compression = false;
 
 struct replicaset replicaset;
 
@@ -87,6 +89,9 @@ replication_init(void)
 	rlist_create(&replicaset.anon);
 	vclock_create(&replicaset.vclock);
 	fiber_cond_create(&replicaset.applier.cond);
+	for (int i = 0; i < VCLOCK_MAX; i++)
+		rlist_create(&replicaset.applier.order[i].pending);
+	fiber_cond_create(&replicaset.applier.order_cond);
 }
 
 void
@@ -94,6 +99,7 @@ replication_free(void)
 {
 	mempool_destroy(&replicaset.pool);
 	fiber_cond_destroy(&replicaset.applier.cond);
+	fiber_cond_destroy(&replicaset.applier.order_cond);
 }
 
 void
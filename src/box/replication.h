@@ -124,6 +124,21 @@ extern int replication_connect_quorum;
  */
 extern double replication_sync_lag;
 
+/**
+ * Number of fibers an applier uses to apply rows received from
+ * a master. If greater than 1, rows that modify different keys
+ * are applied concurrently, see applier_subscribe(). Takes effect
+ * on the next subscribe.
+ */
+extern int replication_apply_fibers;
+
+/**
+ * Set if appliers should ask masters to compress the stream
+ * of rows sent in response to SUBSCRIBE, see enum
+ * iproto_compression. Takes effect on the next subscribe.
+ */
+extern bool replication_compression;
+
 /**
  * Wait for the given period of time before trying to reconnect
  * to a master.
@@ -165,6 +180,19 @@ typedef rb_tree(struct replica) replica_hash_t;
  * A replica set is a set of appliers and their matching
  * relays, usually connected in full mesh.
  */
+/**
+ * Order in which rows of one origin applied by appliers are
+ * submitted to WAL, see replicaset.applier.order.
+ */
+struct replicaset_order {
+	/** Ticket assigned to the next promoted row. */
+	int64_t next_ticket;
+	/** Ticket of the row that may be submitted to WAL next. */
+	int64_t turn;
+	/** Promoted rows not written to WAL yet, in LSN order. */
+	struct rlist pending;
+};
+
 struct replicaset {
 	/** Memory pool for struct replica allocations. */
 	struct mempool pool;
@@ -204,6 +232,17 @@ struct replicaset {
 		 * state.
 		 */
 		struct fiber_cond cond;
+		/**
+		 * Rows promoted in the replica set vclock, but
+		 * not written to WAL yet, by origin replica id.
+		 * WAL requires LSNs of each origin to grow, so
+		 * rows of one origin are submitted to WAL in the
+		 * order they were promoted, whichever applier or
+		 * applier worker fiber applies them.
+		 */
+		struct replicaset_order order[VCLOCK_MAX];
+		/** Signaled when a row passes its turn in order. */
+		struct fiber_cond order_cond;
 	} applier;
 };
 extern struct replicaset replicaset;
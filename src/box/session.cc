@@ -36,6 +36,7 @@
 #include "random.h"
 #include "user.h"
 #include "error.h"
+#include "sql_stmt_cache.h"
 
 const char *session_type_strs[] = {
 	"background",
@@ -97,6 +98,8 @@ session_create(int fd, enum session_type type)
 	session->sync = 0;
 	session->type = type;
 	session->sql_flags = default_flags;
+	rlist_create(&session->sql_stmts);
+	session->sql_stmt_count = 0;
 
 	/* For on_connect triggers. */
 	credentials_init(&session->credentials, guest_user->auth_token,
@@ -189,6 +192,7 @@ session_run_on_auth_triggers(const struct on_auth_trigger_ctx *result)
 void
 session_destroy(struct session *session)
 {
+	sql_stmt_cache_drop_session(session);
 	struct mh_i64ptr_node_t node = { session->id, NULL };
 	mh_i64ptr_remove(session_registry, &node, NULL);
 	mempool_free(&session_pool, session);
@@ -86,6 +86,13 @@ struct session {
 
 	/** SQL Connection flag for current user session */
 	uint32_t sql_flags;
+	/**
+	 * SQL statements prepared by the session, the most
+	 * recently used first, see sql_stmt_cache.h.
+	 */
+	struct rlist sql_stmts;
+	/** Number of statements in sql_stmts. */
+	uint32_t sql_stmt_count;
 	/**
 	 * For iproto requests, we set this field
 	 * to the value of packet sync. Since the
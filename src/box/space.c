@@ -520,6 +520,13 @@ space_execute_dml(struct space *space, struct txn *txn,
 		if (space->vtab->execute_upsert(space, txn, request) != 0)
 			return -1;
 		break;
+	case IPROTO_DEFERRED_DELETE:
+		*result = NULL;
+		if (space->vtab->execute_deferred_delete != NULL &&
+		    space->vtab->execute_deferred_delete(space, txn,
+							 request) != 0)
+			return -1;
+		break;
 	default:
 		*result = NULL;
 	}
@@ -65,6 +65,13 @@ struct space_vtab {
 	int (*execute_update)(struct space *, struct txn *,
 			      struct request *, struct tuple **result);
 	int (*execute_upsert)(struct space *, struct txn *, struct request *);
+	/**
+	 * Execute a DELETE deferred by primary index compaction,
+	 * see IPROTO_DEFERRED_DELETE. NULL if the engine never
+	 * defers DELETEs.
+	 */
+	int (*execute_deferred_delete)(struct space *, struct txn *,
+				       struct request *);
 
 	int (*ephemeral_replace)(struct space *, const char *, const char *);
 
@@ -34,12 +34,14 @@
 #include "error.h"
 
 const struct space_opts space_opts_default = {
-	/* .temporary = */ false,
-	/* .sql        = */ NULL,
+	/* .temporary     = */ false,
+	/* .defer_deletes = */ false,
+	/* .sql           = */ NULL,
 };
 
 const struct opt_def space_opts_reg[] = {
 	OPT_DEF("temporary", OPT_BOOL, struct space_opts, temporary),
+	OPT_DEF("defer_deletes", OPT_BOOL, struct space_opts, defer_deletes),
 	OPT_DEF("sql", OPT_STRPTR, struct space_opts, sql),
 	OPT_END,
 };
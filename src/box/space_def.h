@@ -49,6 +49,13 @@ struct space_opts {
 	 * - changes are not part of a snapshot
 	 */
 	bool temporary;
+	/**
+	 * Vinyl only: do not look up the old tuple on REPLACE
+	 * and DELETE unless it is found in memory. Statements
+	 * deleting overwritten tuples from secondary indexes are
+	 * generated later, on primary index compaction.
+	 */
+	bool defer_deletes;
 	/**
 	 * SQL statement that produced this space.
 	 */
@@ -31,6 +31,7 @@
 #include <assert.h>
 #include "field_def.h"
 #include "sql.h"
+#include "sql_stmt_cache.h"
 #include "sql/sqlite3.h"
 
 /*
@@ -79,11 +80,15 @@ sql_init()
 		panic("failed to initialize SQL subsystem");
 
 	assert(db != NULL);
+
+	if (sql_stmt_cache_init() != 0)
+		panic("failed to initialize SQL statement cache");
 }
 
 void
 sql_free()
 {
+	sql_stmt_cache_destroy();
 	sqlite3_close(db); db = NULL;
 }
 
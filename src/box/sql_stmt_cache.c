@@ -0,0 +1,351 @@
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "sql_stmt_cache.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sql/sqlite3.h"
+#include "small/rlist.h"
+#include "trivia/util.h"
+#include "assoc.h"
+#include "diag.h"
+#include "errcode.h"
+#include "fiber.h"
+#include "schema.h"
+#include "session.h"
+#include "sql.h"
+
+/**
+ * A statement compiled with PREPARE. The statement text is kept
+ * to recompile the statement when the schema changes.
+ * Statements are private to the session which prepared them.
+ */
+struct sql_stmt_entry {
+	/** Statement id. */
+	uint32_t id;
+	/** Id of the session which prepared the statement. */
+	uint64_t session_id;
+	/** Session which prepared the statement. */
+	struct session *session;
+	/** Compiled statement. */
+	struct sqlite3_stmt *stmt;
+	/** Schema version the statement was compiled against. */
+	uint32_t schema_version;
+	/** True while the statement is being executed. */
+	bool is_busy;
+	/** Link in session::sql_stmts. */
+	struct rlist in_session;
+	/** Length of the statement text. */
+	uint32_t sql_len;
+	/**
+	 * Key of sql_stmt_cache_text: the session id followed
+	 * by the statement text.
+	 */
+	char key[0];
+};
+
+/** Size of sql_stmt_entry::key for a text of @a sql_len bytes. */
+static inline uint32_t
+sql_stmt_key_size(uint32_t sql_len)
+{
+	return sizeof(uint64_t) + sql_len;
+}
+
+/** Statement text of a cache entry. */
+static inline const char *
+sql_stmt_entry_sql(const struct sql_stmt_entry *entry)
+{
+	return entry->key + sizeof(uint64_t);
+}
+
+/** mhash table (id -> entry) */
+static struct mh_i32ptr_t *sql_stmt_cache_id = NULL;
+/** mhash table (session id + text -> entry) */
+static struct mh_strnptr_t *sql_stmt_cache_text = NULL;
+/** Id of the next compiled statement. */
+static uint32_t sql_stmt_next_id = 1;
+
+int
+sql_stmt_cache_init(void)
+{
+	sql_stmt_cache_id = mh_i32ptr_new();
+	if (sql_stmt_cache_id == NULL) {
+		diag_set(OutOfMemory, sizeof(*sql_stmt_cache_id), "malloc",
+			 "sql_stmt_cache_id");
+		return -1;
+	}
+	sql_stmt_cache_text = mh_strnptr_new();
+	if (sql_stmt_cache_text == NULL) {
+		diag_set(OutOfMemory, sizeof(*sql_stmt_cache_text), "malloc",
+			 "sql_stmt_cache_text");
+		mh_i32ptr_delete(sql_stmt_cache_id);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Delete a cache entry. A busy statement is finalized when it
+ * is released, see sql_stmt_cache_release().
+ */
+static void
+sql_stmt_entry_delete(struct sql_stmt_entry *entry)
+{
+	mh_int_t i = mh_i32ptr_find(sql_stmt_cache_id, entry->id, NULL);
+	assert(i != mh_end(sql_stmt_cache_id));
+	mh_i32ptr_del(sql_stmt_cache_id, i, NULL);
+	i = mh_strnptr_find_inp(sql_stmt_cache_text, entry->key,
+				sql_stmt_key_size(entry->sql_len));
+	assert(i != mh_end(sql_stmt_cache_text));
+	mh_strnptr_del(sql_stmt_cache_text, i, NULL);
+	rlist_del_entry(entry, in_session);
+	assert(entry->session->sql_stmt_count > 0);
+	entry->session->sql_stmt_count--;
+	if (!entry->is_busy)
+		sqlite3_finalize(entry->stmt);
+	free(entry);
+}
+
+void
+sql_stmt_cache_destroy(void)
+{
+	while (mh_size(sql_stmt_cache_id) > 0) {
+		mh_int_t i = mh_first(sql_stmt_cache_id);
+		sql_stmt_entry_delete((struct sql_stmt_entry *)
+			mh_i32ptr_node(sql_stmt_cache_id, i)->val);
+	}
+	mh_i32ptr_delete(sql_stmt_cache_id);
+	mh_strnptr_delete(sql_stmt_cache_text);
+}
+
+static struct sqlite3_stmt *
+sql_stmt_compile(const char *sql, uint32_t len)
+{
+	sqlite3 *db = sql_get();
+	if (db == NULL) {
+		diag_set(ClientError, ER_LOADING);
+		return NULL;
+	}
+	struct sqlite3_stmt *stmt;
+	if (sqlite3_prepare_v2(db, sql, len, &stmt, NULL) != SQLITE_OK) {
+		diag_set(ClientError, ER_SQL_EXECUTE, sqlite3_errmsg(db));
+		return NULL;
+	}
+	assert(stmt != NULL);
+	return stmt;
+}
+
+/**
+ * Recompile the statement if the schema has changed since
+ * it was compiled. The statement must not be busy.
+ */
+static int
+sql_stmt_entry_refresh(struct sql_stmt_entry *entry)
+{
+	assert(!entry->is_busy);
+	if (entry->schema_version == schema_version)
+		return 0;
+	struct sqlite3_stmt *stmt;
+	stmt = sql_stmt_compile(sql_stmt_entry_sql(entry), entry->sql_len);
+	if (stmt == NULL)
+		return -1;
+	sqlite3_finalize(entry->stmt);
+	entry->stmt = stmt;
+	entry->schema_version = schema_version;
+	return 0;
+}
+
+/**
+ * Evict the least recently used statement of a session which
+ * is not busy.
+ */
+static void
+sql_stmt_cache_evict(struct session *session)
+{
+	struct sql_stmt_entry *entry;
+	rlist_foreach_entry_reverse(entry, &session->sql_stmts, in_session) {
+		if (!entry->is_busy) {
+			sql_stmt_entry_delete(entry);
+			return;
+		}
+	}
+}
+
+struct sqlite3_stmt *
+sql_stmt_cache_prepare(struct session *session, const char *sql,
+		       uint32_t len, uint32_t *stmt_id)
+{
+	uint64_t session_id = session->id;
+	struct sql_stmt_entry *entry;
+	uint32_t key_size = sql_stmt_key_size(len);
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	char *key = (char *) region_alloc(region, key_size);
+	if (key == NULL) {
+		diag_set(OutOfMemory, key_size, "region_alloc", "key");
+		return NULL;
+	}
+	memcpy(key, &session_id, sizeof(session_id));
+	memcpy(key + sizeof(session_id), sql, len);
+	mh_int_t i = mh_strnptr_find_inp(sql_stmt_cache_text, key, key_size);
+	region_truncate(region, used);
+	if (i != mh_end(sql_stmt_cache_text)) {
+		entry = (struct sql_stmt_entry *)
+			mh_strnptr_node(sql_stmt_cache_text, i)->val;
+		/*
+		 * A busy statement can't be recompiled now, it
+		 * will be on the next acquire. Until then its
+		 * description may be stale.
+		 */
+		if (!entry->is_busy && sql_stmt_entry_refresh(entry) != 0)
+			return NULL;
+		rlist_move_entry(&session->sql_stmts, entry, in_session);
+		*stmt_id = entry->id;
+		return entry->stmt;
+	}
+
+	size_t size = sizeof(*entry) + key_size;
+	entry = (struct sql_stmt_entry *) malloc(size);
+	if (entry == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "struct sql_stmt_entry");
+		return NULL;
+	}
+	entry->stmt = sql_stmt_compile(sql, len);
+	if (entry->stmt == NULL) {
+		free(entry);
+		return NULL;
+	}
+	entry->session_id = session_id;
+	entry->session = session;
+	entry->schema_version = schema_version;
+	entry->is_busy = false;
+	entry->sql_len = len;
+	memcpy(entry->key, &session_id, sizeof(session_id));
+	memcpy(entry->key + sizeof(session_id), sql, len);
+	/* Skip ids still used by long living entries. */
+	do {
+		entry->id = sql_stmt_next_id++;
+	} while (entry->id == 0 ||
+		 mh_i32ptr_find(sql_stmt_cache_id, entry->id,
+				NULL) != mh_end(sql_stmt_cache_id));
+
+	const struct mh_i32ptr_node_t id_node = { entry->id, entry };
+	if (mh_i32ptr_put(sql_stmt_cache_id, &id_node, NULL, NULL) ==
+	    mh_end(sql_stmt_cache_id)) {
+		diag_set(OutOfMemory, sizeof(id_node), "malloc",
+			 "sql_stmt_cache_id");
+		goto error;
+	}
+	uint32_t hash = mh_strn_hash(entry->key, key_size);
+	const struct mh_strnptr_node_t text_node =
+		{ entry->key, key_size, hash, entry };
+	if (mh_strnptr_put(sql_stmt_cache_text, &text_node, NULL, NULL) ==
+	    mh_end(sql_stmt_cache_text)) {
+		diag_set(OutOfMemory, sizeof(text_node), "malloc",
+			 "sql_stmt_cache_text");
+		i = mh_i32ptr_find(sql_stmt_cache_id, entry->id, NULL);
+		mh_i32ptr_del(sql_stmt_cache_id, i, NULL);
+		goto error;
+	}
+	if (session->sql_stmt_count >= SQL_STMT_CACHE_MAX)
+		sql_stmt_cache_evict(session);
+	rlist_add_entry(&session->sql_stmts, entry, in_session);
+	session->sql_stmt_count++;
+	*stmt_id = entry->id;
+	return entry->stmt;
+error:
+	sqlite3_finalize(entry->stmt);
+	free(entry);
+	return NULL;
+}
+
+static struct sql_stmt_entry *
+sql_stmt_cache_find(uint32_t stmt_id)
+{
+	mh_int_t i = mh_i32ptr_find(sql_stmt_cache_id, stmt_id, NULL);
+	if (i == mh_end(sql_stmt_cache_id))
+		return NULL;
+	return (struct sql_stmt_entry *)
+		mh_i32ptr_node(sql_stmt_cache_id, i)->val;
+}
+
+struct sqlite3_stmt *
+sql_stmt_cache_acquire(uint64_t session_id, uint32_t stmt_id)
+{
+	struct sql_stmt_entry *entry = sql_stmt_cache_find(stmt_id);
+	/* Don't reveal statements of other sessions. */
+	if (entry == NULL || entry->session_id != session_id) {
+		diag_set(ClientError, ER_SQL_EXECUTE,
+			 tt_sprintf("prepared statement %u does not exist",
+				    (unsigned) stmt_id));
+		return NULL;
+	}
+	rlist_move_entry(&entry->session->sql_stmts, entry, in_session);
+	if (entry->is_busy) {
+		/*
+		 * A VDBE program can't be run by two fibers at
+		 * once, and SQL execution may yield: compile
+		 * a private copy.
+		 */
+		return sql_stmt_compile(sql_stmt_entry_sql(entry),
+					entry->sql_len);
+	}
+	if (sql_stmt_entry_refresh(entry) != 0)
+		return NULL;
+	entry->is_busy = true;
+	return entry->stmt;
+}
+
+void
+sql_stmt_cache_release(uint32_t stmt_id, struct sqlite3_stmt *stmt)
+{
+	struct sql_stmt_entry *entry = sql_stmt_cache_find(stmt_id);
+	if (entry == NULL || entry->stmt != stmt) {
+		sqlite3_finalize(stmt);
+		return;
+	}
+	assert(entry->is_busy);
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+	entry->is_busy = false;
+}
+
+void
+sql_stmt_cache_drop_session(struct session *session)
+{
+	struct sql_stmt_entry *entry, *tmp;
+	rlist_foreach_entry_safe(entry, &session->sql_stmts, in_session, tmp)
+		sql_stmt_entry_delete(entry);
+	assert(session->sql_stmt_count == 0);
+}
@@ -0,0 +1,116 @@
+#ifndef TARANTOOL_BOX_SQL_STMT_CACHE_H_INCLUDED
+#define TARANTOOL_BOX_SQL_STMT_CACHE_H_INCLUDED
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct sqlite3_stmt;
+struct session;
+
+/**
+ * Max number of statements a session may keep prepared. When
+ * the limit is reached, the least recently used statement of
+ * the session is evicted. Statements of other sessions are
+ * never evicted.
+ */
+enum { SQL_STMT_CACHE_MAX = 1024 };
+
+/**
+ * Create the cache of prepared SQL statements.
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+sql_stmt_cache_init(void);
+
+/** Finalize all cached statements and delete the cache. */
+void
+sql_stmt_cache_destroy(void);
+
+/**
+ * Compile an SQL statement and put it into the cache, or find
+ * a statement with the same text already prepared by the same
+ * session.
+ * @param session Session preparing the statement. Only this
+ *        session can execute the statement.
+ * @param sql Statement text.
+ * @param len Length of @a sql.
+ * @param[out] stmt_id Statement id, to be used in
+ *        sql_stmt_cache_acquire().
+ *
+ * @retval not NULL Compiled statement. It is owned by the cache
+ *         and may only be used to get the statement description.
+ * @retval NULL Compilation or memory error.
+ */
+struct sqlite3_stmt *
+sql_stmt_cache_prepare(struct session *session, const char *sql,
+		       uint32_t len, uint32_t *stmt_id);
+
+/**
+ * Get a cached statement ready for binding parameters and
+ * execution. A statement compiled against an older schema
+ * version is recompiled. If the statement is being executed
+ * by another fiber, a private copy is compiled.
+ * The statement must be returned to the cache with
+ * sql_stmt_cache_release().
+ * @param session_id Id of the session executing the statement.
+ * @param stmt_id Statement id returned by sql_stmt_cache_prepare().
+ *
+ * @retval not NULL Statement.
+ * @retval NULL The statement is not found, was prepared by
+ *         another session or can not be compiled.
+ */
+struct sqlite3_stmt *
+sql_stmt_cache_acquire(uint64_t session_id, uint32_t stmt_id);
+
+/**
+ * Reset a statement got with sql_stmt_cache_acquire().
+ */
+void
+sql_stmt_cache_release(uint32_t stmt_id, struct sqlite3_stmt *stmt);
+
+/**
+ * Delete all statements prepared by a session. Called when
+ * the session is destroyed.
+ */
+void
+sql_stmt_cache_drop_session(struct session *session);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_SQL_STMT_CACHE_H_INCLUDED */
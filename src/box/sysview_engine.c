@@ -227,6 +227,7 @@ static const struct space_vtab sysview_space_vtab = {
 	/* .execute_delete = */ sysview_space_execute_delete,
 	/* .execute_update = */ sysview_space_execute_update,
 	/* .execute_upsert = */ sysview_space_execute_upsert,
+	/* .execute_deferred_delete = */ NULL,
 	/* .ephemeral_replace = */ sysview_space_ephemeral_replace,
 	/* .ephemeral_delete = */ sysview_space_ephemeral_delete,
 	/* .ephemeral_cleanup = */ sysview_space_ephemeral_cleanup,
@@ -1245,3 +1245,176 @@ tuple_compare_with_key_create(const struct key_def *def)
 }
 
 /* }}} tuple_compare_with_key */
+
+/* {{{ tuple_hint */
+
+/**
+ * A comparison hint consists of two parts. The highest bits
+ * store the MsgPack class of the first key part (see enum
+ * mp_class), so that values of different classes are ordered
+ * the same way mp_compare_scalar() orders them. The lowest
+ * bits store an order preserving prefix of the value itself:
+ *
+ * - numbers are rounded down to an integer and clamped to the
+ *   range representable in the value bits;
+ * - strings and binary values are represented by their first
+ *   bytes, compared as a big-endian integer;
+ * - booleans are represented by 0 and 1, NULL by 0.
+ *
+ * The mapping is monotonic, but not injective: different values
+ * may share a hint, in which case a full comparison decides.
+ * Strings with a collation, arrays and maps are never hinted.
+ */
+#define HINT_VALUE_BITS 60
+#define HINT_VALUE_MAX (((hint_t)1 << HINT_VALUE_BITS) - 1)
+#define HINT_VALUE_INT_MIN (-((int64_t)1 << (HINT_VALUE_BITS - 1)))
+#define HINT_VALUE_INT_MAX (((int64_t)1 << (HINT_VALUE_BITS - 1)) - 1)
+/** Number of leading string bytes that fit in a hint value. */
+#define HINT_VALUE_STR_LEN (HINT_VALUE_BITS / CHAR_BIT)
+
+static inline hint_t
+hint_create(enum mp_class mp_class, hint_t value)
+{
+	assert(value <= HINT_VALUE_MAX);
+	return ((hint_t)mp_class << HINT_VALUE_BITS) | value;
+}
+
+static inline hint_t
+hint_int(int64_t val)
+{
+	if (val < HINT_VALUE_INT_MIN)
+		val = HINT_VALUE_INT_MIN;
+	else if (val > HINT_VALUE_INT_MAX)
+		val = HINT_VALUE_INT_MAX;
+	return hint_create(MP_CLASS_NUMBER, val - HINT_VALUE_INT_MIN);
+}
+
+static inline hint_t
+hint_uint(uint64_t val)
+{
+	if (val > (uint64_t)HINT_VALUE_INT_MAX)
+		val = HINT_VALUE_INT_MAX;
+	return hint_int(val);
+}
+
+static inline hint_t
+hint_double(double val)
+{
+	/* NaN is less than any other number. */
+	if (isnan(val) || val < (double)HINT_VALUE_INT_MIN)
+		return hint_int(HINT_VALUE_INT_MIN);
+	if (val > (double)HINT_VALUE_INT_MAX)
+		return hint_int(HINT_VALUE_INT_MAX);
+	return hint_int((int64_t)floor(val));
+}
+
+static inline hint_t
+hint_bytes(enum mp_class mp_class, const char *data, uint32_t len)
+{
+	hint_t value = 0;
+	for (uint32_t i = 0; i < HINT_VALUE_STR_LEN; i++) {
+		value <<= CHAR_BIT;
+		if (i < len)
+			value |= (unsigned char)data[i];
+	}
+	return hint_create(mp_class, value);
+}
+
+/**
+ * Compute a hint of a MsgPack field.
+ * @param field field to compute the hint for, NULL if
+ *        the field is absent (treated as MP_NIL)
+ * @param coll collation of the key part or NULL
+ */
+static hint_t
+field_hint(const char *field, struct coll *coll)
+{
+	if (field == NULL)
+		return hint_create(MP_CLASS_NIL, 0);
+	uint32_t len;
+	switch (mp_typeof(*field)) {
+	case MP_NIL:
+		return hint_create(MP_CLASS_NIL, 0);
+	case MP_BOOL:
+		return hint_create(MP_CLASS_BOOL, mp_decode_bool(&field));
+	case MP_UINT:
+		return hint_uint(mp_decode_uint(&field));
+	case MP_INT:
+		return hint_int(mp_decode_int(&field));
+	case MP_FLOAT:
+		return hint_double(mp_decode_float(&field));
+	case MP_DOUBLE:
+		return hint_double(mp_decode_double(&field));
+	case MP_STR:
+		if (coll != NULL)
+			return HINT_NONE;
+		len = mp_decode_strl(&field);
+		return hint_bytes(MP_CLASS_STR, field, len);
+	case MP_BIN:
+		len = mp_decode_binl(&field);
+		return hint_bytes(MP_CLASS_BIN, field, len);
+	default:
+		return HINT_NONE;
+	}
+}
+
+static hint_t
+tuple_hint_default(const struct tuple *tuple, const struct key_def *key_def)
+{
+	const struct key_part *part = &key_def->parts[0];
+	return field_hint(tuple_field(tuple, part->fieldno), part->coll);
+}
+
+static hint_t
+key_hint_default(const char *key, uint32_t part_count,
+		 const struct key_def *key_def)
+{
+	if (part_count == 0)
+		return HINT_NONE;
+	return field_hint(key, key_def->parts[0].coll);
+}
+
+static hint_t
+tuple_hint_none(const struct tuple *tuple, const struct key_def *key_def)
+{
+	(void)tuple;
+	(void)key_def;
+	return HINT_NONE;
+}
+
+static hint_t
+key_hint_none(const char *key, uint32_t part_count,
+	      const struct key_def *key_def)
+{
+	(void)key;
+	(void)part_count;
+	(void)key_def;
+	return HINT_NONE;
+}
+
+void
+tuple_hint_set(struct key_def *def)
+{
+	enum field_type type = def->part_count > 0 ?
+			       def->parts[0].type : FIELD_TYPE_ANY;
+	switch (type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_INTEGER:
+	case FIELD_TYPE_NUMBER:
+	case FIELD_TYPE_BOOLEAN:
+	case FIELD_TYPE_SCALAR:
+		break;
+	case FIELD_TYPE_STRING:
+		if (def->parts[0].coll == NULL)
+			break;
+		FALLTHROUGH;
+	default:
+		def->tuple_hint = tuple_hint_none;
+		def->key_hint = key_hint_none;
+		return;
+	}
+	def->tuple_hint = tuple_hint_default;
+	def->key_hint = key_hint_default;
+}
+
+/* }}} tuple_hint */
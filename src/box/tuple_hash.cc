@@ -360,3 +360,40 @@ key_hash_slowpath(const char *key, const struct key_def *key_def)
 
 	return PMurHash32_Result(h, carry, total_size);
 }
+
+uint32_t
+tuple_hash_prefix(const struct tuple *tuple, const struct key_def *key_def,
+		  uint32_t part_count)
+{
+	assert(part_count > 0 && part_count <= key_def->part_count);
+	uint32_t h = HASH_SEED;
+	uint32_t carry = 0;
+	uint32_t total_size = 0;
+	const char *end = (char *)tuple + tuple_size(tuple);
+	for (uint32_t part_id = 0; part_id < part_count; part_id++) {
+		const struct key_part *part = &key_def->parts[part_id];
+		const char *field = tuple_field(tuple, part->fieldno);
+		if (field == NULL || field >= end) {
+			total_size += tuple_hash_null(&h, &carry);
+		} else {
+			total_size += tuple_hash_field(&h, &carry, &field,
+						       part->coll);
+		}
+	}
+	return PMurHash32_Result(h, carry, total_size);
+}
+
+uint32_t
+key_hash_prefix(const char *key, const struct key_def *key_def,
+		uint32_t part_count)
+{
+	assert(part_count > 0 && part_count <= key_def->part_count);
+	uint32_t h = HASH_SEED;
+	uint32_t carry = 0;
+	uint32_t total_size = 0;
+	for (uint32_t part_id = 0; part_id < part_count; part_id++) {
+		total_size += tuple_hash_field(&h, &carry, &key,
+					       key_def->parts[part_id].coll);
+	}
+	return PMurHash32_Result(h, carry, total_size);
+}
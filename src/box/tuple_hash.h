@@ -68,6 +68,32 @@ key_hash(const char *key, const struct key_def *key_def)
 	return key_def->key_hash(key, key_def);
 }
 
+/**
+ * Calculate a hash value for the first @a part_count parts
+ * of a tuple key. The result is the same as key_hash_prefix()
+ * returns for a key consisting of the same parts.
+ * @param tuple - a tuple
+ * @param key_def - key_def for field description
+ * @param part_count - number of key parts to hash
+ * @return - hash value
+ */
+uint32_t
+tuple_hash_prefix(const struct tuple *tuple, const struct key_def *key_def,
+		  uint32_t part_count);
+
+/**
+ * Calculate a hash value for the first @a part_count parts
+ * of a key.
+ * @param key - key (msgpack fields w/o array marker), must
+ * have at least @a part_count parts
+ * @param key_def - key_def for field description
+ * @param part_count - number of key parts to hash
+ * @return - hash value
+ */
+uint32_t
+key_hash_prefix(const char *key, const struct key_def *key_def,
+		uint32_t part_count);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -295,6 +295,10 @@ txn_commit(struct txn *txn)
 		if (engine_prepare(txn->engine, txn) != 0)
 			goto fail;
 
+		if (txn->has_triggers &&
+		    trigger_run(&txn->on_prepare, txn) != 0)
+			goto fail;
+
 		if (txn->n_rows > 0) {
 			txn->signature = txn_write_to_wal(txn);
 			if (txn->signature < 0)
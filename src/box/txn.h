@@ -137,6 +137,13 @@ struct txn {
 	struct trigger fiber_on_yield, fiber_on_stop;
 	 /** Commit and rollback triggers */
 	struct rlist on_commit, on_rollback;
+	/**
+	 * Triggers run after the transaction has been prepared
+	 * by the engine, right before it is submitted to WAL.
+	 * Unlike commit and rollback triggers, they may yield
+	 * and fail, in which case the transaction is rolled back.
+	 */
+	struct rlist on_prepare;
 	struct sql_txn *psql_txn;
 };
 
@@ -179,6 +186,7 @@ txn_init_triggers(struct txn *txn)
 	if (txn->has_triggers == false) {
 		rlist_create(&txn->on_commit);
 		rlist_create(&txn->on_rollback);
+		rlist_create(&txn->on_prepare);
 		txn->has_triggers = true;
 	}
 }
@@ -197,6 +205,13 @@ txn_on_rollback(struct txn *txn, struct trigger *trigger)
 	trigger_add(&txn->on_rollback, trigger);
 }
 
+static inline void
+txn_on_prepare(struct txn *txn, struct trigger *trigger)
+{
+	txn_init_triggers(txn);
+	trigger_add(&txn->on_prepare, trigger);
+}
+
 /**
  * Start a new statement. If no current transaction,
  * start a new transaction with autocommit = true.
@@ -54,6 +54,7 @@
 #include <small/lsregion.h>
 #include <small/region.h>
 #include <small/mempool.h>
+#include <third_party/qsort_arg.h>
 
 #include "coio_task.h"
 #include "cbus.h"
@@ -64,6 +65,7 @@
 #include "xlog.h"
 #include "engine.h"
 #include "space.h"
+#include "schema.h"
 #include "index.h"
 #include "xstream.h"
 #include "info.h"
@@ -72,6 +74,7 @@
 #include "checkpoint.h"
 #include "session.h"
 #include "wal.h" /* wal_mode() */
+#include "box.h" /* box_is_ro() */
 
 /**
  * Yield after iterating over this many objects (e.g. ranges).
@@ -84,6 +87,7 @@ enum { VY_YIELD_LOOPS = 2 };
 #endif
 
 struct vy_squash_queue;
+struct vy_deferred_delete_queue;
 
 enum vy_status {
 	VINYL_OFFLINE,
@@ -101,6 +105,8 @@ struct vy_env {
 	struct tx_manager   *xm;
 	/** Upsert squash queue */
 	struct vy_squash_queue *squash_queue;
+	/** Queue of DELETEs deferred by primary index compaction. */
+	struct vy_deferred_delete_queue *deferred_delete_queue;
 	/** Memory pool for index iterator. */
 	struct mempool iterator_pool;
 	/** Memory quota */
@@ -302,6 +308,8 @@ vy_info_append_quota(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "watermark", q->watermark);
 	info_append_int(h, "use_rate", env->quota_use_rate);
 	info_append_int(h, "dump_bandwidth", vy_dump_bandwidth(env));
+	info_append_int(h, "throttled", q->throttled);
+	info_append_double(h, "throttle_time", q->throttle_time);
 	info_table_end(h);
 }
 
@@ -346,6 +354,31 @@ vy_info_append_tx(struct vy_env *env, struct info_handler *h)
 	info_table_end(h);
 }
 
+static void
+vy_info_append_throttle_stat(struct info_handler *h, const char *name,
+			     const struct vy_throttle_stat *stat)
+{
+	info_table_begin(h, name);
+	info_append_int(h, "bytes", stat->bytes);
+	info_append_int(h, "throttled", stat->throttled);
+	info_append_double(h, "throttle_time", stat->throttle_time);
+	info_table_end(h);
+}
+
+static void
+vy_info_append_throttle(struct vy_env *env, struct info_handler *h)
+{
+	double rate;
+	struct vy_throttle_stat stat[vy_throttle_type_MAX];
+	vy_throttle_get_stat(&env->scheduler.throttle, &rate, stat);
+
+	info_table_begin(h, "throttle");
+	info_append_int(h, "rate", rate);
+	vy_info_append_throttle_stat(h, "dump", &stat[VY_THROTTLE_DUMP]);
+	vy_info_append_throttle_stat(h, "compact", &stat[VY_THROTTLE_COMPACT]);
+	info_table_end(h);
+}
+
 void
 vinyl_engine_info(struct vinyl_engine *vinyl, struct info_handler *h)
 {
@@ -355,6 +388,7 @@ vinyl_engine_info(struct vinyl_engine *vinyl, struct info_handler *h)
 	vy_info_append_quota(env, h);
 	vy_info_append_cache(env, h);
 	vy_info_append_tx(env, h);
+	vy_info_append_throttle(env, h);
 	info_end(h);
 }
 
@@ -395,6 +429,47 @@ vy_info_append_compact_stat(struct info_handler *h, const char *name,
 	info_table_end(h);
 }
 
+/**
+ * Append estimates of amplification factors of an index:
+ *
+ * - write: bytes written by dump and compaction per byte dumped;
+ * - read: max number of runs a point lookup may have to check;
+ * - space: disk size of the index relative to the size of the
+ *   oldest run of each range, which approximates the size of
+ *   the index after a full compaction.
+ */
+static void
+vy_info_append_amplification(struct info_handler *h, struct vy_index *index)
+{
+	struct vy_index_stat *stat = &index->stat;
+	double write_amp = 0;
+	if (stat->disk.dump.out.bytes > 0)
+		write_amp = (double)(stat->disk.dump.out.bytes +
+				     stat->disk.compact.out.bytes) /
+			    stat->disk.dump.out.bytes;
+
+	int read_amp = 0;
+	int64_t last_level_bytes = 0;
+	for (struct vy_range *range = vy_range_tree_first(index->tree);
+	     range != NULL; range = vy_range_tree_next(index->tree, range)) {
+		read_amp = MAX(read_amp, range->slice_count);
+		if (range->slice_count == 0)
+			continue;
+		struct vy_slice *slice = rlist_last_entry(&range->slices,
+						struct vy_slice, in_range);
+		last_level_bytes += slice->count.bytes;
+	}
+	double space_amp = 0;
+	if (last_level_bytes > 0)
+		space_amp = (double)stat->disk.count.bytes / last_level_bytes;
+
+	info_table_begin(h, "amplification");
+	info_append_double(h, "write", write_amp);
+	info_append_int(h, "read", read_amp);
+	info_append_double(h, "space", space_amp);
+	info_table_end(h);
+}
+
 static void
 vinyl_index_info(struct index *base, struct info_handler *h)
 {
@@ -438,6 +513,13 @@ vinyl_index_info(struct index *base, struct info_handler *h)
 	info_append_int(h, "hit", stat->disk.iterator.bloom_hit);
 	info_append_int(h, "miss", stat->disk.iterator.bloom_miss);
 	info_table_end(h);
+	info_table_begin(h, "page_cache");
+	info_append_int(h, "hit", stat->disk.iterator.page_cache_hit);
+	info_append_int(h, "miss", stat->disk.iterator.page_cache_miss);
+	info_table_end(h);
+	info_append_int(h, "prefetch", stat->disk.iterator.prefetch);
+	info_append_int(h, "parallel_lookup",
+			stat->disk.iterator.parallel_lookup);
 	info_table_end(h);
 	vy_info_append_compact_stat(h, "dump", &stat->disk.dump);
 	vy_info_append_compact_stat(h, "compact", &stat->disk.compact);
@@ -469,6 +551,7 @@ vinyl_index_info(struct index *base, struct info_handler *h)
 	info_append_int(h, "run_avg", index->run_count / index->range_count);
 	histogram_snprint(buf, sizeof(buf), index->run_hist);
 	info_append_str(h, "run_histogram", buf);
+	vy_info_append_amplification(h, index);
 
 	info_end(h);
 }
@@ -1090,6 +1173,17 @@ vinyl_space_prepare_alter(struct space *old_space, struct space *new_space)
 	if (pk->stat.disk.count.rows == 0 &&
 	    pk->stat.memory.count.rows == 0)
 		return 0;
+	/*
+	 * Secondary indexes of a space with deferred DELETEs may
+	 * store stale entries, which are only filtered out by
+	 * readers while the option is set.
+	 */
+	if (old_space->def->opts.defer_deletes &&
+	    !new_space->def->opts.defer_deletes) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "disabling defer_deletes for a non-empty space");
+		return -1;
+	}
 	/*
 	 * Since space format is not persisted in vylog, it can be
 	 * altered on non-empty space to some state, compatible
@@ -1160,6 +1254,8 @@ vinyl_space_commit_alter(struct space *old_space, struct space *new_space)
 	/* Set possibly changed opts. */
 	pk->opts = new_index_def->opts;
 	pk->check_is_unique = true;
+	pk->defer_deletes = new_space->def->opts.defer_deletes &&
+			    new_space->index_count > 1;
 
 	/* Set new formats. */
 	tuple_format_unref(pk->disk_format);
@@ -1409,6 +1505,45 @@ vy_index_get(struct vy_index *index, struct vy_tx *tx,
 	return rc;
 }
 
+/**
+ * Check if DELETEs for secondary indexes of a space can be
+ * deferred until primary index compaction instead of looking
+ * up the old tuple on disk, see space_opts::defer_deletes.
+ * The old tuple is needed if the space has on_replace triggers.
+ */
+static inline bool
+vy_space_defers_deletes(struct space *space)
+{
+	return space->def->opts.defer_deletes &&
+	       rlist_empty(&space->on_replace);
+}
+
+/**
+ * Look up the full tuple corresponding to a secondary index
+ * statement in the primary index. Set @result to NULL if the
+ * statement is stale, i.e. the tuple was overwritten or deleted
+ * while the DELETE for the secondary index was deferred (see
+ * space_opts::defer_deletes).
+ *
+ * Note, there's no need in vy_tx_track() as the statement is
+ * supposed to be tracked in the secondary index.
+ */
+static int
+vy_index_get_full(struct vy_index *index, struct vy_tx *tx,
+		  const struct vy_read_view **rv,
+		  struct tuple *stmt, struct tuple **result)
+{
+	assert(index->id > 0);
+	if (vy_point_lookup(index->pk, tx, rv, stmt, result) != 0)
+		return -1;
+	if (*result != NULL &&
+	    vy_tuple_compare(stmt, *result, index->cmp_def) != 0) {
+		tuple_unref(*result);
+		*result = NULL;
+	}
+	return 0;
+}
+
 /**
  * Check if the index contains the key. If true, then set
  * a duplicate key error in the diagnostics area.
@@ -1444,6 +1579,71 @@ vy_check_is_unique(struct vy_env *env, struct vy_tx *tx, struct space *space,
 	return 0;
 }
 
+/**
+ * Check if a secondary index contains a tuple with the same key
+ * as the given statement. If true, then set a duplicate key error
+ * in the diagnostics area. If the space defers DELETEs, stale
+ * index entries and the entry of the tuple replaced by the
+ * statement are ignored.
+ * @param env        Vinyl environment.
+ * @param tx         Current transaction.
+ * @param space      Target space.
+ * @param index      Secondary index in which to search.
+ * @param stmt       Statement to insert.
+ *
+ * @retval  0 Success, the key isn't found.
+ * @retval -1 Memory error or the key is found.
+ */
+static int
+vy_check_is_unique_secondary(struct vy_env *env, struct vy_tx *tx,
+			     struct space *space, struct vy_index *index,
+			     struct tuple *stmt)
+{
+	assert(index->id > 0);
+	/* See vy_check_is_unique(). */
+	if (env->status != VINYL_ONLINE)
+		return 0;
+	struct tuple *key = vy_stmt_extract_key(stmt, index->key_def,
+						index->env->key_format);
+	if (key == NULL)
+		return -1;
+	if (!index->pk->defer_deletes) {
+		/* No stale entries, a point lookup will do. */
+		int rc = vy_check_is_unique(env, tx, space, index, key);
+		tuple_unref(key);
+		return rc;
+	}
+	const struct vy_read_view **rv = vy_tx_read_view(tx);
+	struct vy_read_iterator itr;
+	vy_read_iterator_open(&itr, index, tx, ITER_EQ, key, rv);
+	struct tuple *found;
+	int rc;
+	while ((rc = vy_read_iterator_next(&itr, &found)) == 0 &&
+	       found != NULL) {
+		/*
+		 * If the primary key matches, the entry is either
+		 * the tuple we are replacing or a stale one.
+		 */
+		if (vy_tuple_compare(found, stmt, index->pk->key_def) == 0)
+			continue;
+		struct tuple *full;
+		rc = vy_index_get_full(index, tx, rv, found, &full);
+		if (rc != 0)
+			break;
+		if (full != NULL) {
+			tuple_unref(full);
+			diag_set(ClientError, ER_TUPLE_FOUND,
+				 index_name_by_id(space, index->id),
+				 space_name(space));
+			rc = -1;
+			break;
+		}
+	}
+	vy_read_iterator_close(&itr);
+	tuple_unref(key);
+	return rc;
+}
+
 /**
  * Insert a tuple in a primary index.
  * @param env   Vinyl environment.
@@ -1500,16 +1700,9 @@ vy_insert_secondary(struct vy_env *env, struct vy_tx *tx, struct space *space,
 	    !key_update_can_be_skipped(index->key_def->column_mask,
 				       vy_stmt_column_mask(stmt)) &&
 	    (!index->key_def->is_nullable ||
-	     !vy_tuple_key_contains_null(stmt, index->key_def))) {
-		struct tuple *key = vy_stmt_extract_key(stmt, index->key_def,
-							index->env->key_format);
-		if (key == NULL)
-			return -1;
-		int rc = vy_check_is_unique(env, tx, space, index, key);
-		tuple_unref(key);
-		if (rc != 0)
-			return -1;
-	}
+	     !vy_tuple_key_contains_null(stmt, index->key_def)) &&
+	    vy_check_is_unique_secondary(env, tx, space, index, stmt) != 0)
+		return -1;
 	/*
 	 * We must always append the statement to transaction write set
 	 * of each index, even if operation itself does not update
@@ -1611,11 +1804,24 @@ vy_replace_impl(struct vy_env *env, struct vy_tx *tx, struct space *space,
 		return -1;
 
 	/* Get full tuple from the primary index. */
-	if (vy_index_get(pk, tx, vy_tx_read_view(tx),
-			 new_stmt, &old_stmt) != 0)
+	bool old_found = true;
+	if (vy_space_defers_deletes(space)) {
+		/*
+		 * Don't read the disk to find the old tuple. If
+		 * it isn't in memory, REPLACE only inserts the new
+		 * tuple into secondary indexes. The old tuple will
+		 * be deleted from them on primary index compaction.
+		 */
+		if (vy_tx_track_point(tx, pk, new_stmt) != 0 ||
+		    vy_point_lookup_mem(pk, tx, vy_tx_read_view(tx),
+					new_stmt, &old_stmt, &old_found) != 0)
+			goto error;
+	} else if (vy_index_get(pk, tx, vy_tx_read_view(tx),
+				new_stmt, &old_stmt) != 0) {
 		goto error;
+	}
 
-	if (old_stmt == NULL) {
+	if (old_stmt == NULL && old_found) {
 		/*
 		 * We can turn REPLACE into INSERT if the new key
 		 * does not have history.
@@ -1737,21 +1943,42 @@ vy_index_full_by_key(struct vy_index *index, struct vy_tx *tx,
 					       key_raw, part_count);
 	if (key == NULL)
 		return -1;
-	struct tuple *found;
-	rc = vy_index_get(index, tx, rv, key, &found);
-	tuple_unref(key);
-	if (rc != 0)
-		return -1;
-	if (index->id == 0 || found == NULL) {
-		*result = found;
-		return 0;
+	if (index->id == 0 || !index->pk->defer_deletes) {
+		struct tuple *found;
+		rc = vy_index_get(index, tx, rv, key, &found);
+		tuple_unref(key);
+		if (rc != 0)
+			return -1;
+		if (index->id == 0 || found == NULL) {
+			*result = found;
+			return 0;
+		}
+		/*
+		 * No need in vy_tx_track() as the tuple is already
+		 * tracked in the secondary index.
+		 */
+		rc = vy_point_lookup(index->pk, tx, rv, found, result);
+		tuple_unref(found);
+		return rc;
 	}
 	/*
-	 * No need in vy_tx_track() as the tuple is already
-	 * tracked in the secondary index.
+	 * A secondary index of a space with deferred DELETEs
+	 * may store stale entries for the key, see
+	 * vy_index_get_full(), so look up all of them until
+	 * a live one is found.
 	 */
-	rc = vy_point_lookup(index->pk, tx, rv, found, result);
-	tuple_unref(found);
+	*result = NULL;
+	struct vy_read_iterator itr;
+	vy_read_iterator_open(&itr, index, tx, ITER_EQ, key, rv);
+	struct tuple *found;
+	while ((rc = vy_read_iterator_next(&itr, &found)) == 0 &&
+	       found != NULL) {
+		rc = vy_index_get_full(index, tx, rv, found, result);
+		if (rc != 0 || *result != NULL)
+			break;
+	}
+	vy_read_iterator_close(&itr);
+	tuple_unref(key);
 	return rc;
 }
 
@@ -1836,8 +2063,33 @@ vy_delete(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 	 * - if the space has one or more secondary indexes, then
 	 *   we need to extract secondary keys from the old tuple
 	 *   and pass them to indexes for deletion.
+	 *
+	 * In the latter case, if the space defers DELETEs and
+	 * the tuple is deleted by the primary key, we don't read
+	 * the disk: if the tuple isn't found in memory, we delete
+	 * the key from the primary index only and let primary
+	 * index compaction delete the tuple from secondary indexes.
 	 */
-	if (has_secondary || !rlist_empty(&space->on_replace)) {
+	if (has_secondary && index->id == 0 &&
+	    vy_space_defers_deletes(space)) {
+		struct tuple *key_stmt = vy_stmt_new_select(pk->env->key_format,
+							    key, part_count);
+		if (key_stmt == NULL)
+			return -1;
+		bool found;
+		int rc = vy_tx_track_point(tx, pk, key_stmt);
+		if (rc == 0)
+			rc = vy_point_lookup_mem(pk, tx, vy_tx_read_view(tx),
+						 key_stmt, &stmt->old_tuple,
+						 &found);
+		tuple_unref(key_stmt);
+		if (rc != 0)
+			return -1;
+		if (found && stmt->old_tuple == NULL)
+			return 0;
+		if (!found)
+			has_secondary = false;
+	} else if (has_secondary || !rlist_empty(&space->on_replace)) {
 		if (vy_index_full_by_key(index, tx, vy_tx_read_view(tx),
 				key, part_count, &stmt->old_tuple) != 0)
 			return -1;
@@ -1861,6 +2113,73 @@ vy_delete(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 	}
 }
 
+/**
+ * Execute a DELETE deferred by primary index compaction, see
+ * IPROTO_DEFERRED_DELETE. The request tuple is a tuple that was
+ * overwritten in the primary index. It is deleted from each
+ * secondary index unless the current version of the tuple has
+ * the same secondary key.
+ * @param env     Vinyl environment.
+ * @param tx      Current transaction.
+ * @param space   Vinyl space.
+ * @param request Request with the overwritten tuple.
+ *
+ * @retval  0 Success
+ * @retval -1 Memory error or read error.
+ */
+static int
+vy_deferred_delete(struct vy_env *env, struct vy_tx *tx,
+		   struct space *space, struct request *request)
+{
+	if (space->index_count <= 1 || vy_is_committed(env, space))
+		return 0;
+	struct vy_index *pk = vy_index_find(space, 0);
+	if (pk == NULL)
+		return -1;
+	if (tuple_validate_raw(pk->mem_format, request->tuple))
+		return -1;
+	struct tuple *old_stmt = vy_stmt_new_replace(pk->mem_format,
+						     request->tuple,
+						     request->tuple_end);
+	if (old_stmt == NULL)
+		return -1;
+	int rc = -1;
+	struct tuple *delete = NULL;
+	struct tuple *cur_stmt = NULL;
+	/*
+	 * The key may have been overwritten with a tuple that has
+	 * the same secondary key after the DELETE was generated.
+	 * Look up the current version and track the read so that
+	 * the transaction is aborted if the key is overwritten
+	 * before it commits.
+	 */
+	if (vy_tx_track_point(tx, pk, old_stmt) != 0 ||
+	    vy_point_lookup(pk, tx, vy_tx_read_view(tx),
+			    old_stmt, &cur_stmt) != 0)
+		goto out;
+	delete = vy_stmt_new_surrogate_delete(pk->mem_format, old_stmt);
+	if (delete == NULL)
+		goto out;
+	for (uint32_t i = 1; i < space->index_count; i++) {
+		struct vy_index *index = vy_index(space->index[i]);
+		if (vy_is_committed_one(env, space, index))
+			continue;
+		if (cur_stmt != NULL &&
+		    vy_tuple_compare(old_stmt, cur_stmt, index->key_def) == 0)
+			continue;
+		if (vy_tx_set(tx, index, delete) != 0)
+			goto out;
+	}
+	rc = 0;
+out:
+	if (delete != NULL)
+		tuple_unref(delete);
+	if (cur_stmt != NULL)
+		tuple_unref(cur_stmt);
+	tuple_unref(old_stmt);
+	return rc;
+}
+
 /**
  * We do not allow changes of the primary key during update.
  *
@@ -2415,6 +2734,15 @@ vinyl_space_execute_upsert(struct space *space, struct txn *txn,
 	return vy_upsert(env, tx, stmt, space, request);
 }
 
+static int
+vinyl_space_execute_deferred_delete(struct space *space, struct txn *txn,
+				    struct request *request)
+{
+	struct vy_env *env = vy_env(space->engine);
+	struct vy_tx *tx = txn->engine_tx;
+	return vy_deferred_delete(env, tx, space, request);
+}
+
 static int
 vinyl_space_ephemeral_replace(struct space *space, const char *tuple,
 			      const char *tuple_end)
@@ -2645,6 +2973,16 @@ vy_env_quota_timer_cb(ev_loop *loop, ev_timer *timer, int events)
 			    (dump_bandwidth + e->quota_use_rate + 1));
 
 	vy_quota_set_watermark(&e->quota, watermark);
+	vy_quota_set_dump_bandwidth(&e->quota, dump_bandwidth);
+
+	/*
+	 * Adapt the rate of background writes to the read
+	 * latency observed since the last invocation.
+	 */
+	vy_throttle_update(&e->scheduler.throttle,
+			   e->run_env.read_latency_max,
+			   VY_QUOTA_UPDATE_INTERVAL);
+	e->run_env.read_latency_max = 0;
 }
 
 static void
@@ -2703,6 +3041,237 @@ vy_env_dump_complete_cb(struct vy_scheduler *scheduler,
 				  mem_dumped / dump_duration);
 }
 
+/**
+ * A tuple overwritten in the primary index of a space with
+ * deferred DELETEs (see space_opts::defer_deletes) that has to
+ * be deleted from secondary indexes.
+ */
+struct vy_deferred_delete_req {
+	/** Next in vy_deferred_delete_queue::queue. */
+	struct stailq_entry next;
+	/** Primary index the tuple was overwritten in. */
+	struct vy_index *pk;
+	/** Overwritten tuple. */
+	struct tuple *stmt;
+};
+
+/**
+ * Deferred DELETEs are generated by the scheduler fiber, which
+ * must not wait for WAL or memory quota, because the latter can
+ * only be freed by dump. So they are queued and written to WAL
+ * by a separate fiber as IPROTO_DEFERRED_DELETE requests. This
+ * gives them a real LSN and makes them survive restart and get
+ * replicated as any other statement.
+ */
+struct vy_deferred_delete_queue {
+	/** Fiber writing deferred DELETEs to WAL. */
+	struct fiber *fiber;
+	/** Used to wake up the fiber to process more requests. */
+	struct fiber_cond cond;
+	/** Queue of vy_deferred_delete_req objects. */
+	struct stailq queue;
+	/** Number of requests in the queue. */
+	int size;
+	/** Mempool for struct vy_deferred_delete_req. */
+	struct mempool pool;
+};
+
+enum {
+	/** Max number of deferred DELETEs written in one transaction. */
+	VY_DEFERRED_DELETE_BATCH = 64,
+	/**
+	 * Max number of deferred DELETEs waiting to be written.
+	 * The rest are dropped, which only leaves garbage in
+	 * secondary indexes.
+	 */
+	VY_DEFERRED_DELETE_QUEUE_MAX = 64 * 1024,
+};
+
+static void
+vy_deferred_delete_req_delete(struct mempool *pool,
+			      struct vy_deferred_delete_req *req)
+{
+	vy_index_unref(req->pk);
+	tuple_unref(req->stmt);
+	mempool_free(pool, req);
+}
+
+/**
+ * Write a batch of deferred DELETEs to WAL in one transaction.
+ * See vy_deferred_delete() for how they are executed.
+ */
+static int
+vy_deferred_delete_write(struct stailq *batch)
+{
+	struct txn *txn = txn_begin(false);
+	if (txn == NULL)
+		return -1;
+	struct vy_deferred_delete_req *req;
+	stailq_foreach_entry(req, batch, next) {
+		struct vy_index *pk = req->pk;
+		if (pk->is_dropped)
+			continue;
+		struct space *space = space_by_id(pk->space_id);
+		if (space == NULL || space->index_count <= 1 ||
+		    vy_index(space->index[0]) != pk)
+			continue;
+		struct request request;
+		memset(&request, 0, sizeof(request));
+		request.type = IPROTO_DEFERRED_DELETE;
+		request.space_id = pk->space_id;
+		uint32_t size;
+		request.tuple = tuple_data_range(req->stmt, &size);
+		request.tuple_end = request.tuple + size;
+		if (txn_begin_stmt(space) == NULL)
+			goto fail;
+		struct tuple *unused;
+		if (space_execute_dml(space, txn, &request, &unused) != 0) {
+			txn_rollback_stmt();
+			goto fail;
+		}
+		if (txn_commit_stmt(txn, &request) != 0)
+			goto fail;
+	}
+	return txn_commit(txn);
+fail:
+	txn_rollback();
+	return -1;
+}
+
+static int
+vy_deferred_delete_queue_f(va_list va)
+{
+	struct vy_deferred_delete_queue *q =
+		va_arg(va, struct vy_deferred_delete_queue *);
+	while (q->fiber != NULL) {
+		if (stailq_empty(&q->queue)) {
+			fiber_cond_wait(&q->cond);
+			continue;
+		}
+		struct stailq batch;
+		stailq_create(&batch);
+		for (int i = 0; i < VY_DEFERRED_DELETE_BATCH &&
+			     !stailq_empty(&q->queue); i++) {
+			stailq_add_tail(&batch, stailq_shift(&q->queue));
+			q->size--;
+		}
+		/*
+		 * Failure to write deferred DELETEs, e.g. because
+		 * of a conflict with a concurrent transaction, is
+		 * not critical: secondary index readers filter
+		 * stale entries.
+		 */
+		if (vy_deferred_delete_write(&batch) != 0)
+			diag_log();
+		struct vy_deferred_delete_req *req, *next;
+		stailq_foreach_entry_safe(req, next, &batch, next)
+			vy_deferred_delete_req_delete(&q->pool, req);
+	}
+	return 0;
+}
+
+static struct vy_deferred_delete_queue *
+vy_deferred_delete_queue_new(void)
+{
+	struct vy_deferred_delete_queue *q = malloc(sizeof(*q));
+	if (q == NULL) {
+		diag_set(OutOfMemory, sizeof(*q), "malloc", "q");
+		return NULL;
+	}
+	q->fiber = NULL;
+	fiber_cond_create(&q->cond);
+	stailq_create(&q->queue);
+	q->size = 0;
+	mempool_create(&q->pool, cord_slab_cache(),
+		       sizeof(struct vy_deferred_delete_req));
+	return q;
+}
+
+static void
+vy_deferred_delete_queue_delete(struct vy_deferred_delete_queue *q)
+{
+	if (q->fiber != NULL) {
+		q->fiber = NULL;
+		/* Sic: fiber_cancel() can't be used here */
+		fiber_cond_signal(&q->cond);
+	}
+	struct vy_deferred_delete_req *req, *next;
+	stailq_foreach_entry_safe(req, next, &q->queue, next)
+		vy_deferred_delete_req_delete(&q->pool, req);
+	mempool_destroy(&q->pool);
+	free(q);
+}
+
+/**
+ * Schedule deletion of a tuple overwritten in the primary index
+ * of a space with deferred DELETEs (see space_opts::defer_deletes)
+ * from secondary indexes whose key differs from the key of the
+ * newest tuple version (@new_stmt, NULL if the tuple was
+ * deleted).
+ *
+ * A read-only instance doesn't generate deferred DELETEs: they
+ * are written to WAL and so would bump the instance's own
+ * vclock component. It applies those received from the master
+ * instead.
+ */
+static void
+vy_env_deferred_delete_cb(struct vy_scheduler *scheduler,
+			  struct vy_index *pk, struct tuple *old_stmt,
+			  struct tuple *new_stmt)
+{
+	struct vy_env *env = container_of(scheduler, struct vy_env, scheduler);
+	struct vy_deferred_delete_queue *q = env->deferred_delete_queue;
+	assert(pk->id == 0);
+	if (env->status != VINYL_ONLINE || wal_mode() == WAL_NONE ||
+	    box_is_ro() || pk->is_dropped)
+		return;
+	struct space *space = space_by_id(pk->space_id);
+	if (space == NULL || space->index_count <= 1 ||
+	    vy_index(space->index[0]) != pk)
+		return;
+	if (new_stmt != NULL) {
+		uint32_t i;
+		for (i = 1; i < space->index_count; i++) {
+			struct vy_index *index = vy_index(space->index[i]);
+			if (vy_tuple_compare(old_stmt, new_stmt,
+					     index->key_def) != 0)
+				break;
+		}
+		if (i == space->index_count)
+			return; /* No secondary key changed. */
+	}
+	if (q->size >= VY_DEFERRED_DELETE_QUEUE_MAX)
+		return;
+
+	/* Start the deferred DELETE writer fiber on demand. */
+	if (q->fiber == NULL) {
+		q->fiber = fiber_new("vinyl.deferred_delete",
+				     vy_deferred_delete_queue_f);
+		if (q->fiber == NULL)
+			goto fail;
+		fiber_start(q->fiber, q);
+	}
+
+	struct vy_deferred_delete_req *req = mempool_alloc(&q->pool);
+	if (req == NULL) {
+		diag_set(OutOfMemory, sizeof(*req), "mempool",
+			 "struct vy_deferred_delete_req");
+		goto fail;
+	}
+	vy_index_ref(pk);
+	req->pk = pk;
+	tuple_ref(old_stmt);
+	req->stmt = old_stmt;
+	stailq_add_tail_entry(&q->queue, req, next);
+	q->size++;
+	fiber_cond_signal(&q->cond);
+	return;
+fail:
+	/* Not critical: readers skip stale secondary index entries. */
+	diag_log();
+	diag_clear(diag_get());
+}
+
 static struct vy_squash_queue *
 vy_squash_queue_new(void);
 static void
@@ -2768,10 +3337,14 @@ vy_env_new(const char *path, size_t memory,
 	e->squash_queue = vy_squash_queue_new();
 	if (e->squash_queue == NULL)
 		goto error_squash_queue;
+	e->deferred_delete_queue = vy_deferred_delete_queue_new();
+	if (e->deferred_delete_queue == NULL)
+		goto error_deferred_delete_queue;
 
 	vy_mem_env_create(&e->mem_env, e->memory);
 	vy_scheduler_create(&e->scheduler, e->write_threads,
 			    vy_env_dump_complete_cb,
+			    vy_env_deferred_delete_cb,
 			    &e->run_env, &e->xm->read_views);
 
 	if (vy_index_env_create(&e->index_env, e->path,
@@ -2794,6 +3367,8 @@ vy_env_new(const char *path, size_t memory,
 error_index_env:
 	vy_mem_env_destroy(&e->mem_env);
 	vy_scheduler_destroy(&e->scheduler);
+	vy_deferred_delete_queue_delete(e->deferred_delete_queue);
+error_deferred_delete_queue:
 	vy_squash_queue_delete(e->squash_queue);
 error_squash_queue:
 	tx_manager_delete(e->xm);
@@ -2812,6 +3387,7 @@ vy_env_delete(struct vy_env *e)
 	ev_timer_stop(loop(), &e->quota_timer);
 	vy_scheduler_destroy(&e->scheduler);
 	vy_squash_queue_delete(e->squash_queue);
+	vy_deferred_delete_queue_delete(e->deferred_delete_queue);
 	tx_manager_delete(e->xm);
 	free(e->path);
 	histogram_delete(e->dump_bw);
@@ -2865,6 +3441,27 @@ vinyl_engine_set_cache(struct vinyl_engine *vinyl, size_t quota)
 	vy_cache_env_set_quota(&vinyl->env->cache_env, quota);
 }
 
+void
+vinyl_engine_set_page_cache(struct vinyl_engine *vinyl, size_t quota)
+{
+	vy_run_env_set_page_cache(&vinyl->env->run_env, quota);
+}
+
+void
+vinyl_engine_set_write_rate_limit(struct vinyl_engine *vinyl, double limit)
+{
+	vy_throttle_set_rate_limit(&vinyl->env->scheduler.throttle,
+				   limit * 1024 * 1024);
+}
+
+void
+vinyl_engine_set_read_latency_target(struct vinyl_engine *vinyl,
+				     double target)
+{
+	vy_throttle_set_latency_target(&vinyl->env->scheduler.throttle,
+				       target);
+}
+
 void
 vinyl_engine_set_max_tuple_size(struct vinyl_engine *vinyl, size_t max_size)
 {
@@ -3123,7 +3720,7 @@ vy_send_range(struct vy_join_ctx *ctx)
 	rlist_create(&fake_read_views);
 	ctx->wi = vy_write_iterator_new(ctx->key_def,
 					ctx->format, ctx->upsert_format,
-					true, true, &fake_read_views);
+					true, true, &fake_read_views, NULL);
 	if (ctx->wi == NULL)
 		goto out;
 
@@ -3979,6 +4576,7 @@ vinyl_iterator_secondary_next(struct iterator *base, struct tuple **ret)
 	struct vinyl_iterator *it = (struct vinyl_iterator *)base;
 	assert(it->index->id > 0);
 	struct tuple *tuple;
+	struct tuple *full;
 
 	if (it->tx == NULL) {
 		diag_set(ClientError, ER_CURSOR_NO_TRANSACTION);
@@ -3989,7 +4587,7 @@ vinyl_iterator_secondary_next(struct iterator *base, struct tuple **ret)
 		goto fail;
 	}
 
-
+next:
 	if (vy_read_iterator_next(&it->iterator, &tuple) != 0)
 		goto fail;
 
@@ -4007,16 +4605,16 @@ vinyl_iterator_secondary_next(struct iterator *base, struct tuple **ret)
 			fiber_sleep(0.01);
 	}
 #endif
-	/*
-	 * Get the full tuple from the primary index.
-	 * Note, there's no need in vy_tx_track() as the
-	 * tuple is already tracked in the secondary index.
-	 */
-	if (vy_point_lookup(it->index->pk, it->tx, vy_tx_read_view(it->tx),
-			    tuple, &tuple) != 0)
+	/* Get the full tuple from the primary index. */
+	if (vy_index_get_full(it->index, it->tx, vy_tx_read_view(it->tx),
+			      tuple, &full) != 0)
 		goto fail;
-	*ret = tuple_bless(tuple);
-	tuple_unref(tuple);
+	if (full == NULL) {
+		/* Skip a stale entry. */
+		goto next;
+	}
+	*ret = tuple_bless(full);
+	tuple_unref(full);
 	if (*ret != NULL)
 		return 0;
 fail:
@@ -4117,6 +4715,181 @@ vinyl_index_get(struct index *base, const char *key,
 	return 0;
 }
 
+enum {
+	/** Max number of fibers doing lookups for index:get_multi(). */
+	VY_GET_MULTI_FIBER_MAX = 16,
+	/**
+	 * Min number of keys looked up by one fiber. Fibers look
+	 * up adjacent keys, so the more keys a fiber gets, the
+	 * fewer pages are read by more than one fiber at once.
+	 */
+	VY_GET_MULTI_CHUNK_MIN = 32,
+};
+
+/** A chunk of keys looked up by a fiber for index:get_multi(). */
+struct vy_get_multi_chunk {
+	struct vy_index *index;
+	struct vy_tx *tx;
+	const struct vy_read_view **rv;
+	/** Keys, in MsgPack Array format. */
+	const char **keys;
+	/** Positions of keys to look up, in the key order. */
+	const uint32_t *order;
+	uint32_t count;
+	/** Found tuples, indexed by key position. */
+	struct tuple **result;
+	/** Fiber doing the lookups or NULL if none. */
+	struct fiber *fiber;
+};
+
+static int
+vy_get_multi_chunk_lookup(struct vy_get_multi_chunk *chunk)
+{
+	for (uint32_t i = 0; i < chunk->count; i++) {
+		struct vy_tx *tx = chunk->tx;
+		if (tx != NULL && tx->state == VINYL_TX_ABORT) {
+			/*
+			 * The transaction was aborted while we
+			 * were waiting for disk, stop early.
+			 */
+			diag_set(ClientError, ER_TRANSACTION_CONFLICT);
+			return -1;
+		}
+		uint32_t pos = chunk->order[i];
+		const char *key = chunk->keys[pos];
+		uint32_t part_count = mp_decode_array(&key);
+		if (vy_index_full_by_key(chunk->index, tx, chunk->rv, key,
+					 part_count, &chunk->result[pos]) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+static int
+vy_get_multi_chunk_f(va_list ap)
+{
+	struct vy_get_multi_chunk *chunk =
+		va_arg(ap, struct vy_get_multi_chunk *);
+	return vy_get_multi_chunk_lookup(chunk);
+}
+
+static int
+vy_get_multi_key_cmp(const void *a, const void *b, void *arg)
+{
+	struct vy_get_multi_chunk *chunk = arg;
+	const char *key_a = chunk->keys[*(const uint32_t *)a];
+	const char *key_b = chunk->keys[*(const uint32_t *)b];
+	return key_compare(key_a, key_b, chunk->index->cmp_def);
+}
+
+/**
+ * Look up a batch of keys. Keys are sorted so that lookups
+ * of neighbouring keys hit the same pages and split in chunks
+ * looked up concurrently by several fibers, so that page reads
+ * for different chunks are in flight at the same time. Pages
+ * read during the batch are kept in the page cache, hence
+ * a page shared by keys of a chunk is read from disk once.
+ */
+static int
+vinyl_index_get_multi(struct index *base, const char **keys,
+		      uint32_t key_count, struct tuple **result)
+{
+	assert(base->def->opts.is_unique);
+
+	struct vy_index *index = vy_index(base);
+	struct vy_env *env = vy_env(base->engine);
+	struct vy_tx *tx = in_txn() ? in_txn()->engine_tx : NULL;
+	const struct vy_read_view **rv = (tx != NULL ? vy_tx_read_view(tx) :
+					  &env->xm->p_global_read_view);
+
+	for (uint32_t i = 0; i < key_count; i++)
+		result[i] = NULL;
+	if (key_count == 0)
+		return 0;
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t *order = region_alloc(region, key_count * sizeof(*order));
+	if (order == NULL) {
+		diag_set(OutOfMemory, key_count * sizeof(*order),
+			 "region", "key order");
+		return -1;
+	}
+	for (uint32_t i = 0; i < key_count; i++)
+		order[i] = i;
+
+	uint32_t chunk_count = 1;
+	if (env->run_env.reader_pool != NULL) {
+		chunk_count = DIV_ROUND_UP(key_count, VY_GET_MULTI_CHUNK_MIN);
+		chunk_count = MIN(chunk_count,
+				  (uint32_t)VY_GET_MULTI_FIBER_MAX);
+	}
+	size_t size = chunk_count * sizeof(struct vy_get_multi_chunk);
+	struct vy_get_multi_chunk *chunks = region_alloc(region, size);
+	if (chunks == NULL) {
+		diag_set(OutOfMemory, size, "region", "key chunks");
+		region_truncate(region, region_svp);
+		return -1;
+	}
+	uint32_t chunk_size = DIV_ROUND_UP(key_count, chunk_count);
+	for (uint32_t i = 0; i < chunk_count; i++) {
+		struct vy_get_multi_chunk *chunk = &chunks[i];
+		chunk->index = index;
+		chunk->tx = tx;
+		chunk->rv = rv;
+		chunk->keys = keys;
+		chunk->order = order + MIN(i * chunk_size, key_count);
+		chunk->count = MIN(chunk_size, key_count -
+				   MIN(i * chunk_size, key_count));
+		chunk->result = result;
+		chunk->fiber = NULL;
+	}
+	qsort_arg(order, key_count, sizeof(*order),
+		  vy_get_multi_key_cmp, &chunks[0]);
+
+	vy_run_env_begin_batch(&env->run_env);
+	/*
+	 * The first chunk is looked up by the caller, the rest
+	 * by separate fibers. Failure to start a fiber is not
+	 * critical, the chunk is looked up by the caller then.
+	 */
+	for (uint32_t i = 1; i < chunk_count; i++) {
+		struct vy_get_multi_chunk *chunk = &chunks[i];
+		if (chunk->count == 0)
+			continue;
+		chunk->fiber = fiber_new("vinyl.get_multi",
+					 vy_get_multi_chunk_f);
+		if (chunk->fiber == NULL) {
+			diag_clear(diag_get());
+			continue;
+		}
+		fiber_set_joinable(chunk->fiber, true);
+		fiber_start(chunk->fiber, chunk);
+	}
+	int rc = 0;
+	for (uint32_t i = 0; i < chunk_count; i++) {
+		struct vy_get_multi_chunk *chunk = &chunks[i];
+		int chunk_rc;
+		if (chunk->fiber != NULL)
+			chunk_rc = fiber_join(chunk->fiber);
+		else
+			chunk_rc = vy_get_multi_chunk_lookup(chunk);
+		if (chunk_rc != 0)
+			rc = -1;
+	}
+	vy_run_env_end_batch(&env->run_env);
+	region_truncate(region, region_svp);
+
+	if (rc != 0) {
+		for (uint32_t i = 0; i < key_count; i++) {
+			if (result[i] != NULL)
+				tuple_unref(result[i]);
+			result[i] = NULL;
+		}
+	}
+	return rc;
+}
+
 /*** }}} Cursor */
 
 static const struct engine_vtab vinyl_engine_vtab = {
@@ -4152,6 +4925,7 @@ static const struct space_vtab vinyl_space_vtab = {
 	/* .execute_delete = */ vinyl_space_execute_delete,
 	/* .execute_update = */ vinyl_space_execute_update,
 	/* .execute_upsert = */ vinyl_space_execute_upsert,
+	/* .execute_deferred_delete = */ vinyl_space_execute_deferred_delete,
 	/* .ephemeral_replace = */ vinyl_space_ephemeral_replace,
 	/* .ephemeral_delete = */ vinyl_space_ephemeral_delete,
 	/* .ephemeral_cleanup = */ vinyl_space_ephemeral_cleanup,
@@ -4181,6 +4955,7 @@ static const struct index_vtab vinyl_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
 	/* .get = */ vinyl_index_get,
+	/* .get_multi = */ vinyl_index_get_multi,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ vinyl_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -57,6 +57,27 @@ vinyl_engine_info(struct vinyl_engine *vinyl, struct info_handler *handler);
 void
 vinyl_engine_set_cache(struct vinyl_engine *vinyl, size_t quota);
 
+/**
+ * Update vinyl page cache size.
+ */
+void
+vinyl_engine_set_page_cache(struct vinyl_engine *vinyl, size_t quota);
+
+/**
+ * Update the max rate of vinyl dump and compaction writes,
+ * in megabytes per second. 0 means unlimited.
+ */
+void
+vinyl_engine_set_write_rate_limit(struct vinyl_engine *vinyl, double limit);
+
+/**
+ * Update the read latency above which vinyl compaction is
+ * slowed down, in seconds. 0 disables adaptation.
+ */
+void
+vinyl_engine_set_read_latency_target(struct vinyl_engine *vinyl,
+				     double target);
+
 /**
  * Update max tuple size.
  */
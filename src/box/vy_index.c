@@ -755,6 +755,25 @@ vy_index_unacct_range(struct vy_index *index, struct vy_range *range)
 	histogram_discard(index->run_hist, range->slice_count);
 }
 
+double
+vy_index_bloom_fpr(struct vy_index *index, uint64_t run_rows,
+		   uint64_t level_rows)
+{
+	double fpr = index->opts.bloom_fpr;
+	/*
+	 * Don't let the rate of upper levels exceed 50% so that
+	 * their filters are still worth checking.
+	 */
+	double max_fpr = MAX(fpr, 0.5);
+	double ratio = index->opts.run_size_ratio;
+	double rows = level_rows;
+	while (fpr < max_fpr && run_rows * ratio <= rows) {
+		fpr *= ratio;
+		rows /= ratio;
+	}
+	return MIN(fpr, max_fpr);
+}
+
 int
 vy_index_rotate_mem(struct vy_index *index)
 {
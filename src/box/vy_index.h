@@ -165,6 +165,14 @@ struct vy_index {
 	 * is not unique or it is a part of another unique index.
 	 */
 	bool check_is_unique;
+	/**
+	 * Set for the primary index of a space that has secondary
+	 * indexes and defers DELETEs, see space_opts::defer_deletes.
+	 * If set, compaction of the index generates DELETEs for
+	 * overwritten tuples and inserts them into secondary
+	 * indexes.
+	 */
+	bool defer_deletes;
 	/**
 	 * Tuple format for tuples of this index created when
 	 * reading pages from disk.
@@ -243,6 +251,14 @@ struct vy_index {
 	 * to invalidate iterators.
 	 */
 	uint32_t mem_list_version;
+	/**
+	 * Saturating counter used by point lookups to decide
+	 * whether to read runs concurrently. Incremented every
+	 * time a lookup finds statements for the key in more than
+	 * one run (e.g. a chain of UPSERTs), decremented when one
+	 * run is enough.
+	 */
+	int deep_lookup_score;
 	/**
 	 * Incremented for each change of the range list,
 	 * to invalidate iterators.
@@ -432,6 +448,25 @@ vy_index_acct_range(struct vy_index *index, struct vy_range *range);
 void
 vy_index_unacct_range(struct vy_index *index, struct vy_range *range);
 
+/**
+ * Return the bloom filter false positive rate for a new run
+ * of an index. index->opts.bloom_fpr is used for runs of the
+ * last LSM tree level, which hold most of the data and so are
+ * the most expensive to read in vain. Each level above it is
+ * run_size_ratio times smaller, and its runs get a proportionally
+ * higher rate, because their filters are cheap to make precise
+ * while saving little memory.
+ *
+ * @param run_rows    Max number of statements in the new run.
+ * @param level_rows  Number of statements in the runs the new
+ *                    run is going to be compared against (all
+ *                    runs of the index on dump, runs of the range
+ *                    on compaction).
+ */
+double
+vy_index_bloom_fpr(struct vy_index *index, uint64_t run_rows,
+		   uint64_t level_rows);
+
 /**
  * Allocate a new active in-memory index for an index while moving
  * the old one to the sealed list. Used by the dump task in order
@@ -175,6 +175,18 @@ vy_mem_older_lsn(struct vy_mem *mem, const struct tuple *stmt)
 	return result;
 }
 
+bool
+vy_mem_has_key(struct vy_mem *mem, const struct tuple *stmt)
+{
+	struct tree_mem_key tree_key;
+	tree_key.stmt = stmt;
+	/* (lsn == INT64_MAX - 1) means that lsn is ignored in comparison */
+	tree_key.lsn = INT64_MAX - 1;
+	bool exact = false;
+	vy_mem_tree_lower_bound(&mem->tree, &tree_key, &exact);
+	return exact;
+}
+
 int
 vy_mem_insert_upsert(struct vy_mem *mem, const struct tuple *stmt)
 {
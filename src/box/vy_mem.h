@@ -131,6 +131,7 @@ vy_mem_tree_cmp_key(const struct tuple *a, struct tree_mem_key *key,
 #undef BPS_TREE_EXTENT_SIZE
 #undef BPS_TREE_COMPARE
 #undef BPS_TREE_COMPARE_KEY
+#undef BPS_TREE_IS_IDENTICAL
 #undef bps_tree_elem_t
 #undef bps_tree_key_t
 #undef bps_tree_arg_t
@@ -272,6 +273,13 @@ vy_mem_delete(struct vy_mem *index);
 const struct tuple *
 vy_mem_older_lsn(struct vy_mem *mem, const struct tuple *stmt);
 
+/**
+ * Check if the in-memory level stores at least one statement
+ * (committed or prepared) for the key of the given statement.
+ */
+bool
+vy_mem_has_key(struct vy_mem *mem, const struct tuple *stmt);
+
 /**
  * Insert a statement into the in-memory level.
  * @param mem        vy_mem.
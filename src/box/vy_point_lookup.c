@@ -47,6 +47,16 @@
 #include "vy_cache.h"
 #include "vy_upsert.h"
 
+enum {
+	/** Max value of vy_index::deep_lookup_score. */
+	VY_DEEP_LOOKUP_SCORE_MAX = 8,
+	/**
+	 * Min value of vy_index::deep_lookup_score at which
+	 * point lookups read candidate runs concurrently.
+	 */
+	VY_DEEP_LOOKUP_SCORE_PARALLEL = 4,
+};
+
 /**
  * ID of an iterator source type. Can be used in bitmaps.
  */
@@ -72,13 +82,12 @@ struct vy_stmt_history_node {
 };
 
 /**
- * Allocate (region) new history node.
+ * Allocate new history node on a region.
  * @return new node or NULL on memory error (diag is set).
  */
 static struct vy_stmt_history_node *
-vy_stmt_history_node_new(void)
+vy_stmt_history_node_new(struct region *region)
 {
-	struct region *region = &fiber()->gc;
 	struct vy_stmt_history_node *node = region_alloc(region, sizeof(*node));
 	if (node == NULL)
 		diag_set(OutOfMemory, sizeof(*node), "region",
@@ -136,7 +145,8 @@ vy_point_lookup_scan_txw(struct vy_index *index, struct vy_tx *tx,
 		return 0;
 	vy_stmt_counter_acct_tuple(&index->stat.txw.iterator.get,
 				   txv->stmt);
-	struct vy_stmt_history_node *node = vy_stmt_history_node_new();
+	struct vy_stmt_history_node *node =
+		vy_stmt_history_node_new(&fiber()->gc);
 	if (node == NULL)
 		return -1;
 	node->src_type = ITER_SRC_TXW;
@@ -161,7 +171,8 @@ vy_point_lookup_scan_cache(struct vy_index *index,
 		return 0;
 
 	vy_stmt_counter_acct_tuple(&index->cache.stat.get, stmt);
-	struct vy_stmt_history_node *node = vy_stmt_history_node_new();
+	struct vy_stmt_history_node *node =
+		vy_stmt_history_node_new(&fiber()->gc);
 	if (node == NULL)
 		return -1;
 
@@ -198,7 +209,8 @@ vy_point_lookup_scan_mem(struct vy_index *index, struct vy_mem *mem,
 		return 0;
 
 	while (true) {
-		struct vy_stmt_history_node *node = vy_stmt_history_node_new();
+		struct vy_stmt_history_node *node =
+			vy_stmt_history_node_new(&fiber()->gc);
 		if (node == NULL)
 			return -1;
 
@@ -249,13 +261,15 @@ vy_point_lookup_scan_mems(struct vy_index *index,
 /**
  * Scan one particular slice.
  * Add found statements to the history list up to terminal statement.
+ * History nodes are allocated on @region.
  * Set *terminal_found to true if the terminal statement (DELETE or REPLACE)
  * was found.
  */
 static int
 vy_point_lookup_scan_slice(struct vy_index *index, struct vy_slice *slice,
 			   const struct vy_read_view **rv, struct tuple *key,
-			   struct rlist *history, bool *terminal_found)
+			   struct region *region, struct rlist *history,
+			   bool *terminal_found)
 {
 	int rc = 0;
 	/*
@@ -271,7 +285,8 @@ vy_point_lookup_scan_slice(struct vy_index *index, struct vy_slice *slice,
 	struct tuple *stmt;
 	rc = vy_run_iterator_next_key(&run_itr, &stmt);
 	while (rc == 0 && stmt != NULL) {
-		struct vy_stmt_history_node *node = vy_stmt_history_node_new();
+		struct vy_stmt_history_node *node =
+			vy_stmt_history_node_new(region);
 		if (node == NULL) {
 			rc = -1;
 			break;
@@ -290,6 +305,121 @@ vy_point_lookup_scan_slice(struct vy_index *index, struct vy_slice *slice,
 	return rc;
 }
 
+/** Scan of a slice done by a separate fiber. */
+struct vy_point_lookup_slice_scan {
+	struct vy_index *index;
+	struct vy_slice *slice;
+	const struct vy_read_view **rv;
+	struct tuple *key;
+	/** Region to allocate history nodes on. */
+	struct region *region;
+	/** Statements found in the slice. */
+	struct rlist history;
+	/** Set if the history ends with a terminal statement. */
+	bool terminal_found;
+	/** Fiber doing the scan or NULL if none. */
+	struct fiber *fiber;
+};
+
+static int
+vy_point_lookup_scan_slice_f(va_list ap)
+{
+	struct vy_point_lookup_slice_scan *scan =
+		va_arg(ap, struct vy_point_lookup_slice_scan *);
+	return vy_point_lookup_scan_slice(scan->index, scan->slice, scan->rv,
+					  scan->key, scan->region,
+					  &scan->history,
+					  &scan->terminal_found);
+}
+
+/**
+ * Scan slices concurrently: the first slice is scanned by the
+ * caller while every other slice that may contain the key is
+ * scanned by a separate fiber, so that page reads for all of
+ * them are in flight at the same time. The results are then
+ * merged in the slice order, i.e. from newer to older runs,
+ * and cut at the first terminal statement.
+ */
+static int
+vy_point_lookup_scan_slices_parallel(struct vy_index *index,
+				     const struct vy_read_view **rv,
+				     struct tuple *key,
+				     struct vy_slice **slices,
+				     int slice_count, struct rlist *history,
+				     int *depth)
+{
+	struct region *region = &fiber()->gc;
+	size_t size = slice_count * sizeof(struct vy_point_lookup_slice_scan);
+	struct vy_point_lookup_slice_scan *scans =
+		(struct vy_point_lookup_slice_scan *)region_alloc(region, size);
+	if (scans == NULL) {
+		diag_set(OutOfMemory, size, "region", "slice scans");
+		return -1;
+	}
+	for (int i = 0; i < slice_count; i++) {
+		struct vy_point_lookup_slice_scan *scan = &scans[i];
+		scan->index = index;
+		scan->slice = slices[i];
+		scan->rv = rv;
+		scan->key = key;
+		scan->region = region;
+		rlist_create(&scan->history);
+		scan->terminal_found = false;
+		scan->fiber = NULL;
+		if (i == 0)
+			continue;
+		if (!vy_run_bloom_maybe_has(slices[i]->run, key,
+					    index->key_def))
+			continue;
+		/*
+		 * Failure to start a fiber is not critical,
+		 * the slice is scanned by the caller then.
+		 */
+		scan->fiber = fiber_new("vinyl.point_lookup",
+					vy_point_lookup_scan_slice_f);
+		if (scan->fiber == NULL) {
+			diag_clear(diag_get());
+			continue;
+		}
+		fiber_set_joinable(scan->fiber, true);
+		fiber_start(scan->fiber, scan);
+	}
+	int rc = 0;
+	for (int i = 0; i < slice_count; i++) {
+		struct vy_point_lookup_slice_scan *scan = &scans[i];
+		int scan_rc;
+		if (scan->fiber != NULL)
+			scan_rc = fiber_join(scan->fiber);
+		else
+			scan_rc = vy_point_lookup_scan_slice(index, scan->slice,
+					rv, key, region, &scan->history,
+					&scan->terminal_found);
+		if (scan_rc != 0)
+			rc = -1;
+	}
+	bool terminal_found = false;
+	for (int i = 0; i < slice_count; i++) {
+		struct vy_point_lookup_slice_scan *scan = &scans[i];
+		if (rc == 0 && !terminal_found && !rlist_empty(&scan->history))
+			++*depth;
+		while (!rlist_empty(&scan->history)) {
+			struct vy_stmt_history_node *node = rlist_shift_entry(
+				&scan->history, struct vy_stmt_history_node,
+				link);
+			if (rc != 0 || terminal_found) {
+				/* Older than the terminal statement. */
+				assert(node->src_type == ITER_SRC_RUN);
+				tuple_unref(node->stmt);
+				continue;
+			}
+			rlist_add_tail(history, &node->link);
+		}
+		if (scan->terminal_found)
+			terminal_found = true;
+	}
+	return rc;
+}
+
 /**
  * Find a range and scan all slices that belongs to the range.
  * Add found statements to the history list up to terminal statement.
@@ -319,14 +449,51 @@ vy_point_lookup_scan_slices(struct vy_index *index,
 		slices[i++] = slice;
 	}
 	assert(i == slice_count);
+	/*
+	 * If lookups in this index often have to read more than
+	 * one run and the key may be found in more than one run,
+	 * it is worth reading them concurrently rather than one
+	 * by one, but only if reads are done by reader threads.
+	 */
+	int candidate_count = 0;
+	if (slice_count > 1 &&
+	    index->deep_lookup_score >= VY_DEEP_LOOKUP_SCORE_PARALLEL &&
+	    slices[0]->run->env->reader_pool != NULL) {
+		for (i = 0; i < slice_count && candidate_count < 2; i++) {
+			if (vy_run_bloom_maybe_has(slices[i]->run, key,
+						   index->key_def))
+				candidate_count++;
+		}
+	}
 	int rc = 0;
-	bool terminal_found = false;
-	for (i = 0; i < slice_count; i++) {
-		if (rc == 0 && !terminal_found)
-			rc = vy_point_lookup_scan_slice(index, slices[i],
-					rv, key, history, &terminal_found);
-		vy_slice_unpin(slices[i]);
+	/* Number of runs the key history was collected from. */
+	int depth = 0;
+	if (candidate_count > 1) {
+		index->stat.disk.iterator.parallel_lookup++;
+		rc = vy_point_lookup_scan_slices_parallel(index, rv, key,
+				slices, slice_count, history, &depth);
+		for (i = 0; i < slice_count; i++)
+			vy_slice_unpin(slices[i]);
+	} else {
+		bool terminal_found = false;
+		for (i = 0; i < slice_count; i++) {
+			if (rc == 0 && !terminal_found) {
+				struct rlist *last = history->prev;
+				rc = vy_point_lookup_scan_slice(index,
+						slices[i], rv, key,
+						&fiber()->gc, history,
+						&terminal_found);
+				if (history->prev != last)
+					depth++;
+			}
+			vy_slice_unpin(slices[i]);
+		}
 	}
+	if (rc == 0 && depth > 1 &&
+	    index->deep_lookup_score < VY_DEEP_LOOKUP_SCORE_MAX)
+		index->deep_lookup_score++;
+	if (rc == 0 && depth == 1 && index->deep_lookup_score > 0)
+		index->deep_lookup_score--;
 	return rc;
 }
 
@@ -463,3 +630,44 @@ done:
 	}
 	return 0;
 }
+
+int
+vy_point_lookup_mem(struct vy_index *index, struct vy_tx *tx,
+		    const struct vy_read_view **rv,
+		    struct tuple *key, struct tuple **ret, bool *found)
+{
+	assert(tuple_field_count(key) >= index->cmp_def->part_count);
+
+	*ret = NULL;
+	*found = false;
+	size_t region_svp = region_used(&fiber()->gc);
+	int rc = 0;
+
+	struct rlist history;
+	rlist_create(&history);
+
+	rc = vy_point_lookup_scan_txw(index, tx, key, &history);
+	if (rc != 0 || vy_stmt_history_is_terminal(&history))
+		goto done;
+
+	rc = vy_point_lookup_scan_cache(index, rv, key, &history);
+	if (rc != 0 || vy_stmt_history_is_terminal(&history))
+		goto done;
+
+	rc = vy_point_lookup_scan_mems(index, rv, key, &history);
+	if (rc != 0 || vy_stmt_history_is_terminal(&history))
+		goto done;
+
+	/* The history is incomplete, disk lookup is required. */
+	goto out;
+done:
+	if (rc == 0) {
+		index->stat.lookup++;
+		rc = vy_point_lookup_apply_history(index, rv, key,
+						   &history, ret);
+		*found = (rc == 0);
+	}
+out:
+	vy_stmt_history_cleanup(&history, region_svp);
+	return rc;
+}
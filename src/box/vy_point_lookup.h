@@ -74,6 +74,19 @@ vy_point_lookup(struct vy_index *index, struct vy_tx *tx,
 		const struct vy_read_view **rv,
 		struct tuple *key, struct tuple **ret);
 
+/**
+ * Same as vy_point_lookup(), but only looks up the key in the
+ * transaction write set, cache and in-memory trees, never in
+ * runs. If the resulting tuple can be determined without reading
+ * the disk, @found is set and the tuple is returned in @ret
+ * (NULL if there is no such key). Otherwise @found is cleared.
+ * Never yields.
+ */
+int
+vy_point_lookup_mem(struct vy_index *index, struct vy_tx *tx,
+		    const struct vy_read_view **rv,
+		    struct tuple *key, struct tuple **ret, bool *found);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
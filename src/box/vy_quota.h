@@ -38,6 +38,7 @@
 #include "fiber.h"
 #include "fiber_cond.h"
 #include "say.h"
+#include "trivia/util.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -48,6 +49,13 @@ struct vy_quota;
 typedef void
 (*vy_quota_exceeded_f)(struct vy_quota *quota);
 
+/**
+ * Max amount of quota that can be consumed at once when the
+ * rate limit is in effect, in seconds of consumption at the
+ * current rate.
+ */
+static const double VY_QUOTA_RATE_BURST = 0.1;
+
 /**
  * Quota used for accounting and limiting memory consumption
  * in the vinyl engine. It is NOT multi-threading safe.
@@ -81,6 +89,25 @@ struct vy_quota {
 	 * It is supposed to trigger memory reclaim.
 	 */
 	vy_quota_exceeded_f quota_exceeded_cb;
+	/**
+	 * Estimated rate at which memory is dumped, in bytes
+	 * per second. Used for limiting the rate of quota
+	 * consumption once the watermark is exceeded, see
+	 * vy_quota_rate_limit(). 0 disables the rate limit.
+	 */
+	size_t dump_bandwidth;
+	/**
+	 * Amount of quota that can be consumed without a delay
+	 * while the rate limit is in effect. Replenished at the
+	 * rate limit, may go negative if a consumer runs ahead.
+	 */
+	double rate_avail;
+	/** Time when @rate_avail was last replenished. */
+	double rate_update_time;
+	/** Number of times a consumer was delayed by the rate limit. */
+	int64_t throttled;
+	/** Total time consumers were delayed by the rate limit. */
+	double throttle_time;
 };
 
 static inline void
@@ -91,6 +118,11 @@ vy_quota_create(struct vy_quota *q, vy_quota_exceeded_f quota_exceeded_cb)
 	q->used = 0;
 	q->too_long_threshold = TIMEOUT_INFINITY;
 	q->quota_exceeded_cb = quota_exceeded_cb;
+	q->dump_bandwidth = 0;
+	q->rate_avail = 0;
+	q->rate_update_time = 0;
+	q->throttled = 0;
+	q->throttle_time = 0;
 	fiber_cond_create(&q->cond);
 }
 
@@ -124,6 +156,61 @@ vy_quota_set_watermark(struct vy_quota *q, size_t watermark)
 		q->quota_exceeded_cb(q);
 }
 
+/**
+ * Set the estimated dump bandwidth used for calculating
+ * the rate limit, see vy_quota_rate_limit().
+ */
+static inline void
+vy_quota_set_dump_bandwidth(struct vy_quota *q, size_t dump_bandwidth)
+{
+	q->dump_bandwidth = dump_bandwidth;
+}
+
+/**
+ * Return the max rate at which quota may be consumed, in bytes
+ * per second, or SIZE_MAX if the rate is unlimited.
+ *
+ * Memory used by in-memory trees is freed only after they have
+ * all been dumped, so once the watermark is exceeded and a dump
+ * is triggered, all memory left must last until the dump is
+ * complete, which is estimated to take used / dump_bandwidth
+ * seconds. The rate is limited accordingly so that transactions
+ * are delayed smoothly instead of being stalled on hitting the
+ * limit when the watermark turns out to be set too late, e.g.
+ * due to a burst of writes.
+ */
+static inline size_t
+vy_quota_rate_limit(struct vy_quota *q)
+{
+	if (q->dump_bandwidth == 0 ||
+	    q->used < q->watermark || q->used >= q->limit)
+		return SIZE_MAX;
+	double rate = (double)(q->limit - q->used) *
+		      q->dump_bandwidth / q->used;
+	return MAX(rate, 1);
+}
+
+/**
+ * Replenish the amount of quota that can be consumed
+ * without a delay according to the current rate limit.
+ * Return the rate limit.
+ */
+static inline size_t
+vy_quota_update_rate(struct vy_quota *q)
+{
+	double now = ev_monotonic_now(loop());
+	size_t rate = vy_quota_rate_limit(q);
+	if (rate == SIZE_MAX) {
+		q->rate_avail = 0;
+	} else {
+		q->rate_avail += rate * (now - q->rate_update_time);
+		q->rate_avail = MIN(q->rate_avail,
+				    rate * VY_QUOTA_RATE_BURST);
+	}
+	q->rate_update_time = now;
+	return rate;
+}
+
 /**
  * Consume @size bytes of memory. In contrast to vy_quota_use()
  * this function does not throttle the caller.
@@ -157,6 +244,32 @@ vy_quota_use(struct vy_quota *q, size_t size, double timeout)
 {
 	double start_time = ev_monotonic_now(loop());
 	double deadline = start_time + timeout;
+	/*
+	 * Delay the caller if quota is consumed faster than
+	 * the rate limit. Don't fail on timeout though, only
+	 * the memory limit is strict.
+	 */
+	size_t rate = vy_quota_update_rate(q);
+	if (rate != SIZE_MAX && q->rate_avail < 0) {
+		q->throttled++;
+		do {
+			double wakeup = ev_monotonic_now(loop()) +
+					-q->rate_avail / rate;
+			if (fiber_cond_wait_deadline(&q->cond,
+					MIN(wakeup, deadline)) != 0) {
+				/*
+				 * Waking up on timeout is expected here,
+				 * don't leave the error in the diagnostics
+				 * area.
+				 */
+				diag_clear(diag_get());
+				if (ev_monotonic_now(loop()) >= deadline)
+					break; /* timed out */
+			}
+			rate = vy_quota_update_rate(q);
+		} while (rate != SIZE_MAX && q->rate_avail < 0);
+		q->throttle_time += ev_monotonic_now(loop()) - start_time;
+	}
 	while (q->used + size > q->limit && timeout > 0) {
 		q->quota_exceeded_cb(q);
 		if (fiber_cond_wait_deadline(&q->cond, deadline) != 0)
@@ -170,6 +283,7 @@ vy_quota_use(struct vy_quota *q, size_t size, double timeout)
 	if (q->used + size > q->limit)
 		return -1;
 	q->used += size;
+	q->rate_avail -= size;
 	if (q->used >= q->watermark)
 		q->quota_exceeded_cb(q);
 	return 0;
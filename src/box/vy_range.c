@@ -282,17 +282,15 @@ vy_range_remove_slice(struct vy_range *range, struct vy_slice *slice)
  * ratio.
  *
  * Given a range, this function computes the maximal level that needs
- * to be compacted and sets @compact_priority to the number of runs in
- * this level and all preceding levels.
+ * to be compacted and returns the number of runs in this level and
+ * all preceding levels. Only @max_run_count newest runs are checked.
  */
-void
-vy_range_update_compact_priority(struct vy_range *range,
-				 const struct index_opts *opts)
+static int
+vy_range_compact_priority_tiered(struct vy_range *range,
+				 const struct index_opts *opts,
+				 int max_run_count)
 {
-	assert(opts->run_count_per_level > 0);
-	assert(opts->run_size_ratio > 1);
-
-	range->compact_priority = 0;
+	int compact_priority = 0;
 
 	/* Total number of checked runs. */
 	uint32_t total_run_count = 0;
@@ -312,6 +310,8 @@ vy_range_update_compact_priority(struct vy_range *range,
 
 	struct vy_slice *slice;
 	rlist_foreach_entry(slice, &range->slices, in_range) {
+		if ((int)total_run_count >= max_run_count)
+			break;
 		uint64_t size = slice->count.bytes_compressed;
 		/*
 		 * The size of the first level is defined by
@@ -358,10 +358,111 @@ vy_range_update_compact_priority(struct vy_range *range,
 			 * for compaction. We compact all runs at
 			 * this level and upper levels.
 			 */
-			range->compact_priority = total_run_count;
+			compact_priority = total_run_count;
 			est_new_run_size = total_size;
 		}
 	}
+	return compact_priority;
+}
+
+/**
+ * Leveled compaction bounds read amplification at the cost of
+ * higher write amplification. Up to run_count_per_level newest
+ * runs (level 0) are allowed to have any size. Every older run
+ * forms a level of its own and must be at least run_size_ratio
+ * times larger than all newer runs taken together. If it is not,
+ * the newer runs are merged into it. This way a range never has
+ * more than run_count_per_level + log(range size / dump size) /
+ * log(run_size_ratio) runs.
+ *
+ * Return the number of newest runs that need to be compacted.
+ */
+static int
+vy_range_compact_priority_leveled(struct vy_range *range,
+				  const struct index_opts *opts)
+{
+	int compact_priority = 0;
+	/* Total number of checked runs. */
+	int64_t run_count = 0;
+	/* The total size of runs checked so far. */
+	uint64_t total_size = 0;
+
+	struct vy_slice *slice;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		uint64_t size = slice->count.bytes_compressed;
+		if (run_count >= opts->run_count_per_level &&
+		    size < total_size * opts->run_size_ratio) {
+			/*
+			 * The run is too small to be a level
+			 * below the newer runs. Merge them all.
+			 */
+			compact_priority = run_count + 1;
+		}
+		total_size += size;
+		run_count++;
+	}
+	return compact_priority;
+}
+
+/**
+ * Time window compaction is designed for append-mostly data
+ * that expires with time. Runs are grouped by dump time into
+ * windows of compaction_window seconds. Runs of the newest window
+ * are compacted using the tiered policy, while runs of older
+ * windows are never merged again, so that compaction does not
+ * rewrite old data over and over. Runs with unknown dump time,
+ * e.g. created by an older version, belong to the oldest window.
+ *
+ * Return the number of newest runs that need to be compacted.
+ */
+static int
+vy_range_compact_priority_time_window(struct vy_range *range,
+				      const struct index_opts *opts)
+{
+	assert(opts->compaction_window > 0);
+
+	int run_count = 0;
+	uint64_t window = 0;
+	struct vy_slice *slice;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		uint64_t w = slice->run->info.dump_time /
+			     opts->compaction_window;
+		if (run_count == 0)
+			window = w;
+		else if (w != window)
+			break;
+		run_count++;
+	}
+	return vy_range_compact_priority_tiered(range, opts, run_count);
+}
+
+/**
+ * Compute the number of newest runs of a range that need to be
+ * compacted according to the index compaction policy and store
+ * it in @compact_priority.
+ */
+void
+vy_range_update_compact_priority(struct vy_range *range,
+				 const struct index_opts *opts)
+{
+	assert(opts->run_count_per_level > 0);
+	assert(opts->run_size_ratio > 1);
+
+	switch (opts->compaction_policy) {
+	case VY_COMPACTION_POLICY_LEVELED:
+		range->compact_priority =
+			vy_range_compact_priority_leveled(range, opts);
+		break;
+	case VY_COMPACTION_POLICY_TIME_WINDOW:
+		range->compact_priority =
+			vy_range_compact_priority_time_window(range, opts);
+		break;
+	default:
+		range->compact_priority =
+			vy_range_compact_priority_tiered(range, opts,
+							 range->slice_count);
+		break;
+	}
 }
 
 /**
@@ -438,6 +539,68 @@ vy_range_needs_split(struct vy_range *range, const struct index_opts *opts,
 	return true;
 }
 
+int
+vy_range_compact_split(struct vy_range *range, const struct index_opts *opts,
+		       int max_parts, const char **split_keys)
+{
+	/* Find the biggest slice to compact and the total size. */
+	struct vy_slice *slice, *max_slice = NULL;
+	uint64_t total_size = 0;
+	int n = range->compact_priority;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		total_size += slice->count.bytes_compressed;
+		if (max_slice == NULL || slice->count.bytes_compressed >
+					 max_slice->count.bytes_compressed)
+			max_slice = slice;
+		if (--n == 0)
+			break;
+	}
+	assert(max_slice != NULL);
+
+	if (max_slice->run->info.page_count == 0)
+		return 1;
+
+	/*
+	 * Don't make parts smaller than the range size and
+	 * don't split a page between parts.
+	 */
+	uint32_t page_count = max_slice->last_page_no -
+			      max_slice->first_page_no + 1;
+	uint64_t part_count = total_size / opts->range_size;
+	part_count = MIN(part_count, (uint64_t)max_parts);
+	part_count = MIN(part_count, (uint64_t)page_count);
+	if (part_count < 2)
+		return 1;
+
+	/*
+	 * Take min keys of evenly spaced pages for split keys.
+	 * Skip a key if it isn't greater than the previous one
+	 * or the beginning of the slice, see the comment in
+	 * vy_range_needs_split().
+	 */
+	struct vy_page_info *page;
+	page = vy_run_page_info(max_slice->run, max_slice->first_page_no);
+	const char *prev_key = page->min_key;
+	int key_count = 0;
+	for (uint64_t i = 1; i < part_count; i++) {
+		page = vy_run_page_info(max_slice->run,
+				max_slice->first_page_no +
+				page_count * i / part_count);
+		if (key_compare(page->min_key, prev_key,
+				range->cmp_def) <= 0)
+			continue;
+		if (max_slice->begin != NULL && key_compare(page->min_key,
+				tuple_data(max_slice->begin),
+				range->cmp_def) <= 0)
+			continue;
+		assert(max_slice->end == NULL || key_compare(page->min_key,
+				tuple_data(max_slice->end), range->cmp_def) < 0);
+		split_keys[key_count++] = page->min_key;
+		prev_key = page->min_key;
+	}
+	return key_count + 1;
+}
+
 /**
  * Check if a range should be coalesced with one or more its neighbors.
  * If it should, return true and set @p_first and @p_last to the first
@@ -245,6 +245,26 @@ bool
 vy_range_needs_split(struct vy_range *range, const struct index_opts *opts,
 		     const char **p_split_key);
 
+/**
+ * Split compaction of a range into key-disjoint parts so that
+ * they can be written by different worker threads concurrently.
+ * The split keys are taken from the page index of the biggest
+ * slice to compact so that the parts are of roughly equal size.
+ * A part is never made less than the range size.
+ *
+ * @param range            The range.
+ * @param opts             Index options.
+ * @param max_parts        Max number of parts.
+ * @param[out] split_keys  Keys to split compaction by, the array
+ *                         must have room for @max_parts - 1 keys.
+ *
+ * @return                 Number of parts, 1 if compaction of
+ *                         the range shouldn't be split.
+ */
+int
+vy_range_compact_split(struct vy_range *range, const struct index_opts *opts,
+		       int max_parts, const char **split_keys);
+
 /**
  * Check if a range needs to be coalesced with adjacent
  * ranges in a range tree.
@@ -30,7 +30,11 @@
  */
 #include "vy_run.h"
 
+#include <fcntl.h>
 #include <zstd.h>
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif /* HAVE_LIBURING */
 
 #include "fiber.h"
 #include "fiber_cond.h"
@@ -57,7 +61,13 @@ static const uint64_t vy_run_info_key_map = (1 << VY_RUN_INFO_MIN_KEY) |
 					    (1 << VY_RUN_INFO_MAX_LSN) |
 					    (1 << VY_RUN_INFO_PAGE_COUNT);
 
-enum { VY_BLOOM_VERSION = 0 };
+/**
+ * Version of bloom filters stored in .index files. It equals
+ * the layout of the filter table (enum bloom_type): 0 stands
+ * for classic filters written by older versions, 1 for split
+ * block filters, which are written now.
+ */
+enum { VY_BLOOM_VERSION = BLOOM_SPLIT_BLOCK };
 
 /** xlog meta type for .run files */
 #define XLOG_META_TYPE_RUN "RUN"
@@ -93,6 +103,12 @@ struct vy_page_read_task {
 	struct vy_run *run;
 	/** [out] resulting vinyl page */
 	struct vy_page *page;
+	/**
+	 * Offset and size of the page to prefetch after
+	 * reading the requested one, size is 0 if none.
+	 */
+	uint64_t prefetch_offset;
+	uint32_t prefetch_size;
 };
 
 /** Destructor for env->zdctx_key thread-local variable */
@@ -103,6 +119,213 @@ vy_free_zdctx(void *arg)
 	ZSTD_freeDStream(arg);
 }
 
+#ifdef HAVE_LIBURING
+
+/**
+ * io_uring based page reader of a run reader thread. Pages are
+ * read with IORING_OP_READ. The page a run iterator is going
+ * to ask for next (see vy_page_read_task::prefetch_offset) is
+ * read in the background into a read-ahead buffer, so that
+ * the next request of a sequential scan finds it already read.
+ */
+struct vy_run_uring {
+	/** The ring. */
+	struct io_uring ring;
+	/** Read-ahead buffer. */
+	char *ahead_buf;
+	/** Size of the read-ahead buffer. */
+	uint32_t ahead_capacity;
+	/**
+	 * Id of the run, offset and size of the page stored in
+	 * or being read into the read-ahead buffer. The run id
+	 * is -1 if the buffer is empty. Ids are used rather
+	 * than file descriptors, which are reused.
+	 */
+	int64_t ahead_run_id;
+	uint64_t ahead_offset;
+	uint32_t ahead_size;
+	/** Set while the read-ahead request is in flight. */
+	bool ahead_in_flight;
+	/** Result of the read-ahead request: size read or -errno. */
+	int ahead_res;
+};
+
+/** Values of io_uring_sqe::user_data. */
+enum {
+	VY_URING_PAGE = 1,
+	VY_URING_AHEAD = 2,
+};
+
+/** Number of entries in a reader thread ring. */
+enum { VY_URING_ENTRIES = 4 };
+
+/**
+ * The page reader of the current thread or NULL if pages are
+ * read with pread(), e.g. by tx or if the kernel doesn't
+ * support io_uring.
+ */
+static __thread struct vy_run_uring *vy_run_uring = NULL;
+
+/**
+ * Create the page reader of the current thread. Failures are
+ * not fatal: pages are read with pread() then.
+ */
+static void
+vy_run_uring_create(void)
+{
+	assert(vy_run_uring == NULL);
+	struct vy_run_uring *uring = calloc(1, sizeof(*uring));
+	if (uring == NULL)
+		return;
+	int rc = io_uring_queue_init(VY_URING_ENTRIES, &uring->ring, 0);
+	if (rc < 0) {
+		say_warn("%s: io_uring is not available: %s, "
+			 "falling back on pread", cord_name(cord()),
+			 strerror(-rc));
+		free(uring);
+		return;
+	}
+	struct io_uring_probe *probe = io_uring_get_probe_ring(&uring->ring);
+	bool supported = probe != NULL &&
+			 io_uring_opcode_supported(probe, IORING_OP_READ);
+	free(probe);
+	if (!supported) {
+		say_warn("%s: io_uring doesn't support reads, "
+			 "falling back on pread", cord_name(cord()));
+		io_uring_queue_exit(&uring->ring);
+		free(uring);
+		return;
+	}
+	uring->ahead_run_id = -1;
+	vy_run_uring = uring;
+}
+
+/**
+ * Wait for the completion of a request and return its result.
+ * The result of the read-ahead request is stored if it
+ * completes in the meantime.
+ */
+static int
+vy_run_uring_wait(struct vy_run_uring *uring, uint64_t user_data)
+{
+	while (true) {
+		struct io_uring_cqe *cqe;
+		int rc = io_uring_wait_cqe(&uring->ring, &cqe);
+		if (rc == -EINTR)
+			continue;
+		if (rc < 0)
+			return rc;
+		uint64_t data = cqe->user_data;
+		int res = cqe->res;
+		io_uring_cqe_seen(&uring->ring, cqe);
+		if (data == VY_URING_AHEAD) {
+			uring->ahead_in_flight = false;
+			uring->ahead_res = res;
+		}
+		if (data == user_data)
+			return res;
+	}
+}
+
+/** Destroy the page reader of the current thread. */
+static void
+vy_run_uring_destroy(void)
+{
+	struct vy_run_uring *uring = vy_run_uring;
+	if (uring == NULL)
+		return;
+	if (uring->ahead_in_flight)
+		(void) vy_run_uring_wait(uring, VY_URING_AHEAD);
+	io_uring_queue_exit(&uring->ring);
+	free(uring->ahead_buf);
+	free(uring);
+	vy_run_uring = NULL;
+}
+
+/**
+ * Read a page with io_uring. Returns the number of bytes read
+ * or -1 with errno set.
+ */
+static ssize_t
+vy_run_uring_read(struct vy_run_uring *uring, struct vy_run *run,
+		  char *buf, uint32_t size, uint64_t offset)
+{
+	if (uring->ahead_run_id == run->id &&
+	    uring->ahead_offset == offset && uring->ahead_size == size) {
+		/* The page has been read ahead. */
+		int ahead_res = uring->ahead_res;
+		if (uring->ahead_in_flight)
+			ahead_res = vy_run_uring_wait(uring, VY_URING_AHEAD);
+		uring->ahead_run_id = -1;
+		if (ahead_res == (int)size) {
+			memcpy(buf, uring->ahead_buf, size);
+			return size;
+		}
+		/* Read the page again to get the error, if any. */
+	}
+	struct io_uring_sqe *sqe = io_uring_get_sqe(&uring->ring);
+	if (sqe == NULL) {
+		errno = EAGAIN;
+		return -1;
+	}
+	io_uring_prep_read(sqe, run->fd, buf, size, offset);
+	sqe->user_data = VY_URING_PAGE;
+	int res = io_uring_submit(&uring->ring);
+	if (res >= 0)
+		res = vy_run_uring_wait(uring, VY_URING_PAGE);
+	if (res < 0) {
+		errno = -res;
+		return -1;
+	}
+	/* Complete a short read, if any, as pread() would. */
+	if ((uint32_t)res < size && res > 0) {
+		ssize_t rc = fio_pread(run->fd, buf + res, size - res,
+				       offset + res);
+		if (rc < 0)
+			return -1;
+		res += rc;
+	}
+	return res;
+}
+
+/**
+ * Start reading a page into the read-ahead buffer. Returns
+ * false if the read can't be started, e.g. because the
+ * previous one is still in flight.
+ */
+static bool
+vy_run_uring_read_ahead(struct vy_run_uring *uring, struct vy_run *run,
+			uint64_t offset, uint32_t size)
+{
+	if (uring->ahead_in_flight)
+		return false;
+	if (uring->ahead_run_id == run->id &&
+	    uring->ahead_offset == offset && uring->ahead_size == size)
+		return true;
+	if (size > uring->ahead_capacity) {
+		char *buf = realloc(uring->ahead_buf, size);
+		if (buf == NULL)
+			return false;
+		uring->ahead_buf = buf;
+		uring->ahead_capacity = size;
+	}
+	uring->ahead_run_id = -1;
+	struct io_uring_sqe *sqe = io_uring_get_sqe(&uring->ring);
+	if (sqe == NULL)
+		return false;
+	io_uring_prep_read(sqe, run->fd, uring->ahead_buf, size, offset);
+	sqe->user_data = VY_URING_AHEAD;
+	if (io_uring_submit(&uring->ring) < 0)
+		return false;
+	uring->ahead_run_id = run->id;
+	uring->ahead_offset = offset;
+	uring->ahead_size = size;
+	uring->ahead_in_flight = true;
+	return true;
+}
+
+#endif /* HAVE_LIBURING */
+
 /** Run reader thread function. */
 static int
 vy_run_reader_f(va_list ap)
@@ -110,12 +333,18 @@ vy_run_reader_f(va_list ap)
 	struct vy_run_reader *reader = va_arg(ap, struct vy_run_reader *);
 	struct cbus_endpoint endpoint;
 
+#ifdef HAVE_LIBURING
+	vy_run_uring_create();
+#endif
 	cpipe_create(&reader->tx_pipe, "tx_prio");
 	cbus_endpoint_create(&endpoint, cord_name(cord()),
 			     fiber_schedule_cb, fiber());
 	cbus_loop(&endpoint);
 	cbus_endpoint_destroy(&endpoint, cbus_process);
 	cpipe_destroy(&reader->tx_pipe);
+#ifdef HAVE_LIBURING
+	vy_run_uring_destroy();
+#endif
 	return 0;
 }
 
@@ -167,11 +396,15 @@ void
 vy_run_env_create(struct vy_run_env *env)
 {
 	memset(env, 0, sizeof(*env));
+	rlist_create(&env->page_cache.lru);
 	tt_pthread_key_create(&env->zdctx_key, vy_free_zdctx);
 	mempool_create(&env->read_task_pool, cord_slab_cache(),
 		       sizeof(struct vy_page_read_task));
 }
 
+static void
+vy_page_cache_destroy(struct vy_page_cache *cache);
+
 /**
  * Destroy vinyl run environment
  */
@@ -180,6 +413,7 @@ vy_run_env_destroy(struct vy_run_env *env)
 {
 	if (env->reader_pool != NULL)
 		vy_run_env_stop_readers(env);
+	vy_page_cache_destroy(&env->page_cache);
 	mempool_destroy(&env->read_task_pool);
 	tt_pthread_key_delete(env->zdctx_key);
 }
@@ -239,12 +473,21 @@ vy_run_new(struct vy_run_env *env, int64_t id)
 	rlist_create(&run->in_index);
 	rlist_create(&run->in_unused);
 	TRASH(&run->info.bloom);
+	TRASH(&run->info.prefix_bloom);
 	return run;
 }
 
+static void
+vy_page_cache_evict_run(struct vy_page_cache *cache, struct vy_run *run);
+
 static void
 vy_run_clear(struct vy_run *run)
 {
+	if (run->cached_pages != NULL) {
+		vy_page_cache_evict_run(&run->env->page_cache, run);
+		free(run->cached_pages);
+		run->cached_pages = NULL;
+	}
 	if (run->page_info != NULL) {
 		uint32_t page_no;
 		for (page_no = 0; page_no < run->info.page_count; ++page_no)
@@ -257,6 +500,9 @@ vy_run_clear(struct vy_run *run)
 	if (run->info.has_bloom)
 		bloom_destroy(&run->info.bloom, runtime.quota);
 	run->info.has_bloom = false;
+	if (run->info.has_prefix_bloom)
+		bloom_destroy(&run->info.prefix_bloom, runtime.quota);
+	run->info.has_prefix_bloom = false;
 	free(run->info.min_key);
 	run->info.min_key = NULL;
 	free(run->info.max_key);
@@ -556,12 +802,14 @@ vy_run_bloom_decode(struct bloom *bloom, const char **buffer,
 		return -1;
 	}
 	uint64_t version = mp_decode_uint(pos);
-	if (version != VY_BLOOM_VERSION) {
+	if (version > VY_BLOOM_VERSION) {
 		diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
 			 tt_sprintf("Can't decode bloom meta: "
-				    "wrong version (expected %d, got %u)",
+				    "wrong version (expected <= %d, got %u)",
 				    VY_BLOOM_VERSION, (unsigned)version));
+		return -1;
 	}
+	bloom->type = version;
 	bloom->table_size = mp_decode_uint(pos);
 	bloom->hash_count = mp_decode_uint(pos);
 	size_t table_size = mp_decode_binl(pos);
@@ -631,6 +879,9 @@ vy_run_info_decode(struct vy_run_info *run_info,
 		case VY_RUN_INFO_PAGE_COUNT:
 			run_info->page_count = mp_decode_uint(&pos);
 			break;
+		case VY_RUN_INFO_DUMP_TIME:
+			run_info->dump_time = mp_decode_uint(&pos);
+			break;
 		case VY_RUN_INFO_BLOOM:
 			if (vy_run_bloom_decode(&run_info->bloom, &pos,
 						filename) == 0)
@@ -638,6 +889,16 @@ vy_run_info_decode(struct vy_run_info *run_info,
 			else
 				return -1;
 			break;
+		case VY_RUN_INFO_PREFIX_PART_COUNT:
+			run_info->prefix_part_count = mp_decode_uint(&pos);
+			break;
+		case VY_RUN_INFO_PREFIX_BLOOM:
+			if (vy_run_bloom_decode(&run_info->prefix_bloom, &pos,
+						filename) == 0)
+				run_info->has_prefix_bloom = true;
+			else
+				return -1;
+			break;
 		default:
 			diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
 				"Can't decode run info: unknown key %u",
@@ -665,6 +926,9 @@ vy_page_new(const struct vy_page_info *page_info)
 			 "load_page", "page cache");
 		return NULL;
 	}
+	page->refs = 1;
+	page->run = NULL;
+	rlist_create(&page->in_lru);
 	page->unpacked_size = page_info->unpacked_size;
 	page->row_count = page_info->row_count;
 	page->row_index = calloc(page_info->row_count, sizeof(uint32_t));
@@ -701,6 +965,179 @@ vy_page_delete(struct vy_page *page)
 	free(page);
 }
 
+static inline void
+vy_page_ref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	page->refs++;
+}
+
+static inline void
+vy_page_unref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	if (--page->refs == 0)
+		vy_page_delete(page);
+}
+
+/* {{{ vy_page_cache */
+
+/** Size of memory occupied by a page. */
+static inline size_t
+vy_page_mem_used(struct vy_page *page)
+{
+	return sizeof(*page) + page->unpacked_size +
+	       page->row_count * sizeof(uint32_t);
+}
+
+/** Remove a page from the cache and drop the cache reference. */
+static void
+vy_page_cache_remove(struct vy_page_cache *cache, struct vy_page *page)
+{
+	struct vy_run *run = page->run;
+	assert(run != NULL);
+	assert(run->cached_pages[page->page_no] == page);
+	run->cached_pages[page->page_no] = NULL;
+	page->run = NULL;
+	rlist_del_entry(page, in_lru);
+	assert(cache->mem_used >= vy_page_mem_used(page));
+	cache->mem_used -= vy_page_mem_used(page);
+	vy_page_unref(page);
+}
+
+/**
+ * Max size of memory pages cached by the tx thread may occupy
+ * in excess of the quota while a batch of lookups is in progress.
+ */
+enum { VY_PAGE_CACHE_BATCH_MAX = 16 * 1024 * 1024 };
+
+/**
+ * Max size of memory cached pages may occupy at the moment:
+ * the quota, raised while a batch of lookups is in progress.
+ */
+static inline size_t
+vy_page_cache_limit(struct vy_page_cache *cache)
+{
+	size_t limit = cache->mem_quota;
+	if (cache->batch_count > 0)
+		limit += VY_PAGE_CACHE_BATCH_MAX;
+	return limit;
+}
+
+/** Evict least recently used pages until the limit is met. */
+static void
+vy_page_cache_gc(struct vy_page_cache *cache)
+{
+	size_t limit = vy_page_cache_limit(cache);
+	while (cache->mem_used > limit) {
+		assert(!rlist_empty(&cache->lru));
+		struct vy_page *page = rlist_first_entry(&cache->lru,
+						struct vy_page, in_lru);
+		vy_page_cache_remove(cache, page);
+	}
+}
+
+/** Remove all pages of a run from the cache. */
+static void
+vy_page_cache_evict_run(struct vy_page_cache *cache, struct vy_run *run)
+{
+	for (uint32_t i = 0; i < run->info.page_count; i++) {
+		struct vy_page *page = run->cached_pages[i];
+		if (page != NULL)
+			vy_page_cache_remove(cache, page);
+	}
+}
+
+/**
+ * Remove all pages from the cache. Runs are not deleted on
+ * shutdown, so the cache may still hold their pages.
+ */
+static void
+vy_page_cache_destroy(struct vy_page_cache *cache)
+{
+	while (!rlist_empty(&cache->lru)) {
+		struct vy_page *page = rlist_first_entry(&cache->lru,
+						struct vy_page, in_lru);
+		vy_page_cache_remove(cache, page);
+	}
+	assert(cache->mem_used == 0);
+}
+
+/**
+ * Look up a page in the cache. Return the page with a new
+ * reference or NULL if the page is not cached.
+ */
+static struct vy_page *
+vy_page_cache_get(struct vy_page_cache *cache, struct vy_run *run,
+		  uint32_t page_no)
+{
+	if (run->cached_pages == NULL)
+		return NULL;
+	struct vy_page *page = run->cached_pages[page_no];
+	if (page == NULL)
+		return NULL;
+	/* Move the page to the tail of the LRU list. */
+	rlist_move_tail_entry(&cache->lru, page, in_lru);
+	vy_page_ref(page);
+	return page;
+}
+
+/**
+ * Add a page that has just been read from the disk to the
+ * cache. A failure to allocate the page index of the run
+ * is not critical, the page is simply not cached then.
+ */
+static void
+vy_page_cache_put(struct vy_page_cache *cache, struct vy_run *run,
+		  struct vy_page *page)
+{
+	assert(page->run == NULL);
+	if (vy_page_mem_used(page) > vy_page_cache_limit(cache))
+		return;
+	if (run->cached_pages == NULL) {
+		run->cached_pages = calloc(run->info.page_count,
+					   sizeof(*run->cached_pages));
+		if (run->cached_pages == NULL)
+			return;
+	}
+	if (run->cached_pages[page->page_no] != NULL) {
+		/*
+		 * Another fiber has read the same page while
+		 * this one was waiting for the reader thread.
+		 */
+		return;
+	}
+	run->cached_pages[page->page_no] = page;
+	page->run = run;
+	rlist_add_tail_entry(&cache->lru, page, in_lru);
+	cache->mem_used += vy_page_mem_used(page);
+	vy_page_ref(page);
+	vy_page_cache_gc(cache);
+}
+
+void
+vy_run_env_set_page_cache(struct vy_run_env *env, size_t quota)
+{
+	env->page_cache.mem_quota = quota;
+	vy_page_cache_gc(&env->page_cache);
+}
+
+void
+vy_run_env_begin_batch(struct vy_run_env *env)
+{
+	env->page_cache.batch_count++;
+}
+
+void
+vy_run_env_end_batch(struct vy_run_env *env)
+{
+	assert(env->page_cache.batch_count > 0);
+	env->page_cache.batch_count--;
+	vy_page_cache_gc(&env->page_cache);
+}
+
+/* }}} vy_page_cache */
+
 static int
 vy_page_xrow(struct vy_page *page, uint32_t stmt_no,
 	     struct xrow_header *xrow)
@@ -750,9 +1187,9 @@ vy_run_iterator_stop(struct vy_run_iterator *itr)
 		itr->curr_stmt = NULL;
 	}
 	if (itr->curr_page != NULL) {
-		vy_page_delete(itr->curr_page);
+		vy_page_unref(itr->curr_page);
 		if (itr->prev_page != NULL)
-			vy_page_delete(itr->prev_page);
+			vy_page_unref(itr->prev_page);
 		itr->curr_page = itr->prev_page = NULL;
 	}
 	itr->search_ended = true;
@@ -816,7 +1253,14 @@ vy_page_read(struct vy_page *page, const struct vy_page_info *page_info,
 		diag_set(OutOfMemory, page_info->size, "region gc", "page");
 		return -1;
 	}
-	ssize_t readen = fio_pread(run->fd, data, page_info->size,
+	ssize_t readen;
+#ifdef HAVE_LIBURING
+	if (vy_run_uring != NULL)
+		readen = vy_run_uring_read(vy_run_uring, run, data,
+					   page_info->size, page_info->offset);
+	else
+#endif
+		readen = fio_pread(run->fd, data, page_info->size,
 				   page_info->offset);
 	ERROR_INJECT(ERRINJ_VYRUN_DATA_READ, {
 		readen = -1;
@@ -868,6 +1312,32 @@ error:
 	return -1;
 }
 
+/**
+ * Start reading a page that is going to be requested soon in
+ * the background: with io_uring, if available, or by letting
+ * the kernel know it should read the page into the page cache.
+ * Used by run iterators moving sequentially, which would
+ * otherwise keep only one page read request in flight per
+ * reader thread.
+ */
+static void
+vy_page_prefetch(struct vy_run *run, uint64_t offset, uint32_t size)
+{
+#ifdef HAVE_LIBURING
+	if (vy_run_uring != NULL &&
+	    vy_run_uring_read_ahead(vy_run_uring, run, offset, size))
+		return;
+#endif /* HAVE_LIBURING */
+#ifdef HAVE_POSIX_FADVISE
+	/* It's just a hint, ignore errors. */
+	(void) posix_fadvise(run->fd, offset, size, POSIX_FADV_WILLNEED);
+#else
+	(void) run;
+	(void) offset;
+	(void) size;
+#endif /* HAVE_POSIX_FADVISE */
+}
+
 /**
  * Get thread local zstd decompression context
  */
@@ -897,7 +1367,12 @@ vy_page_read_cb(struct cbus_call_msg *base)
 	ZSTD_DStream *zdctx = vy_env_get_zdctx(task->run->env);
 	if (zdctx == NULL)
 		return -1;
-	return vy_page_read(task->page, &task->page_info, task->run, zdctx);
+	if (vy_page_read(task->page, &task->page_info, task->run, zdctx) != 0)
+		return -1;
+	if (task->prefetch_size > 0)
+		vy_page_prefetch(task->run, task->prefetch_offset,
+				 task->prefetch_size);
+	return 0;
 }
 
 /**
@@ -940,9 +1415,26 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		}
 	}
 
+	/*
+	 * Check the page cache. It is only used by the tx thread,
+	 * compaction running in worker threads bypasses it.
+	 */
+	struct vy_page_cache *page_cache = NULL;
+	if (vy_page_cache_limit(&env->page_cache) > 0 && cord_is_main())
+		page_cache = &env->page_cache;
+	struct vy_page *page = NULL;
+	if (page_cache != NULL) {
+		page = vy_page_cache_get(page_cache, slice->run, page_no);
+		if (page != NULL) {
+			itr->stat->page_cache_hit++;
+			goto out;
+		}
+		itr->stat->page_cache_miss++;
+	}
+
 	/* Allocate buffers */
 	struct vy_page_info *page_info = vy_run_page_info(slice->run, page_no);
-	struct vy_page *page = vy_page_new(page_info);
+	page = vy_page_new(page_info);
 	if (page == NULL)
 		return -1;
 
@@ -967,14 +1459,43 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		task->run = slice->run;
 		task->page_info = *page_info;
 		task->page = page;
+		task->prefetch_offset = 0;
+		task->prefetch_size = 0;
+
+		/*
+		 * If the iterator is moving page by page, prefetch
+		 * the page following the requested one in the same
+		 * direction, unless it is out of the slice.
+		 */
+		struct vy_page_info *prefetch_info = NULL;
+		if (itr->curr_page != NULL) {
+			uint32_t curr_page_no = itr->curr_page->page_no;
+			if (page_no == curr_page_no + 1 &&
+			    page_no < slice->last_page_no)
+				prefetch_info = vy_run_page_info(slice->run,
+								 page_no + 1);
+			else if (page_no + 1 == curr_page_no &&
+				 page_no > slice->first_page_no)
+				prefetch_info = vy_run_page_info(slice->run,
+								 page_no - 1);
+		}
+		if (prefetch_info != NULL) {
+			task->prefetch_offset = prefetch_info->offset;
+			task->prefetch_size = prefetch_info->size;
+			itr->stat->prefetch++;
+		}
 
 		/* Post task to the reader thread. */
+		double start_time = ev_monotonic_now(loop());
 		rc = cbus_call(&reader->reader_pipe, &reader->tx_pipe,
 			       &task->base, vy_page_read_cb,
 			       vy_page_read_cb_free, TIMEOUT_INFINITY);
 		if (!task->base.complete)
 			return -1; /* timed out or cancelled */
 
+		double latency = ev_monotonic_now(loop()) - start_time;
+		env->read_latency_max = MAX(env->read_latency_max, latency);
+
 		mempool_free(&env->read_task_pool, task);
 
 		if (rc != 0) {
@@ -998,18 +1519,21 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		}
 	}
 
-	/* Update cache */
-	if (itr->prev_page != NULL)
-		vy_page_delete(itr->prev_page);
-	itr->prev_page = itr->curr_page;
-	itr->curr_page = page;
 	page->page_no = page_no;
+	if (page_cache != NULL)
+		vy_page_cache_put(page_cache, slice->run, page);
 
 	/* Update read statistics. */
 	itr->stat->read.rows += page_info->row_count;
 	itr->stat->read.bytes += page_info->unpacked_size;
 	itr->stat->read.bytes_compressed += page_info->size;
 	itr->stat->read.pages++;
+out:
+	/* Update cache */
+	if (itr->prev_page != NULL)
+		vy_page_unref(itr->prev_page);
+	itr->prev_page = itr->curr_page;
+	itr->curr_page = page;
 
 	*result = page;
 	return 0;
@@ -1244,6 +1768,41 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr,
 	return 0;
 }
 
+bool
+vy_run_has_bloom_for_key(struct vy_run *run, const struct tuple *key,
+			 const struct key_def *key_def)
+{
+	uint32_t part_count = tuple_field_count(key);
+	if (part_count >= key_def->part_count)
+		return run->info.has_bloom;
+	return run->info.has_prefix_bloom &&
+	       run->info.prefix_part_count > 0 &&
+	       run->info.prefix_part_count <= part_count;
+}
+
+bool
+vy_run_bloom_maybe_has(struct vy_run *run, const struct tuple *key,
+		       const struct key_def *key_def)
+{
+	if (!vy_run_has_bloom_for_key(run, key, key_def))
+		return true;
+	bool is_full_key = tuple_field_count(key) >= key_def->part_count;
+	uint32_t prefix_part_count = run->info.prefix_part_count;
+	uint32_t hash;
+	if (vy_stmt_type(key) == IPROTO_SELECT) {
+		const char *data = tuple_data(key);
+		mp_decode_array(&data);
+		hash = is_full_key ? key_hash(data, key_def) :
+		       key_hash_prefix(data, key_def, prefix_part_count);
+	} else if (is_full_key) {
+		hash = tuple_hash(key, key_def);
+	} else {
+		hash = tuple_hash_prefix(key, key_def, prefix_part_count);
+	}
+	return bloom_possible_has(is_full_key ? &run->info.bloom :
+				  &run->info.prefix_bloom, hash);
+}
+
 static NODISCARD int
 vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 			enum iterator_type iterator_type,
@@ -1254,21 +1813,11 @@ vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 	*ret = NULL;
 
 	const struct key_def *key_def = itr->key_def;
-	bool is_full_key = (tuple_field_count(key) >= key_def->part_count);
-	if (run->info.has_bloom && iterator_type == ITER_EQ && is_full_key) {
-		uint32_t hash;
-		if (vy_stmt_type(key) == IPROTO_SELECT) {
-			const char *data = tuple_data(key);
-			mp_decode_array(&data);
-			hash = key_hash(data, key_def);
-		} else {
-			hash = tuple_hash(key, key_def);
-		}
-		if (!bloom_possible_has(&run->info.bloom, hash)) {
-			itr->search_ended = true;
-			itr->stat->bloom_hit++;
-			return 0;
-		}
+	if (iterator_type == ITER_EQ &&
+	    !vy_run_bloom_maybe_has(run, key, key_def)) {
+		itr->search_ended = true;
+		itr->stat->bloom_hit++;
+		return 0;
 	}
 
 	itr->stat->lookup++;
@@ -1290,7 +1839,7 @@ vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 	}
 	if (iterator_type == ITER_EQ && !equal_found) {
 		vy_run_iterator_stop(itr);
-		if (run->info.has_bloom && is_full_key)
+		if (vy_run_has_bloom_for_key(run, key, key_def))
 			itr->stat->bloom_miss++;
 		return 0;
 	}
@@ -1861,7 +2410,7 @@ static size_t
 vy_run_bloom_encode_size(const struct bloom *bloom)
 {
 	size_t size = mp_sizeof_array(4);
-	size += mp_sizeof_uint(VY_BLOOM_VERSION); /* version */
+	size += mp_sizeof_uint(bloom->type); /* version */
 	size += mp_sizeof_uint(bloom->table_size);
 	size += mp_sizeof_uint(bloom->hash_count);
 	size += mp_sizeof_bin(bloom_store_size(bloom));
@@ -1880,7 +2429,7 @@ vy_run_bloom_encode(const struct bloom *bloom, char *buffer)
 {
 	char *pos = buffer;
 	pos = mp_encode_array(pos, 4);
-	pos = mp_encode_uint(pos, VY_BLOOM_VERSION);
+	pos = mp_encode_uint(pos, bloom->type); /* version */
 	pos = mp_encode_uint(pos, bloom->table_size);
 	pos = mp_encode_uint(pos, bloom->hash_count);
 	pos = mp_encode_binl(pos, bloom_store_size(bloom));
@@ -1910,9 +2459,11 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	mp_next(&tmp);
 	size_t max_key_size = tmp - run_info->max_key;
 
-	uint32_t key_count = 5;
+	uint32_t key_count = 6;
 	if (run_info->has_bloom)
 		key_count++;
+	if (run_info->has_prefix_bloom)
+		key_count += 2;
 
 	size_t size = mp_sizeof_map(key_count);
 	size += mp_sizeof_uint(VY_RUN_INFO_MIN_KEY) + min_key_size;
@@ -1923,9 +2474,17 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 		mp_sizeof_uint(run_info->max_lsn);
 	size += mp_sizeof_uint(VY_RUN_INFO_PAGE_COUNT) +
 		mp_sizeof_uint(run_info->page_count);
+	size += mp_sizeof_uint(VY_RUN_INFO_DUMP_TIME) +
+		mp_sizeof_uint(run_info->dump_time);
 	if (run_info->has_bloom)
 		size += mp_sizeof_uint(VY_RUN_INFO_BLOOM) +
 			vy_run_bloom_encode_size(&run_info->bloom);
+	if (run_info->has_prefix_bloom) {
+		size += mp_sizeof_uint(VY_RUN_INFO_PREFIX_PART_COUNT) +
+			mp_sizeof_uint(run_info->prefix_part_count);
+		size += mp_sizeof_uint(VY_RUN_INFO_PREFIX_BLOOM) +
+			vy_run_bloom_encode_size(&run_info->prefix_bloom);
+	}
 
 	char *pos = region_alloc(&fiber()->gc, size);
 	if (pos == NULL) {
@@ -1948,10 +2507,18 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	pos = mp_encode_uint(pos, run_info->max_lsn);
 	pos = mp_encode_uint(pos, VY_RUN_INFO_PAGE_COUNT);
 	pos = mp_encode_uint(pos, run_info->page_count);
+	pos = mp_encode_uint(pos, VY_RUN_INFO_DUMP_TIME);
+	pos = mp_encode_uint(pos, run_info->dump_time);
 	if (run_info->has_bloom) {
 		pos = mp_encode_uint(pos, VY_RUN_INFO_BLOOM);
 		pos = vy_run_bloom_encode(&run_info->bloom, pos);
 	}
+	if (run_info->has_prefix_bloom) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_PREFIX_PART_COUNT);
+		pos = mp_encode_uint(pos, run_info->prefix_part_count);
+		pos = mp_encode_uint(pos, VY_RUN_INFO_PREFIX_BLOOM);
+		pos = vy_run_bloom_encode(&run_info->prefix_bloom, pos);
+	}
 	xrow->body->iov_len = (void *)pos - xrow->body->iov_base;
 	xrow->bodycnt = 1;
 	xrow->type = VY_INDEX_RUN_INFO;
@@ -2019,7 +2586,8 @@ int
 vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		const char *dirpath, uint32_t space_id, uint32_t iid,
 		const struct key_def *cmp_def, const struct key_def *key_def,
-		uint64_t page_size, double bloom_fpr, size_t max_output_count)
+		uint64_t page_size, double bloom_fpr,
+		uint32_t bloom_prefix_parts, size_t max_output_count)
 {
 	memset(writer, 0, sizeof(*writer));
 	writer->run = run;
@@ -2031,12 +2599,26 @@ vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 	writer->page_size = page_size;
 	writer->has_bloom = (max_output_count > 0 && bloom_fpr < 1);
 	if (writer->has_bloom &&
-	    bloom_spectrum_create(&writer->bloom, max_output_count,
-				  bloom_fpr, runtime.quota) != 0) {
+	    bloom_spectrum_create(&writer->bloom, BLOOM_SPLIT_BLOCK,
+				  max_output_count, bloom_fpr,
+				  runtime.quota) != 0) {
 		diag_set(OutOfMemory, 0,
 			 "bloom_spectrum_create", "bloom_spectrum");
 		return -1;
 	}
+	writer->has_prefix_bloom = (writer->has_bloom &&
+				    bloom_prefix_parts > 0 &&
+				    bloom_prefix_parts < key_def->part_count);
+	writer->prefix_part_count = bloom_prefix_parts;
+	if (writer->has_prefix_bloom &&
+	    bloom_spectrum_create(&writer->prefix_bloom, BLOOM_SPLIT_BLOCK,
+				  max_output_count, bloom_fpr,
+				  runtime.quota) != 0) {
+		diag_set(OutOfMemory, 0,
+			 "bloom_spectrum_create", "bloom_spectrum");
+		bloom_spectrum_destroy(&writer->bloom, runtime.quota);
+		return -1;
+	}
 	xlog_clear(&writer->data_xlog);
 	ibuf_create(&writer->row_index_buf, &cord()->slabc,
 		    4096 * sizeof(uint32_t));
@@ -2131,6 +2713,15 @@ vy_run_writer_write_to_page(struct vy_run_writer *writer, struct tuple *stmt)
 		bloom_spectrum_add(&writer->bloom,
 				   tuple_hash(stmt, writer->key_def));
 	}
+	if (writer->has_prefix_bloom) {
+		uint32_t hash = tuple_hash_prefix(stmt, writer->key_def,
+						  writer->prefix_part_count);
+		if (!writer->has_last_prefix_hash ||
+		    hash != writer->last_prefix_hash)
+			bloom_spectrum_add(&writer->prefix_bloom, hash);
+		writer->last_prefix_hash = hash;
+		writer->has_last_prefix_hash = true;
+	}
 	int64_t lsn = vy_stmt_lsn(stmt);
 	run->info.min_lsn = MIN(run->info.min_lsn, lsn);
 	run->info.max_lsn = MAX(run->info.max_lsn, lsn);
@@ -2212,6 +2803,8 @@ vy_run_writer_destroy(struct vy_run_writer *writer, bool reuse_fd)
 		xlog_close(&writer->data_xlog, reuse_fd);
 	if (writer->has_bloom)
 		bloom_spectrum_destroy(&writer->bloom, runtime.quota);
+	if (writer->has_prefix_bloom)
+		bloom_spectrum_destroy(&writer->prefix_bloom, runtime.quota);
 	ibuf_destroy(&writer->row_index_buf);
 }
 
@@ -2252,6 +2845,12 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 		bloom_spectrum_choose(&writer->bloom, &run->info.bloom);
 		run->info.has_bloom = true;
 	}
+	if (writer->has_prefix_bloom) {
+		bloom_spectrum_choose(&writer->prefix_bloom,
+				      &run->info.prefix_bloom);
+		run->info.has_prefix_bloom = true;
+		run->info.prefix_part_count = writer->prefix_part_count;
+	}
 	if (vy_run_write_index(run, writer->dirpath,
 			       writer->space_id, writer->iid) != 0)
 		goto out;
@@ -2369,12 +2968,25 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		goto done;
 	if (xlog_cursor_reset(&cursor) != 0)
 		goto close_err;
-	if (bloom_create(&run->info.bloom, run_row_count,
+	if (bloom_create(&run->info.bloom, BLOOM_SPLIT_BLOCK, run_row_count,
 			 opts->bloom_fpr, runtime.quota) != 0) {
 		diag_set(OutOfMemory, 0,
 			 "bloom_create", "bloom");
 		goto close_err;
 	}
+	run->info.has_bloom = true;
+	uint32_t prefix_part_count = opts->bloom_prefix_parts;
+	if (prefix_part_count > 0 && prefix_part_count < key_def->part_count) {
+		if (bloom_create(&run->info.prefix_bloom, BLOOM_SPLIT_BLOCK,
+				 run_row_count, opts->bloom_fpr,
+				 runtime.quota) != 0) {
+			diag_set(OutOfMemory, 0,
+				 "bloom_create", "bloom");
+			goto close_err;
+		}
+		run->info.has_prefix_bloom = true;
+		run->info.prefix_part_count = prefix_part_count;
+	}
 	struct xrow_header xrow;
 	while ((rc = xlog_cursor_next(&cursor, &xrow, false)) == 0) {
 		if (xrow.type == VY_RUN_ROW_INDEX)
@@ -2385,8 +2997,12 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		if (tuple == NULL)
 			goto close_err;
 		bloom_add(&run->info.bloom, tuple_hash(tuple, key_def));
+		if (run->info.has_prefix_bloom) {
+			bloom_add(&run->info.prefix_bloom,
+				  tuple_hash_prefix(tuple, key_def,
+						    prefix_part_count));
+		}
 	}
-	run->info.has_bloom = true;
 done:
 	region_truncate(region, mem_used);
 	run->fd = cursor.fd;
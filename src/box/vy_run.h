@@ -52,8 +52,31 @@ extern "C" {
 
 struct vy_run_reader;
 
+/**
+ * Cache of decompressed run pages. Pages are looked up by
+ * run and page number and shared by all run iterators of
+ * the tx thread, so that a hot page is read and decompressed
+ * only once.
+ */
+struct vy_page_cache {
+	/** List of cached pages, least recently used first. */
+	struct rlist lru;
+	/** Size of memory occupied by cached pages. */
+	size_t mem_used;
+	/** Max size of memory cached pages may occupy. */
+	size_t mem_quota;
+	/**
+	 * Number of batched lookups in progress. While it is
+	 * not 0, cached pages may exceed the quota by a fixed
+	 * amount so that the batch reads each page only once.
+	 */
+	int batch_count;
+};
+
 /** Part of vinyl environment for run read/write */
 struct vy_run_env {
+	/** Cache of decompressed pages. */
+	struct vy_page_cache page_cache;
 	/** Mempool for struct vy_page_read_task */
 	struct mempool read_task_pool;
 	/** Key for thread-local ZSTD context */
@@ -67,6 +90,13 @@ struct vy_run_env {
 	 * processing the next read request.
 	 */
 	int next_reader;
+	/**
+	 * Max time it took a reader thread to read a page,
+	 * as seen from the tx thread, since it was last reset,
+	 * in seconds. Used for adapting the rate of background
+	 * writes to foreground read latency.
+	 */
+	double read_latency_max;
 };
 
 /**
@@ -83,10 +113,21 @@ struct vy_run_info {
 	int64_t max_lsn;
 	/** Number of pages in the run. */
 	uint32_t page_count;
+	/**
+	 * Time of the most recent dump of the data stored in
+	 * the run, in seconds since the Epoch. 0 if unknown.
+	 */
+	uint64_t dump_time;
 	/** Set iff bloom filter is available. */
 	bool has_bloom;
 	/** Bloom filter of all tuples in run */
 	struct bloom bloom;
+	/** Set iff prefix bloom filter is available. */
+	bool has_prefix_bloom;
+	/** Number of key parts hashed by the prefix bloom filter. */
+	uint32_t prefix_part_count;
+	/** Bloom filter of key prefixes of all tuples in run. */
+	struct bloom prefix_bloom;
 };
 
 /**
@@ -146,6 +187,11 @@ struct vy_run {
 	struct rlist in_unused;
 	/** Link in vy_index::runs list. */
 	struct rlist in_index;
+	/**
+	 * Pages of this run stored in the page cache, indexed
+	 * by page number. Allocated on first use.
+	 */
+	struct vy_page **cached_pages;
 };
 
 /**
@@ -268,6 +314,15 @@ struct vy_run_iterator {
 struct vy_page {
 	/** Page position in the run file. */
 	uint32_t page_no;
+	/** Reference counter, the page is freed when it hits 0. */
+	int refs;
+	/**
+	 * Run this page is cached for or NULL if the page
+	 * is not in the page cache.
+	 */
+	struct vy_run *run;
+	/** Link in vy_page_cache::lru. */
+	struct rlist in_lru;
 	/** Size of page data in memory, i.e. unpacked. */
 	uint32_t unpacked_size;
 	/** Number of statements in the page. */
@@ -290,6 +345,31 @@ vy_run_env_create(struct vy_run_env *env);
 void
 vy_run_env_destroy(struct vy_run_env *env);
 
+/**
+ * Set the max size of memory decompressed pages cached by
+ * a vinyl run environment may occupy. Evict pages if the
+ * new limit is exceeded. 0 disables the page cache.
+ */
+void
+vy_run_env_set_page_cache(struct vy_run_env *env, size_t quota);
+
+/**
+ * Begin a batch of lookups that are likely to hit the same
+ * pages. Until the matching vy_run_env_end_batch() call,
+ * pages read in the tx thread are kept in the page cache
+ * even if it is disabled or over its quota, as long as they
+ * exceed the quota by no more than a fixed amount.
+ */
+void
+vy_run_env_begin_batch(struct vy_run_env *env);
+
+/**
+ * End a batch of lookups started with vy_run_env_begin_batch()
+ * and evict the pages that do not fit in the page cache quota.
+ */
+void
+vy_run_env_end_batch(struct vy_run_env *env);
+
 /**
  * Enable coio reads for a vinyl run environment.
  *
@@ -305,7 +385,12 @@ vy_run_env_enable_coio(struct vy_run_env *env, int threads);
 static inline size_t
 vy_run_bloom_size(struct vy_run *run)
 {
-	return run->info.has_bloom ? bloom_store_size(&run->info.bloom) : 0;
+	size_t size = 0;
+	if (run->info.has_bloom)
+		size += bloom_store_size(&run->info.bloom);
+	if (run->info.has_prefix_bloom)
+		size += bloom_store_size(&run->info.prefix_bloom);
+	return size;
 }
 
 static inline struct vy_page_info *
@@ -481,6 +566,26 @@ vy_slice_cut(struct vy_slice *slice, int64_t id,
 	     const struct key_def *cmp_def,
 	     struct vy_slice **result);
 
+/**
+ * Check whether a run has a bloom filter applicable to a key:
+ * the full key bloom filter for a full key or the prefix bloom
+ * filter for a partial key that includes the prefix.
+ */
+bool
+vy_run_has_bloom_for_key(struct vy_run *run, const struct tuple *key,
+			 const struct key_def *key_def);
+
+/**
+ * Check the bloom filter of a run for a key.
+ *
+ * Return false if the run definitely doesn't contain the key,
+ * true if it may contain it. True is also returned if the run
+ * has no bloom filter applicable to the key.
+ */
+bool
+vy_run_bloom_maybe_has(struct vy_run *run, const struct tuple *key,
+		       const struct key_def *key_def);
+
 /**
  * Open an iterator over on-disk run.
  *
@@ -604,6 +709,20 @@ struct vy_run_writer {
 	bool has_bloom;
 	/** Bloom filter. */
 	struct bloom_spectrum bloom;
+	/** Set iff prefix bloom filter is available. */
+	bool has_prefix_bloom;
+	/** Number of key parts hashed by the prefix bloom filter. */
+	uint32_t prefix_part_count;
+	/** Prefix bloom filter. */
+	struct bloom_spectrum prefix_bloom;
+	/**
+	 * Hash of the key prefix of the last written statement.
+	 * Statements are written in the key order, so a prefix
+	 * is added to the prefix bloom filter only once.
+	 */
+	uint32_t last_prefix_hash;
+	/** Set if last_prefix_hash is valid. */
+	bool has_last_prefix_hash;
 	/** Buffer of a current page row offsets. */
 	struct ibuf row_index_buf;
 	/**
@@ -618,7 +737,8 @@ int
 vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		const char *dirpath, uint32_t space_id, uint32_t iid,
 		const struct key_def *cmp_def, const struct key_def *key_def,
-		uint64_t page_size, double bloom_fpr, size_t max_output_count);
+		uint64_t page_size, double bloom_fpr,
+		uint32_t bloom_prefix_parts, size_t max_output_count);
 
 /**
  * Write a specified statement into a run.
@@ -53,6 +53,7 @@
 #include "vy_mem.h"
 #include "vy_range.h"
 #include "vy_run.h"
+#include "vy_stmt.h"
 #include "vy_write_iterator.h"
 #include "trivia/util.h"
 #include "tt_pthread.h"
@@ -102,6 +103,52 @@ struct vy_task_ops {
 		      bool in_shutdown);
 };
 
+/**
+ * A tuple overwritten in a primary index with deferred DELETEs,
+ * found by compaction. See vy_task::deferred_deletes.
+ */
+struct vy_deferred_delete {
+	/** Link in vy_task::deferred_deletes. */
+	struct stailq_entry in_task;
+	/** Size of the overwritten tuple data. */
+	uint32_t old_size;
+	/**
+	 * Size of the newest version of the tuple data,
+	 * 0 if the tuple was deleted.
+	 */
+	uint32_t new_size;
+	/** The overwritten tuple followed by the newest one. */
+	char data[0];
+};
+
+/**
+ * Compaction of a range split into key-disjoint parts, each of
+ * which is written by its own task so that the range can be
+ * compacted by several worker threads concurrently. When all
+ * parts are written, the compacted range is replaced with one
+ * range per part in a single metadata log transaction.
+ */
+struct vy_compact_job {
+	/** Range to compact. */
+	struct vy_range *range;
+	/** First (newest) and last (oldest) slices to compact. */
+	struct vy_slice *first_slice, *last_slice;
+	/** Number of parts the compaction is split into. */
+	int part_count;
+	/** Number of part tasks that haven't been processed yet. */
+	int parts_pending;
+	/** Set if any part task failed. */
+	bool is_failed;
+	/**
+	 * Boundaries of the parts: part i spans keys from
+	 * keys[i] (inclusive) to keys[i + 1] (exclusive).
+	 * NULL stands for infinity.
+	 */
+	struct tuple **keys;
+	/** Runs written by the part tasks. */
+	struct vy_run **new_runs;
+};
+
 struct vy_task {
 	const struct vy_task_ops *ops;
 	/** Return code of ->execute. */
@@ -147,7 +194,27 @@ struct vy_task {
 	 * from another thread.
 	 */
 	double bloom_fpr;
+	uint32_t bloom_prefix_parts;
 	int64_t page_size;
+	/**
+	 * Handler passed to the write iterator if the task
+	 * compacts a primary index with deferred DELETEs.
+	 */
+	struct vy_deferred_delete_handler deferred_delete_handler;
+	/**
+	 * Tuples overwritten in the primary index, linked by
+	 * vy_deferred_delete::in_task. Filled in a worker thread,
+	 * processed on task completion. Since tuples can't be
+	 * passed between threads, raw data is copied.
+	 */
+	struct stailq deferred_deletes;
+	/** Split compaction this task is a part of, or NULL. */
+	struct vy_compact_job *job;
+	/**
+	 * Slices of the compacted runs cut to the boundaries of
+	 * the part written by the task, linked by vy_slice::in_range.
+	 */
+	struct rlist part_slices;
 };
 
 /**
@@ -183,6 +250,8 @@ vy_task_new(struct mempool *pool, struct vy_index *index,
 	}
 	vy_index_ref(index);
 	diag_create(&task->diag);
+	stailq_create(&task->deferred_deletes);
+	rlist_create(&task->part_slices);
 	return task;
 }
 
@@ -190,6 +259,10 @@ vy_task_new(struct mempool *pool, struct vy_index *index,
 static void
 vy_task_delete(struct mempool *pool, struct vy_task *task)
 {
+	struct vy_deferred_delete *dd, *next_dd;
+	stailq_foreach_entry_safe(dd, next_dd, &task->deferred_deletes,
+				  in_task)
+		free(dd);
 	key_def_delete(task->cmp_def);
 	key_def_delete(task->key_def);
 	vy_index_unref(task->index);
@@ -305,6 +378,7 @@ vy_scheduler_stop_workers(struct vy_scheduler *scheduler)
 	stailq_concat(&task_queue, &scheduler->input_queue);
 	pthread_cond_broadcast(&scheduler->worker_cond);
 	tt_pthread_mutex_unlock(&scheduler->mutex);
+	vy_throttle_cancel(&scheduler->throttle);
 
 	/* Wait for worker threads to exit. */
 	for (int i = 0; i < scheduler->worker_pool_size; i++)
@@ -317,6 +391,7 @@ vy_scheduler_stop_workers(struct vy_scheduler *scheduler)
 	/* Abort all pending tasks. */
 	struct vy_task *task, *next;
 	stailq_concat(&task_queue, &scheduler->output_queue);
+	stailq_concat(&task_queue, &scheduler->pending_tasks);
 	stailq_foreach_entry_safe(task, next, &task_queue, link) {
 		if (task->ops->abort != NULL)
 			task->ops->abort(scheduler, task, true);
@@ -327,11 +402,13 @@ vy_scheduler_stop_workers(struct vy_scheduler *scheduler)
 void
 vy_scheduler_create(struct vy_scheduler *scheduler, int write_threads,
 		    vy_scheduler_dump_complete_f dump_complete_cb,
+		    vy_scheduler_deferred_delete_f deferred_delete_cb,
 		    struct vy_run_env *run_env, struct rlist *read_views)
 {
 	memset(scheduler, 0, sizeof(*scheduler));
 
 	scheduler->dump_complete_cb = dump_complete_cb;
+	scheduler->deferred_delete_cb = deferred_delete_cb;
 	scheduler->read_views = read_views;
 	scheduler->run_env = run_env;
 
@@ -349,6 +426,7 @@ vy_scheduler_create(struct vy_scheduler *scheduler, int write_threads,
 		       sizeof(struct vy_task));
 	stailq_create(&scheduler->input_queue);
 	stailq_create(&scheduler->output_queue);
+	stailq_create(&scheduler->pending_tasks);
 
 	tt_pthread_cond_init(&scheduler->worker_cond, NULL);
 	tt_pthread_mutex_init(&scheduler->mutex, NULL);
@@ -358,6 +436,7 @@ vy_scheduler_create(struct vy_scheduler *scheduler, int write_threads,
 
 	diag_create(&scheduler->diag);
 	fiber_cond_create(&scheduler->dump_cond);
+	vy_throttle_create(&scheduler->throttle);
 
 	fiber_start(scheduler->scheduler_fiber, scheduler);
 }
@@ -383,6 +462,7 @@ vy_scheduler_destroy(struct vy_scheduler *scheduler)
 	fiber_cond_destroy(&scheduler->scheduler_cond);
 	vy_dump_heap_destroy(&scheduler->dump_heap);
 	vy_compact_heap_destroy(&scheduler->compact_heap);
+	vy_throttle_destroy(&scheduler->throttle);
 
 	TRASH(scheduler);
 }
@@ -641,7 +721,8 @@ vy_run_discard(struct vy_run *run)
 }
 
 static int
-vy_task_write_run(struct vy_scheduler *scheduler, struct vy_task *task)
+vy_task_write_run(struct vy_scheduler *scheduler, struct vy_task *task,
+		  enum vy_throttle_type throttle_type)
 {
 	struct vy_index *index = task->index;
 	struct vy_stmt_stream *wi = task->wi;
@@ -659,6 +740,7 @@ vy_task_write_run(struct vy_scheduler *scheduler, struct vy_task *task)
 				 index->space_id, index->id,
 				 task->cmp_def, task->key_def,
 				 task->page_size, task->bloom_fpr,
+				 task->bloom_prefix_parts,
 				 task->max_output_count) != 0)
 		goto fail;
 
@@ -666,6 +748,7 @@ vy_task_write_run(struct vy_scheduler *scheduler, struct vy_task *task)
 		goto fail_abort_writer;
 	int rc;
 	struct tuple *stmt = NULL;
+	off_t written = 0;
 	while ((rc = wi->iface->next(wi, &stmt)) == 0 && stmt != NULL) {
 		inj = errinj(ERRINJ_VY_RUN_WRITE_STMT_TIMEOUT, ERRINJ_DOUBLE);
 		if (inj != NULL && inj->dparam > 0)
@@ -675,6 +758,13 @@ vy_task_write_run(struct vy_scheduler *scheduler, struct vy_task *task)
 		if (rc != 0)
 			break;
 
+		/* Throttle the task if it writes too fast. */
+		if (writer.data_xlog.offset > written) {
+			vy_throttle_consume(&scheduler->throttle, throttle_type,
+					    writer.data_xlog.offset - written);
+			written = writer.data_xlog.offset;
+		}
+
 		if (!scheduler->is_worker_pool_running) {
 			diag_set(FiberIsCancelled);
 			rc = -1;
@@ -699,7 +789,7 @@ fail:
 static int
 vy_task_dump_execute(struct vy_scheduler *scheduler, struct vy_task *task)
 {
-	return vy_task_write_run(scheduler, task);
+	return vy_task_write_run(scheduler, task, VY_THROTTLE_DUMP);
 }
 
 static int
@@ -1005,12 +1095,13 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_index *index,
 
 	assert(dump_lsn >= 0);
 	new_run->dump_lsn = dump_lsn;
+	new_run->info.dump_time = ev_now(loop());
 
 	struct vy_stmt_stream *wi;
 	bool is_last_level = (index->run_count == 0);
 	wi = vy_write_iterator_new(task->cmp_def, index->disk_format,
 				   index->upsert_format, index->id == 0,
-				   is_last_level, scheduler->read_views);
+				   is_last_level, scheduler->read_views, NULL);
 	if (wi == NULL)
 		goto err_wi;
 	rlist_foreach_entry(mem, &index->sealed, in_sealed) {
@@ -1023,7 +1114,9 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_index *index,
 	task->new_run = new_run;
 	task->wi = wi;
 	task->max_output_count = max_output_count;
-	task->bloom_fpr = index->opts.bloom_fpr;
+	task->bloom_fpr = vy_index_bloom_fpr(index, max_output_count,
+					     index->stat.disk.count.rows);
+	task->bloom_prefix_parts = index->opts.bloom_prefix_parts;
 	task->page_size = index->opts.page_size;
 
 	index->is_dumping = true;
@@ -1059,10 +1152,139 @@ err:
 	return -1;
 }
 
+/**
+ * Deferred DELETE handler callback invoked by the write iterator
+ * of a primary index compaction task in a worker thread. Copies
+ * the overwritten tuple and its newest version to the task so
+ * that secondary indexes can be updated on task completion.
+ */
+static int
+vy_task_deferred_delete_process(struct vy_deferred_delete_handler *handler,
+				struct tuple *old_stmt, struct tuple *new_stmt)
+{
+	struct vy_task *task = container_of(handler, struct vy_task,
+					    deferred_delete_handler);
+	uint32_t old_size, new_size = 0;
+	const char *old_data = tuple_data_range(old_stmt, &old_size);
+	const char *new_data = NULL;
+	if (vy_stmt_type(new_stmt) != IPROTO_DELETE) {
+		new_data = tuple_data_range(new_stmt, &new_size);
+		/* Nothing to do if the tuple wasn't changed. */
+		if (old_size == new_size &&
+		    memcmp(old_data, new_data, old_size) == 0)
+			return 0;
+	}
+	size_t size = sizeof(struct vy_deferred_delete) + old_size + new_size;
+	struct vy_deferred_delete *dd = malloc(size);
+	if (dd == NULL) {
+		diag_set(OutOfMemory, size, "malloc",
+			 "struct vy_deferred_delete");
+		return -1;
+	}
+	dd->old_size = old_size;
+	dd->new_size = new_size;
+	memcpy(dd->data, old_data, old_size);
+	if (new_data != NULL)
+		memcpy(dd->data + old_size, new_data, new_size);
+	stailq_add_tail_entry(&task->deferred_deletes, dd, in_task);
+	return 0;
+}
+
+static const struct vy_deferred_delete_handler_iface
+vy_task_deferred_delete_iface = {
+	.process = vy_task_deferred_delete_process,
+};
+
+/**
+ * Check if a primary index may store a version of a key newer
+ * than the statements compacted by a task, i.e. if the key is
+ * present in an in-memory tree or in a slice added to the range
+ * by a dump completed while the task was in progress.
+ */
+static bool
+vy_task_compact_key_may_be_newer(struct vy_task *task,
+				 const struct tuple *stmt)
+{
+	struct vy_index *index = task->index;
+	if (vy_mem_has_key(index->mem, stmt))
+		return true;
+	struct vy_mem *mem;
+	rlist_foreach_entry(mem, &index->sealed, in_sealed) {
+		if (vy_mem_has_key(mem, stmt))
+			return true;
+	}
+	struct vy_slice *slice;
+	rlist_foreach_entry(slice, &task->range->slices, in_range) {
+		if (slice == task->first_slice)
+			break;
+		if (vy_run_bloom_maybe_has(slice->run, stmt, index->key_def))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Pass tuples overwritten in a primary index with deferred
+ * DELETEs and found by compaction to the deferred DELETE
+ * callback, unless a newer version of the key may have been
+ * written after the compacted runs were created. In the latter
+ * case there's no way to tell whether the overwritten tuple
+ * has to be deleted from secondary indexes without a disk read,
+ * so we skip it: readers filter stale secondary index entries
+ * anyway.
+ */
+static void
+vy_task_compact_process_deferred_deletes(struct vy_scheduler *scheduler,
+					 struct vy_task *task)
+{
+	struct vy_index *index = task->index;
+	struct vy_deferred_delete *dd;
+	int loops = 0;
+	stailq_foreach_entry(dd, &task->deferred_deletes, in_task) {
+		/*
+		 * It's OK to yield here, because the compacted
+		 * slices can't be removed from the range while
+		 * the task is in progress.
+		 */
+		if (++loops % VY_YIELD_LOOPS == 0)
+			fiber_sleep(0);
+		if (index->is_dropped)
+			break;
+		struct tuple *old_stmt, *new_stmt = NULL;
+		old_stmt = vy_stmt_new_replace(index->mem_format, dd->data,
+					       dd->data + dd->old_size);
+		if (old_stmt == NULL)
+			goto fail;
+		if (dd->new_size > 0) {
+			const char *new_data = dd->data + dd->old_size;
+			new_stmt = vy_stmt_new_replace(index->mem_format,
+					new_data, new_data + dd->new_size);
+			if (new_stmt == NULL) {
+				tuple_unref(old_stmt);
+				goto fail;
+			}
+		}
+		if (!vy_task_compact_key_may_be_newer(task, old_stmt)) {
+			scheduler->deferred_delete_cb(scheduler, index,
+						      old_stmt, new_stmt);
+		}
+		tuple_unref(old_stmt);
+		if (new_stmt != NULL)
+			tuple_unref(new_stmt);
+		continue;
+fail:
+		/*
+		 * Failure to generate a DELETE is not critical,
+		 * it only leaves garbage in secondary indexes.
+		 */
+		diag_log();
+	}
+}
+
 static int
 vy_task_compact_execute(struct vy_scheduler *scheduler, struct vy_task *task)
 {
-	return vy_task_write_run(scheduler, task);
+	return vy_task_write_run(scheduler, task, VY_THROTTLE_COMPACT);
 }
 
 static int
@@ -1076,6 +1298,13 @@ vy_task_compact_complete(struct vy_scheduler *scheduler, struct vy_task *task)
 	struct vy_slice *slice, *next_slice, *new_slice = NULL;
 	struct vy_run *run;
 
+	/*
+	 * Generate DELETEs for secondary indexes before replacing
+	 * the compacted slices so that overwritten tuples don't
+	 * get lost if we fail below.
+	 */
+	vy_task_compact_process_deferred_deletes(scheduler, task);
+
 	/*
 	 * Allocate a slice of the new run.
 	 *
@@ -1246,6 +1475,485 @@ vy_task_compact_abort(struct vy_scheduler *scheduler, struct vy_task *task,
 	vy_scheduler_update_index(scheduler, index);
 }
 
+static struct vy_compact_job *
+vy_compact_job_new(struct vy_range *range, int part_count)
+{
+	struct vy_compact_job *job;
+	size_t size = sizeof(*job) +
+		      sizeof(*job->keys) * (part_count + 1) +
+		      sizeof(*job->new_runs) * part_count;
+	job = calloc(1, size);
+	if (job == NULL) {
+		diag_set(OutOfMemory, size, "malloc",
+			 "struct vy_compact_job");
+		return NULL;
+	}
+	job->range = range;
+	job->part_count = part_count;
+	job->keys = (struct tuple **)(job + 1);
+	job->new_runs = (struct vy_run **)(job->keys + part_count + 1);
+	return job;
+}
+
+static void
+vy_compact_job_delete(struct vy_compact_job *job)
+{
+	for (int i = 0; i <= job->part_count; i++) {
+		if (job->keys[i] != NULL)
+			tuple_unref(job->keys[i]);
+	}
+	TRASH(job);
+	free(job);
+}
+
+/**
+ * Replace the range compacted by a split compaction job with
+ * new ranges, one per part. Each new range receives the run
+ * written for it in place of the compacted slices and slices
+ * of the runs that weren't compacted (e.g. added by a dump
+ * while the job was in progress) cut to its boundaries.
+ */
+static int
+vy_compact_job_commit(struct vy_scheduler *scheduler, struct vy_index *index,
+		      struct vy_compact_job *job)
+{
+	struct vy_range *range = job->range;
+	struct vy_slice *first_slice = job->first_slice;
+	struct vy_slice *last_slice = job->last_slice;
+	struct vy_slice *slice, *new_slice;
+	struct vy_range *part, **parts;
+	struct vy_run *run;
+	int part_count = job->part_count;
+
+	size_t size = sizeof(*parts) * part_count;
+	parts = calloc(1, size);
+	if (parts == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "struct vy_range");
+		return -1;
+	}
+
+	/*
+	 * Allocate new ranges and fill them with slices.
+	 */
+	for (int i = 0; i < part_count; i++) {
+		part = vy_range_new(vy_log_next_id(), job->keys[i],
+				    job->keys[i + 1], index->cmp_def);
+		if (part == NULL)
+			goto fail;
+		parts[i] = part;
+		/*
+		 * vy_range_add_slice() adds a slice to the list head,
+		 * so to preserve the order of the slices list, we have
+		 * to iterate backward.
+		 */
+		bool is_compacted = false;
+		rlist_foreach_entry_reverse(slice, &range->slices, in_range) {
+			if (slice == last_slice)
+				is_compacted = true;
+			if (!is_compacted) {
+				if (vy_slice_cut(slice, vy_log_next_id(),
+						 part->begin, part->end,
+						 index->cmp_def,
+						 &new_slice) != 0)
+					goto fail;
+				if (new_slice != NULL)
+					vy_range_add_slice(part, new_slice);
+				continue;
+			}
+			if (slice != first_slice)
+				continue;
+			is_compacted = false;
+			run = job->new_runs[i];
+			if (vy_run_is_empty(run))
+				continue;
+			new_slice = vy_slice_new(vy_log_next_id(), run,
+						 NULL, NULL, index->cmp_def);
+			if (new_slice == NULL)
+				goto fail;
+			vy_range_add_slice(part, new_slice);
+		}
+		part->n_compactions = range->n_compactions + 1;
+		vy_range_update_compact_priority(part, &index->opts);
+	}
+
+	/*
+	 * Build the list of runs that became unused
+	 * as a result of compaction.
+	 */
+	RLIST_HEAD(unused_runs);
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		slice->run->compacted_slice_count++;
+		if (slice == last_slice)
+			break;
+	}
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		run = slice->run;
+		if (run->compacted_slice_count == run->refs)
+			rlist_add_entry(&unused_runs, run, in_unused);
+		slice->run->compacted_slice_count = 0;
+		if (slice == last_slice)
+			break;
+	}
+
+	/*
+	 * Log change in metadata.
+	 */
+	vy_log_tx_begin();
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		vy_log_delete_slice(slice->id);
+	vy_log_delete_range(range->id);
+	int64_t gc_lsn = checkpoint_last(NULL);
+	rlist_foreach_entry(run, &unused_runs, in_unused)
+		vy_log_drop_run(run->id, gc_lsn);
+	for (int i = 0; i < part_count; i++) {
+		run = job->new_runs[i];
+		if (!vy_run_is_empty(run))
+			vy_log_create_run(index->commit_lsn, run->id,
+					  run->dump_lsn);
+	}
+	for (int i = 0; i < part_count; i++) {
+		part = parts[i];
+		vy_log_insert_range(index->commit_lsn, part->id,
+				    tuple_data_or_null(part->begin),
+				    tuple_data_or_null(part->end));
+		rlist_foreach_entry(slice, &part->slices, in_range)
+			vy_log_insert_slice(part->id, slice->run->id, slice->id,
+					    tuple_data_or_null(slice->begin),
+					    tuple_data_or_null(slice->end));
+	}
+	if (vy_log_tx_commit() < 0)
+		goto fail;
+
+	if (gc_lsn < 0) {
+		/*
+		 * If there is no last snapshot, i.e. we are in
+		 * the middle of join, we can delete compacted
+		 * run files right away.
+		 */
+		vy_log_tx_begin();
+		rlist_foreach_entry(run, &unused_runs, in_unused) {
+			if (vy_run_remove_files(index->env->path,
+						index->space_id, index->id,
+						run->id) == 0) {
+				vy_log_forget_run(run->id);
+			}
+		}
+		vy_log_tx_try_commit();
+	}
+
+	/*
+	 * Account the new runs that are not empty,
+	 * discard the rest.
+	 */
+	for (int i = 0; i < part_count; i++) {
+		run = job->new_runs[i];
+		job->new_runs[i] = NULL;
+		if (!vy_run_is_empty(run)) {
+			vy_index_add_run(index, run);
+			vy_stmt_counter_add_disk(&index->stat.disk.compact.out,
+						 &run->count);
+			/* Drop the reference held by the job. */
+			vy_run_unref(run);
+		} else
+			vy_run_discard(run);
+	}
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		vy_stmt_counter_add_disk(&index->stat.disk.compact.in,
+					 &slice->count);
+		if (slice == last_slice)
+			break;
+	}
+
+	/*
+	 * Replace the compacted range in the index. The range
+	 * was removed from the heap when the job was started,
+	 * while vy_index_remove_range() expects to find it there.
+	 */
+	vy_index_unacct_range(index, range);
+	vy_range_heap_insert(&index->range_heap, &range->heap_node);
+	vy_index_remove_range(index, range);
+	for (int i = 0; i < part_count; i++) {
+		part = parts[i];
+		vy_index_add_range(index, part);
+		vy_index_acct_range(index, part);
+	}
+	index->range_tree_version++;
+	index->stat.disk.compact.count++;
+
+	/*
+	 * Unaccount unused runs and delete the compacted range.
+	 */
+	rlist_foreach_entry(run, &unused_runs, in_unused)
+		vy_index_remove_run(index, run);
+
+	say_info("%s: completed compacting range %s in %d parts",
+		 vy_index_name(index), vy_range_str(range), part_count);
+
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		vy_slice_wait_pinned(slice);
+	vy_range_delete(range);
+	free(parts);
+
+	vy_scheduler_update_index(scheduler, index);
+	return 0;
+fail:
+	for (int i = 0; i < part_count; i++) {
+		if (parts[i] != NULL)
+			vy_range_delete(parts[i]);
+	}
+	free(parts);
+	return -1;
+}
+
+/**
+ * Drop a reference to a split compaction job held by a part
+ * task. When the last part is processed, the job is destroyed.
+ * If any part failed, the runs written by the job are discarded
+ * and the range is returned to the heap.
+ */
+static void
+vy_compact_job_unref(struct vy_scheduler *scheduler, struct vy_index *index,
+		     struct vy_compact_job *job, bool in_shutdown)
+{
+	assert(job->parts_pending > 0);
+	if (--job->parts_pending > 0)
+		return;
+
+	if (job->is_failed) {
+		for (int i = 0; i < job->part_count; i++) {
+			struct vy_run *run = job->new_runs[i];
+			if (run == NULL)
+				continue;
+			/* The metadata log is unavailable on shutdown. */
+			if (!in_shutdown)
+				vy_run_discard(run);
+			else
+				vy_run_unref(run);
+		}
+		struct vy_range *range = job->range;
+		assert(range->heap_node.pos == UINT32_MAX);
+		vy_range_heap_insert(&index->range_heap, &range->heap_node);
+		vy_scheduler_update_index(scheduler, index);
+	}
+	vy_compact_job_delete(job);
+}
+
+/**
+ * Release resources used by a part task in the tx thread:
+ * the write iterator and the slices it was reading.
+ */
+static void
+vy_task_compact_part_cleanup(struct vy_task *task)
+{
+	if (task->wi != NULL) {
+		task->wi->iface->close(task->wi);
+		task->wi = NULL;
+	}
+	struct vy_slice *slice, *next_slice;
+	rlist_foreach_entry_safe(slice, &task->part_slices,
+				 in_range, next_slice)
+		vy_slice_delete(slice);
+	rlist_create(&task->part_slices);
+}
+
+static int
+vy_task_compact_part_complete(struct vy_scheduler *scheduler,
+			      struct vy_task *task)
+{
+	struct vy_index *index = task->index;
+	struct vy_compact_job *job = task->job;
+
+	/* See the comment in vy_task_compact_complete(). */
+	vy_task_compact_process_deferred_deletes(scheduler, task);
+
+	/* The iterator has been cleaned up in worker. */
+	vy_task_compact_part_cleanup(task);
+
+	/*
+	 * The last part commits the whole job. If it fails,
+	 * the job will be destroyed by ->abort.
+	 */
+	if (job->parts_pending == 1 && !job->is_failed &&
+	    vy_compact_job_commit(scheduler, index, job) != 0)
+		return -1;
+
+	vy_compact_job_unref(scheduler, index, job, false);
+	return 0;
+}
+
+static void
+vy_task_compact_part_abort(struct vy_scheduler *scheduler,
+			   struct vy_task *task, bool in_shutdown)
+{
+	struct vy_index *index = task->index;
+	struct vy_compact_job *job = task->job;
+
+	vy_task_compact_part_cleanup(task);
+
+	/*
+	 * It's no use alerting the user if the server is
+	 * shutting down or the index was dropped.
+	 */
+	if (!in_shutdown && !index->is_dropped) {
+		struct error *e = diag_last_error(&task->diag);
+		error_log(e);
+		say_error("%s: failed to compact range %s",
+			  vy_index_name(index), vy_range_str(job->range));
+	}
+
+	job->is_failed = true;
+	vy_compact_job_unref(scheduler, index, job, in_shutdown);
+}
+
+/**
+ * Create tasks for compacting a range split in @part_count
+ * parts by @split_keys. The first task is returned in @p_task,
+ * the rest are appended to vy_scheduler::pending_tasks.
+ */
+static int
+vy_task_compact_split_new(struct vy_scheduler *scheduler,
+			  struct vy_index *index, struct vy_range *range,
+			  int part_count, const char **split_keys,
+			  struct vy_task **p_task)
+{
+	static struct vy_task_ops compact_part_ops = {
+		.execute = vy_task_compact_execute,
+		.complete = vy_task_compact_part_complete,
+		.abort = vy_task_compact_part_abort,
+	};
+
+	struct tuple_format *key_format = index->env->key_format;
+	struct vy_slice *slice, *part_slice;
+	struct vy_task *task, *next_task;
+	struct stailq tasks;
+	stailq_create(&tasks);
+
+	struct vy_compact_job *job = vy_compact_job_new(range, part_count);
+	if (job == NULL)
+		return -1;
+
+	/* Remember the slices we are compacting. */
+	int n = range->compact_priority;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		if (job->first_slice == NULL)
+			job->first_slice = slice;
+		job->last_slice = slice;
+		if (--n == 0)
+			break;
+	}
+	assert(n == 0);
+
+	/* Determine the parts' boundaries. */
+	job->keys[0] = range->begin;
+	if (range->begin != NULL)
+		tuple_ref(range->begin);
+	job->keys[part_count] = range->end;
+	if (range->end != NULL)
+		tuple_ref(range->end);
+	for (int i = 1; i < part_count; i++) {
+		job->keys[i] = vy_key_from_msgpack(key_format,
+						   split_keys[i - 1]);
+		if (job->keys[i] == NULL)
+			goto err;
+	}
+
+	bool is_last_level = (range->compact_priority == range->slice_count);
+	for (int i = 0; i < part_count; i++) {
+		task = vy_task_new(&scheduler->task_pool, index,
+				   &compact_part_ops);
+		if (task == NULL)
+			goto err;
+		stailq_add_tail_entry(&tasks, task, link);
+
+		struct vy_run *new_run = vy_run_prepare(scheduler->run_env,
+							index);
+		if (new_run == NULL)
+			goto err;
+		job->new_runs[i] = new_run;
+		task->new_run = new_run;
+
+		struct vy_deferred_delete_handler *handler = NULL;
+		if (index->defer_deletes) {
+			assert(index->id == 0);
+			task->deferred_delete_handler.iface =
+				&vy_task_deferred_delete_iface;
+			handler = &task->deferred_delete_handler;
+		}
+		task->wi = vy_write_iterator_new(task->cmp_def,
+				index->disk_format, index->upsert_format,
+				index->id == 0, is_last_level,
+				scheduler->read_views, handler);
+		if (task->wi == NULL)
+			goto err;
+
+		/*
+		 * Feed the write iterator with the compacted slices
+		 * cut to the part's boundaries.
+		 */
+		for (slice = job->first_slice; ;
+		     slice = rlist_next_entry(slice, in_range)) {
+			if (vy_slice_cut(slice, vy_log_next_id(),
+					 job->keys[i], job->keys[i + 1],
+					 index->cmp_def, &part_slice) != 0)
+				goto err;
+			if (part_slice != NULL) {
+				rlist_add_tail_entry(&task->part_slices,
+						     part_slice, in_range);
+				if (vy_write_iterator_new_slice(task->wi,
+							part_slice) != 0)
+					goto err;
+				task->max_output_count +=
+					part_slice->count.rows;
+			}
+			new_run->dump_lsn = MAX(new_run->dump_lsn,
+						slice->run->dump_lsn);
+			new_run->info.dump_time = MAX(new_run->info.dump_time,
+						slice->run->info.dump_time);
+			if (slice == job->last_slice)
+				break;
+		}
+		assert(new_run->dump_lsn >= 0);
+
+		task->job = job;
+		task->range = range;
+		task->first_slice = job->first_slice;
+		task->last_slice = job->last_slice;
+		task->bloom_fpr = vy_index_bloom_fpr(index,
+				task->max_output_count,
+				range->count.rows / part_count);
+		task->bloom_prefix_parts = index->opts.bloom_prefix_parts;
+		task->page_size = index->opts.page_size;
+		job->parts_pending++;
+	}
+
+	/*
+	 * Remove the range we are going to compact from the heap
+	 * so that it doesn't get selected again.
+	 */
+	vy_range_heap_delete(&index->range_heap, &range->heap_node);
+	range->heap_node.pos = UINT32_MAX;
+	vy_scheduler_update_index(scheduler, index);
+
+	say_info("%s: started compacting range %s in %d parts, runs %d/%d",
+		 vy_index_name(index), vy_range_str(range), part_count,
+		 range->compact_priority, range->slice_count);
+
+	*p_task = stailq_shift_entry(&tasks, struct vy_task, link);
+	stailq_concat(&scheduler->pending_tasks, &tasks);
+	return 0;
+err:
+	stailq_foreach_entry_safe(task, next_task, &tasks, link) {
+		vy_task_compact_part_cleanup(task);
+		vy_task_delete(&scheduler->task_pool, task);
+	}
+	for (int i = 0; i < part_count; i++) {
+		if (job->new_runs[i] != NULL)
+			vy_run_discard(job->new_runs[i]);
+	}
+	vy_compact_job_delete(job);
+	return -1;
+}
+
 static int
 vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_index *index,
 		    struct vy_task **p_task)
@@ -1272,6 +1980,35 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_index *index,
 		return 0;
 	}
 
+	/*
+	 * If the range is big, split its compaction between
+	 * idle worker threads, keeping one reserved for dumps.
+	 */
+	int max_parts = scheduler->workers_available - 1;
+	if (max_parts > 1) {
+		struct region *region = &fiber()->gc;
+		size_t region_svp = region_used(region);
+		const char **split_keys = region_alloc(region,
+				sizeof(*split_keys) * (max_parts - 1));
+		if (split_keys == NULL) {
+			diag_set(OutOfMemory, sizeof(*split_keys) *
+				 (max_parts - 1), "region", "split keys");
+			goto err_task;
+		}
+		int part_count = vy_range_compact_split(range, &index->opts,
+							max_parts, split_keys);
+		int rc = 0;
+		if (part_count > 1)
+			rc = vy_task_compact_split_new(scheduler, index, range,
+						       part_count, split_keys,
+						       p_task);
+		region_truncate(region, region_svp);
+		if (rc != 0)
+			goto err_task;
+		if (part_count > 1)
+			return 0;
+	}
+
 	struct vy_task *task = vy_task_new(&scheduler->task_pool,
 					   index, &compact_ops);
 	if (task == NULL)
@@ -1283,9 +2020,17 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_index *index,
 
 	struct vy_stmt_stream *wi;
 	bool is_last_level = (range->compact_priority == range->slice_count);
+	struct vy_deferred_delete_handler *handler = NULL;
+	if (index->defer_deletes) {
+		assert(index->id == 0);
+		task->deferred_delete_handler.iface =
+			&vy_task_deferred_delete_iface;
+		handler = &task->deferred_delete_handler;
+	}
 	wi = vy_write_iterator_new(task->cmp_def, index->disk_format,
 				   index->upsert_format, index->id == 0,
-				   is_last_level, scheduler->read_views);
+				   is_last_level, scheduler->read_views,
+				   handler);
 	if (wi == NULL)
 		goto err_wi;
 
@@ -1298,6 +2043,8 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_index *index,
 		task->max_output_count += slice->count.rows;
 		new_run->dump_lsn = MAX(new_run->dump_lsn,
 					slice->run->dump_lsn);
+		new_run->info.dump_time = MAX(new_run->info.dump_time,
+					      slice->run->info.dump_time);
 
 		/* Remember the slices we are compacting. */
 		if (task->first_slice == NULL)
@@ -1313,7 +2060,9 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_index *index,
 	task->range = range;
 	task->new_run = new_run;
 	task->wi = wi;
-	task->bloom_fpr = index->opts.bloom_fpr;
+	task->bloom_fpr = vy_index_bloom_fpr(index, task->max_output_count,
+					     range->count.rows);
+	task->bloom_prefix_parts = index->opts.bloom_prefix_parts;
 	task->page_size = index->opts.page_size;
 
 	/*
@@ -1461,6 +2210,13 @@ vy_schedule(struct vy_scheduler *scheduler, struct vy_task **ptask)
 		return 0;
 	}
 
+	if (!stailq_empty(&scheduler->pending_tasks)) {
+		/* Schedule the remaining parts of a split compaction. */
+		*ptask = stailq_shift_entry(&scheduler->pending_tasks,
+					    struct vy_task, link);
+		return 0;
+	}
+
 	if (vy_scheduler_peek_compact(scheduler, ptask) != 0)
 		goto fail;
 	if (*ptask != NULL)
@@ -43,6 +43,7 @@
 #include "salad/heap.h"
 #include "salad/stailq.h"
 #include "tt_pthread.h"
+#include "vy_throttle.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -50,6 +51,7 @@ extern "C" {
 
 struct cord;
 struct fiber;
+struct tuple;
 struct vy_index;
 struct vy_run_env;
 struct vy_scheduler;
@@ -58,6 +60,11 @@ typedef void
 (*vy_scheduler_dump_complete_f)(struct vy_scheduler *scheduler,
 				int64_t dump_generation, double dump_duration);
 
+typedef void
+(*vy_scheduler_deferred_delete_f)(struct vy_scheduler *scheduler,
+				  struct vy_index *pk, struct tuple *old_stmt,
+				  struct tuple *new_stmt);
+
 struct vy_scheduler {
 	/** Scheduler fiber. */
 	struct fiber *scheduler_fiber;
@@ -84,6 +91,12 @@ struct vy_scheduler {
 	struct stailq input_queue;
 	/** Queue of processed tasks, linked by vy_task::link. */
 	struct stailq output_queue;
+	/**
+	 * Tasks created along with a split compaction task, but
+	 * not queued yet, linked by vy_task::link. They are queued
+	 * before any new compaction task as workers get available.
+	 */
+	struct stailq pending_tasks;
 	/**
 	 * Signaled to wake up a worker when there is
 	 * a pending task in the input queue. Also used
@@ -163,10 +176,21 @@ struct vy_scheduler {
 	 * by the dump.
 	 */
 	vy_scheduler_dump_complete_f dump_complete_cb;
+	/**
+	 * Function called by the scheduler for each tuple that
+	 * was overwritten in a primary index with deferred DELETEs
+	 * (see vy_index::defer_deletes) and dropped by compaction.
+	 * @new_stmt is the newest version of the tuple or NULL if
+	 * the tuple was deleted. It is supposed to delete the old
+	 * tuple from secondary indexes.
+	 */
+	vy_scheduler_deferred_delete_f deferred_delete_cb;
 	/** List of read views, see tx_manager::read_views. */
 	struct rlist *read_views;
 	/** Context needed for writing runs. */
 	struct vy_run_env *run_env;
+	/** Limits the rate at which dump and compaction write. */
+	struct vy_throttle throttle;
 };
 
 /**
@@ -175,6 +199,7 @@ struct vy_scheduler {
 void
 vy_scheduler_create(struct vy_scheduler *scheduler, int write_threads,
 		    vy_scheduler_dump_complete_f dump_complete_cb,
+		    vy_scheduler_deferred_delete_f deferred_delete_cb,
 		    struct vy_run_env *run_env, struct rlist *read_views);
 
 /**
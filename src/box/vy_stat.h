@@ -84,6 +84,23 @@ struct vy_run_iterator_stat {
 	 * prevent a disk read.
 	 */
 	int64_t bloom_miss;
+	/** Number of pages found in the page cache. */
+	int64_t page_cache_hit;
+	/**
+	 * Number of pages looked up in the page cache,
+	 * but read from the disk.
+	 */
+	int64_t page_cache_miss;
+	/**
+	 * Number of pages the reader threads were asked to read
+	 * ahead, because the iterator was moving page by page.
+	 */
+	int64_t prefetch;
+	/**
+	 * Number of point lookups that read runs concurrently,
+	 * see vy_point_lookup().
+	 */
+	int64_t parallel_lookup;
 	/**
 	 * Number of statements actually read from the disk.
 	 * It may be greater than the number of statements
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2010-2017, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "vy_throttle.h"
+
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+#include "clock.h"
+#include "trivia/util.h"
+
+/**
+ * Max amount of budget that may be accumulated while there are
+ * no writes, in seconds of writing at the current rate.
+ */
+static const double VY_THROTTLE_BURST = 0.1;
+
+/**
+ * The compaction rate is never decreased below this value,
+ * in bytes per second, so that compaction still makes progress.
+ */
+static const double VY_THROTTLE_RATE_MIN = 1024 * 1024;
+
+void
+vy_throttle_create(struct vy_throttle *t)
+{
+	memset(t, 0, sizeof(*t));
+	tt_pthread_mutex_init(&t->mutex, NULL);
+	tt_pthread_cond_init(&t->cond, NULL);
+	t->refill_time = clock_monotonic();
+}
+
+void
+vy_throttle_destroy(struct vy_throttle *t)
+{
+	tt_pthread_cond_destroy(&t->cond);
+	tt_pthread_mutex_destroy(&t->mutex);
+}
+
+/**
+ * Replenish the budgets according to the time passed since
+ * they were last replenished. Must be called under the mutex.
+ */
+static void
+vy_throttle_refill(struct vy_throttle *t)
+{
+	double now = clock_monotonic();
+	double elapsed = now - t->refill_time;
+	t->refill_time = now;
+	if (t->rate_limit > 0) {
+		t->dump_tokens = MIN(t->dump_tokens + elapsed * t->rate_limit,
+				     t->rate_limit * VY_THROTTLE_BURST);
+	}
+	if (t->rate > 0) {
+		t->compact_tokens = MIN(t->compact_tokens + elapsed * t->rate,
+					t->rate * VY_THROTTLE_BURST);
+	}
+}
+
+/**
+ * Reset the budgets and wake up throttled writers so that
+ * they reevaluate their sleep time after the rate was changed.
+ * Must be called under the mutex.
+ */
+static void
+vy_throttle_reset(struct vy_throttle *t)
+{
+	t->dump_tokens = 0;
+	t->compact_tokens = 0;
+	t->refill_time = clock_monotonic();
+	pthread_cond_broadcast(&t->cond);
+}
+
+void
+vy_throttle_set_rate_limit(struct vy_throttle *t, double rate_limit)
+{
+	tt_pthread_mutex_lock(&t->mutex);
+	t->rate_limit = MAX(rate_limit, 0);
+	t->rate = t->rate_limit;
+	vy_throttle_reset(t);
+	tt_pthread_mutex_unlock(&t->mutex);
+}
+
+void
+vy_throttle_set_latency_target(struct vy_throttle *t, double latency_target)
+{
+	tt_pthread_mutex_lock(&t->mutex);
+	t->latency_target = MAX(latency_target, 0);
+	if (t->latency_target == 0) {
+		t->rate = t->rate_limit;
+		vy_throttle_reset(t);
+	}
+	tt_pthread_mutex_unlock(&t->mutex);
+}
+
+void
+vy_throttle_update(struct vy_throttle *t, double read_latency,
+		   double interval)
+{
+	tt_pthread_mutex_lock(&t->mutex);
+	double write_rate = t->bytes_curr / interval;
+	t->bytes_curr = 0;
+	if (t->latency_target == 0)
+		goto out;
+	vy_throttle_refill(t);
+	if (read_latency > t->latency_target) {
+		/*
+		 * If there were no background writes, they
+		 * can't be blamed for the latency spike.
+		 */
+		if (write_rate == 0)
+			goto out;
+		double rate = write_rate;
+		if (t->rate > 0)
+			rate = MIN(rate, t->rate);
+		t->rate = MAX(rate / 2, VY_THROTTLE_RATE_MIN);
+		if (t->rate_limit > 0)
+			t->rate = MIN(t->rate, t->rate_limit);
+	} else if (t->rate > 0) {
+		t->rate *= 1.25;
+		if (t->rate_limit > 0) {
+			t->rate = MIN(t->rate, t->rate_limit);
+		} else if (t->rate > 2 * write_rate) {
+			/*
+			 * No rate limit is configured and
+			 * writers don't use most of the budget.
+			 * Stop throttling.
+			 */
+			t->rate = 0;
+		}
+	}
+	pthread_cond_broadcast(&t->cond);
+out:
+	tt_pthread_mutex_unlock(&t->mutex);
+}
+
+/**
+ * Sleep for at most @timeout seconds or until woken up.
+ * Must be called under the mutex.
+ */
+static void
+vy_throttle_wait(struct vy_throttle *t, double timeout)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	double sec = ts.tv_nsec / 1e9 + timeout;
+	ts.tv_sec += (time_t)sec;
+	ts.tv_nsec = (sec - (time_t)sec) * 1e9;
+	tt_pthread_cond_timedwait(&t->cond, &t->mutex, &ts);
+}
+
+void
+vy_throttle_consume(struct vy_throttle *t, enum vy_throttle_type type,
+		    size_t size)
+{
+	assert(type < vy_throttle_type_MAX);
+	tt_pthread_mutex_lock(&t->mutex);
+	vy_throttle_refill(t);
+
+	struct vy_throttle_stat *stat = &t->stat[type];
+	stat->bytes += size;
+	t->bytes_curr += size;
+
+	/* Dumps are charged to the compaction budget, too. */
+	if (t->rate > 0)
+		t->compact_tokens -= size;
+	if (type == VY_THROTTLE_DUMP && t->rate_limit > 0)
+		t->dump_tokens -= size;
+
+	double start = clock_monotonic();
+	bool throttled = false;
+	while (!t->is_cancelled) {
+		double rate, tokens;
+		if (type == VY_THROTTLE_DUMP) {
+			rate = t->rate_limit;
+			tokens = t->dump_tokens;
+		} else {
+			rate = t->rate;
+			tokens = t->compact_tokens;
+		}
+		if (rate == 0 || tokens >= 0)
+			break;
+		throttled = true;
+		vy_throttle_wait(t, -tokens / rate);
+		vy_throttle_refill(t);
+	}
+	if (throttled) {
+		stat->throttled++;
+		stat->throttle_time += clock_monotonic() - start;
+	}
+	tt_pthread_mutex_unlock(&t->mutex);
+}
+
+void
+vy_throttle_cancel(struct vy_throttle *t)
+{
+	tt_pthread_mutex_lock(&t->mutex);
+	t->is_cancelled = true;
+	pthread_cond_broadcast(&t->cond);
+	tt_pthread_mutex_unlock(&t->mutex);
+}
+
+void
+vy_throttle_get_stat(struct vy_throttle *t, double *rate,
+		     struct vy_throttle_stat stat[vy_throttle_type_MAX])
+{
+	tt_pthread_mutex_lock(&t->mutex);
+	*rate = t->rate;
+	memcpy(stat, t->stat, sizeof(t->stat));
+	tt_pthread_mutex_unlock(&t->mutex);
+}
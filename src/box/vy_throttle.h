@@ -0,0 +1,167 @@
+#ifndef INCLUDES_TARANTOOL_BOX_VY_THROTTLE_H
+#define INCLUDES_TARANTOOL_BOX_VY_THROTTLE_H
+/*
+ * Copyright 2010-2017, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tt_pthread.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/** Kind of background write subject to throttling. */
+enum vy_throttle_type {
+	VY_THROTTLE_DUMP,
+	VY_THROTTLE_COMPACT,
+	vy_throttle_type_MAX,
+};
+
+/** Throttling statistics of a kind of background write. */
+struct vy_throttle_stat {
+	/** Number of bytes written. */
+	int64_t bytes;
+	/** Number of times a writer was put to sleep. */
+	int64_t throttled;
+	/** Total time writers spent sleeping, in seconds. */
+	double throttle_time;
+};
+
+/**
+ * Token bucket limiting the rate at which dump and compaction
+ * write run files, so that they don't starve foreground reads
+ * and WAL writes sharing the same disk.
+ *
+ * Dumps and compactions have separate budgets. The dump budget
+ * is replenished at the configured rate limit. The compaction
+ * budget is replenished at a rate that adapts to foreground read
+ * latency (see vy_throttle_update()) and is also charged for
+ * dumps, so that compaction gets only what's left of the budget
+ * and never slows down dumps, which free memory.
+ *
+ * The throttle is consumed from worker threads and configured
+ * from the tx thread, so all its members are protected by a mutex.
+ */
+struct vy_throttle {
+	/** Mutex protecting the throttle. */
+	pthread_mutex_t mutex;
+	/** Signaled to wake up throttled writers. */
+	pthread_cond_t cond;
+	/** Max write rate, in bytes per second. 0 if unlimited. */
+	double rate_limit;
+	/**
+	 * Target foreground read latency, in seconds. If it is
+	 * exceeded, the compaction rate is decreased. 0 disables
+	 * adaptation.
+	 */
+	double latency_target;
+	/**
+	 * Current compaction rate, in bytes per second,
+	 * never greater than @rate_limit. 0 if unlimited.
+	 */
+	double rate;
+	/** Dump budget, in bytes. May be negative. */
+	double dump_tokens;
+	/** Compaction budget, in bytes. May be negative. */
+	double compact_tokens;
+	/** Time when the budgets were last replenished. */
+	double refill_time;
+	/** Bytes written since the last vy_throttle_update(). */
+	int64_t bytes_curr;
+	/** Set if throttled writers must not wait anymore. */
+	bool is_cancelled;
+	/** Statistics, by vy_throttle_type. */
+	struct vy_throttle_stat stat[vy_throttle_type_MAX];
+};
+
+void
+vy_throttle_create(struct vy_throttle *t);
+
+void
+vy_throttle_destroy(struct vy_throttle *t);
+
+/**
+ * Set the max rate of background writes, in bytes per second.
+ * 0 means unlimited.
+ */
+void
+vy_throttle_set_rate_limit(struct vy_throttle *t, double rate_limit);
+
+/**
+ * Set the target foreground read latency, in seconds.
+ * 0 disables adaptation.
+ */
+void
+vy_throttle_set_latency_target(struct vy_throttle *t, double latency_target);
+
+/**
+ * Adapt the compaction rate to the foreground read latency
+ * observed during the last @interval seconds: halve the rate if
+ * the latency is above the target, otherwise let it grow by 25%
+ * until it reaches the rate limit. Called periodically from the
+ * tx thread.
+ */
+void
+vy_throttle_update(struct vy_throttle *t, double read_latency,
+		   double interval);
+
+/**
+ * Account @size bytes written by a background task of the given
+ * type. If the task is out of budget, put the calling thread to
+ * sleep until the budget is replenished. Called from a worker
+ * thread.
+ */
+void
+vy_throttle_consume(struct vy_throttle *t, enum vy_throttle_type type,
+		    size_t size);
+
+/**
+ * Wake up all throttled writers and stop throttling.
+ * Used on shutdown.
+ */
+void
+vy_throttle_cancel(struct vy_throttle *t);
+
+/**
+ * Get the current compaction rate and throttling statistics.
+ */
+void
+vy_throttle_get_stat(struct vy_throttle *t, double *rate,
+		     struct vy_throttle_stat stat[vy_throttle_type_MAX]);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* INCLUDES_TARANTOOL_BOX_VY_THROTTLE_H */
@@ -181,6 +181,8 @@ struct vy_write_iterator {
 	 * key and its tuple format is different.
 	 */
 	bool is_primary;
+	/** Deferred DELETE handler, NULL if not used. */
+	struct vy_deferred_delete_handler *deferred_delete_handler;
 
 	/** Length of the @read_views. */
 	int rv_count;
@@ -332,8 +334,10 @@ static const struct vy_stmt_stream_iface vy_slice_stream_iface;
 struct vy_stmt_stream *
 vy_write_iterator_new(const struct key_def *cmp_def, struct tuple_format *format,
 		      struct tuple_format *upsert_format, bool is_primary,
-		      bool is_last_level, struct rlist *read_views)
+		      bool is_last_level, struct rlist *read_views,
+		      struct vy_deferred_delete_handler *handler)
 {
+	assert(handler == NULL || is_primary);
 	/*
 	 * One is reserved for INT64_MAX - maximal read view.
 	 */
@@ -369,6 +373,7 @@ vy_write_iterator_new(const struct key_def *cmp_def, struct tuple_format *format
 	tuple_format_ref(stream->upsert_format);
 	stream->is_primary = is_primary;
 	stream->is_last_level = is_last_level;
+	stream->deferred_delete_handler = handler;
 	return &stream->base;
 }
 
@@ -555,6 +560,40 @@ vy_write_iterator_pop_read_view_stmt(struct vy_write_iterator *stream)
 	return rv->tuple;
 }
 
+/**
+ * Pass a statement discarded because it had been overwritten
+ * to the deferred DELETE handler, if there is one.
+ *
+ * @param stream Write iterator.
+ * @param old_stmt Overwritten statement.
+ * @param new_stmt The newest statement for the same key.
+ *
+ * @retval  0 Success.
+ * @retval -1 Error.
+ */
+static NODISCARD int
+vy_write_iterator_deferred_delete(struct vy_write_iterator *stream,
+				  struct tuple *old_stmt,
+				  struct tuple *new_stmt)
+{
+	struct vy_deferred_delete_handler *handler =
+		stream->deferred_delete_handler;
+	if (handler == NULL)
+		return 0;
+	/*
+	 * Only full tuples need to be deleted from secondary
+	 * indexes. If the newest statement is an UPSERT, we
+	 * don't know the current tuple so leave the secondary
+	 * indexes as they are.
+	 */
+	if (vy_stmt_type(old_stmt) != IPROTO_REPLACE &&
+	    vy_stmt_type(old_stmt) != IPROTO_INSERT)
+		return 0;
+	if (vy_stmt_type(new_stmt) == IPROTO_UPSERT)
+		return 0;
+	return handler->iface->process(handler, old_stmt, new_stmt);
+}
+
 /**
  * Build the history of the current key.
  * Apply optimizations 1, 2 and 3 (@sa vy_write_iterator.h).
@@ -639,7 +678,14 @@ vy_write_iterator_build_history(struct region *region,
 			 * Skip statements invisible to the current read
 			 * view but older than the previous read view,
 			 * which is already fully built.
+			 *
+			 * The first statement of the key is the newest
+			 * one and it is referenced by end_of_key_src.
 			 */
+			rc = vy_write_iterator_deferred_delete(stream,
+					src->tuple, end_of_key_src.tuple);
+			if (rc != 0)
+				break;
 			goto next_lsn;
 		}
 		while (vy_stmt_lsn(src->tuple) <= merge_until_lsn) {
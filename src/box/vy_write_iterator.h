@@ -218,6 +218,34 @@ struct tuple_format;
 struct tuple;
 struct vy_mem;
 struct vy_slice;
+struct vy_deferred_delete_handler;
+
+/**
+ * Callbacks of a deferred DELETE handler.
+ */
+struct vy_deferred_delete_handler_iface {
+	/**
+	 * Process a REPLACE or INSERT statement that was discarded
+	 * by a primary index write iterator, because it had been
+	 * overwritten. @new_stmt is the newest REPLACE, INSERT or
+	 * DELETE statement for the same key among the iterator
+	 * sources. Called from the thread the iterator is used in.
+	 *
+	 * @retval  0 Success.
+	 * @retval -1 Error, diag is set. The iterator fails.
+	 */
+	int (*process)(struct vy_deferred_delete_handler *handler,
+		       struct tuple *old_stmt, struct tuple *new_stmt);
+};
+
+/**
+ * A handler passed to a primary index write iterator in order
+ * to generate DELETE statements for secondary indexes of spaces
+ * that defer DELETEs (see space_opts::defer_deletes).
+ */
+struct vy_deferred_delete_handler {
+	const struct vy_deferred_delete_handler_iface *iface;
+};
 
 /**
  * Open an empty write iterator. To add sources to the iterator
@@ -228,12 +256,15 @@ struct vy_slice;
  * @param LSM tree is_primary - set if this iterator is for a primary index.
  * @param is_last_level - there is no older level than the one we're writing to.
  * @param read_views - Opened read views.
+ * @param handler - deferred DELETE handler, can be NULL. Only
+ *                  applicable to a primary index.
  * @return the iterator or NULL on error (diag is set).
  */
 struct vy_stmt_stream *
 vy_write_iterator_new(const struct key_def *cmp_def, struct tuple_format *format,
 		      struct tuple_format *upsert_format, bool is_primary,
-		      bool is_last_level, struct rlist *read_views);
+		      bool is_last_level, struct rlist *read_views,
+		      struct vy_deferred_delete_handler *handler);
 
 /**
  * Add a mem as a source to the iterator.
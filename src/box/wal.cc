@@ -41,12 +41,32 @@
 #include "cbus.h"
 #include "coio_task.h"
 #include "replication.h"
+#include "trigger.h"
+#include "rmean.h"
+#include "tt_pthread.h"
+#include <small/ibuf.h>
+#include <pmatomic.h>
 
 
 const char *wal_mode_STRS[] = { "none", "write", "fsync", NULL };
 
 int wal_dir_lock = -1;
 
+/** WAL statistics, see box.stat.wal. */
+struct rmean *rmean_wal;
+
+enum rmean_wal_name {
+	/** Number of batches written to the WAL. */
+	WAL_STAT_BATCH,
+	/** Number of transactions committed to the WAL. */
+	WAL_STAT_COMMIT,
+	/** Number of fdatasync() calls done by the WAL. */
+	WAL_STAT_SYNC,
+	WAL_STAT_LAST,
+};
+
+const char *rmean_wal_strings[WAL_STAT_LAST] = { "BATCH", "COMMIT", "SYNC" };
+
 static int64_t
 wal_write(struct journal *, struct journal_entry *);
 
@@ -61,6 +81,23 @@ struct wal_thread {
 	struct cpipe wal_pipe;
 	/** Return pipe from 'wal' to tx' */
 	struct cpipe tx_pipe;
+	/**
+	 * 'wal_sync' thread, doing fdatasync() of written
+	 * batches in wal_mode = 'fsync'.
+	 */
+	struct cord sync_cord;
+	/** A pipe from 'wal' thread to 'wal_sync' */
+	struct cpipe sync_pipe;
+	/** Return pipe from 'wal_sync' to 'tx' */
+	struct cpipe sync_tx_pipe;
+	/** Descriptor of the WAL file synced last by 'wal_sync'. */
+	int synced_fd;
+	/**
+	 * Value of wal_writer::write_gen before the last sync of
+	 * synced_fd: all batches written to synced_fd with
+	 * a lesser or equal generation are on disk.
+	 */
+	uint64_t synced_gen;
 };
 
 /*
@@ -82,6 +119,29 @@ struct wal_writer
 	 * the wal-tx bus and are rolled back "on arrival".
 	 */
 	struct stailq rollback;
+	/**
+	 * Max time a batch may wait in tx for more requests to
+	 * join it before it is sent to WAL thread, in seconds.
+	 * 0 means that batches are sent right away.
+	 */
+	double commit_delay;
+	/**
+	 * A batch is sent to WAL thread without waiting for
+	 * commit_delay to expire as soon as it is this large.
+	 * 0 means no size limit.
+	 */
+	int64_t commit_min_size;
+	/**
+	 * If set, the group commit delay follows the measured
+	 * sync time, but doesn't exceed commit_delay.
+	 */
+	bool commit_is_adaptive;
+	/** Moving average of the time spent in fdatasync(). */
+	double sync_time;
+	/** Timer sending a delayed batch to WAL thread. */
+	struct ev_timer commit_timer;
+	/** Stops commit_timer when the WAL pipe is flushed. */
+	struct trigger on_wal_pipe_flush;
 	/* ----------------- wal ------------------- */
 	/** A setting from instance configuration - rows_per_wal */
 	int64_t wal_max_rows;
@@ -105,6 +165,14 @@ struct wal_writer
 	struct vclock vclock;
 	/** The current WAL file. */
 	struct xlog current_wal;
+	/**
+	 * Generation of the last batch written to disk.
+	 * Incremented by 'wal' thread after each write and
+	 * read by 'wal_sync' thread right before fdatasync(),
+	 * so that a single sync covers all batches written
+	 * while the previous one was in progress.
+	 */
+	uint64_t write_gen;
 	/**
 	 * Used if there was a WAL I/O error and we need to
 	 * keep adding all incoming requests to the rollback
@@ -127,6 +195,28 @@ struct wal_msg: public cmsg {
 	 * be rolled back.
 	 */
 	struct stailq rollback;
+	/**
+	 * Descriptor of the WAL file the batch was written to,
+	 * or -1 if the batch doesn't need to be synced.
+	 */
+	int sync_fd;
+	/** Value of wal_writer::write_gen after writing the batch. */
+	uint64_t write_gen;
+	/** Approximate size of the batch rows, in bytes. */
+	size_t approx_len;
+	/** Set if the batch was synced with fdatasync(). */
+	bool is_synced;
+	/** Time spent in fdatasync() if is_synced is set. */
+	double sync_time;
+};
+
+/**
+ * A message sent to 'wal_sync' thread when a WAL file is
+ * closed. The file descriptor is closed after all batches
+ * written to it are synced.
+ */
+struct wal_sync_close_msg: public cmsg {
+	int fd;
 };
 
 /**
@@ -137,9 +227,44 @@ struct vy_log_writer {
 	struct xlog xlog;
 };
 
+/** Size of the buffer of recently written rows, see wal_mem. */
+enum { WAL_MEM_SIZE = 8 * 1024 * 1024 };
+
+/** Max size of entries wal_mem_read() copies at once. */
+enum { WAL_MEM_READ_MAX = 128 * 1024 };
+
+/**
+ * Ring buffer of rows written to WAL recently. It is filled
+ * by 'wal' thread and read by relay threads, which thus don't
+ * need to read and decode xlog files while they keep up with
+ * WAL. Each entry is struct wal_mem_entry followed by the row
+ * encoded without fixheader. Entries may wrap around the end
+ * of the buffer.
+ */
+struct wal_mem {
+	/** Protects all members. */
+	pthread_mutex_t mutex;
+	/** Buffer memory or NULL if rows are not buffered. */
+	char *buf;
+	/**
+	 * Offsets of the first entry and the end of the last
+	 * entry. Offsets grow monotonically and are wrapped
+	 * around the buffer size on access.
+	 */
+	uint64_t begin;
+	uint64_t end;
+	/**
+	 * WAL vclock before the first row stored in the buffer.
+	 * A reader with a vclock greater than or equal to this
+	 * one can get all rows it hasn't seen from the buffer.
+	 */
+	struct vclock vclock;
+};
+
 static struct vy_log_writer vy_log_writer;
 static struct wal_thread wal_thread;
 static struct wal_writer wal_writer_singleton;
+static struct wal_mem wal_mem;
 
 enum wal_mode
 wal_mode()
@@ -150,6 +275,9 @@ wal_mode()
 static void
 wal_write_to_disk(struct cmsg *msg);
 
+static void
+wal_sync_to_disk(struct cmsg *msg);
+
 static void
 tx_schedule_commit(struct cmsg *msg);
 
@@ -158,18 +286,219 @@ static struct cmsg_hop wal_request_route[] = {
 	{tx_schedule_commit, NULL},
 };
 
+/**
+ * In wal_mode = 'fsync' a batch is written by 'wal' thread
+ * and then synced by 'wal_sync' thread, so that writing of
+ * the next batch overlaps with syncing of the previous one.
+ */
+static struct cmsg_hop wal_sync_request_route[] = {
+	{wal_write_to_disk, &wal_thread.sync_pipe},
+	{wal_sync_to_disk, &wal_thread.sync_tx_pipe},
+	{tx_schedule_commit, NULL},
+};
+
 static void
-wal_msg_create(struct wal_msg *batch)
+wal_msg_create(struct wal_msg *batch, enum wal_mode wal_mode)
 {
-	cmsg_init(batch, wal_request_route);
+	cmsg_init(batch, wal_mode == WAL_FSYNC ?
+		  wal_sync_request_route : wal_request_route);
 	stailq_create(&batch->commit);
 	stailq_create(&batch->rollback);
+	batch->sync_fd = -1;
+	batch->write_gen = 0;
+	batch->approx_len = 0;
+	batch->is_synced = false;
+	batch->sync_time = 0;
 }
 
 static struct wal_msg *
 wal_msg(struct cmsg *msg)
 {
-	return msg->route == wal_request_route ? (struct wal_msg *) msg : NULL;
+	return msg->route == wal_request_route ||
+	       msg->route == wal_sync_request_route ?
+	       (struct wal_msg *) msg : NULL;
+}
+
+/** Copy data to the WAL memory buffer at the given offset. */
+static void
+wal_mem_write(struct wal_mem *mem, uint64_t pos, const void *data,
+	      size_t size)
+{
+	assert(size <= WAL_MEM_SIZE);
+	size_t offset = pos % WAL_MEM_SIZE;
+	size_t n = MIN(size, WAL_MEM_SIZE - offset);
+	memcpy(mem->buf + offset, data, n);
+	memcpy(mem->buf, (const char *) data + n, size - n);
+}
+
+/** Copy data from the WAL memory buffer at the given offset. */
+static void
+wal_mem_copy(struct wal_mem *mem, uint64_t pos, void *data, size_t size)
+{
+	assert(size <= WAL_MEM_SIZE);
+	size_t offset = pos % WAL_MEM_SIZE;
+	size_t n = MIN(size, WAL_MEM_SIZE - offset);
+	memcpy(data, mem->buf + offset, n);
+	memcpy((char *) data + n, mem->buf, size - n);
+}
+
+/**
+ * Discard the oldest entries of the WAL memory buffer
+ * until there is enough room for @size bytes.
+ */
+static void
+wal_mem_discard(struct wal_mem *mem, size_t size)
+{
+	while (mem->begin < mem->end &&
+	       mem->end - mem->begin + size > WAL_MEM_SIZE) {
+		struct wal_mem_entry entry;
+		wal_mem_copy(mem, mem->begin, &entry, sizeof(entry));
+		if (entry.replica_id != 0) {
+			vclock_follow(&mem->vclock, entry.replica_id,
+				      entry.lsn);
+		}
+		mem->begin += sizeof(entry) + entry.size;
+	}
+}
+
+/** Append an entry to the WAL memory buffer. */
+static void
+wal_mem_append(struct wal_mem *mem, const struct wal_mem_entry *entry,
+	       const struct iovec *iov, int iovcnt)
+{
+	wal_mem_discard(mem, sizeof(*entry) + entry->size);
+	wal_mem_write(mem, mem->end, entry, sizeof(*entry));
+	mem->end += sizeof(*entry);
+	for (int i = 0; i < iovcnt; i++) {
+		wal_mem_write(mem, mem->end, iov[i].iov_base, iov[i].iov_len);
+		mem->end += iov[i].iov_len;
+	}
+}
+
+/**
+ * Append a row written to WAL to the memory buffer. If the row
+ * can't be stored, the buffer is emptied so that readers never
+ * miss it.
+ */
+static void
+wal_mem_append_row(struct wal_mem *mem, struct xrow_header *row)
+{
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_header_encode(row, 0, iov, 0);
+	struct wal_mem_entry entry;
+	entry.size = 0;
+	for (int i = 0; i < iovcnt; i++)
+		entry.size += iov[i].iov_len;
+	entry.replica_id = row->replica_id;
+	entry.lsn = row->lsn;
+	if (iovcnt < 0 || sizeof(entry) + entry.size > WAL_MEM_SIZE) {
+		diag_clear(diag_get());
+		wal_mem_discard(mem, WAL_MEM_SIZE);
+		mem->begin = mem->end;
+		vclock_follow(&mem->vclock, row->replica_id, row->lsn);
+		return;
+	}
+	wal_mem_append(mem, &entry, iov, iovcnt);
+}
+
+/**
+ * Append rows of requests written to WAL to the memory buffer.
+ */
+static void
+wal_mem_append_batch(struct wal_mem *mem, struct stailq *commit)
+{
+	if (mem->buf == NULL)
+		return;
+	tt_pthread_mutex_lock(&mem->mutex);
+	struct journal_entry *entry;
+	stailq_foreach_entry(entry, commit, fifo) {
+		struct xrow_header **row = entry->rows;
+		for (; row < entry->rows + entry->n_rows; row++)
+			wal_mem_append_row(mem, *row);
+	}
+	tt_pthread_mutex_unlock(&mem->mutex);
+}
+
+/**
+ * Append a marker to the WAL memory buffer to let readers know
+ * that a new WAL file was created and rows following the marker
+ * are stored in it.
+ */
+static void
+wal_mem_append_rotate(struct wal_mem *mem)
+{
+	if (mem->buf == NULL)
+		return;
+	struct wal_mem_entry entry;
+	memset(&entry, 0, sizeof(entry));
+	tt_pthread_mutex_lock(&mem->mutex);
+	wal_mem_append(mem, &entry, NULL, 0);
+	tt_pthread_mutex_unlock(&mem->mutex);
+}
+
+ssize_t
+wal_mem_read(struct wal_mem_cursor *cursor, const struct vclock *vclock,
+	     struct ibuf *buf)
+{
+	struct wal_mem *mem = &wal_mem;
+	struct wal_mem_entry entry;
+	ssize_t rc = -1;
+	tt_pthread_mutex_lock(&mem->mutex);
+	if (mem->buf == NULL)
+		goto out;
+	if (!cursor->is_open || cursor->pos < mem->begin) {
+		/*
+		 * Rows the reader needs may have been discarded.
+		 * If they are still here, skip the rows the reader
+		 * has already got from xlog files.
+		 *
+		 * Rotation markers followed by such rows must be
+		 * skipped, too: the reader has already switched to
+		 * the new file, and passing a marker makes it report
+		 * its vclock to garbage collection as the end of the
+		 * previous file. So position the cursor right after
+		 * the last row the reader has.
+		 */
+		cursor->is_open = false;
+		if (vclock_compare(&mem->vclock, vclock) > 0)
+			goto out;
+		cursor->pos = mem->begin;
+		uint64_t pos;
+		pos = mem->begin;
+		while (pos < mem->end) {
+			wal_mem_copy(mem, pos, &entry, sizeof(entry));
+			if (entry.replica_id != 0 &&
+			    entry.lsn > vclock_get(vclock, entry.replica_id))
+				break;
+			pos += sizeof(entry) + entry.size;
+			if (entry.replica_id != 0)
+				cursor->pos = pos;
+		}
+		cursor->is_open = true;
+	}
+	/* Copy whole entries only. */
+	uint64_t end;
+	end = cursor->pos;
+	while (end < mem->end && end - cursor->pos < WAL_MEM_READ_MAX) {
+		wal_mem_copy(mem, end, &entry, sizeof(entry));
+		end += sizeof(entry) + entry.size;
+	}
+	size_t size;
+	size = end - cursor->pos;
+	if (size > 0) {
+		void *data = ibuf_alloc(buf, size);
+		if (data == NULL) {
+			/* Let the reader fall back on xlog files. */
+			cursor->is_open = false;
+			goto out;
+		}
+		wal_mem_copy(mem, cursor->pos, data, size);
+		cursor->pos = end;
+	}
+	rc = size;
+out:
+	tt_pthread_mutex_unlock(&mem->mutex);
+	return rc;
 }
 
 /** Write a request to a log in a single transaction. */
@@ -222,14 +551,25 @@ tx_schedule_queue(struct stailq *queue)
 static void
 tx_schedule_commit(struct cmsg *msg)
 {
+	struct wal_writer *writer = &wal_writer_singleton;
 	struct wal_msg *batch = (struct wal_msg *) msg;
 	/*
-	 * Move the rollback list to the writer first, since
-	 * wal_msg memory disappears after the first
-	 * iteration of tx_schedule_queue loop.
+	 * Account the batch and move the rollback list to
+	 * the writer first, since wal_msg memory disappears
+	 * after the first iteration of tx_schedule_queue loop.
 	 */
+	struct journal_entry *entry;
+	int64_t n_commits = 0;
+	stailq_foreach_entry(entry, &batch->commit, fifo)
+		n_commits++;
+	rmean_collect(rmean_wal, WAL_STAT_BATCH, 1);
+	rmean_collect(rmean_wal, WAL_STAT_COMMIT, n_commits);
+	if (batch->is_synced) {
+		rmean_collect(rmean_wal, WAL_STAT_SYNC, 1);
+		writer->sync_time = (writer->sync_time * 7 +
+				     batch->sync_time) / 8;
+	}
 	if (! stailq_empty(&batch->rollback)) {
-		struct wal_writer *writer = &wal_writer_singleton;
 		/* Closes the input valve. */
 		stailq_concat(&writer->rollback, &batch->rollback);
 	}
@@ -254,6 +594,23 @@ tx_schedule_rollback(struct cmsg *msg)
 	stailq_create(&writer->rollback);
 }
 
+static void
+wal_commit_timer_cb(ev_loop *loop, ev_timer *timer, int events)
+{
+	(void) loop;
+	(void) timer;
+	(void) events;
+	cpipe_flush_input(&wal_thread.wal_pipe);
+}
+
+static void
+wal_on_wal_pipe_flush(struct trigger *trigger, void *event)
+{
+	(void) event;
+	struct wal_writer *writer = (struct wal_writer *) trigger->data;
+	ev_timer_stop(loop(), &writer->commit_timer);
+}
+
 /**
  * Initialize WAL writer context. Even though it's a singleton,
  * encapsulate the details just in case we may use
@@ -273,30 +630,58 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 
 	xdir_create(&writer->wal_dir, wal_dirname, XLOG, instance_uuid);
 	xlog_clear(&writer->current_wal);
-	if (wal_mode == WAL_FSYNC)
-		writer->wal_dir.open_wflags |= O_SYNC;
+	writer->write_gen = 0;
 
 	stailq_create(&writer->rollback);
 	cmsg_init(&writer->in_rollback, NULL);
 
+	writer->commit_delay = 0;
+	writer->commit_min_size = 0;
+	writer->commit_is_adaptive = false;
+	writer->sync_time = 0;
+	ev_timer_init(&writer->commit_timer, wal_commit_timer_cb, 0, 0);
+	trigger_create(&writer->on_wal_pipe_flush, wal_on_wal_pipe_flush,
+		       writer, NULL);
+	trigger_add(&wal_thread.wal_pipe.on_flush, &writer->on_wal_pipe_flush);
+
 	/* Create and fill writer->vclock. */
 	vclock_create(&writer->vclock);
 	vclock_copy(&writer->vclock, vclock);
 
 	rlist_create(&writer->watchers);
+
+	if (wal_mode != WAL_NONE) {
+		tt_pthread_mutex_lock(&wal_mem.mutex);
+		/* Relays will read xlog files if this fails. */
+		wal_mem.buf = (char *) malloc(WAL_MEM_SIZE);
+		wal_mem.begin = wal_mem.end = 0;
+		vclock_copy(&wal_mem.vclock, vclock);
+		tt_pthread_mutex_unlock(&wal_mem.mutex);
+	}
 }
 
 /** Destroy a WAL writer structure. */
 static void
 wal_writer_destroy(struct wal_writer *writer)
 {
+	ev_timer_stop(loop(), &writer->commit_timer);
+	trigger_clear(&writer->on_wal_pipe_flush);
 	xdir_destroy(&writer->wal_dir);
+
+	tt_pthread_mutex_lock(&wal_mem.mutex);
+	free(wal_mem.buf);
+	wal_mem.buf = NULL;
+	tt_pthread_mutex_unlock(&wal_mem.mutex);
 }
 
 /** WAL thread routine. */
 static int
 wal_thread_f(va_list ap);
 
+/** WAL sync thread routine. */
+static int
+wal_sync_thread_f(va_list ap);
+
 /** Start WAL thread and setup pipes to and from TX. */
 void
 wal_thread_start()
@@ -307,6 +692,38 @@ wal_thread_start()
 	/* Create a pipe to WAL thread. */
 	cpipe_create(&wal_thread.wal_pipe, "wal");
 	cpipe_set_max_input(&wal_thread.wal_pipe, IOV_MAX);
+
+	rmean_wal = rmean_new(rmean_wal_strings, WAL_STAT_LAST);
+	if (rmean_wal == NULL)
+		panic("failed to allocate WAL statistics");
+
+	tt_pthread_mutex_init(&wal_mem.mutex, NULL);
+}
+
+static int
+wal_sync_pipe_create_f(struct cbus_call_msg *msg)
+{
+	(void) msg;
+	cpipe_create(&wal_thread.sync_pipe, "wal_sync");
+	return 0;
+}
+
+/**
+ * Start WAL sync thread and setup a pipe to it from WAL
+ * thread. Used only in wal_mode = 'fsync'.
+ */
+static void
+wal_sync_thread_start()
+{
+	wal_thread.synced_fd = -1;
+	wal_thread.synced_gen = 0;
+	if (cord_costart(&wal_thread.sync_cord, "wal_sync",
+			 wal_sync_thread_f, NULL) != 0)
+		panic("failed to start WAL sync thread");
+
+	struct cbus_call_msg msg;
+	cbus_call(&wal_thread.wal_pipe, &wal_thread.tx_pipe, &msg,
+		  wal_sync_pipe_create_f, NULL, TIMEOUT_INFINITY);
 }
 
 /**
@@ -330,6 +747,9 @@ wal_init(enum wal_mode wal_mode, const char *wal_dirname,
 
 	xdir_scan_xc(&writer->wal_dir);
 
+	if (wal_mode == WAL_FSYNC)
+		wal_sync_thread_start();
+
 	journal_set(&writer->base);
 }
 
@@ -349,6 +769,104 @@ wal_thread_stop()
 
 	if (journal_is_initialized(&wal_writer_singleton.base))
 		wal_writer_destroy(&wal_writer_singleton);
+
+	rmean_delete(rmean_wal);
+	rmean_wal = NULL;
+}
+
+void
+wal_set_group_commit(double delay, int64_t min_size, bool is_adaptive)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	writer->commit_delay = delay;
+	writer->commit_min_size = min_size;
+	writer->commit_is_adaptive = is_adaptive;
+	if (delay == 0) {
+		/* Don't hold back the pending batch. */
+		cpipe_flush_input(&wal_thread.wal_pipe);
+	}
+}
+
+void
+wal_reset_stat()
+{
+	rmean_cleanup(rmean_wal);
+}
+
+static void
+wal_sync_close_f(struct cmsg *msg)
+{
+	struct wal_sync_close_msg *close_msg =
+		(struct wal_sync_close_msg *) msg;
+	if (wal_thread.synced_fd == close_msg->fd)
+		wal_thread.synced_fd = -1;
+	if (close(close_msg->fd) < 0)
+		say_syserror("%s: close() failed",
+			     fio_filename(close_msg->fd));
+	free(close_msg);
+}
+
+/**
+ * Close the current WAL. In wal_mode = 'fsync' batches
+ * written to the file may still be waiting to be synced,
+ * so the file descriptor is handed over to 'wal_sync'
+ * thread, which closes it after syncing them.
+ */
+static void
+wal_writer_close_wal(struct wal_writer *writer)
+{
+	if (writer->wal_mode != WAL_FSYNC) {
+		xlog_close(&writer->current_wal, false);
+		return;
+	}
+	static const struct cmsg_hop route[1] = {
+		{wal_sync_close_f, NULL},
+	};
+	struct wal_sync_close_msg *msg =
+		(struct wal_sync_close_msg *) malloc(sizeof(*msg));
+	if (msg == NULL)
+		panic("failed to allocate WAL sync message");
+	cmsg_init(msg, route);
+	msg->fd = writer->current_wal.fd;
+	xlog_close(&writer->current_wal, true);
+	cpipe_push(&wal_thread.sync_pipe, msg);
+}
+
+/**
+ * Sync a batch written by 'wal' thread to disk. Runs in
+ * 'wal_sync' thread. The sync is skipped if the batch was
+ * written before the previous fdatasync() was started,
+ * i.e. a single sync is shared by all batches written
+ * while another sync was in progress.
+ */
+static void
+wal_sync_to_disk(struct cmsg *msg)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_msg *batch = (struct wal_msg *) msg;
+
+	if (batch->sync_fd < 0)
+		return;
+	if (batch->sync_fd == wal_thread.synced_fd &&
+	    batch->write_gen <= wal_thread.synced_gen)
+		return;
+	uint64_t write_gen = pm_atomic_load_explicit(&writer->write_gen,
+						     pm_memory_order_acquire);
+	double start = ev_monotonic_time();
+	if (fdatasync(batch->sync_fd) < 0) {
+		/*
+		 * The state of the page cache is unknown after
+		 * a failed sync, and the rows may be already
+		 * sent to replicas, so we can neither commit
+		 * nor roll back the batch.
+		 */
+		panic_syserror("%s: fdatasync() failed",
+			       fio_filename(batch->sync_fd));
+	}
+	batch->is_synced = true;
+	batch->sync_time = ev_monotonic_time() - start;
+	wal_thread.synced_fd = batch->sync_fd;
+	wal_thread.synced_gen = write_gen;
 }
 
 struct wal_checkpoint: public cmsg
@@ -376,7 +894,7 @@ wal_checkpoint_f(struct cmsg *data)
 	    vclock_sum(&writer->current_wal.meta.vclock) !=
 	    vclock_sum(&writer->vclock)) {
 
-		xlog_close(&writer->current_wal, false);
+		wal_writer_close_wal(writer);
 		/*
 		 * Avoid creating an empty xlog if this is the
 		 * last snapshot before shutdown.
@@ -490,7 +1008,7 @@ wal_opt_rotate(struct wal_writer *writer)
 		 * failure in any reasonable way.
 		 * A warning is written to the error log.
 		 */
-		xlog_close(&writer->current_wal, false);
+		wal_writer_close_wal(writer);
 	}
 
 	if (xlog_is_open(&writer->current_wal))
@@ -513,6 +1031,7 @@ wal_opt_rotate(struct wal_writer *writer)
 	}
 	xdir_add_vclock(&writer->wal_dir, vclock);
 
+	wal_mem_append_rotate(&wal_mem);
 	wal_notify_watchers(writer, WAL_EVENT_ROTATE);
 	return 0;
 }
@@ -647,6 +1166,14 @@ wal_write_to_disk(struct cmsg *msg)
 	last_committed = stailq_last(&wal_msg->commit);
 
 done:
+	if (writer->wal_mode == WAL_FSYNC && last_committed != NULL) {
+		/* Let 'wal_sync' thread sync the written rows. */
+		wal_msg->sync_fd = l->fd;
+		wal_msg->write_gen = writer->write_gen + 1;
+		pm_atomic_store_explicit(&writer->write_gen,
+					 wal_msg->write_gen,
+					 pm_memory_order_release);
+	}
 	struct error *error = diag_last_error(diag_get());
 	if (error) {
 		/* Until we can pass the error to tx, log it and clear. */
@@ -671,6 +1198,7 @@ done:
 		stailq_concat(&wal_msg->rollback, &rollback);
 		wal_writer_begin_rollback(writer);
 	}
+	wal_mem_append_batch(&wal_mem, &wal_msg->commit);
 	fiber_gc();
 	wal_notify_watchers(writer, WAL_EVENT_WRITE);
 }
@@ -698,15 +1226,82 @@ wal_thread_f(va_list ap)
 	struct wal_writer *writer = &wal_writer_singleton;
 
 	if (xlog_is_open(&writer->current_wal))
-		xlog_close(&writer->current_wal, false);
+		wal_writer_close_wal(writer);
 
 	if (xlog_is_open(&vy_log_writer.xlog))
 		xlog_close(&vy_log_writer.xlog, false);
 
+	if (writer->wal_mode == WAL_FSYNC) {
+		cbus_stop_loop(&wal_thread.sync_pipe);
+		if (cord_join(&wal_thread.sync_cord) != 0) {
+			/* We can't recover from this in any reasonable way. */
+			panic_syserror("WAL writer: sync thread join failed");
+		}
+		cpipe_destroy(&wal_thread.sync_pipe);
+	}
+
 	cpipe_destroy(&wal_thread.tx_pipe);
 	return 0;
 }
 
+/** WAL sync thread main loop. */
+static int
+wal_sync_thread_f(va_list ap)
+{
+	(void) ap;
+
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, "wal_sync", fiber_schedule_cb, fiber());
+	/*
+	 * Committed batches are delivered to the same high
+	 * priority endpoint as the ones sent by WAL thread.
+	 */
+	cpipe_create(&wal_thread.sync_tx_pipe, "tx_prio");
+
+	cbus_loop(&endpoint);
+
+	cpipe_destroy(&wal_thread.sync_tx_pipe);
+	return 0;
+}
+
+/** Approximate size of a request's rows, in bytes. */
+static size_t
+wal_entry_len(struct journal_entry *entry)
+{
+	size_t len = 0;
+	for (int i = 0; i < entry->n_rows; i++) {
+		struct xrow_header *row = entry->rows[i];
+		for (int j = 0; j < row->bodycnt; j++)
+			len += row->body[j].iov_len;
+	}
+	return len;
+}
+
+/**
+ * Send queued requests to WAL thread. With group commit
+ * enabled, the batch is held back for up to the group
+ * commit delay, so that requests of other fibers can join
+ * it and share the write and fdatasync() with it.
+ */
+static void
+wal_flush_input(struct wal_writer *writer, struct wal_msg *batch)
+{
+	struct cpipe *pipe = &wal_thread.wal_pipe;
+	double delay = writer->commit_delay;
+	if (writer->commit_is_adaptive)
+		delay = MIN(delay, writer->sync_time);
+	if (delay <= 0 || pipe->n_input >= pipe->max_input ||
+	    (writer->commit_min_size > 0 &&
+	     (int64_t) batch->approx_len >= writer->commit_min_size)) {
+		cpipe_flush_input(pipe);
+		return;
+	}
+	if (!ev_is_active(&writer->commit_timer)) {
+		ev_timer_set(&writer->commit_timer, delay, 0);
+		ev_timer_start(loop(), &writer->commit_timer);
+	}
+}
+
 /**
  * WAL writer main entry point: queue a single request
  * to be written to disk and wait until this task is completed.
@@ -742,17 +1337,18 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 		batch = (struct wal_msg *)
 			region_alloc_xc(&fiber()->gc,
 					sizeof(struct wal_msg));
-		wal_msg_create(batch);
+		wal_msg_create(batch, writer->wal_mode);
 		/*
 		 * Sic: first add a request, then push the batch,
 		 * since cpipe_push() may pass the batch to WAL
 		 * thread right away.
 		 */
 		stailq_add_tail_entry(&batch->commit, entry, fifo);
-		cpipe_push(&wal_thread.wal_pipe, batch);
+		cpipe_push_input(&wal_thread.wal_pipe, batch);
 	}
+	batch->approx_len += wal_entry_len(entry);
 	wal_thread.wal_pipe.n_input += entry->n_rows * XROW_IOVMAX;
-	cpipe_flush_input(&wal_thread.wal_pipe);
+	wal_flush_input(writer, batch);
 	/**
 	 * It's not safe to spuriously wakeup this fiber
 	 * since in that case it will ignore a possible
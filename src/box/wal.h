@@ -39,6 +39,7 @@
 struct fiber;
 struct vclock;
 struct wal_writer;
+struct ibuf;
 
 enum wal_mode { WAL_NONE = 0, WAL_WRITE, WAL_FSYNC, WAL_MODE_MAX };
 
@@ -60,6 +61,25 @@ wal_init(enum wal_mode wal_mode, const char *wal_dirname,
 void
 wal_thread_stop();
 
+/**
+ * Configure WAL group commit.
+ *
+ * @param delay       Max time a batch of requests may wait for
+ *                    more requests before being written, in
+ *                    seconds, 0 to disable group commit.
+ * @param min_size    Batch size, in bytes, at which the batch
+ *                    is written without waiting for the delay
+ *                    to expire, 0 for no limit.
+ * @param is_adaptive Limit the delay with the measured time
+ *                    of fdatasync().
+ */
+void
+wal_set_group_commit(double delay, int64_t min_size, bool is_adaptive);
+
+/** Reset WAL statistics, see box.stat.wal. */
+void
+wal_reset_stat();
+
 struct wal_watcher_msg {
 	struct cmsg cmsg;
 	struct wal_watcher *watcher;
@@ -135,6 +155,55 @@ void
 wal_clear_watcher(struct wal_watcher *watcher,
 		  void (*process_cb)(struct cbus_endpoint *));
 
+/**
+ * Header of an entry of the buffer of rows written to WAL
+ * recently, see wal_mem_read(). It is followed by the row
+ * encoded without fixheader.
+ */
+struct wal_mem_entry {
+	/** Size of the encoded row. */
+	uint32_t size;
+	/**
+	 * Replica id of the row. 0 means that the entry marks
+	 * creation of a new WAL file and has no row.
+	 */
+	uint32_t replica_id;
+	/** LSN of the row. */
+	int64_t lsn;
+};
+
+/** Position of a reader in the buffer of recent WAL rows. */
+struct wal_mem_cursor {
+	/** Offset of the next entry to read. */
+	uint64_t pos;
+	/** Set if the reader has been positioned. */
+	bool is_open;
+};
+
+/**
+ * Copy entries of the buffer of rows written to WAL recently
+ * to @a buf. Used by relays so as not to read xlog files while
+ * they keep up with WAL. Safe to call from any thread.
+ *
+ * When the cursor isn't open or the entries it points to have
+ * been discarded, it is positioned right after the last row
+ * included in @a vclock, provided all rows following @a vclock
+ * are still in the buffer. File rotation markers preceding that
+ * row are skipped.
+ *
+ * @param cursor  Reader position, updated on success.
+ * @param vclock  Vclock of rows the reader has got so far.
+ * @param buf     Buffer to append entries to.
+ *
+ * @retval >0 size of copied entries, in bytes
+ * @retval  0 there are no more rows
+ * @retval -1 rows following @a vclock are not in the buffer
+ *            and must be read from xlog files
+ */
+ssize_t
+wal_mem_read(struct wal_mem_cursor *cursor, const struct vclock *vclock,
+	     struct ibuf *buf);
+
 void
 wal_atfork();
 
@@ -1675,6 +1675,30 @@ xlog_cursor_find_tx_magic(struct xlog_cursor *i)
 	return 0;
 }
 
+/**
+ * Called when an eof marker is read, check that there is no
+ * more data in the file.
+ *
+ * @retval 1 eof
+ * @retval -1 error, check diag
+ */
+static int
+xlog_cursor_eof_found(struct xlog_cursor *i)
+{
+	int rc = xlog_cursor_ensure(i, sizeof(log_magic_t) + sizeof(char));
+
+	if (rc < 0)
+		return -1;
+	if (rc == 0) {
+		diag_set(XlogError, "%s: has some data after "
+			  "eof marker at %lld", i->name,
+			  xlog_cursor_pos(i));
+		return -1;
+	}
+	i->state = XLOG_CURSOR_EOF;
+	return 1;
+}
+
 int
 xlog_cursor_next_tx(struct xlog_cursor *i)
 {
@@ -1689,7 +1713,7 @@ xlog_cursor_next_tx(struct xlog_cursor *i)
 		return 1;
 	if (load_u32(i->rbuf.rpos) == eof_marker) {
 		/* eof marker found */
-		goto eof_found;
+		return xlog_cursor_eof_found(i);
 	}
 
 	ssize_t to_load;
@@ -1708,23 +1732,53 @@ xlog_cursor_next_tx(struct xlog_cursor *i)
 
 	i->state = XLOG_CURSOR_TX;
 	return 0;
-eof_found:
-	/*
-	 * A eof marker is read, check that there is no
-	 * more data in the file.
-	 */
-	rc = xlog_cursor_ensure(i, sizeof(log_magic_t) + sizeof(char));
+}
 
+int
+xlog_cursor_next_tx_raw(struct xlog_cursor *i, const char **data,
+			size_t *size)
+{
+	int rc;
+	assert(xlog_cursor_is_open(i));
+	assert(i->state != XLOG_CURSOR_TX);
+
+	/* load at least magic to check eof */
+	rc = xlog_cursor_ensure(i, sizeof(log_magic_t));
 	if (rc < 0)
 		return -1;
-	if (rc == 0) {
-		diag_set(XlogError, "%s: has some data after "
-			  "eof marker at %lld", i->name,
-			  xlog_cursor_pos(i));
-		return -1;
+	if (rc > 0)
+		return 1;
+	if (load_u32(i->rbuf.rpos) == eof_marker) {
+		/* eof marker found */
+		return xlog_cursor_eof_found(i);
 	}
-	i->state = XLOG_CURSOR_EOF;
-	return 1;
+
+	struct xlog_fixheader fixheader;
+	ssize_t to_load;
+	while (true) {
+		const char *rpos = i->rbuf.rpos;
+		to_load = xlog_fixheader_decode(&fixheader, &rpos,
+						i->rbuf.wpos);
+		if (to_load < 0)
+			return -1;
+		if (to_load == 0) {
+			/* Check that the whole tx has been read */
+			*size = rpos - i->rbuf.rpos + fixheader.len;
+			to_load = (ssize_t)*size -
+				  (ssize_t)ibuf_used(&i->rbuf);
+			if (to_load <= 0)
+				break;
+		}
+		/* not enough data in read buffer */
+		rc = xlog_cursor_ensure(i, ibuf_used(&i->rbuf) + to_load);
+		if (rc < 0)
+			return -1;
+		if (rc > 0)
+			return 1;
+	}
+	*data = i->rbuf.rpos;
+	i->rbuf.rpos += *size;
+	return 0;
 }
 
 int
@@ -1741,6 +1795,17 @@ xlog_cursor_next_row(struct xlog_cursor *cursor, struct xrow_header *xrow)
 	return rc;
 }
 
+const char *
+xlog_cursor_tx_rows(struct xlog_cursor *cursor, size_t *size)
+{
+	assert(cursor->state == XLOG_CURSOR_TX);
+	struct ibuf *rows = &cursor->tx_cursor.rows;
+	const char *data = rows->rpos;
+	*size = ibuf_used(rows);
+	rows->rpos = rows->wpos;
+	return data;
+}
+
 int
 xlog_cursor_next(struct xlog_cursor *cursor,
 		 struct xrow_header *xrow, bool force_recovery)
@@ -653,6 +653,24 @@ xlog_cursor_close(struct xlog_cursor *cursor, bool reuse_fd);
 int
 xlog_cursor_next_tx(struct xlog_cursor *cursor);
 
+/**
+ * Read next tx from xlog without decoding it. The tx is
+ * returned as stored in the file, starting with its fixed
+ * header, and can be decoded with xlog_tx_cursor_create().
+ * The returned data is valid until the next call to the
+ * cursor. Must not be mixed with xlog_cursor_next_row().
+ *
+ * @param cursor cursor
+ * @param[out] data tx data
+ * @param[out] size size of the tx data
+ * @retval 0 succes
+ * @retval 1 eof
+ * retval -1 error, check diag
+ */
+int
+xlog_cursor_next_tx_raw(struct xlog_cursor *cursor, const char **data,
+			size_t *size);
+
 /**
  * Fetch next xrow from current xlog tx
  *
@@ -663,6 +681,20 @@ xlog_cursor_next_tx(struct xlog_cursor *cursor);
 int
 xlog_cursor_next_row(struct xlog_cursor *cursor, struct xrow_header *xrow);
 
+/**
+ * Fetch all rows of the current xlog tx that have not been
+ * fetched yet. The rows are left encoded and are considered
+ * consumed, so the next call to xlog_cursor_next_row() returns 1.
+ * The returned data is valid until the next call to
+ * xlog_cursor_next_row() or xlog_cursor_next_tx().
+ *
+ * @param cursor cursor positioned at a tx
+ * @param[out] size size of the returned data
+ * @retval pointer to encoded rows
+ */
+const char *
+xlog_cursor_tx_rows(struct xlog_cursor *cursor, size_t *size);
+
 /**
  * Fetch next row from cursor, ignores xlog tx boundary,
  * open a next one tx if current is done.
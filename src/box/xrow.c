@@ -864,7 +864,7 @@ int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
-		      const struct vclock *vclock)
+		      const struct vclock *vclock, uint32_t compression)
 {
 	memset(row, 0, sizeof(*row));
 	uint32_t replicaset_size = vclock_size(vclock);
@@ -876,7 +876,8 @@ xrow_encode_subscribe(struct xrow_header *row,
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 4);
+	data = mp_encode_map(data, compression != IPROTO_COMPRESSION_NONE ?
+			     5 : 4);
 	data = mp_encode_uint(data, IPROTO_CLUSTER_UUID);
 	data = xrow_encode_uuid(data, replicaset_uuid);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
@@ -891,6 +892,10 @@ xrow_encode_subscribe(struct xrow_header *row,
 	}
 	data = mp_encode_uint(data, IPROTO_SERVER_VERSION);
 	data = mp_encode_uint(data, tarantool_version_id());
+	if (compression != IPROTO_COMPRESSION_NONE) {
+		data = mp_encode_uint(data, IPROTO_COMPRESSION);
+		data = mp_encode_uint(data, compression);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
@@ -902,8 +907,13 @@ xrow_encode_subscribe(struct xrow_header *row,
 int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id)
+		      uint32_t *version_id, uint32_t *compression,
+		      bool *xlog_tx)
 {
+	if (compression != NULL)
+		*compression = IPROTO_COMPRESSION_NONE;
+	if (xlog_tx != NULL)
+		*xlog_tx = false;
 	if (row->bodycnt == 0) {
 		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
 		return -1;
@@ -961,6 +971,26 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 			}
 			*version_id = mp_decode_uint(&d);
 			break;
+		case IPROTO_COMPRESSION:
+			if (compression == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_UINT) {
+				diag_set(ClientError, ER_INVALID_MSGPACK,
+					 "invalid COMPRESSION");
+				return -1;
+			}
+			*compression = mp_decode_uint(&d);
+			break;
+		case IPROTO_JOIN_XLOG_TX:
+			if (xlog_tx == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_BOOL) {
+				diag_set(ClientError, ER_INVALID_MSGPACK,
+					 "invalid JOIN_XLOG_TX");
+				return -1;
+			}
+			*xlog_tx = mp_decode_bool(&d);
+			break;
 		default: skip:
 			mp_next(&d); /* value */
 		}
@@ -1000,10 +1030,12 @@ xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 1);
+	data = mp_encode_map(data, 2);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
 	/* Greet the remote replica with our replica UUID */
 	data = xrow_encode_uuid(data, instance_uuid);
+	data = mp_encode_uint(data, IPROTO_JOIN_XLOG_TX);
+	data = mp_encode_bool(data, true);
 	assert(data <= buf + size);
 
 	row->body[0].iov_base = buf;
@@ -1014,13 +1046,80 @@ xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
 }
 
 int
-xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock)
+xrow_encode_xlog_tx(struct xrow_header *row, const char *data, size_t size)
+{
+	memset(row, 0, sizeof(*row));
+
+	size_t buf_size = mp_sizeof_map(1) + mp_sizeof_uint(IPROTO_DATA) +
+			  mp_sizeof_binl(size);
+	char *buf = (char *) region_alloc(&fiber()->gc, buf_size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, buf_size, "region_alloc", "buf");
+		return -1;
+	}
+	char *d = buf;
+	d = mp_encode_map(d, 1);
+	d = mp_encode_uint(d, IPROTO_DATA);
+	d = mp_encode_binl(d, size);
+	assert(d == buf + buf_size);
+
+	/* The block itself is not copied. */
+	row->body[0].iov_base = buf;
+	row->body[0].iov_len = buf_size;
+	row->body[1].iov_base = (void *) data;
+	row->body[1].iov_len = size;
+	row->bodycnt = 2;
+	row->type = IPROTO_XLOG_TX;
+	return 0;
+}
+
+int
+xrow_decode_xlog_tx(struct xrow_header *row, const char **data, size_t *size)
+{
+	const char *d = NULL;
+	uint32_t map_size = 0;
+	if (row->bodycnt > 0) {
+		assert(row->bodycnt == 1);
+		d = (const char *) row->body[0].iov_base;
+		const char *end = d + row->body[0].iov_len;
+		const char *tmp = d;
+		if (mp_check(&tmp, end) != 0 || mp_typeof(*d) != MP_MAP) {
+			diag_set(ClientError, ER_INVALID_MSGPACK,
+				 "XLOG_TX body");
+			return -1;
+		}
+		map_size = mp_decode_map(&d);
+	}
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*d) != MP_UINT) {
+			mp_next(&d); /* key */
+			mp_next(&d); /* value */
+			continue;
+		}
+		uint8_t key = mp_decode_uint(&d);
+		if (key != IPROTO_DATA || mp_typeof(*d) != MP_BIN) {
+			mp_next(&d); /* value */
+			continue;
+		}
+		uint32_t len;
+		*data = mp_decode_bin(&d, &len);
+		*size = len;
+		return 0;
+	}
+	diag_set(ClientError, ER_INVALID_MSGPACK, "XLOG_TX body");
+	return -1;
+}
+
+int
+xrow_encode_subscribe_response(struct xrow_header *row,
+			       const struct vclock *vclock,
+			       uint32_t compression)
 {
 	memset(row, 0, sizeof(*row));
 
 	/* Add vclock to response body */
 	uint32_t replicaset_size = vclock_size(vclock);
-	size_t size = 8 + replicaset_size *
+	size_t size = 16 + replicaset_size *
 		(mp_sizeof_uint(UINT32_MAX) + mp_sizeof_uint(UINT64_MAX));
 	char *buf = (char *) region_alloc(&fiber()->gc, size);
 	if (buf == NULL) {
@@ -1028,7 +1127,8 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock)
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 1);
+	data = mp_encode_map(data, compression != IPROTO_COMPRESSION_NONE ?
+			     2 : 1);
 	data = mp_encode_uint(data, IPROTO_VCLOCK);
 	data = mp_encode_map(data, replicaset_size);
 	struct vclock_iterator it;
@@ -1037,6 +1137,10 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock)
 		data = mp_encode_uint(data, replica.id);
 		data = mp_encode_uint(data, replica.lsn);
 	}
+	if (compression != IPROTO_COMPRESSION_NONE) {
+		data = mp_encode_uint(data, IPROTO_COMPRESSION);
+		data = mp_encode_uint(data, compression);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
@@ -1045,6 +1149,13 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock)
 	return 0;
 }
 
+int
+xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock)
+{
+	return xrow_encode_subscribe_response(row, vclock,
+					      IPROTO_COMPRESSION_NONE);
+}
+
 void
 xrow_encode_timestamp(struct xrow_header *row, uint32_t replica_id, double tm)
 {
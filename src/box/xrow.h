@@ -248,6 +248,8 @@ xrow_encode_request_vote(struct xrow_header *row);
  * @param replicaset_uuid Replica set uuid.
  * @param instance_uuid Instance uuid.
  * @param vclock Replication clock.
+ * @param compression Compression of the replication stream
+ *        requested by the replica, see enum iproto_compression.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
@@ -256,7 +258,7 @@ int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
-		      const struct vclock *vclock);
+		      const struct vclock *vclock, uint32_t compression);
 
 /**
  * Decode SUBSCRIBE command.
@@ -264,6 +266,11 @@ xrow_encode_subscribe(struct xrow_header *row,
  * @param[out] replicaset_uuid.
  * @param[out] instance_uuid.
  * @param[out] vclock.
+ * @param[out] version_id.
+ * @param[out] compression IPROTO_COMPRESSION_NONE unless
+ *             the row requests compression.
+ * @param[out] xlog_tx Set if the row is a JOIN request of
+ *             a replica which accepts IPROTO_XLOG_TX rows.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
@@ -271,10 +278,12 @@ xrow_encode_subscribe(struct xrow_header *row,
 int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id);
+		      uint32_t *version_id, uint32_t *compression,
+		      bool *xlog_tx);
 
 /**
- * Encode JOIN command.
+ * Encode JOIN command. The command tells the master that
+ * this instance accepts IPROTO_XLOG_TX rows.
  * @param[out] row Row to encode into.
  * @param instance_uuid.
  *
@@ -288,16 +297,48 @@ xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid);
  * Decode JOIN command.
  * @param row Row to decode.
  * @param[out] instance_uuid.
+ * @param[out] xlog_tx Set if the replica accepts IPROTO_XLOG_TX
+ *             rows, false for replicas which don't know them.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
  */
 static inline int
-xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		 bool *xlog_tx)
 {
-	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL);
+	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL,
+				     NULL, xlog_tx);
 }
 
+/**
+ * Encode IPROTO_XLOG_TX row.
+ * @param[out] row Row to encode into. The row body references
+ *             @a data, which must stay valid while the row
+ *             is in use.
+ * @param data A transaction block as returned by
+ *             xlog_cursor_next_tx_raw().
+ * @param size Size of the block.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_xlog_tx(struct xrow_header *row, const char *data, size_t size);
+
+/**
+ * Decode IPROTO_XLOG_TX row.
+ * @param row Row to decode.
+ * @param[out] data Transaction block, points to the row body.
+ * @param[out] size Size of the block.
+ *
+ * @retval  0 Success.
+ * @retval -1 Format error.
+ */
+int
+xrow_decode_xlog_tx(struct xrow_header *row, const char **data,
+		    size_t *size);
+
 /**
  * Encode end of stream command (a response to JOIN command).
  * @param row[out] Row to encode into.
@@ -309,6 +350,38 @@ xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid)
 int
 xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock);
 
+/**
+ * Encode a response to SUBSCRIBE command.
+ * @param row[out] Row to encode into.
+ * @param vclock Current vclock of the master.
+ * @param compression Compression of the rows that follow
+ *        the response, see enum iproto_compression.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_subscribe_response(struct xrow_header *row,
+			       const struct vclock *vclock,
+			       uint32_t compression);
+
+/**
+ * Decode a response to SUBSCRIBE command.
+ * @param row Row to decode.
+ * @param[out] vclock.
+ * @param[out] compression.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory or format error.
+ */
+static inline int
+xrow_decode_subscribe_response(struct xrow_header *row, struct vclock *vclock,
+			       uint32_t *compression)
+{
+	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL,
+				     compression, NULL);
+}
+
 /**
  * Decode end of stream command (a response to JOIN command).
  * @param row Row to decode.
@@ -320,7 +393,8 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock);
 static inline int
 xrow_decode_vclock(struct xrow_header *row, struct vclock *vclock)
 {
-	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL);
+	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL,
+				     NULL);
 }
 
 /**
@@ -613,10 +687,10 @@ static inline void
 xrow_encode_subscribe_xc(struct xrow_header *row,
 			 const struct tt_uuid *replicaset_uuid,
 			 const struct tt_uuid *instance_uuid,
-			 const struct vclock *vclock)
+			 const struct vclock *vclock, uint32_t compression)
 {
 	if (xrow_encode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock) != 0)
+				  vclock, compression) != 0)
 		diag_raise();
 }
 
@@ -625,10 +699,11 @@ static inline void
 xrow_decode_subscribe_xc(struct xrow_header *row,
 			 struct tt_uuid *replicaset_uuid,
 		         struct tt_uuid *instance_uuid, struct vclock *vclock,
-			 uint32_t *replica_version_id)
+			 uint32_t *replica_version_id, uint32_t *compression)
 {
 	if (xrow_decode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock, replica_version_id) != 0)
+				  vclock, replica_version_id,
+				  compression, NULL) != 0)
 		diag_raise();
 }
 
@@ -643,9 +718,28 @@ xrow_encode_join_xc(struct xrow_header *row,
 
 /** @copydoc xrow_decode_join. */
 static inline void
-xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		    bool *xlog_tx)
+{
+	if (xrow_decode_join(row, instance_uuid, xlog_tx) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_xlog_tx. */
+static inline void
+xrow_encode_xlog_tx_xc(struct xrow_header *row, const char *data,
+		       size_t size)
+{
+	if (xrow_encode_xlog_tx(row, data, size) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_xlog_tx. */
+static inline void
+xrow_decode_xlog_tx_xc(struct xrow_header *row, const char **data,
+		       size_t *size)
 {
-	if (xrow_decode_join(row, instance_uuid) != 0)
+	if (xrow_decode_xlog_tx(row, data, size) != 0)
 		diag_raise();
 }
 
@@ -665,6 +759,26 @@ xrow_decode_vclock_xc(struct xrow_header *row, struct vclock *vclock)
 		diag_raise();
 }
 
+/** @copydoc xrow_encode_subscribe_response. */
+static inline void
+xrow_encode_subscribe_response_xc(struct xrow_header *row,
+				  const struct vclock *vclock,
+				  uint32_t compression)
+{
+	if (xrow_encode_subscribe_response(row, vclock, compression) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_subscribe_response. */
+static inline void
+xrow_decode_subscribe_response_xc(struct xrow_header *row,
+				  struct vclock *vclock,
+				  uint32_t *compression)
+{
+	if (xrow_decode_subscribe_response(row, vclock, compression) != 0)
+		diag_raise();
+}
+
 /** @copydoc iproto_reply_ok. */
 static inline void
 iproto_reply_ok_xc(struct obuf *out, uint64_t sync, uint32_t schema_version)
@@ -374,3 +374,25 @@ evio_service_stop(struct evio_service *service)
 		}
 	}
 }
+
+void
+evio_service_attach(struct evio_service *dst,
+		    const struct evio_service *src)
+{
+	assert(!ev_is_active(&dst->ev));
+	assert(evio_service_is_active((struct evio_service *) src));
+	snprintf(dst->host, sizeof(dst->host), "%s", src->host);
+	snprintf(dst->serv, sizeof(dst->serv), "%s", src->serv);
+	memcpy(&dst->addrstorage, &src->addrstorage, sizeof(dst->addrstorage));
+	dst->addr_len = src->addr_len;
+	ev_io_set(&dst->ev, src->ev.fd, EV_READ);
+	ev_io_start(dst->loop, &dst->ev);
+}
+
+void
+evio_service_detach(struct evio_service *service)
+{
+	if (ev_is_active(&service->ev))
+		ev_io_stop(service->loop, &service->ev);
+	ev_io_set(&service->ev, -1, 0);
+}
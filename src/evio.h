@@ -116,6 +116,22 @@ evio_service_listen(struct evio_service *service);
 void
 evio_service_stop(struct evio_service *service);
 
+/**
+ * Start accepting connections on the acceptor socket of another,
+ * already listening, service. Both services may run in different
+ * event loops. A new connection wakes up every loop watching the
+ * socket: the one whose accept() wins gets it, the others get
+ * EAGAIN and go back to sleep. The socket is owned by @a src, so
+ * @a dst must be detached before @a src is stopped.
+ */
+void
+evio_service_attach(struct evio_service *dst,
+		    const struct evio_service *src);
+
+/** Stop accepting on a socket borrowed with evio_service_attach(). */
+void
+evio_service_detach(struct evio_service *service);
+
 void
 evio_socket(struct ev_io *coio, int domain, int type, int protocol);
 
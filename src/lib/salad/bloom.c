@@ -37,16 +37,68 @@
 #include <assert.h>
 #include <string.h>
 
+/**
+ * False positive rate of a split block bloom filter with the
+ * given average number of values per block. The number of
+ * values in a block follows Poisson distribution, and a value
+ * checked against a block with j values is a false positive if
+ * each of the 8 bits it probes has been set by one of them.
+ */
+static double
+bloom_split_block_fpr(double values_per_block)
+{
+	const double word_bits = sizeof(uint32_t) * CHAR_BIT;
+	double fpr = 0;
+	double poisson = exp(-values_per_block);
+	double limit = values_per_block + 12 * sqrt(values_per_block) + 20;
+	for (uint32_t j = 0; j < limit; j++) {
+		double bit_set = 1 - pow(1 - 1 / word_bits, j);
+		fpr += poisson * pow(bit_set, BLOOM_SPLIT_BLOCK_WORDS);
+		poisson *= values_per_block / (j + 1);
+	}
+	return fpr;
+}
+
+/**
+ * Number of bits a split block bloom filter needs to store
+ * number_of_values values with the given false positive rate.
+ */
+static uint64_t
+bloom_split_block_bits(uint32_t number_of_values, double false_positive_rate)
+{
+	/* Bisect the number of values per block, fpr grows with it. */
+	double lo = 0.01, hi = 1000;
+	for (int i = 0; i < 64; i++) {
+		double mid = (lo + hi) / 2;
+		if (bloom_split_block_fpr(mid) > false_positive_rate)
+			hi = mid;
+		else
+			lo = mid;
+	}
+	const double block_bits = sizeof(struct bloom_split_block) * CHAR_BIT;
+	return (uint64_t)(number_of_values / lo * block_bits + 0.5);
+}
+
 int
-bloom_create(struct bloom *bloom, uint32_t number_of_values,
-	     double false_positive_rate, struct quota *quota)
+bloom_create(struct bloom *bloom, enum bloom_type type,
+	     uint32_t number_of_values, double false_positive_rate,
+	     struct quota *quota)
 {
-	/* Optimal hash_count and bit count calculation */
-	bloom->hash_count = (uint32_t)
-		(log(false_positive_rate) / log(0.5) + 0.99);
-	/* Number of bits */
-	uint64_t m = (uint64_t)
-		(number_of_values * bloom->hash_count / log(2) + 0.5);
+	assert(type < bloom_type_MAX);
+	bloom->type = type;
+	uint64_t m;
+	if (type == BLOOM_SPLIT_BLOCK) {
+		bloom->hash_count = BLOOM_SPLIT_BLOCK_WORDS;
+		m = bloom_split_block_bits(number_of_values,
+					   false_positive_rate);
+	} else {
+		/* Optimal hash_count and bit count calculation */
+		bloom->hash_count = (uint32_t)
+			(log(false_positive_rate) / log(0.5) + 0.99);
+		/* Number of bits */
+		m = (uint64_t)(number_of_values * bloom->hash_count /
+			       log(2) + 0.5);
+	}
 	/* mmap page size */
 	uint64_t page_size = sysconf(_SC_PAGE_SIZE);
 	/* Number of bits in one page */
@@ -134,7 +186,7 @@ bloom_spectrum_choose(struct bloom_spectrum *spectrum, struct bloom *bloom)
 }
 
 int
-bloom_spectrum_create(struct bloom_spectrum *spectrum,
+bloom_spectrum_create(struct bloom_spectrum *spectrum, enum bloom_type type,
 		      uint32_t max_number_of_values, double false_positive_rate,
 		      struct quota *quota)
 {
@@ -142,7 +194,7 @@ bloom_spectrum_create(struct bloom_spectrum *spectrum,
 	spectrum->count_collected = 0;
 	spectrum->chosen_one = -1;
 	for (uint32_t i = 0; i < BLOOM_SPECTRUM_SIZE; i++) {
-		int rc = bloom_create(&spectrum->vector[i],
+		int rc = bloom_create(&spectrum->vector[i], type,
 				      max_number_of_values,
 				      false_positive_rate, quota);
 		if (rc) {
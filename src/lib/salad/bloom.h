@@ -41,6 +41,12 @@
  *  "Less Hashing, Same Performance: Building a Better Bloom Filter"
  *   https://www.eecs.harvard.edu/~michaelm/postscripts/tr-02-05.pdf
  * 3) Using only one hash value that is splitted into several independent parts
+ *
+ * Besides the classic layout, a split block bloom filter is implemented:
+ *  Putze, F.; Sanders, P.; Singler, J. (2007), section 3 (same paper)
+ *  Every value sets exactly one bit in each of eight 32-bit words of
+ *  a 32-byte block, so a lookup is a single masked compare that is
+ *  done with SIMD instructions where available.
  */
 
 #include <stdint.h>
@@ -50,6 +56,12 @@
 #include "bit/bit.h"
 #include "small/quota.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
@@ -59,6 +71,20 @@ enum {
 	BLOOM_CACHE_LINE = 64,
 	/* Number of different bloom filter in bloom spectrum */
 	BLOOM_SPECTRUM_SIZE = 10,
+	/* Number of 32-bit words in a block of split block filter */
+	BLOOM_SPLIT_BLOCK_WORDS = 8,
+};
+
+/**
+ * Layout of a bloom filter table. The values are persistent,
+ * they are stored along with the table by users of the filter.
+ */
+enum bloom_type {
+	/** Cache line blocks, hash_count bits per value. */
+	BLOOM_CLASSIC = 0,
+	/** 32-byte blocks, one bit per 32-bit word per value. */
+	BLOOM_SPLIT_BLOCK = 1,
+	bloom_type_MAX,
 };
 
 typedef uint32_t bloom_hash_t;
@@ -70,14 +96,23 @@ struct bloom_block {
 	unsigned char bits[BLOOM_CACHE_LINE];
 };
 
+/**
+ * Block of split block bloom filter
+ */
+struct bloom_split_block {
+	uint32_t words[BLOOM_SPLIT_BLOCK_WORDS];
+};
+
 /**
  * Bloom filter data structure
  */
 struct bloom {
-	/* Number of buckets (blocks) in the table */
+	/* Number of cache line blocks in the table */
 	uint32_t table_size;
 	/* Number of hash function per value */
 	uint16_t hash_count;
+	/* Layout of the table, enum bloom_type */
+	uint8_t type;
 	/* Bit field table */
 	struct bloom_block *table;
 };
@@ -88,14 +123,16 @@ struct bloom {
  * Allocate and initialize an instance of bloom filter
  *
  * @param bloom - structure to initialize
+ * @param type - layout of the table
  * @param number_of_values - estimated number of values to be added
  * @param false_positive_rate - desired false positive rate
  * @param quota - quota for memory allocation
  * @return 0 - OK, -1 - memory error
  */
 int
-bloom_create(struct bloom *bloom, uint32_t number_of_values,
-	     double false_positive_rate, struct quota *quota);
+bloom_create(struct bloom *bloom, enum bloom_type type,
+	     uint32_t number_of_values, double false_positive_rate,
+	     struct quota *quota);
 
 /**
  * Free resources of the bloom filter
@@ -145,7 +182,8 @@ bloom_store(const struct bloom *bloom, char *table);
 
 /**
  * Allocate table and load it from given buffer.
- * Other struct bloom members must be loaded manually.
+ * Other struct bloom members (table_size, hash_count and type)
+ * must be loaded manually.
  *
  * @param bloom - structure to load to
  * @param table - data to load
@@ -172,6 +210,7 @@ struct bloom_spectrum {
 /**
  * Create a bloom spectrum
  * @param spectrum - spectrum to init
+ * @param type - layout of the bloom filters
  * @param max_number_of_values - upper bound of estimation about
  *  number of elements
  * @param false_positive_rate - desired false positive rate
@@ -179,7 +218,7 @@ struct bloom_spectrum {
  * @return 0 - OK, -1 - memory error
  */
 int
-bloom_spectrum_create(struct bloom_spectrum *spectrum,
+bloom_spectrum_create(struct bloom_spectrum *spectrum, enum bloom_type type,
 		      uint32_t max_number_of_values, double false_positive_rate,
 		      struct quota *quota);
 
@@ -213,7 +252,7 @@ bloom_spectrum_destroy(struct bloom_spectrum *spectrum, struct quota *quota);
 /* {{{ API definition */
 
 static inline void
-bloom_add(struct bloom *bloom, bloom_hash_t hash)
+bloom_classic_add(struct bloom *bloom, bloom_hash_t hash)
 {
 	/* Using lower part of the has for finding a block */
 	bloom_hash_t pos = hash % bloom->table_size;
@@ -233,7 +272,7 @@ bloom_add(struct bloom *bloom, bloom_hash_t hash)
 }
 
 static inline bool
-bloom_possible_has(const struct bloom *bloom, bloom_hash_t hash)
+bloom_classic_possible_has(const struct bloom *bloom, bloom_hash_t hash)
 {
 	/* Using lower part of the has for finding a block */
 	bloom_hash_t pos = hash % bloom->table_size;
@@ -254,6 +293,118 @@ bloom_possible_has(const struct bloom *bloom, bloom_hash_t hash)
 	return true;
 }
 
+/**
+ * Odd multipliers used to derive a bit number for every word
+ * of a split block from one 32-bit value.
+ */
+static const uint32_t bloom_split_block_salt[BLOOM_SPLIT_BLOCK_WORDS]
+	__attribute__((aligned(32))) = {
+	0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+	0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+/**
+ * Find the block of a split block filter a value belongs to
+ * and return the value to derive bits in the block from.
+ */
+static inline struct bloom_split_block *
+bloom_split_block_find(const struct bloom *bloom, bloom_hash_t hash,
+		       uint32_t *key)
+{
+	uint32_t block_count = bloom->table_size *
+		(sizeof(struct bloom_block) / sizeof(struct bloom_split_block));
+	bloom_hash_t pos = hash % block_count;
+	/*
+	 * The lower part of the hash has already been used for
+	 * finding the block, so mix the hash (murmur3 finalizer)
+	 * to get bits that are independent of the block number.
+	 */
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35U;
+	hash ^= hash >> 16;
+	*key = hash;
+	return (struct bloom_split_block *)bloom->table + pos;
+}
+
+/**
+ * Calculate the mask of bits a value sets in a split block.
+ */
+static inline void
+bloom_split_block_mask(uint32_t key, uint32_t *mask)
+{
+	for (int i = 0; i < BLOOM_SPLIT_BLOCK_WORDS; i++)
+		mask[i] = 1U << ((key * bloom_split_block_salt[i]) >> 27);
+}
+
+static inline void
+bloom_split_block_add(struct bloom *bloom, bloom_hash_t hash)
+{
+	uint32_t key;
+	struct bloom_split_block *block =
+		bloom_split_block_find(bloom, hash, &key);
+	uint32_t mask[BLOOM_SPLIT_BLOCK_WORDS];
+	bloom_split_block_mask(key, mask);
+	for (int i = 0; i < BLOOM_SPLIT_BLOCK_WORDS; i++)
+		block->words[i] |= mask[i];
+}
+
+static inline bool
+bloom_split_block_possible_has(const struct bloom *bloom, bloom_hash_t hash)
+{
+	uint32_t key;
+	const struct bloom_split_block *block =
+		bloom_split_block_find(bloom, hash, &key);
+#if defined(__AVX2__)
+	const __m256i one = _mm256_set1_epi32(1);
+	__m256i salt = _mm256_load_si256((const __m256i *)
+					 bloom_split_block_salt);
+	__m256i bit_no = _mm256_srli_epi32(
+		_mm256_mullo_epi32(_mm256_set1_epi32(key), salt), 27);
+	__m256i mask = _mm256_sllv_epi32(one, bit_no);
+	__m256i bits = _mm256_load_si256((const __m256i *)block->words);
+	/* All bits of the mask must be set in the block */
+	return _mm256_testc_si256(bits, mask) != 0;
+#elif defined(__SSE2__)
+	uint32_t m[BLOOM_SPLIT_BLOCK_WORDS] __attribute__((aligned(16)));
+	bloom_split_block_mask(key, m);
+	__m128i mask_lo = _mm_load_si128((const __m128i *)m);
+	__m128i mask_hi = _mm_load_si128((const __m128i *)m + 1);
+	__m128i bits_lo = _mm_load_si128((const __m128i *)block->words);
+	__m128i bits_hi = _mm_load_si128((const __m128i *)block->words + 1);
+	__m128i eq = _mm_and_si128(
+		_mm_cmpeq_epi32(_mm_and_si128(bits_lo, mask_lo), mask_lo),
+		_mm_cmpeq_epi32(_mm_and_si128(bits_hi, mask_hi), mask_hi));
+	return _mm_movemask_epi8(eq) == 0xffff;
+#else
+	uint32_t mask[BLOOM_SPLIT_BLOCK_WORDS];
+	bloom_split_block_mask(key, mask);
+	for (int i = 0; i < BLOOM_SPLIT_BLOCK_WORDS; i++) {
+		if ((block->words[i] & mask[i]) != mask[i])
+			return false;
+	}
+	return true;
+#endif
+}
+
+static inline void
+bloom_add(struct bloom *bloom, bloom_hash_t hash)
+{
+	if (bloom->type == BLOOM_SPLIT_BLOCK)
+		bloom_split_block_add(bloom, hash);
+	else
+		bloom_classic_add(bloom, hash);
+}
+
+static inline bool
+bloom_possible_has(const struct bloom *bloom, bloom_hash_t hash)
+{
+	if (bloom->type == BLOOM_SPLIT_BLOCK)
+		return bloom_split_block_possible_has(bloom, hash);
+	return bloom_classic_possible_has(bloom, hash);
+}
+
 static inline void
 bloom_spectrum_add(struct bloom_spectrum *spectrum, bloom_hash_t hash)
 {
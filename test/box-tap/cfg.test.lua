@@ -6,7 +6,7 @@ local socket = require('socket')
 local fio = require('fio')
 local uuid = require('uuid')
 local msgpack = require('msgpack')
-test:plan(89)
+test:plan(90)
 
 --------------------------------------------------------------------------------
 -- Invalid values
@@ -358,6 +358,20 @@ os.exit(cnt1 < cnt2 - 8 and 0 or 1)
 ]]
 test:is(run_script(code), 0, "wal_max_size xlog rotation")
 
+--
+-- Group commit options are applied at startup
+--
+code = [[
+clock = require('clock')
+box.cfg{wal_group_commit_delay = 0.5}
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+t = clock.monotonic()
+s:replace{1}
+os.exit(clock.monotonic() - t >= 0.4 and 0 or 1)
+]]
+test:is(run_script(code), 0, "wal_group_commit_delay at startup")
+
 --
 -- gh-2872 bootstrap is aborted if vinyl_dir contains vylog files
 -- left from previous runs
@@ -940,3 +940,63 @@ weak.c
 box.schema.user.revoke('guest', 'execute', 'universe')
 c:close()
 c = nil
+
+--
+-- Batched INSERT/REPLACE: all rows are written in one
+-- transaction, failed rows are skipped and reported.
+--
+space = box.schema.space.create('test_batch')
+_ = space:create_index('primary')
+box.schema.user.grant('guest', 'read,write', 'space', 'test_batch')
+c = net.connect(box.cfg.listen)
+res = c.space.test_batch:insert_batch({{1, 'a'}, {2, 'b'}, {1, 'c'}, {3, 'd'}})
+#res
+res[1][1], res[1][2]
+res[1][3]:match('Duplicate key') ~= nil
+space:select()
+c.space.test_batch:replace_batch({{1, 'x'}, {4, 'y'}})
+space:select()
+c.space.test_batch:insert_batch({})
+-- A row which is not an array fails alone.
+c.space.test_batch:insert_batch({5, {6}})
+space:select()
+c:close()
+-- A batch which is not an array is rejected.
+socket = require('socket')
+LISTEN = require('uri').parse(box.cfg.listen)
+sock = socket.tcp_connect(LISTEN.host, LISTEN.service)
+greeting = sock:read(128)
+test_run:cmd("setopt delimiter ';'")
+function batch_request(tuples)
+    local header = msgpack.encode({[0x00] = 14, [0x01] = 1})
+    local body = msgpack.encode({[0x10] = space.id, [0x21] = tuples})
+    sock:write(msgpack.encode(#header + #body) .. header .. body)
+    local len = msgpack.decode(sock:read(5))
+    local h, pos = msgpack.decode(sock:read(len))
+    return h[0x00] == 0x8000 + box.error.TUPLE_NOT_ARRAY
+end;
+test_run:cmd("setopt delimiter ''");
+batch_request('abc')
+batch_request(100)
+batch_request({})
+sock:close()
+space:drop()
+
+--
+-- get_multi: tuples are looked up by a list of keys in one
+-- request and returned in the order of keys.
+--
+space = box.schema.space.create('test_get_multi')
+_ = space:create_index('primary')
+_ = space:create_index('secondary', {parts = {2, 'string'}})
+_ = space:create_index('multi', {parts = {3, 'unsigned'}, unique = false})
+for i = 1, 5 do space:insert{i, 'v' .. i, i % 2} end
+box.schema.user.grant('guest', 'read', 'space', 'test_get_multi')
+c = net.connect(box.cfg.listen)
+c.space.test_get_multi:get_multi({4, 1, 100, {2}})
+c.space.test_get_multi.index.secondary:get_multi({'v5', 'x', 'v3'})
+c.space.test_get_multi:get_multi({})
+c.space.test_get_multi:get_multi({{1, 2}})
+c.space.test_get_multi.index.multi:get_multi({1})
+c:close()
+space:drop()
@@ -21,6 +21,14 @@ box.stat.net.RECEIVED.total > 0
 -- box.stat.net.EVENTS.total > 0
 -- box.stat.net.LOCKS.total > 0
 
+-- per-thread statistics
+box.cfg.iproto_threads
+#box.stat.net.thread()
+box.stat.net.thread(1).SENT.total == box.stat.net.SENT.total
+box.stat.net.thread(1).RECEIVED.total == box.stat.net.RECEIVED.total
+box.stat.net.thread(2)
+box.cfg{iproto_threads = 2}
+
 -- reset
 box.stat.reset()
 box.stat.net.SENT.total
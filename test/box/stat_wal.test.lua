@@ -0,0 +1,35 @@
+fiber = require('fiber')
+
+space = box.schema.space.create('tweedledum')
+index = space:create_index('primary')
+
+box.stat.reset()
+box.stat.wal.BATCH -- zero
+box.stat.wal.COMMIT -- zero
+
+-- every transaction of a single fiber is written in its own batch
+for i = 1, 10 do space:replace{i} end
+box.stat.wal.BATCH.total
+box.stat.wal.COMMIT.total
+box.stat.wal.SYNC.total -- wal_mode = 'write'
+
+-- group commit
+box.cfg{wal_group_commit_delay = -1}
+box.cfg{wal_group_commit_min_size = -1}
+box.cfg{wal_group_commit_delay = 'abc'}
+box.cfg{wal_group_commit_adaptive = 1}
+
+box.cfg{wal_group_commit_delay = 0.1}
+box.stat.reset()
+ch = fiber.channel(10)
+for i = 1, 10 do fiber.create(function() space:replace{i} ch:put(true) end) end
+for i = 1, 10 do ch:get() end
+box.stat.wal.BATCH.total
+box.stat.wal.COMMIT.total
+
+box.cfg{wal_group_commit_delay = 0}
+box.stat.reset()
+box.stat.wal.BATCH.total
+box.stat.wal.COMMIT.total
+
+space:drop()
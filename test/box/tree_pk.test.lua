@@ -301,3 +301,30 @@ s:drop()
 
 box.internal.collation.drop('test')
 box.internal.collation.drop('test-ci')
+
+--
+-- Tree index comparison hints: values that share a hint
+-- must still be ordered correctly.
+--
+s = box.schema.space.create('test')
+i1 = s:create_index('i1', {type = 'tree', parts = {1, 'scalar'}})
+_ = s:replace{'abcdefgh2'}
+_ = s:replace{'abcdefgh1'}
+_ = s:replace{'abcdefg'}
+_ = s:replace{tonumber64('4611686018427387905')}
+_ = s:replace{tonumber64('4611686018427387904')}
+_ = s:replace{tonumber64('-4611686018427387904')}
+_ = s:replace{2}
+_ = s:replace{1.5}
+_ = s:replace{1}
+_ = s:replace{-1}
+_ = s:replace{true}
+_ = s:replace{false}
+s:select{}
+s:get{1.5}
+s:get{tonumber64('4611686018427387905')}
+s:get{'abcdefgh1'}
+s:select({'abcdefgh'}, {iterator = 'GE'})
+s:select({2}, {iterator = 'LT', limit = 3})
+s:select({1}, {iterator = 'GT', limit = 2})
+s:drop()
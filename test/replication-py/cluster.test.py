@@ -71,6 +71,17 @@ server.iproto.reconnect() # re-connect with new permissions
 server_id = check_join('join with granted role')
 server.iproto.py_con.space('_cluster').delete(server_id)
 
+## The connector doesn't set IPROTO_JOIN_XLOG_TX in JOIN, so the
+## master must unpack snapshot blocks and send rows one by one.
+IPROTO_XLOG_TX = 68
+rows = list(server.iproto.py_con.join(replica_uuid))
+server.iproto.reconnect() # the only way to stop JOIN
+print len(rows) > 1 and rows[-1].code == 0 and \
+    all(row.code != IPROTO_XLOG_TX for row in rows[:-1]) and \
+    'ok' or 'not ok', '-', 'join without xlog tx blocks'
+tuples = server.iproto.py_con.space('_cluster').select(replica_uuid, index = 1)
+server.iproto.py_con.space('_cluster').delete(tuples[0][0])
+
 print '-------------------------------------------------------------'
 print 'gh-707: Master crashes on JOIN if it does not have snapshot files'
 print 'gh-480: If socket is closed while JOIN, replica wont reconnect'
@@ -0,0 +1,54 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+box.schema.user.grant('guest', 'replication')
+
+box.cfg{replication_apply_fibers = 0}
+
+-- Rows of test1 are applied concurrently, while rows of test2
+-- are applied one by one, because it has a unique secondary index.
+s1 = box.schema.space.create('test1', {engine = engine})
+_ = s1:create_index('pk')
+_ = s1:create_index('sk', {unique = false, parts = {2, 'unsigned'}})
+s2 = box.schema.space.create('test2', {engine = engine})
+_ = s2:create_index('pk')
+_ = s2:create_index('sk', {parts = {2, 'unsigned'}})
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica_apply.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("stop server replica")
+
+-- Make the replica receive all rows in one go.
+for i = 1, 1000 do s1:replace{i % 100, i} s2:replace{i % 100, i} end
+for i = 1, 99, 2 do s1:delete{i} s2:delete{i} end
+-- DDL is applied after all rows received before it.
+s3 = box.schema.space.create('test3', {engine = engine})
+_ = s3:create_index('pk')
+for i = 1, 50 do s3:insert{i, i * 2} end
+for i = 2, 98, 2 do s1:update({i}, {{'+', 2, 1}}) s2:update({i}, {{'+', 2, 1}}) end
+for i = 100, 199 do s1:upsert({i, i}, {{'+', 2, 1}}) end
+
+function digest(s) local n, sum = 0, 0 for _, t in s:pairs() do n = n + 1 sum = sum + t[1] * t[2] end return n, sum end
+digest(s1)
+digest(s2)
+digest(s3)
+
+test_run:cmd("start server replica")
+_ = test_run:wait_lsn('replica', 'default')
+test_run:cmd("switch replica")
+box.cfg.replication_apply_fibers
+box.info.replication[1].upstream.status
+function digest(s) local n, sum = 0, 0 for _, t in s:pairs() do n = n + 1 sum = sum + t[1] * t[2] end return n, sum end
+digest(box.space.test1)
+digest(box.space.test2)
+digest(box.space.test3)
+test_run:cmd("switch default")
+
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+s1:drop()
+s2:drop()
+s3:drop()
+box.schema.user.revoke('guest', 'replication')
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
@@ -0,0 +1,59 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+fiber = require('fiber')
+
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+box.schema.user.grant('guest', 'replication')
+
+box.cfg{replication_compression = true}
+
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica_compression.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("stop server replica")
+
+-- Rows written while the replica is down are sent compressed.
+for i = 1, 1000 do s:insert{i, string.rep('x', 100)} end
+
+test_run:cmd("start server replica")
+_ = test_run:wait_lsn('replica', 'default')
+replica_id = test_run:get_server_id('replica')
+downstream = box.info.replication[replica_id].downstream
+while downstream.compression_ratio <= 1 do fiber.sleep(0.01) downstream = box.info.replication[replica_id].downstream end
+downstream.compression_ratio > 1
+
+test_run:cmd("switch replica")
+box.cfg.replication_compression
+box.info.replication[1].upstream.status
+box.space.test:count()
+box.space.test:get(1000)[2] == string.rep('x', 100)
+test_run:cmd("switch default")
+
+-- An error that stops the relay is sent after the end of the
+-- compressed stream, so the replica reads it as is.
+test_run:cmd("stop server replica")
+fio = require('fio')
+-- Make sure the relay has to read xlog files, not the WAL
+-- memory buffer, then remove the files the replica needs.
+pad = string.rep('x', 100 * 1024)
+for i = 1, 100 do s:replace{i, pad} end
+box.snapshot()
+s:replace{1}
+xlogs = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))
+table.sort(xlogs)
+for i = 1, #xlogs - 1 do fio.unlink(xlogs[i]) end
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+fiber = require('fiber')
+while box.info.replication[1].upstream.status ~= 'stopped' do fiber.sleep(0.01) end
+box.info.replication[1].upstream.message:match('Missing .xlog file') ~= nil
+test_run:cmd("switch default")
+
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+box.cfg{replication_compression = false}
+s:drop()
+box.schema.user.revoke('guest', 'replication')
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
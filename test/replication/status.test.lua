@@ -66,6 +66,8 @@ replica.lsn == 0
 replica.upstream == nil
 replica.downstream.vclock[master_id] == box.info.vclock[master_id]
 replica.downstream.vclock[replica_id] == box.info.vclock[replica_id]
+type(replica.downstream.rows_per_write) == 'number'
+replica.downstream.compression_ratio
 
 --
 -- Replica
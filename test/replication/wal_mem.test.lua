@@ -0,0 +1,91 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+fiber = require('fiber')
+fio = require('fio')
+
+--
+-- Relays send rows written recently from WAL memory and fall
+-- back on xlog files if the rows they need have been discarded.
+--
+default_checkpoint_count = box.cfg.checkpoint_count
+box.cfg{checkpoint_count = 1}
+
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+box.schema.user.grant('guest', 'replication')
+
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+
+test_run:cmd("setopt delimiter ';'")
+function xlog_count()
+    return #fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))
+end;
+function wait_xlog_count(n)
+    while xlog_count() > n do fiber.sleep(0.01) end
+    return xlog_count()
+end;
+test_run:cmd("setopt delimiter ''");
+
+-- Catch up across WAL file rotation.
+for i = 1, 10 do s:replace{i} end
+box.snapshot()
+for i = 11, 20 do s:replace{i} end
+_ = test_run:wait_lsn('replica', 'default')
+
+-- The relay reads rotated files on reconnect and then switches
+-- to memory, skipping the rotation marker it has passed.
+test_run:cmd("stop server replica")
+for i = 21, 30 do s:replace{i} end
+box.snapshot()
+for i = 31, 40 do s:replace{i} end
+test_run:cmd("start server replica")
+_ = test_run:wait_lsn('replica', 'default')
+for i = 41, 50 do s:replace{i} end
+_ = test_run:wait_lsn('replica', 'default')
+
+test_run:cmd("switch replica")
+box.info.replication[1].upstream.status
+box.space.test:count()
+test_run:cmd("switch default")
+
+-- Old xlog files are collected while the relay reads from memory.
+for i = 1, 3 do s:replace{i, i} box.snapshot() end
+s:replace{51}
+wait_xlog_count(1)
+
+-- The files the replica needs are still there.
+test_run:cmd("stop server replica")
+for i = 52, 60 do s:replace{i} end
+test_run:cmd("start server replica")
+_ = test_run:wait_lsn('replica', 'default')
+
+test_run:cmd("switch replica")
+box.info.replication[1].upstream.status
+box.space.test:count()
+test_run:cmd("switch default")
+
+-- Fall back on xlog files if the rows were discarded from memory.
+test_run:cmd("stop server replica")
+pad = string.rep('x', 100 * 1024)
+for i = 1, 100 do s:replace{i, pad} end
+test_run:cmd("start server replica")
+_ = test_run:wait_lsn('replica', 'default')
+for i = 101, 110 do s:replace{i} end
+_ = test_run:wait_lsn('replica', 'default')
+
+test_run:cmd("switch replica")
+box.info.replication[1].upstream.status
+box.space.test:count()
+box.space.test:get(100)[2] == string.rep('x', 100 * 1024)
+test_run:cmd("switch default")
+
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cleanup_cluster()
+s:drop()
+box.schema.user.revoke('guest', 'replication')
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
+box.cfg{checkpoint_count = default_checkpoint_count}
@@ -174,6 +174,46 @@ cn:execute('drop table test3')
 cn:reload_schema()
 cn:execute('drop table if exists test3')
 
+--
+-- Prepared statements.
+--
+stmt = cn:prepare('select * from test where id = ?')
+stmt.bind_count
+stmt.metadata
+cn:execute(stmt.stmt_id, {100})
+cn:prepare('select * from test where id = ?').stmt_id == stmt.stmt_id
+ins = cn:prepare('insert into test values (?, ?, ?)')
+ins.bind_count
+ins.metadata
+cn:execute(ins.stmt_id, {100, 100, 'abc'})
+cn:execute(stmt.stmt_id, {100})
+cn:execute('delete from test where id = 100')
+-- A prepared statement is private to the session.
+cn2 = remote.connect(box.cfg.listen)
+cn2:execute(stmt.stmt_id, {100})
+cn2:prepare('select * from test where id = ?').stmt_id == stmt.stmt_id
+-- Statements of a session are not evicted by other sessions.
+for i = 1, 1100 do cn2:prepare('select ' .. i) end
+cn:execute(stmt.stmt_id, {100})
+cn2:close()
+-- Statement ids are 32-bit.
+cn:execute(2^32 + stmt.stmt_id, {100})
+cn:prepare('select * from not_existing_table')
+-- A prepared statement is recompiled on schema change.
+box.sql.execute('create table test_prep (id primary key, a)')
+cn:reload_schema()
+sel = cn:prepare('select * from test_prep')
+sel.metadata
+box.sql.execute('drop table test_prep')
+cn:reload_schema()
+cn:execute(sel.stmt_id)
+box.sql.execute('create table test_prep (id primary key, a, b)')
+cn:reload_schema()
+_ = box.space.TEST_PREP:replace{1, 2, 3}
+cn:execute(sel.stmt_id)
+box.sql.execute('drop table test_prep')
+cn:reload_schema()
+
 -- gh-2602 obuf_alloc breaks the tuple in different slabs
 _ = space:replace{1, 1, string.rep('a', 4 * 1024 * 1024)}
 res = cn:execute('select * from test')
@@ -11,9 +11,10 @@ uint32_t h(uint32_t i)
 }
 
 void
-simple_test()
+simple_test(enum bloom_type type)
 {
-	cout << "*** " << __func__ << " ***" << endl;
+	cout << "*** " << __func__ << " (type = " << type << ") ***"
+	     << endl;
 	struct quota q;
 	quota_init(&q, 100500);
 	srand(time(0));
@@ -24,7 +25,7 @@ simple_test()
 		uint64_t false_positive = 0;
 		for (uint32_t count = 1000; count <= 10000; count *= 2) {
 			struct bloom bloom;
-			bloom_create(&bloom, count, p, &q);
+			bloom_create(&bloom, type, count, p, &q);
 			unordered_set<uint32_t> check;
 			for (uint32_t i = 0; i < count; i++) {
 				uint32_t val = rand() % (count * 10);
@@ -54,9 +55,10 @@ simple_test()
 }
 
 void
-store_load_test()
+store_load_test(enum bloom_type type)
 {
-	cout << "*** " << __func__ << " ***" << endl;
+	cout << "*** " << __func__ << " (type = " << type << ") ***"
+	     << endl;
 	struct quota q;
 	quota_init(&q, 100500);
 	srand(time(0));
@@ -67,7 +69,7 @@ store_load_test()
 		uint64_t false_positive = 0;
 		for (uint32_t count = 300; count <= 3000; count *= 10) {
 			struct bloom bloom;
-			bloom_create(&bloom, count, p, &q);
+			bloom_create(&bloom, type, count, p, &q);
 			unordered_set<uint32_t> check;
 			for (uint32_t i = 0; i < count; i++) {
 				uint32_t val = rand() % (count * 10);
@@ -104,9 +106,10 @@ store_load_test()
 }
 
 void
-spectrum_test()
+spectrum_test(enum bloom_type type)
 {
-	cout << "*** " << __func__ << " ***" << endl;
+	cout << "*** " << __func__ << " (type = " << type << ") ***"
+	     << endl;
 	struct quota q;
 	quota_init(&q, 1005000);
 	double p = 0.01;
@@ -115,7 +118,7 @@ spectrum_test()
 	struct bloom bloom;
 
 	/* using (count) */
-	bloom_spectrum_create(&spectrum, count, p, &q);
+	bloom_spectrum_create(&spectrum, type, count, p, &q);
 	for (uint32_t i = 0; i < count; i++) {
 		bloom_spectrum_add(&spectrum, h(i));
 	}
@@ -139,7 +142,7 @@ spectrum_test()
 	bloom_destroy(&bloom, &q);
 
 	/* same test using (count * 10) */
-	bloom_spectrum_create(&spectrum, count * 10, p, &q);
+	bloom_spectrum_create(&spectrum, type, count * 10, p, &q);
 	for (uint32_t i = 0; i < count; i++) {
 		bloom_spectrum_add(&spectrum, h(i));
 	}
@@ -168,7 +171,10 @@ spectrum_test()
 int
 main(void)
 {
-	simple_test();
-	store_load_test();
-	spectrum_test();
+	simple_test(BLOOM_CLASSIC);
+	store_load_test(BLOOM_CLASSIC);
+	spectrum_test(BLOOM_CLASSIC);
+	simple_test(BLOOM_SPLIT_BLOCK);
+	store_load_test(BLOOM_SPLIT_BLOCK);
+	spectrum_test(BLOOM_SPLIT_BLOCK);
 }
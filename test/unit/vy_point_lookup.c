@@ -21,7 +21,7 @@ write_run(struct vy_run *run, const char *dir_name,
 	if (vy_run_writer_create(&writer, run, dir_name,
 				 index->space_id, index->id,
 				 index->cmp_def, index->key_def,
-				 4096, 0.1, 100500) != 0)
+				 4096, 0.1, 0, 100500) != 0)
 		goto fail;
 
 	if (wi->iface->start(wi) != 0)
@@ -194,7 +194,7 @@ test_basic()
 	struct vy_stmt_stream *write_stream
 		= vy_write_iterator_new(pk->cmp_def, pk->disk_format,
 					pk->upsert_format, pk->id == 0,
-					true, &read_views);
+					true, &read_views, NULL);
 	vy_write_iterator_new_mem(write_stream, run_mem);
 	struct vy_run *run = vy_run_new(&run_env, 1);
 	isnt(run, NULL, "vy_run_new");
@@ -229,7 +229,7 @@ test_basic()
 	write_stream
 		= vy_write_iterator_new(pk->cmp_def, pk->disk_format,
 					pk->upsert_format, pk->id == 0,
-					true, &read_views);
+					true, &read_views, NULL);
 	vy_write_iterator_new_mem(write_stream, run_mem);
 	run = vy_run_new(&run_env, 2);
 	isnt(run, NULL, "vy_run_new");
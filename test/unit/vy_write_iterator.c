@@ -38,7 +38,8 @@ compare_write_iterator_results(struct key_def *key_def,
 
 	struct vy_stmt_stream *wi =
 		vy_write_iterator_new(key_def, mem->format, mem->upsert_format,
-				      is_primary, is_last_level, &rv_list);
+				      is_primary, is_last_level, &rv_list,
+				      NULL);
 	fail_if(wi == NULL);
 	fail_if(vy_write_iterator_new_mem(wi, mem) != 0);
 
@@ -507,12 +508,118 @@ test_basic(void)
 	check_plan();
 }
 
+/** Deferred DELETE handler used by test_deferred_delete(). */
+struct test_handler {
+	struct vy_deferred_delete_handler base;
+	/** Number of processed statements. */
+	int count;
+	/** LSNs of overwritten and newest statements. */
+	int64_t old_lsn[2];
+	int64_t new_lsn[2];
+};
+
+static int
+test_handler_process(struct vy_deferred_delete_handler *base,
+		     struct tuple *old_stmt, struct tuple *new_stmt)
+{
+	struct test_handler *handler = (struct test_handler *)base;
+	fail_if(handler->count >= 2);
+	handler->old_lsn[handler->count] = vy_stmt_lsn(old_stmt);
+	handler->new_lsn[handler->count] = vy_stmt_lsn(new_stmt);
+	handler->count++;
+	return 0;
+}
+
+static const struct vy_deferred_delete_handler_iface test_handler_iface = {
+	.process = test_handler_process,
+};
+
+void
+test_deferred_delete(void)
+{
+	header();
+	plan(9);
+
+	/* Create key_def */
+	uint32_t fields[] = { 0 };
+	uint32_t types[] = { FIELD_TYPE_UNSIGNED };
+	struct key_def *key_def = box_key_def_new(fields, types, 1);
+	assert(key_def != NULL);
+
+	/*
+	 * Key 1: REPLACE overwritten by REPLACE.
+	 * Key 2: REPLACE overwritten by DELETE.
+	 * Key 3: UPSERT overwritten by REPLACE, nothing to delete.
+	 * Key 4: the only REPLACE.
+	 */
+	const struct vy_stmt_template content[] = {
+		STMT_TEMPLATE(5, REPLACE, 1, 1),
+		STMT_TEMPLATE(6, REPLACE, 1, 2),
+		STMT_TEMPLATE(7, REPLACE, 2, 1),
+		STMT_TEMPLATE(8, DELETE, 2),
+		STMT_TEMPLATE(9, UPSERT, 3, 1),
+		STMT_TEMPLATE(10, REPLACE, 3, 2),
+		STMT_TEMPLATE(11, REPLACE, 4, 1),
+	};
+	const struct vy_stmt_template expected[] = {
+		content[1], content[5], content[6]
+	};
+	int content_count = sizeof(content) / sizeof(content[0]);
+	int expected_count = sizeof(expected) / sizeof(expected[0]);
+
+	struct vy_mem *mem = create_test_mem(key_def);
+	for (int i = 0; i < content_count; ++i)
+		vy_mem_insert_template(mem, &content[i]);
+	struct rlist rv_list;
+	rlist_create(&rv_list);
+
+	struct test_handler handler;
+	handler.base.iface = &test_handler_iface;
+	handler.count = 0;
+
+	struct vy_stmt_stream *wi =
+		vy_write_iterator_new(key_def, mem->format, mem->upsert_format,
+				      true, true, &rv_list, &handler.base);
+	fail_if(wi == NULL);
+	fail_if(vy_write_iterator_new_mem(wi, mem) != 0);
+
+	struct tuple *ret;
+	fail_if(wi->iface->start(wi) != 0);
+	int i = 0;
+	do {
+		fail_if(wi->iface->next(wi, &ret) != 0);
+		if (ret == NULL)
+			break;
+		fail_if(i >= expected_count);
+		ok(vy_stmt_are_same(ret, &expected[i], mem->format,
+				    mem->upsert_format,
+				    mem->format_with_colmask),
+		   "stmt %d is correct", i);
+		++i;
+	} while (ret != NULL);
+	ok(i == expected_count, "correct results count");
+
+	is(handler.count, 2, "deferred delete count");
+	is(handler.old_lsn[0], 5, "overwritten by REPLACE: old lsn");
+	is(handler.new_lsn[0], 6, "overwritten by REPLACE: new lsn");
+	is(handler.old_lsn[1], 7, "overwritten by DELETE: old lsn");
+	is(handler.new_lsn[1], 8, "overwritten by DELETE: new lsn");
+
+	wi->iface->close(wi);
+	vy_mem_delete(mem);
+	key_def_delete(key_def);
+	fiber_gc();
+	footer();
+	check_plan();
+}
+
 int
 main(int argc, char *argv[])
 {
 	vy_iterator_C_test_init(0);
 
 	test_basic();
+	test_deferred_delete();
 
 	vy_iterator_C_test_finish();
 	return 0;
@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zstd.h>
+#include <crc32.h>
+#include "unit.h"
+#include "msgpuck.h"
+#include "trivia/util.h"
+#include "memory.h"
+#include "fiber.h"
+#include "box/xlog.h"
+#include "box/xrow.h"
+#include "box/iproto_constants.h"
+
+enum {
+	/** Number of rows in the first, big transaction block. */
+	BIG_TX_ROWS = 100,
+	/** Size of a row of the big block. */
+	BIG_ROW_SIZE = 1000,
+};
+
+/** Write a row with a random string body of the given size. */
+static int
+write_row(struct xlog *xlog, int64_t lsn, uint32_t size)
+{
+	char body[BIG_ROW_SIZE + 16];
+	assert(size <= BIG_ROW_SIZE);
+	char *pos = mp_encode_strl(body, size);
+	for (uint32_t i = 0; i < size; i++)
+		*pos++ = rand();
+
+	struct xrow_header row;
+	memset(&row, 0, sizeof(row));
+	row.type = IPROTO_INSERT;
+	row.replica_id = 1;
+	row.lsn = lsn;
+	row.body[0].iov_base = body;
+	row.body[0].iov_len = pos - body;
+	row.bodycnt = 1;
+	return xlog_write_row(xlog, &row) < 0 ? -1 : 0;
+}
+
+/**
+ * Decode a block returned by xlog_cursor_next_tx_raw() and
+ * return the number of rows in it or -1 if the block or the
+ * LSNs of its rows, which must start with @first_lsn, are
+ * invalid.
+ */
+static int
+check_tx(const char *data, size_t size, int64_t first_lsn,
+	 ZSTD_DStream *zdctx)
+{
+	struct xlog_tx_cursor tx_cursor;
+	const char *pos = data;
+	if (xlog_tx_cursor_create(&tx_cursor, &pos, data + size,
+				  zdctx) != 0)
+		return -1;
+	int count = 0;
+	int rc = 0;
+	struct xrow_header row;
+	while ((rc = xlog_tx_cursor_next_row(&tx_cursor, &row)) == 0) {
+		if (row.lsn != first_lsn + count) {
+			rc = -1;
+			break;
+		}
+		count++;
+	}
+	xlog_tx_cursor_destroy(&tx_cursor);
+	if (rc < 0 || pos != data + size)
+		return -1;
+	return count;
+}
+
+static void
+test_next_tx_raw(void)
+{
+	header();
+	plan(13);
+
+	char dir_tmpl[] = "./xlog_test.XXXXXX";
+	char *dir_name = mkdtemp(dir_tmpl);
+	isnt(dir_name, NULL, "temp dir name is not NULL");
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/00000000000000000000.xlog",
+		 dir_name);
+
+	/*
+	 * The first block is bigger than the cursor read-ahead,
+	 * and incompressible, so it is split between reads. The
+	 * second one is small and stored uncompressed.
+	 */
+	struct xlog xlog;
+	struct xlog_meta meta;
+	memset(&meta, 0, sizeof(meta));
+	strcpy(meta.filetype, "XLOG");
+	int rc = xlog_create(&xlog, path, 0, &meta);
+	srand(1);
+	for (int i = 0; i < BIG_TX_ROWS && rc == 0; i++)
+		rc = write_row(&xlog, 1 + i, BIG_ROW_SIZE);
+	if (rc == 0 && xlog_flush(&xlog) < 0)
+		rc = -1;
+	if (rc == 0)
+		rc = write_row(&xlog, 1 + BIG_TX_ROWS, 10);
+	if (rc == 0 && xlog_flush(&xlog) < 0)
+		rc = -1;
+	if (rc == 0)
+		rc = xlog_rename(&xlog);
+	if (rc == 0)
+		rc = xlog_close(&xlog, false);
+	is(rc, 0, "xlog write");
+
+	ZSTD_DStream *zdctx = ZSTD_createDStream();
+	struct xlog_cursor cursor;
+	const char *data;
+	size_t size;
+	is(xlog_cursor_open(&cursor, path), 0, "cursor open");
+
+	is(xlog_cursor_next_tx_raw(&cursor, &data, &size), 0, "big tx");
+	ok(size > (size_t)BIG_TX_ROWS * BIG_ROW_SIZE, "big tx size");
+	is(check_tx(data, size, 1, zdctx), BIG_TX_ROWS, "big tx rows");
+
+	is(xlog_cursor_next_tx_raw(&cursor, &data, &size), 0, "small tx");
+	is(check_tx(data, size, 1 + BIG_TX_ROWS, zdctx), 1, "small tx rows");
+
+	is(xlog_cursor_next_tx_raw(&cursor, &data, &size), 1, "eof");
+	ok(xlog_cursor_is_eof(&cursor), "eof marker found");
+	xlog_cursor_close(&cursor, false);
+
+	/* A file without the EOF marker ends with no error. */
+	off_t file_size = 0;
+	FILE *f = fopen(path, "r");
+	if (f != NULL && fseek(f, 0, SEEK_END) == 0)
+		file_size = ftell(f);
+	if (f != NULL)
+		fclose(f);
+	rc = truncate(path, file_size - sizeof(uint32_t));
+	is(xlog_cursor_open(&cursor, path), 0, "truncated cursor open");
+	while ((rc = xlog_cursor_next_tx_raw(&cursor, &data, &size)) == 0)
+		;
+	is(rc, 1, "truncated eof");
+	ok(!xlog_cursor_is_eof(&cursor), "no eof marker");
+	xlog_cursor_close(&cursor, false);
+
+	ZSTD_freeDStream(zdctx);
+	snprintf(path, sizeof(path), "rm -rf %s", dir_name);
+	system(path);
+
+	check_plan();
+	footer();
+}
+
+int
+main(void)
+{
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	crc32_init();
+	plan(1);
+
+	test_next_tx_raw();
+
+	fiber_free();
+	memory_free();
+	return check_plan();
+}
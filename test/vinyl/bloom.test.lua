@@ -60,3 +60,30 @@ new_reflects() > 980
 new_seeks() < 20
 
 s:drop()
+
+--
+-- Prefix bloom filter is used by lookups by a partial key.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {parts = {1, 'unsigned', 2, 'unsigned'}, bloom_prefix_parts = 1})
+s.index.pk.options.bloom_prefix_parts
+for i = 1, 100 do for j = 1, 3 do s:replace{i * 2, j} end end
+box.snapshot()
+
+for i = 1, 200 do s:select{i} end
+stat = s.index.pk:info().disk.iterator
+stat.bloom.hit + stat.bloom.miss -- 100
+stat.bloom.hit > 90
+stat.lookup < 110
+s:select{3}
+s:select{4}
+s:get{4, 2}
+
+test_run:cmd('restart server default')
+
+s = box.space.test
+for i = 1, 200 do s:select{i} end
+stat = s.index.pk:info().disk.iterator
+stat.bloom.hit + stat.bloom.miss -- 100
+stat.bloom.hit > 90
+s:drop()
@@ -0,0 +1,83 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+test_run:cmd("setopt delimiter ';'")
+function create(name, opts)
+    local s = box.schema.space.create(name, {engine = 'vinyl'})
+    opts.run_count_per_level = 1
+    opts.run_size_ratio = 10
+    s:create_index('pk', opts)
+    return s
+end;
+-- Insert 'count' tuples with random padding so that run size
+-- is proportional to the number of tuples.
+function fill(s, first, count)
+    for k = first, first + count - 1 do
+        local t = {}
+        for i = 1, 100 do
+            t[i] = string.char(math.random(65, 90))
+        end
+        s:replace{k, table.concat(t)}
+    end
+end;
+function wait_compaction(s)
+    while s.index.pk:info().run_count > 1 do fiber.sleep(0.01) end
+end;
+test_run:cmd("setopt delimiter ''");
+
+--
+-- An old run that is bigger than a new one, but less than
+-- run_size_ratio times, is not compacted by the tiered policy,
+-- while the leveled policy merges them.
+--
+tiered = create('tiered', {})
+leveled = create('leveled', {compaction_policy = 'leveled'})
+tiered.index.pk.options.compaction_policy
+leveled.index.pk.options.compaction_policy
+fill(tiered, 1, 50) fill(leveled, 1, 50)
+box.snapshot()
+fill(tiered, 51, 10) fill(leveled, 51, 10)
+box.snapshot()
+wait_compaction(leveled)
+leveled.index.pk:info().run_count
+tiered.index.pk:info().run_count
+leveled:count()
+tiered:count()
+
+st = leveled.index.pk:info().amplification
+st.read
+st.space
+st.write > 1
+st = tiered.index.pk:info().amplification
+st.read
+st.space > 1
+st.write
+tiered:drop()
+leveled:drop()
+
+--
+-- The time window policy doesn't merge runs dumped in
+-- different windows.
+--
+tiered = create('tiered', {})
+window = create('window', {compaction_policy = 'time_window', compaction_window = 1})
+window.index.pk.options.compaction_window
+fill(tiered, 1, 10) fill(window, 1, 10)
+box.snapshot()
+fiber.sleep(1.1)
+fill(tiered, 11, 50) fill(window, 11, 50)
+box.snapshot()
+wait_compaction(tiered)
+tiered.index.pk:info().run_count
+window.index.pk:info().run_count
+window:count()
+
+-- Runs dumped in the same window are compacted.
+window.index.pk:alter{compaction_window = 1e9}
+fill(window, 61, 60)
+box.snapshot()
+wait_compaction(window)
+window.index.pk:info().run_count
+window:count()
+tiered:drop()
+window:drop()
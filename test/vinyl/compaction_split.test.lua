@@ -0,0 +1,66 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Compaction of a big range is split into key-disjoint parts
+-- written by different worker threads. The compacted range is
+-- replaced with one range per part.
+--
+box.cfg.vinyl_write_threads >= 3
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 1024, range_size = 16384, run_count_per_level = 1})
+
+test_run:cmd("setopt delimiter ';'")
+function pad()
+    local t = {}
+    for i = 1, 1000 do
+        t[i] = string.char(math.random(65, 90))
+    end
+    return table.concat(t)
+end;
+function fill(iter)
+    for k = 1, 1000 do s:replace{k, iter, pad()} end
+end;
+function check(iter)
+    local ok = true
+    for k = 1, 1000 do
+        local t = s:get(k)
+        if t == nil or t[2] ~= iter then ok = false end
+    end
+    return ok and s:count() == 1000
+end;
+test_run:cmd("setopt delimiter ''");
+
+fill(1)
+box.snapshot()
+fill(2)
+box.snapshot()
+while s.index.pk:info().disk.compact.count < 1 do fiber.sleep(0.01) end
+
+info = s.index.pk:info()
+info.range_count -- 2
+info.run_count -- 2
+info.run_histogram -- [1]:2
+check(2)
+
+-- Check that the new ranges are recovered.
+test_run:cmd('restart server default')
+
+s = box.space.test
+
+test_run:cmd("setopt delimiter ';'")
+function check(iter)
+    local ok = true
+    for k = 1, 1000 do
+        local t = s:get(k)
+        if t == nil or t[2] ~= iter then ok = false end
+    end
+    return ok and s:count() == 1000
+end;
+test_run:cmd("setopt delimiter ''");
+
+s.index.pk:info().range_count -- 2
+check(2)
+
+s:drop()
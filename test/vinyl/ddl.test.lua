@@ -10,6 +10,9 @@ space:create_index('pk', {run_count_per_level = 0})
 space:create_index('pk', {run_size_ratio = 1})
 space:create_index('pk', {bloom_fpr = 0})
 space:create_index('pk', {bloom_fpr = 1.1})
+space:create_index('pk', {bloom_prefix_parts = 1})
+space:create_index('pk', {compaction_policy = 'universal'})
+space:create_index('pk', {compaction_window = 0})
 space:drop()
 
 -- space secondary index create
@@ -0,0 +1,77 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- If a space defers DELETEs, REPLACE and DELETE do not look up
+-- the old tuple on disk, so secondary indexes may store stale
+-- entries. Check that they are invisible to readers.
+--
+s = box.schema.space.create('test', {engine = 'vinyl', defer_deletes = true})
+pk = s:create_index('pk', {run_count_per_level = 1})
+i1 = s:create_index('i1', {parts = {2, 'unsigned'}, run_count_per_level = 1})
+i2 = s:create_index('i2', {parts = {3, 'unsigned'}, unique = false, run_count_per_level = 1})
+for i = 1, 6 do s:replace{i, i, i % 2} end
+box.snapshot()
+
+-- The old tuples are on disk.
+s:replace{1, 11, 1}
+s:replace{2, 12, 1}
+s:delete{3}
+s:delete{4}
+
+i1:select()
+i2:select()
+i1:get(1)
+i1:get(11)
+i2:select(0)
+s:count()
+i1:count()
+i2:count(1)
+
+-- A stale entry doesn't violate uniqueness.
+s:insert{7, 1, 0}
+s:replace{8, 5, 0}
+
+-- Make the new run big enough to trigger compaction.
+for i = 101, 120 do s:replace{i, i, 2} end
+box.snapshot()
+while pk:info().run_count > 1 do fiber.sleep(0.01) end
+
+i1:select({100}, {iterator = 'LT'})
+i2:select(0)
+i2:select(1)
+
+--
+-- Compaction of the primary index writes DELETEs for the
+-- overwritten tuples to WAL so they survive restart.
+--
+while i1:info().memory.rows < 4 or i2:info().memory.rows < 3 do fiber.sleep(0.01) end
+i1:info().memory.rows
+i2:info().memory.rows
+
+test_run:cmd('restart server default')
+fiber = require('fiber')
+s = box.space.test
+pk = s.index.pk
+i1 = s.index.i1
+i2 = s.index.i2
+
+i1:info().memory.rows
+i2:info().memory.rows
+i1:select({100}, {iterator = 'LT'})
+i2:select(0)
+i2:select(1)
+
+--
+-- Compaction of secondary indexes purges stale entries.
+--
+box.snapshot()
+while i1:info().run_count > 1 or i2:info().run_count > 1 do fiber.sleep(0.01) end
+pk:info().rows
+i1:info().rows
+i2:info().rows
+
+-- The option can't be disabled while there may be stale entries.
+box.space._space:update(s.id, {{'=', 6, {defer_deletes = false}}})
+
+s:drop()
@@ -0,0 +1,47 @@
+--
+-- index:get_multi()
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}})
+for i = 1, 10 do s:insert{i, 100 + i} end
+box.snapshot()
+
+-- Tuples are returned in the order of keys.
+s:get_multi({5, 3, {1}, 4, 2})
+-- Keys sharing a page are served by one read even if the
+-- page cache is disabled.
+box.cfg.vinyl_page_cache -- 0
+stat = s.index.pk:info().disk.iterator
+stat.page_cache.miss -- 1
+stat.page_cache.hit -- 4
+stat.read.pages -- 1
+-- The pages are evicted when the batch ends.
+s:get_multi({6, 7})
+stat = s.index.pk:info().disk.iterator
+stat.read.pages -- 2
+
+-- Missing keys are skipped.
+s:get_multi({8, 100, 9, 200})
+s:get_multi({})
+s.index.sk:get_multi({110, 101, 1})
+
+-- Keys must be full.
+s:get_multi({{1, 2}})
+s.index.sk:get_multi({'abc'})
+
+-- Statements of the active transaction are visible.
+function f() box.begin() s:replace{1, 1000} s:delete{2} local ret = {s:get_multi({1, 2, 3}), s.index.sk:get_multi({101, 1000})} box.rollback() return ret end
+f()
+s:get_multi({1, 2, 3})
+
+s:drop()
+
+-- memtx
+s = box.schema.space.create('test', {engine = 'memtx'})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+for i = 1, 5 do s:insert{i, i % 2} end
+s:get_multi({5, 1, 100, 3})
+s.index.sk:get_multi({1})
+s:drop()
@@ -67,23 +67,34 @@ end;
 
 -- Return index statistics.
 --
--- Note, latency measurement is beyond the scope of this test
--- so we just filter it out.
+-- Note, latency measurement, amplification estimates, page
+-- prefetching and concurrent lookups are beyond the scope of
+-- this test so we just filter them out. Amplification is checked
+-- by vinyl/compaction_policy.test.lua, prefetching by
+-- vinyl/prefetch.test.lua, concurrent lookups by
+-- vinyl/upsert.test.lua.
 function istat()
     local st = box.space.test.index.pk:info()
     st.latency = nil
+    st.amplification = nil
+    st.disk.iterator.prefetch = nil
+    st.disk.iterator.parallel_lookup = nil
     return st
 end;
 
 -- Return global statistics.
 --
--- Note, quota watermark checking is beyond the scope of this
--- test so we just filter out related statistics.
+-- Note, quota watermark checking and write throttling are
+-- beyond the scope of this test so we just filter out related
+-- statistics.
 function gstat()
     local st = box.info.vinyl()
     st.quota.use_rate = nil
     st.quota.dump_bandwidth = nil
     st.quota.watermark = nil
+    st.quota.throttled = nil
+    st.quota.throttle_time = nil
+    st.throttle = nil
     return st
 end;
 
@@ -0,0 +1,28 @@
+--
+-- Decompressed page cache.
+--
+page_cache = box.cfg.vinyl_page_cache
+box.cfg{vinyl_page_cache = 1024 * 1024}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 10 do s:insert{i} end
+box.snapshot()
+
+-- The first lookup reads the page, the rest hit the cache.
+for i = 1, 5 do s:get{i} end
+stat = s.index.pk:info().disk.iterator
+stat.page_cache.miss -- 1
+stat.page_cache.hit -- 4
+stat.read.pages -- 1
+
+-- Setting vinyl_page_cache to 0 disables the cache.
+box.cfg{vinyl_page_cache = 0}
+for i = 6, 10 do s:get{i} end
+stat = s.index.pk:info().disk.iterator
+stat.page_cache.miss -- 1
+stat.page_cache.hit -- 4
+stat.read.pages -- 6
+
+s:drop()
+box.cfg{vinyl_page_cache = page_cache}
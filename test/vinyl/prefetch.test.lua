@@ -0,0 +1,30 @@
+--
+-- Read-ahead of the next page on sequential run scans.
+--
+box.cfg.vinyl_read_threads > 0
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 1024})
+-- Every statement is bigger than a page so that a run page
+-- stores exactly one statement.
+for i = 1, 10 do s:insert{i, string.rep('x', 2000)} end
+box.snapshot()
+stat = s.index.pk:info().disk
+stat.pages -- 10
+stat.iterator.prefetch -- 0
+
+-- A point lookup does not read ahead.
+_ = s:get(5)
+stat = s.index.pk:info().disk.iterator
+stat.read.pages -- 1
+stat.prefetch -- 0
+
+-- A full scan reads ahead the next page along with every page
+-- but the first one, which is read before the iterator starts
+-- moving, and the last one, which has no next page.
+#s:select()
+stat = s.index.pk:info().disk.iterator
+stat.read.pages -- 11
+stat.prefetch -- 8
+
+s:drop()
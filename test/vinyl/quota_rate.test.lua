@@ -0,0 +1,45 @@
+test_run = require('test_run').new()
+
+test_run:cmd("create server test with script='vinyl/low_quota.lua'")
+test_run:cmd("start server test with args='1048576'")
+test_run:cmd('switch test')
+
+fiber = require('fiber')
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+
+--
+-- Slow down dump so that the estimated dump bandwidth drops
+-- and the quota watermark is lowered accordingly.
+--
+box.error.injection.set('ERRINJ_VY_RUN_WRITE_TIMEOUT', 1)
+_ = s:auto_increment{string.rep('x', box.cfg.vinyl_memory / 20)}
+box.snapshot()
+box.error.injection.set('ERRINJ_VY_RUN_WRITE_TIMEOUT', 0)
+box.info.vinyl().quota.dump_bandwidth < 1000 * 1000
+
+--
+-- Check that once the watermark is exceeded, the rate of
+-- quota consumption is limited and the delay is accounted.
+--
+box.error.injection.set('ERRINJ_VY_RUN_WRITE', true)
+st1 = box.info.vinyl().quota
+pad = string.rep('x', 2000)
+test_run:cmd("setopt delimiter ';'")
+while box.info.vinyl().quota.throttled == st1.throttled do
+    s:auto_increment{pad}
+    fiber.sleep(0.01)
+end;
+test_run:cmd("setopt delimiter ''");
+st2 = box.info.vinyl().quota
+st2.used < st2.limit
+st2.throttled > st1.throttled
+st2.throttle_time > st1.throttle_time
+
+box.error.injection.set('ERRINJ_VY_RUN_WRITE', false)
+s:drop()
+
+test_run:cmd('switch default')
+test_run:cmd("stop server test")
+test_run:cmd("cleanup server test")
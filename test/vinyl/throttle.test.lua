@@ -0,0 +1,45 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+
+test_run:cmd("setopt delimiter ';'")
+function pad()
+    local t = {}
+    for i = 1, 1024 do
+        t[i] = string.char(math.random(65, 90))
+    end
+    return table.concat(t)
+end;
+test_run:cmd("setopt delimiter ''");
+
+--
+-- Dump is throttled if it writes faster than
+-- vinyl_write_rate_limit.
+--
+box.cfg{vinyl_write_rate_limit = 1}
+box.info.vinyl().throttle.rate
+st1 = box.info.vinyl().throttle
+for i = 1, 500 do s:replace{i, pad()} end
+box.snapshot()
+st2 = box.info.vinyl().throttle
+st2.dump.bytes > st1.dump.bytes
+st2.dump.throttled > st1.dump.throttled
+st2.dump.throttle_time > st1.dump.throttle_time
+st2.compact.throttled == st1.compact.throttled
+
+--
+-- The compaction rate doesn't exceed the limit when it
+-- adapts to read latency and is reset when adaptation
+-- is disabled.
+--
+box.cfg{vinyl_read_latency_target = 0.001}
+fiber.sleep(1.5)
+box.info.vinyl().throttle.rate <= 1024 * 1024
+box.cfg{vinyl_read_latency_target = 0}
+box.info.vinyl().throttle.rate
+
+box.cfg{vinyl_write_rate_limit = 0}
+box.info.vinyl().throttle.rate
+s:drop()
@@ -322,3 +322,20 @@ s:upsert({100}, {{'+', 2, 100}})
 s:select({100}, 'GE')
 
 s:drop()
+
+--
+-- Point lookups read runs concurrently if keys are often
+-- found in more than one run.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {run_count_per_level = 20})
+for i = 1, 10 do s:replace{i, 0} end
+box.snapshot()
+for j = 1, 3 do for i = 1, 10 do s:upsert({i, 0}, {{'+', 2, 1}}) end box.snapshot() end
+t = {}
+for i = 1, 10 do table.insert(t, s:get{i}) end
+t
+-- Once lookups have read several runs a few times, the runs
+-- are read concurrently.
+s.index.pk:info().disk.iterator.parallel_lookup > 0
+s:drop()